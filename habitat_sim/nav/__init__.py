@@ -1,8 +1,10 @@
 from habitat_sim._ext.habitat_sim_bindings import (
+    GoalDistanceField,
     GreedyFollowerCodes,
     GreedyGeodesicFollowerImpl,
     HitRecord,
     MultiGoalShortestPath,
+    NavigablePointSamplingOptions,
     NavMeshSettings,
     PathFinder,
     ShortestPath,
@@ -12,10 +14,12 @@ from habitat_sim._ext.habitat_sim_bindings import (
 from .greedy_geodesic_follower import GreedyGeodesicFollower
 
 __all__ = [
+    "GoalDistanceField",
     "GreedyGeodesicFollower",
     "GreedyGeodesicFollowerImpl",
     "GreedyFollowerCodes",
     "MultiGoalShortestPath",
+    "NavigablePointSamplingOptions",
     "NavMeshSettings",
     "PathFinder",
     "ShortestPath",
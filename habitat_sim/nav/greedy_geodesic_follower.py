@@ -121,6 +121,9 @@ class GreedyGeodesicFollower:
             fix_thrashing,
             thrashing_threshold,
         )
+        # With actuation noise, each simulated step from a pose has a
+        # different outcome, so caching the first one would freeze it
+        self.impl.try_step_cache_enabled = not self._has_actuation_noise()
 
     def _find_action(self, name: str) -> Tuple[str, ActuationSpec]:
         candidates = list(
@@ -136,6 +139,12 @@ class GreedyGeodesicFollower:
 
         return candidates[0][0], candidates[0][1].actuation
 
+    def _has_actuation_noise(self) -> bool:
+        return any(
+            getattr(spec, "noise_multiplier", 0.0) > 0.0
+            for spec in (self.forward_spec, self.left_spec, self.right_spec)
+        )
+
     def _move_forward(self, obj: scene.SceneNode) -> bool:
         return self.agent.controls(obj, "move_forward", self.forward_spec, True)
 
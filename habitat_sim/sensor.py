@@ -14,6 +14,7 @@ from habitat_sim._ext.habitat_sim_bindings import (
     FisheyeSensorModelType,
     FisheyeSensorSpec,
     Observation,
+    ObservationArena,
     Sensor,
     SensorFactory,
     SensorSpec,
@@ -35,6 +36,7 @@ __all__ = [
     "FisheyeSensorModelType",
     "FisheyeSensorSpec",
     "Observation",
+    "ObservationArena",
     "Sensor",
     "SensorFactory",
     "SensorSpec",
@@ -7,6 +7,7 @@
 import time
 from collections import OrderedDict
 from collections.abc import MutableMapping
+from functools import partial
 from os import path as osp
 from typing import Any, Dict, List
 from typing import MutableMapping as MutableMapping_T
@@ -32,7 +33,7 @@ from habitat_sim.bindings import cuda_enabled
 from habitat_sim.logging import logger
 from habitat_sim.metadata import MetadataMediator
 from habitat_sim.nav import GreedyGeodesicFollower, NavMeshSettings, PathFinder
-from habitat_sim.sensor import SensorSpec, SensorType
+from habitat_sim.sensor import SensorSpec, SensorType, VisualSensor
 from habitat_sim.sensors.noise_models import make_sensor_noise_model
 from habitat_sim.sim import SimulatorBackend, SimulatorConfiguration
 from habitat_sim.utils.common import quat_from_angle_axis
@@ -242,6 +243,7 @@ class Simulator(SimulatorBackend):
         self._config_agents(config)
         self._config_pathfinder(config)
         self.frustum_culling = config.sim_cfg.frustum_culling
+        self.pipelined_observations = config.sim_cfg.pipelined_observations
 
         for i in range(len(self.agents)):
             self.agents[i].controls.move_filter_fn = self.step_filter
@@ -329,10 +331,13 @@ class Simulator(SimulatorBackend):
         else:
             return_single = False
 
+        # Drawn together, so that co-located sensors share a render pass
+        sensor_objects = []
         for agent_id in agent_ids:
             agent_sensorsuite = self.__sensors[agent_id]
             for _sensor_uuid, sensor in agent_sensorsuite.items():
-                sensor.draw_observation()
+                sensor_objects.append(sensor.sensor_object_to_draw())
+        self.renderer.draw(sensor_objects, self)
 
         # As backport. All Dicts are ordered in Python >= 3.7
         observations: Dict[int, ObservationDict] = OrderedDict()
@@ -527,7 +532,7 @@ class Sensor:
             self._spec.noise_model, self._spec.uuid
         )
 
-    def draw_observation(self) -> None:
+    def sensor_object_to_draw(self) -> VisualSensor:
         # sanity check:
 
         # see if the sensor is attached to a scene graph, otherwise it is invalid,
@@ -538,7 +543,10 @@ class Sensor:
                  (has it been detached from a scene node?)"
             )
 
-        self._sim.renderer.draw(self._sensor_object, self._sim)
+        return self._sensor_object
+
+    def draw_observation(self) -> None:
+        self._sim.renderer.draw(self.sensor_object_to_draw(), self._sim)
 
     def get_observation(self) -> Union[ndarray, "Tensor"]:
 
@@ -556,24 +564,43 @@ class Sensor:
                 obs = self._buffer.flip(0)  # type: ignore[union-attr]
         else:
             size = self._sensor_object.framebuffer_size
+            pipelined = self._sim.pipelined_observations
+            if not pipelined:
+                tgt.discard_pending_reads()
 
             if self._spec.sensor_type == SensorType.SEMANTIC:
-                tgt.read_frame_object_id(
-                    mn.MutableImageView2D(mn.PixelFormat.R32UI, size, self._buffer)
+                view = mn.MutableImageView2D(mn.PixelFormat.R32UI, size, self._buffer)
+                read_frame = tgt.read_frame_object_id
+                read_frame_async = partial(
+                    tgt.read_frame_object_id_async, mn.PixelFormat.R32UI
                 )
             elif self._spec.sensor_type == SensorType.DEPTH:
-                tgt.read_frame_depth(
-                    mn.MutableImageView2D(mn.PixelFormat.R32F, size, self._buffer)
-                )
+                view = mn.MutableImageView2D(mn.PixelFormat.R32F, size, self._buffer)
+                read_frame = tgt.read_frame_depth
+                read_frame_async = partial(tgt.read_frame_depth_async)
             else:
-                tgt.read_frame_rgba(
-                    mn.MutableImageView2D(
-                        mn.PixelFormat.RGBA8_UNORM,
-                        size,
-                        self._buffer.reshape(self._spec.resolution[0], -1),
-                    )
+                view = mn.MutableImageView2D(
+                    mn.PixelFormat.RGBA8_UNORM,
+                    size,
+                    self._buffer.reshape(self._spec.resolution[0], -1),
+                )
+                read_frame = tgt.read_frame_rgba
+                read_frame_async = partial(
+                    tgt.read_frame_rgba_async, mn.PixelFormat.RGBA8_UNORM
                 )
 
+            if pipelined and tgt.num_pending_reads > 0:
+                # Keep one read in flight: start reading the frame that was
+                # just drawn, then retrieve the one drawn by the previous call
+                read_frame_async()
+                tgt.finish_read_frame(view)
+            else:
+                # The first pipelined observation can't lag behind, so it is
+                # read synchronously
+                read_frame(view)
+                if pipelined:
+                    read_frame_async()
+
             obs = np.flip(self._buffer, axis=0)
 
         return self._noise_model(obs)
@@ -103,6 +103,20 @@ void initGfxBindings(py::module& m) {
              sim::Simulator& sim) { self.draw(visualSensor, sim); },
           R"(Draw the active scene in current simulator using the visual sensor)",
           "visualSensor"_a, "sim"_a)
+      .def(
+          "draw",
+          [](Renderer& self,
+             const std::vector<sensor::VisualSensor*>& visualSensors,
+             sim::Simulator& sim) {
+            std::vector<std::reference_wrapper<sensor::VisualSensor>> sensors;
+            sensors.reserve(visualSensors.size());
+            for (sensor::VisualSensor* visualSensor : visualSensors) {
+              sensors.emplace_back(*visualSensor);
+            }
+            self.draw(sensors, sim);
+          },
+          R"(Draw the active scene in current simulator using several visual sensors. Co-located color, depth and semantic camera sensors share one render pass.)",
+          "visualSensors"_a, "sim"_a)
       .def(
           "bind_render_target",
           [](Renderer& self, sensor::VisualSensor& visualSensor,
@@ -125,6 +139,17 @@ void initGfxBindings(py::module& m) {
            "Reads RGBA frame into passed img in uint8 byte format.")
       .def("read_frame_depth", &RenderTarget::readFrameDepth)
       .def("read_frame_object_id", &RenderTarget::readFrameObjectId)
+      .def("read_frame_rgba_async", &RenderTarget::readFrameRgbaAsync,
+           R"(Start reading the RGBA frame into a pixel buffer object. Retrieve it with finish_read_frame.)",
+           "format"_a = Mn::PixelFormat::RGBA8Unorm)
+      .def("read_frame_depth_async", &RenderTarget::readFrameDepthAsync)
+      .def("read_frame_object_id_async", &RenderTarget::readFrameObjectIdAsync,
+           "format"_a = Mn::PixelFormat::R32UI)
+      .def_property_readonly("num_pending_reads",
+                             &RenderTarget::numPendingReads)
+      .def("finish_read_frame", &RenderTarget::finishReadFrame,
+           R"(Retrieve the oldest pending asynchronous read into the given view.)")
+      .def("discard_pending_reads", &RenderTarget::discardPendingReads)
       .def("blit_rgba_to_default", &RenderTarget::blitRgbaToDefault)
 #ifdef ESP_BUILD_WITH_CUDA
       .def("read_frame_rgba_gpu",
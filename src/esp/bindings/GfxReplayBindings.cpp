@@ -7,6 +7,7 @@
 #include <Magnum/PythonBindings.h>
 #include <Magnum/SceneGraph/PythonBindings.h>
 
+#include "esp/gfx/replay/KeyframeFile.h"
 #include "esp/gfx/replay/Player.h"
 #include "esp/gfx/replay/ReplayManager.h"
 
@@ -81,12 +82,59 @@ void initGfxReplayBindings(py::module& m) {
                   "replay save not enabled. See "
                   "SimulatorConfiguration.enable_gfx_replay_save.");
             }
-            self.getRecorder()->writeSavedKeyframesToFile(filepath);
+            return self.getRecorder()->writeSavedKeyframesToFile(filepath);
           },
-          R"(Write all saved keyframes to a file, then discard the keyframes.)")
+          R"(Write all saved keyframes to a file, then discard the keyframes. Files ending in .bin use the compact binary format; all others use JSON. Returns whether the file was completely written.)")
+
+      .def(
+          "start_streaming_keyframes_to_file",
+          [](ReplayManager& self, const std::string& filepath,
+             int maxQueuedKeyframes) {
+            if (!self.getRecorder()) {
+              throw std::runtime_error(
+                  "replay save not enabled. See "
+                  "SimulatorConfiguration.enable_gfx_replay_save.");
+            }
+            return self.getRecorder()->startStreamingKeyframesToFile(
+                filepath, maxQueuedKeyframes);
+          },
+          "filepath"_a, "max_queued_keyframes"_a = 0,
+          R"(Append saved keyframes to a binary replay file as they are saved, instead of keeping them in memory. Already-saved keyframes are written first. If max_queued_keyframes is positive, keyframes are written on a background thread and at most that many keyframes wait in memory. Returns whether the file could be created.)")
+
+      .def(
+          "stop_streaming_keyframes",
+          [](ReplayManager& self) {
+            if (!self.getRecorder()) {
+              throw std::runtime_error(
+                  "replay save not enabled. See "
+                  "SimulatorConfiguration.enable_gfx_replay_save.");
+            }
+            return self.getRecorder()->stopStreamingKeyframes();
+          },
+          R"(Finish the file started by start_streaming_keyframes_to_file. Returns false if the file could not be completely written.)")
+
+      .def(
+          "set_change_thresholds",
+          [](ReplayManager& self, float translationEpsilon,
+             Magnum::Radd rotationEpsilon) {
+            if (!self.getRecorder()) {
+              throw std::runtime_error(
+                  "replay save not enabled. See "
+                  "SimulatorConfiguration.enable_gfx_replay_save.");
+            }
+            self.getRecorder()->setChangeThresholds(
+                translationEpsilon, Magnum::Rad(rotationEpsilon));
+          },
+          "translation_epsilon"_a, "rotation_epsilon"_a,
+          R"(Set how far (in meters) and how much (in radians) an instance or user transform must move before a new state is saved for it. By default any change is saved.)")
 
       .def("read_keyframes_from_file", &ReplayManager::readKeyframesFromFile,
            R"(Create a Player object from a replay file.)");
+
+  m.def(
+      "convert_replay_file", &convertKeyframeFile, "input_filepath"_a,
+      "output_filepath"_a,
+      R"(Convert a replay file between the JSON and binary formats. Output files ending in .bin use the binary format; all others use JSON. Returns whether the conversion succeeded.)");
 }
 
 }  // namespace replay
@@ -5,17 +5,22 @@
 #include "esp/bindings/bindings.h"
 
 #include <Magnum/Magnum.h>
+#include <Magnum/PixelFormat.h>
 #include <Magnum/SceneGraph/SceneGraph.h>
 
 #include <Magnum/PythonBindings.h>
 #include <Magnum/SceneGraph/PythonBindings.h>
+#include <pybind11/numpy.h>
 
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "esp/sensor/CameraSensor.h"
 #include "esp/sensor/CubeMapSensorBase.h"
 #include "esp/sensor/EquirectangularSensor.h"
 #include "esp/sensor/FisheyeSensor.h"
+#include "esp/sensor/ObservationArena.h"
 #include "esp/sensor/VisualSensor.h"
 #ifdef ESP_BUILD_WITH_CUDA
 #include "esp/sensor/RedwoodNoiseModel.h"
@@ -36,6 +41,47 @@ esp::scene::SceneNode* nodeGetter(T& self) {
     throw py::value_error{"feature not valid"};
   return &self.node();
 };
+
+/* A numpy view on the observations of a slot, of shape [batch, height, width]
+   for single-channel formats and [batch, height, width, channels] otherwise,
+   like the observations of habitat_sim.Simulator.get_sensor_observations().
+   Rows are stored bottom to top, so the view starts at the last row and steps
+   backwards, which flips the observations without copying them. */
+py::array observationArenaView(const py::object& pyArena,
+                               const std::string& uuid) {
+  auto& arena = pyArena.cast<esp::sensor::ObservationArena&>();
+  const int slotIndex = arena.getSlotIndex(uuid);
+  if (slotIndex == esp::ID_UNDEFINED) {
+    throw py::key_error{uuid};
+  }
+  const esp::sensor::ObservationArena::Slot& slot = arena.slots()[slotIndex];
+
+  py::dtype dtype;
+  if (slot.format == Magnum::PixelFormat::R32UI) {
+    dtype = py::dtype::of<uint32_t>();
+  } else if (slot.format == Magnum::PixelFormat::R32F) {
+    dtype = py::dtype::of<float>();
+  } else {
+    dtype = py::dtype::of<uint8_t>();
+  }
+  const auto elementSize = py::ssize_t(dtype.itemsize());
+  const auto height = py::ssize_t(slot.shape[0]);
+  const auto width = py::ssize_t(slot.shape[1]);
+  const auto channels = py::ssize_t(slot.shape[2]);
+  const py::ssize_t rowSize = width * channels * elementSize;
+
+  std::vector<py::ssize_t> shape{py::ssize_t(arena.batchSize()), height,
+                                 width};
+  std::vector<py::ssize_t> strides{py::ssize_t(slot.frameSize), -rowSize,
+                                   channels * elementSize};
+  if (channels != 1) {
+    shape.push_back(channels);
+    strides.push_back(elementSize);
+  }
+  char* lastRow = arena.data().data() + slot.offset + (height - 1) * rowSize;
+  // the array keeps the arena alive
+  return py::array{dtype, shape, strides, lastRow, pyArena};
+}
 }  // namespace
 
 namespace esp {
@@ -200,6 +246,35 @@ void initSensorBindings(py::module& m) {
       .def_property_readonly("framebuffer_size", &VisualSensor::framebufferSize)
       .def_property_readonly("render_target", &VisualSensor::renderTarget);
 
+  // ==== ObservationArena ====
+  py::class_<ObservationArena, ObservationArena::ptr>(
+      m, "ObservationArena",
+      R"(Preallocated memory for the observations of the visual sensors in the subtree
+      of a scene node, e.g. of an agent, with a slot of batch_size observations for
+      each sensor. Fill it with Simulator.fill_sensor_observations() or
+      Simulator.fill_batched_sensor_observations(). arena[uuid] is a numpy view on
+      the slot of a sensor, which is filled in place, without copies or allocations.
+      Sensor noise models are not applied.)")
+      .def(py::init([](scene::SceneNode& node, std::size_t batchSize) {
+             return ObservationArena::create(node.getSubtreeSensors(),
+                                             batchSize);
+           }),
+           "scene_node"_a, "batch_size"_a = 1)
+      .def_property_readonly("batch_size", &ObservationArena::batchSize)
+      .def_property_readonly("uuids",
+                             [](const ObservationArena& self) {
+                               std::vector<std::string> uuids;
+                               for (const auto& slot : self.slots()) {
+                                 uuids.push_back(slot.uuid);
+                               }
+                               return uuids;
+                             })
+      .def("__getitem__", &observationArenaView, "uuid"_a)
+      .def("__contains__",
+           [](const ObservationArena& self, const std::string& uuid) {
+             return self.getSlotIndex(uuid) != ID_UNDEFINED;
+           });
+
   // === CameraSensor ====
   py::class_<CameraSensor, Magnum::SceneGraph::PyFeature<CameraSensor>,
              VisualSensor, Magnum::SceneGraph::PyFeatureHolder<CameraSensor>>(
@@ -48,6 +48,11 @@ void initShortestPathBindings(py::module& m) {
       .def_readwrite("geodesic_distance",
                      &MultiGoalShortestPath::geodesicDistance);
 
+  py::class_<GoalDistanceField, GoalDistanceField::ptr>(m, "GoalDistanceField")
+      .def(py::init(&GoalDistanceField::create<>))
+      .def_property("goals", &GoalDistanceField::getGoals,
+                    &GoalDistanceField::setGoals);
+
   py::class_<NavMeshSettings, NavMeshSettings::ptr>(m, "NavMeshSettings")
       .def(py::init(&NavMeshSettings::create<>))
       .def_readwrite("cell_size", &NavMeshSettings::cellSize)
@@ -69,8 +74,23 @@ void initShortestPathBindings(py::module& m) {
       .def_readwrite("filter_ledge_spans", &NavMeshSettings::filterLedgeSpans)
       .def_readwrite("filter_walkable_low_height_spans",
                      &NavMeshSettings::filterWalkableLowHeightSpans)
+      .def_readwrite("tile_size", &NavMeshSettings::tileSize)
       .def("set_defaults", &NavMeshSettings::setDefaults);
 
+  py::class_<NavigablePointSamplingOptions,
+             NavigablePointSamplingOptions::ptr>(
+      m, "NavigablePointSamplingOptions")
+      .def(py::init(&NavigablePointSamplingOptions::create<>))
+      .def_readwrite("island_id", &NavigablePointSamplingOptions::islandId)
+      .def_readwrite("min_island_radius",
+                     &NavigablePointSamplingOptions::minIslandRadius)
+      .def_readwrite("stratified", &NavigablePointSamplingOptions::stratified)
+      .def_readwrite("min_distance",
+                     &NavigablePointSamplingOptions::minDistance)
+      .def_readwrite("max_tries", &NavigablePointSamplingOptions::maxTries)
+      .def_readwrite("seed", &NavigablePointSamplingOptions::seed)
+      .def("set_defaults", &NavigablePointSamplingOptions::setDefaults);
+
   py::class_<PathFinder, PathFinder::ptr>(m, "PathFinder")
       .def(py::init(&PathFinder::create<>))
       .def("get_bounds", &PathFinder::bounds)
@@ -80,11 +100,54 @@ void initShortestPathBindings(py::module& m) {
            "meters_per_pixel"_a, "height"_a)
       .def("get_random_navigable_point", &PathFinder::getRandomNavigablePoint,
            "max_tries"_a = 10)
+      .def("sample_navigable_points", &PathFinder::sampleNavigablePoints,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Samples n random navigable points in one call. Returns an n x 3 array, with fewer rows if min_distance could not be satisfied for all points.)",
+           "n"_a, "options"_a = NavigablePointSamplingOptions())
       .def("find_path", py::overload_cast<ShortestPath&>(&PathFinder::findPath),
            "path"_a)
       .def("find_path",
            py::overload_cast<MultiGoalShortestPath&>(&PathFinder::findPath),
            "path"_a)
+      .def("build_hierarchy", &PathFinder::buildHierarchy,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Precomputes the region hierarchy used by find_path_hierarchical. It is saved and loaded together with the navmesh.)",
+           "max_region_polys"_a = 64)
+      .def_property_readonly("has_hierarchy", &PathFinder::hasHierarchy)
+      .def("find_path_hierarchical", &PathFinder::findPathHierarchical,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Same as find_path, but plans long paths on the hierarchy built by build_hierarchy.)",
+           "path"_a)
+      .def(
+          "find_paths",
+          [](PathFinder& self, const std::vector<ShortestPath::ptr>& paths) {
+            std::vector<ShortestPath> batch;
+            batch.reserve(paths.size());
+            for (const auto& path : paths) {
+              batch.push_back(*path);
+            }
+            int numFound = 0;
+            {
+              py::gil_scoped_release release;
+              numFound = self.findPaths(batch);
+            }
+            for (size_t i = 0; i < paths.size(); ++i) {
+              paths[i]->points = std::move(batch[i].points);
+              paths[i]->geodesicDistance = batch[i].geodesicDistance;
+            }
+            return numFound;
+          },
+          R"(Finds the shortest path for each of the paths in parallel. Returns the number of paths that exist.)",
+          "paths"_a)
+      .def("geodesic_distances", &PathFinder::geodesicDistances,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Computes the geodesic distance between each pair of start and end points in parallel.)",
+           "starts"_a, "ends"_a)
+      // keeps the GIL, as it uses the shared navmesh query and updates the
+      // field
+      .def("geodesic_distance_to_goals", &PathFinder::geodesicDistanceToGoals,
+           R"(Returns the geodesic distance from pt to the closest goal of the field. The field is computed once and reused until its goals or the navmesh change.)",
+           "pt"_a, "field"_a)
       .def("try_step", &PathFinder::tryStep<Magnum::Vector3>, "start"_a,
            "end"_a)
       .def("try_step", &PathFinder::tryStep<vec3f>, "start"_a, "end"_a)
@@ -94,7 +157,23 @@ void initShortestPathBindings(py::module& m) {
            "start"_a, "end"_a)
       .def("snap_point", &PathFinder::snapPoint<Magnum::Vector3>)
       .def("snap_point", &PathFinder::snapPoint<vec3f>)
+      .def("try_steps", &PathFinder::trySteps,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Batched try_step. Takes two N x 3 arrays of start and end points and returns an N x 3 array of the found end points, processed in parallel.)",
+           "starts"_a, "ends"_a)
+      .def("try_steps_no_sliding", &PathFinder::tryStepsNoSliding,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Batched try_step_no_sliding, see try_steps.)", "starts"_a,
+           "ends"_a)
+      .def("snap_points", &PathFinder::snapPoints,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Batched snap_point. Takes and returns an N x 3 array of points, processed in parallel.)",
+           "points"_a)
       .def("island_radius", &PathFinder::islandRadius, "pt"_a)
+      .def("get_island_id", &PathFinder::getIslandId,
+           R"(Returns the id of the connected component pt belongs to, in [0, num_islands), or -1 if pt isn't on the navmesh.)",
+           "pt"_a)
+      .def_property_readonly("num_islands", &PathFinder::numIslands)
       .def_property_readonly("is_loaded", &PathFinder::isLoaded)
       .def_property_readonly("navigable_area", &PathFinder::getNavigableArea)
       .def("build_navmesh_vertices",
@@ -103,6 +182,9 @@ void initShortestPathBindings(py::module& m) {
            [](PathFinder& self) { return self.getNavMeshData()->ibo; })
       .def("load_nav_mesh", &PathFinder::loadNavMesh)
       .def("save_nav_mesh", &PathFinder::saveNavMesh, "path"_a)
+      .def_property_readonly(
+          "source_hash", &PathFinder::getSourceHash,
+          R"(Hash of the source mesh and NavMeshSettings the navmesh was built from. 0 if unknown.)")
       .def("distance_to_closest_obstacle",
            &PathFinder::distanceToClosestObstacle,
            R"(Returns the distance to the closest obstacle.)", "pt"_a,
@@ -112,6 +194,12 @@ void initShortestPathBindings(py::module& m) {
            R"(Returns the hit_pos, hit_normal and hit_dist of the surface point
           on the closest obstacle.)",
            "pt"_a, "max_search_radius"_a = 2.0)
+      .def("build_clearance_field", &PathFinder::buildClearanceField,
+           py::call_guard<py::gil_scoped_release>(),
+           R"(Precomputes distances to the closest obstacle every cell_size up to max_distance, which makes distance_to_closest_obstacle a lookup. It is saved and loaded together with the navmesh.)",
+           "cell_size"_a = 0.05, "max_distance"_a = 2.0)
+      .def_property_readonly("has_clearance_field",
+                             &PathFinder::hasClearanceField)
       .def("is_navigable", &PathFinder::isNavigable,
            R"(Checks to see if the agent can stand at the specified point.)",
            "pt"_a, "max_y_delta"_a = 0.5);
@@ -128,6 +216,17 @@ void initShortestPathBindings(py::module& m) {
   py::bind_vector<std::vector<GreedyGeodesicFollowerImpl::CODES>>(
       m, "VectorGreedyCodes");
 
+  py::class_<GreedyGeodesicFollowerImpl::CacheStats>(m,
+                                                    "GreedyFollowerCacheStats")
+      .def_readonly("geo_dist_hits",
+                    &GreedyGeodesicFollowerImpl::CacheStats::geoDistHits)
+      .def_readonly("geo_dist_misses",
+                    &GreedyGeodesicFollowerImpl::CacheStats::geoDistMisses)
+      .def_readonly("try_step_hits",
+                    &GreedyGeodesicFollowerImpl::CacheStats::tryStepHits)
+      .def_readonly("try_step_misses",
+                    &GreedyGeodesicFollowerImpl::CacheStats::tryStepMisses);
+
   py::class_<GreedyGeodesicFollowerImpl, GreedyGeodesicFollowerImpl::ptr>(
       m, "GreedyGeodesicFollowerImpl")
       .def(py::init(&GreedyGeodesicFollowerImpl::create<
@@ -153,7 +252,15 @@ void initShortestPathBindings(py::module& m) {
            py::overload_cast<const core::RigidState&, const Mn::Vector3&>(
                &GreedyGeodesicFollowerImpl::findPath),
            py::return_value_policy::move)
-      .def("reset", &GreedyGeodesicFollowerImpl::reset);
+      .def("reset", &GreedyGeodesicFollowerImpl::reset)
+      .def_property_readonly("cache_stats",
+                             &GreedyGeodesicFollowerImpl::getCacheStats,
+                             R"(Hit and miss counts of the planning caches.)")
+      .def("reset_cache_stats", &GreedyGeodesicFollowerImpl::resetCacheStats)
+      .def_property("try_step_cache_enabled",
+                    &GreedyGeodesicFollowerImpl::isTryStepCacheEnabled,
+                    &GreedyGeodesicFollowerImpl::setTryStepCacheEnabled,
+                    R"(Whether simulated forward steps are cached by pose. Disable if the move functions have actuation noise.)");
 }
 
 }  // namespace nav
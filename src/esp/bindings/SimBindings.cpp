@@ -11,10 +11,12 @@
 #include <Magnum/PythonBindings.h>
 #include <Magnum/SceneGraph/PythonBindings.h>
 
+#include "esp/core/Check.h"
 #include "esp/gfx/RenderCamera.h"
 #include "esp/gfx/Renderer.h"
 #include "esp/gfx/replay/ReplayManager.h"
 #include "esp/scene/SemanticScene.h"
+#include "esp/sensor/ObservationArena.h"
 #include "esp/sim/Simulator.h"
 #include "esp/sim/SimulatorConfiguration.h"
 
@@ -47,6 +49,12 @@ void initSimBindings(py::module& m) {
       .def_readwrite("allow_sliding", &SimulatorConfiguration::allowSliding)
       .def_readwrite("create_renderer", &SimulatorConfiguration::createRenderer)
       .def_readwrite("frustum_culling", &SimulatorConfiguration::frustumCulling)
+      .def_readwrite(
+          "pipelined_observations",
+          &SimulatorConfiguration::pipelinedObservations,
+          R"(Read visual sensor observations back asynchronously. Each observation of a
+          sensor is then the one drawn by the previous request for that sensor, which
+          avoids stalling the GPU.)")
       .def_readwrite("enable_physics", &SimulatorConfiguration::enablePhysics)
       .def_readwrite(
           "enable_gfx_replay_save",
@@ -110,6 +118,44 @@ void initSimBindings(py::module& m) {
       .def_property("frustum_culling", &Simulator::isFrustumCullingEnabled,
                     &Simulator::setFrustumCullingEnabled,
                     R"(Enable or disable the frustum culling)")
+      .def_property(
+          "pipelined_observations", &Simulator::isPipelinedObservationsEnabled,
+          &Simulator::setPipelinedObservationsEnabled,
+          R"(Enable or disable pipelined observations. See SimulatorConfiguration.pipelined_observations.)")
+      .def("fill_sensor_observations", &Simulator::getSensorObservations,
+           R"(Draw the visual sensors in the subtree of scene_node and read their
+           observations into observation batch_index of each slot of arena.)",
+           "scene_node"_a, "arena"_a, "batch_index"_a = 0)
+      .def_static(
+          "fill_batched_sensor_observations",
+          [](const std::vector<Simulator*>& simulators,
+             const std::vector<scene::SceneNode*>& sceneNodes,
+             sensor::ObservationArena& arena) {
+            ESP_CHECK(simulators.size() == sceneNodes.size() &&
+                          simulators.size() <= arena.batchSize(),
+                      "fill_batched_sensor_observations(): expected as many "
+                      "scene nodes as simulators and at most"
+                          << arena.batchSize() << "of each but got"
+                          << simulators.size() << "and" << sceneNodes.size());
+            std::vector<std::reference_wrapper<Simulator>> sims;
+            std::vector<std::reference_wrapper<scene::SceneNode>> nodes;
+            for (Simulator* sim : simulators) {
+              ESP_CHECK(sim, "fill_batched_sensor_observations(): simulators "
+                             "can't be None");
+              sims.emplace_back(*sim);
+            }
+            for (scene::SceneNode* node : sceneNodes) {
+              ESP_CHECK(node, "fill_batched_sensor_observations(): scene "
+                              "nodes can't be None");
+              nodes.emplace_back(*node);
+            }
+            return Simulator::getBatchedSensorObservations(sims, nodes, arena);
+          },
+          R"(Draw the visual sensors in the subtree of scene_nodes[i] in simulators[i] for
+          every i and read their observations into observation i of each slot of arena,
+          whose batch size must be at least the number of simulators. Observations past
+          the last simulator are left as they are.)",
+          "simulators"_a, "scene_nodes"_a, "arena"_a)
       .def_property(
           "active_dataset", &Simulator::getActiveSceneDatasetName,
           &Simulator::setActiveSceneDatasetName,
@@ -383,6 +429,9 @@ void initSimBindings(py::module& m) {
           "recompute_navmesh", &Simulator::recomputeNavMesh, "pathfinder"_a,
           "navmesh_settings"_a, "include_static_objects"_a = false,
           R"(Recompute the NavMesh for a given PathFinder instance using configured NavMeshSettings. Optionally include all MotionType::STATIC objects in the navigability constraints.)")
+      .def(
+          "update_navmesh", &Simulator::updateNavMesh, "pathfinder"_a,
+          R"(Update the NavMesh last computed by recompute_navmesh after MotionType::STATIC objects were added, removed or moved. Only rebuilds the tiles around changed objects if the NavMeshSettings used tiles.)")
 #ifdef ESP_BUILD_WITH_VHACD
       .def(
           "apply_convex_hull_decomposition",
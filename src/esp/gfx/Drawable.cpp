@@ -39,5 +39,15 @@ DrawableGroup* Drawable::drawables() {
                  {});
   return static_cast<DrawableGroup*>(group);
 }
+
+DrawableGroup::DrawStateChanges Drawable::trackDrawState() {
+  DrawableGroup* group = drawables();
+  if (!group) {
+    return DrawableGroup::DrawStateChange::Shader |
+           DrawableGroup::DrawStateChange::LightSetup |
+           DrawableGroup::DrawStateChange::Material;
+  }
+  return group->trackDrawState(getDrawState());
+}
 }  // namespace gfx
 }  // namespace esp
@@ -8,6 +8,7 @@
 #include <Corrade/Containers/EnumSet.h>
 
 #include "esp/core/esp.h"
+#include "esp/gfx/DrawableGroup.h"
 #include "magnum.h"
 
 namespace esp {
@@ -16,8 +17,6 @@ class SceneNode;
 }
 namespace gfx {
 
-class DrawableGroup;
-
 /**
  * @brief Drawable for use with @ref DrawableGroup.
  *
@@ -87,7 +86,40 @@ class Drawable : public Magnum::SceneGraph::Drawable3D {
    */
   virtual Magnum::GL::Mesh& getVisualizerMesh() { return mesh_; }
 
+  /**
+   * @brief The state this drawable draws with, which its @ref DrawableGroup
+   * sorts the drawables by
+   *
+   * Only the mesh by default. Sub-classes that skip setting state shared with
+   * the previous drawable (see @ref DrawableGroup::trackDrawState()) should
+   * override this function.
+   */
+  virtual DrawableGroup::DrawState getDrawState() {
+    DrawableGroup::DrawState state;
+    state.mesh = &mesh_;
+    return state;
+  }
+
+  /**
+   * @brief Draw several drawables with a single instanced draw call
+   * @param instances   This drawable followed by others with the same @ref
+   *                    getDrawState(), and their transformations relative to
+   *                    the camera
+   * @param camera      Camera to draw from
+   * @return Whether the drawables were drawn. If not, e.g. because the
+   * drawable doesn't support instancing, which is the default, they have to
+   * be drawn one by one.
+   */
+  virtual bool drawInstances(
+      CORRADE_UNUSED Corrade::Containers::ArrayView<
+          const DrawableGroup::DrawableTransform> instances,
+      CORRADE_UNUSED Magnum::SceneGraph::Camera3D& camera) {
+    return false;
+  }
+
  protected:
+  friend class DrawableGroup;
+
   /**
    * @brief Draw the object using given camera
    *
@@ -100,11 +132,24 @@ class Drawable : public Magnum::SceneGraph::Drawable3D {
   void draw(const Magnum::Matrix4& transformationMatrix,
             Magnum::SceneGraph::Camera3D& camera) override = 0;
 
+  /**
+   * @brief Record the state this drawable is drawn with in its group
+   * @return The state that has to be set, see @ref
+   * DrawableGroup::trackDrawState()
+   *
+   * Drawables that don't skip setting any state should still call this, so
+   * that the next drawable sets its state in full.
+   */
+  DrawableGroup::DrawStateChanges trackDrawState();
+
   static uint64_t drawableIdCounter;
   uint64_t drawableId_;
 
   scene::SceneNode& node_;
   Magnum::GL::Mesh& mesh_;
+
+  // position in the draw order of the group, see DrawableGroup::sortForDraw()
+  std::size_t drawOrder_ = 0;
 };
 
 CORRADE_ENUMSET_OPERATORS(Drawable::Flags)
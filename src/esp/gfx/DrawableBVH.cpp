@@ -0,0 +1,252 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "DrawableBVH.h"
+
+#include <algorithm>
+
+#include "esp/scene/SceneNode.h"
+
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+
+namespace {
+
+// Leaves with more drawables are split
+const int MAX_LEAF_DRAWABLES = 4;
+
+enum class Containment { Outside, Intersecting, Inside };
+
+/**
+ * @brief Frustum test with temporal coherence, like rangeFrustum in
+ * RenderCamera.cpp, that also tells whether the box is fully inside
+ * @param range the axis-aligned bounding box
+ * @param frustum the frustum
+ * @param frustumPlaneIndex the plane that culled the box last time. Set to the
+ * plane that culls it now, if any.
+ */
+Containment testRangeFrustum(const Mn::Range3D& range,
+                             const Mn::Frustum& frustum,
+                             int& frustumPlaneIndex) {
+  const Mn::Vector3 center = range.min() + range.max();
+  const Mn::Vector3 extent = range.max() - range.min();
+
+  bool isInside = true;
+  for (int iPlane = 0; iPlane < 6; ++iPlane) {
+    int index = (iPlane + frustumPlaneIndex) % 6;
+    const Mn::Vector4& plane = frustum[index];
+
+    const Mn::Vector3 absPlaneNormal = Mn::Math::abs(plane.xyz());
+
+    const float d = Mn::Math::dot(center, plane.xyz());
+    const float r = Mn::Math::dot(extent, absPlaneNormal);
+    if (d + r < -2.0 * plane.w()) {
+      frustumPlaneIndex = index;
+      return Containment::Outside;
+    }
+    if (d - r < -2.0 * plane.w()) {
+      isInside = false;
+    }
+  }
+
+  return isInside ? Containment::Inside : Containment::Intersecting;
+}
+
+}  // namespace
+
+void DrawableBVH::build(Mn::SceneGraph::DrawableGroup3D& drawables) {
+  clear();
+  items_.reserve(drawables.size());
+  for (size_t i = 0; i < drawables.size(); ++i) {
+    Item item;
+    item.drawable = &drawables[i];
+    item.node = &static_cast<scene::SceneNode&>(drawables[i].object());
+    // This updates the AABB for dynamic objects if needed
+    item.node->setClean();
+    item.aabb = item.node->getAbsoluteAABB();
+    items_.push_back(item);
+  }
+
+  if (!items_.empty()) {
+    nodes_.reserve(2 * items_.size());
+    buildNode(0, items_.size(), ID_UNDEFINED);
+  }
+
+  // items_ were reordered by buildNode
+  for (int i = 0; i < int(items_.size()); ++i) {
+    itemIndices_[items_[i].drawable] = i;
+    if (!items_[i].node->hasStaticAABB()) {
+      dynamicItems_.push_back(i);
+    }
+  }
+  isBuilt_ = true;
+}
+
+int DrawableBVH::buildNode(int firstItem, int numItems, int parent) {
+  const int nodeIndex = nodes_.size();
+  nodes_.emplace_back();
+
+  Mn::Range3D aabb = items_[firstItem].aabb;
+  Mn::Vector3 minCenter = aabb.center();
+  Mn::Vector3 maxCenter = minCenter;
+  for (int i = firstItem + 1; i < firstItem + numItems; ++i) {
+    aabb = Mn::Math::join(aabb, items_[i].aabb);
+    const Mn::Vector3 center = items_[i].aabb.center();
+    minCenter = Mn::Math::min(minCenter, center);
+    maxCenter = Mn::Math::max(maxCenter, center);
+  }
+
+  int right = ID_UNDEFINED;
+  if (numItems > MAX_LEAF_DRAWABLES) {
+    // split at the median along the axis where the centers spread the most
+    const Mn::Vector3 spread = maxCenter - minCenter;
+    int axis = 0;
+    if (spread.y() > spread[axis])
+      axis = 1;
+    if (spread.z() > spread[axis])
+      axis = 2;
+    const int numLeftItems = numItems / 2;
+    auto begin = items_.begin() + firstItem;
+    std::nth_element(begin, begin + numLeftItems, begin + numItems,
+                     [axis](const Item& a, const Item& b) {
+                       return a.aabb.center()[axis] < b.aabb.center()[axis];
+                     });
+    buildNode(firstItem, numLeftItems, nodeIndex);
+    right =
+        buildNode(firstItem + numLeftItems, numItems - numLeftItems, nodeIndex);
+  } else {
+    for (int i = firstItem; i < firstItem + numItems; ++i) {
+      items_[i].leaf = nodeIndex;
+    }
+  }
+
+  Node& node = nodes_[nodeIndex];
+  node.aabb = aabb;
+  node.parent = parent;
+  node.right = right;
+  node.firstItem = firstItem;
+  node.numItems = numItems;
+  return nodeIndex;
+}
+
+void DrawableBVH::clear() {
+  items_.clear();
+  nodes_.clear();
+  dynamicItems_.clear();
+  itemIndices_.clear();
+  isBuilt_ = false;
+}
+
+void DrawableBVH::remove(const Mn::SceneGraph::Drawable3D& drawable) {
+  auto it = itemIndices_.find(&drawable);
+  if (it == itemIndices_.end()) {
+    return;
+  }
+  // The item keeps its AABB, so the nodes above it stay conservative
+  items_[it->second].drawable = nullptr;
+  itemIndices_.erase(it);
+}
+
+void DrawableBVH::refit() {
+  for (const int itemIndex : dynamicItems_) {
+    Item& item = items_[itemIndex];
+    if (!item.drawable) {
+      continue;
+    }
+    // This updates the AABB for dynamic objects if needed
+    item.node->setClean();
+    const Mn::Range3D& aabb = item.node->getAbsoluteAABB();
+    if (aabb != item.aabb) {
+      item.aabb = aabb;
+      refitNode(item.leaf);
+    }
+  }
+}
+
+void DrawableBVH::refitNode(int nodeIndex) {
+  while (nodeIndex != ID_UNDEFINED) {
+    Node& node = nodes_[nodeIndex];
+    Mn::Range3D aabb;
+    if (node.right == ID_UNDEFINED) {
+      aabb = items_[node.firstItem].aabb;
+      for (int i = node.firstItem + 1; i < node.firstItem + node.numItems;
+           ++i) {
+        aabb = Mn::Math::join(aabb, items_[i].aabb);
+      }
+    } else {
+      aabb =
+          Mn::Math::join(nodes_[nodeIndex + 1].aabb, nodes_[node.right].aabb);
+    }
+    if (aabb == node.aabb) {
+      // the ancestors don't change either
+      return;
+    }
+    node.aabb = aabb;
+    nodeIndex = node.parent;
+  }
+}
+
+void DrawableBVH::cull(
+    const Mn::Frustum& frustum,
+    std::vector<std::reference_wrapper<Mn::SceneGraph::Drawable3D>>&
+        visibleDrawables) {
+  visibleDrawables.clear();
+  if (nodes_.empty()) {
+    return;
+  }
+  refit();
+
+  stack_.clear();
+  stack_.push_back(0);
+  while (!stack_.empty()) {
+    const int nodeIndex = stack_.back();
+    stack_.pop_back();
+    Node& node = nodes_[nodeIndex];
+    const Containment containment =
+        testRangeFrustum(node.aabb, frustum, node.frustumPlaneIndex);
+    if (containment == Containment::Outside) {
+      continue;
+    }
+    if (containment == Containment::Inside) {
+      addItems(node, visibleDrawables);
+      continue;
+    }
+    if (node.right != ID_UNDEFINED) {
+      stack_.push_back(node.right);
+      stack_.push_back(nodeIndex + 1);
+      continue;
+    }
+
+    // a leaf straddling the frustum: test its drawables one by one
+    for (int i = node.firstItem; i < node.firstItem + node.numItems; ++i) {
+      const Item& item = items_[i];
+      if (!item.drawable) {
+        continue;
+      }
+      int frustumPlaneIndex = item.node->getFrustumPlaneIndex();
+      if (testRangeFrustum(item.aabb, frustum, frustumPlaneIndex) ==
+          Containment::Outside) {
+        item.node->setFrustumPlaneIndex(frustumPlaneIndex);
+      } else {
+        visibleDrawables.emplace_back(*item.drawable);
+      }
+    }
+  }
+}
+
+void DrawableBVH::addItems(
+    const Node& node,
+    std::vector<std::reference_wrapper<Mn::SceneGraph::Drawable3D>>&
+        visibleDrawables) const {
+  for (int i = node.firstItem; i < node.firstItem + node.numItems; ++i) {
+    if (items_[i].drawable) {
+      visibleDrawables.emplace_back(*items_[i].drawable);
+    }
+  }
+}
+
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,116 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_DRAWABLEBVH_H_
+#define ESP_GFX_DRAWABLEBVH_H_
+
+#include <Magnum/Math/Frustum.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/SceneGraph/Drawable.h>
+#include <Magnum/SceneGraph/SceneGraph.h>
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace scene {
+class SceneNode;
+}
+namespace gfx {
+
+/**
+ * @brief Bounding volume hierarchy over the absolute AABBs of a group of
+ * drawables, for frustum culling.
+ *
+ * The hierarchy is built once. Drawables of nodes with a static AABB (see
+ * @ref scene::SceneNode::setAbsoluteAABB) are assumed not to move. The AABBs
+ * of the other, dynamic drawables are updated on every @ref cull, and the
+ * hierarchy is refit around them. Culling then rejects or accepts whole
+ * subtrees at once, and only tests individual drawables in the leaves that
+ * straddle the frustum.
+ */
+class DrawableBVH {
+ public:
+  /**
+   * @brief Build the hierarchy over the drawables of @p drawables
+   */
+  void build(Magnum::SceneGraph::DrawableGroup3D& drawables);
+
+  /**
+   * @brief Forget the hierarchy, so it's built again before the next cull
+   */
+  void clear();
+
+  bool isBuilt() const { return isBuilt_; }
+
+  /**
+   * @brief Stop returning @p drawable, e.g. because it is being deleted.
+   * The hierarchy stays valid.
+   */
+  void remove(const Magnum::SceneGraph::Drawable3D& drawable);
+
+  /**
+   * @brief Find the drawables whose absolute AABB intersects a frustum
+   * @param frustum The frustum, in world space
+   * @param[out] visibleDrawables Is cleared and filled with the drawables
+   * that aren't culled
+   */
+  void cull(const Magnum::Frustum& frustum,
+            std::vector<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>>&
+                visibleDrawables);
+
+  int getNumNodes() const { return nodes_.size(); }
+
+  int getNumDrawables() const { return items_.size(); }
+
+  int getNumDynamicDrawables() const { return dynamicItems_.size(); }
+
+ private:
+  struct Item {
+    // nullptr once removed
+    Magnum::SceneGraph::Drawable3D* drawable = nullptr;
+    scene::SceneNode* node = nullptr;
+    Magnum::Range3D aabb;
+    // leaf node containing this item
+    int leaf = ID_UNDEFINED;
+  };
+
+  // Nodes are stored depth first, so the left child of node i is node i + 1.
+  // Every node covers a contiguous range of items_.
+  struct Node {
+    Magnum::Range3D aabb;
+    int parent = ID_UNDEFINED;
+    int right = ID_UNDEFINED;  // ID_UNDEFINED for leaves
+    int firstItem = 0;
+    int numItems = 0;
+    // the frustum plane that last culled this node
+    int frustumPlaneIndex = 0;
+  };
+
+  int buildNode(int firstItem, int numItems, int parent);
+  void refit();
+  void refitNode(int nodeIndex);
+  void addItems(const Node& node,
+                std::vector<
+                    std::reference_wrapper<Magnum::SceneGraph::Drawable3D>>&
+                    visibleDrawables) const;
+
+  std::vector<Item> items_;
+  std::vector<Node> nodes_;
+  std::vector<int> dynamicItems_;
+  std::unordered_map<const Magnum::SceneGraph::Drawable3D*, int> itemIndices_;
+  // traversal stack, kept to avoid allocating on every cull
+  std::vector<int> stack_;
+  bool isBuilt_ = false;
+
+  ESP_SMART_POINTERS(DrawableBVH)
+};
+
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_DRAWABLEBVH_H_
@@ -4,9 +4,24 @@
 #include "DrawableGroup.h"
 #include "Drawable.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <tuple>
+
 namespace esp {
 namespace gfx {
 
+namespace {
+// Orders the state by how expensive it is to change
+std::tuple<std::uintptr_t, std::uintptr_t, std::uintptr_t, std::uintptr_t>
+sortKey(const DrawableGroup::DrawState& state) {
+  return std::make_tuple(reinterpret_cast<std::uintptr_t>(state.shader),
+                         reinterpret_cast<std::uintptr_t>(state.lightSetup),
+                         reinterpret_cast<std::uintptr_t>(state.material),
+                         reinterpret_cast<std::uintptr_t>(state.mesh));
+}
+}  // namespace
+
 class Drawable;
 DrawableGroup& DrawableGroup::add(Drawable& drawable) {
   if (registerDrawable(drawable)) {
@@ -37,9 +52,137 @@ Drawable* DrawableGroup::getDrawable(uint64_t id) const {
   return nullptr;
 }
 
+void DrawableGroup::cull(
+    const Magnum::Frustum& frustum,
+    std::vector<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>>&
+        visibleDrawables) {
+  if (!bvh_.isBuilt()) {
+    bvh_.build(*this);
+  }
+  bvh_.cull(frustum, visibleDrawables);
+}
+
+bool DrawableGroup::prepareForDraw(const RenderCamera&) {
+  if (drawOrderDirty_) {
+    updateDrawOrder();
+  }
+  return true;
+}
+
+void DrawableGroup::updateDrawOrder() {
+  std::vector<std::pair<DrawState, Drawable*>> drawStates;
+  drawStates.reserve(idToDrawable_.size());
+  for (const auto& it : idToDrawable_) {
+    drawStates.emplace_back(it.second->getDrawState(), it.second);
+  }
+  // ties are broken by the id, so that the order doesn't depend on the
+  // iteration order of idToDrawable_
+  std::sort(drawStates.begin(), drawStates.end(),
+            [](const std::pair<DrawState, Drawable*>& a,
+               const std::pair<DrawState, Drawable*>& b) {
+              return std::make_pair(sortKey(a.first),
+                                    a.second->getDrawableId()) <
+                     std::make_pair(sortKey(b.first),
+                                    b.second->getDrawableId());
+            });
+  for (std::size_t i = 0; i < drawStates.size(); ++i) {
+    drawStates[i].second->drawOrder_ = i;
+  }
+  drawOrderDirty_ = false;
+}
+
+void DrawableGroup::sortForDraw(
+    std::vector<DrawableTransform>& drawableTransforms) {
+  if (drawOrderDirty_) {
+    updateDrawOrder();
+  }
+  // every drawable in the group is a gfx::Drawable, see Drawable::drawables()
+  std::sort(drawableTransforms.begin(), drawableTransforms.end(),
+            [](const DrawableTransform& a, const DrawableTransform& b) {
+              return static_cast<const Drawable&>(a.first.get()).drawOrder_ <
+                     static_cast<const Drawable&>(b.first.get()).drawOrder_;
+            });
+  drawnState_ = DrawState{};
+}
+
+void DrawableGroup::draw(std::vector<DrawableTransform>& drawableTransforms,
+                         Magnum::SceneGraph::Camera3D& camera) {
+  std::size_t i = 0;
+  while (i < drawableTransforms.size()) {
+    auto& drawable = static_cast<Drawable&>(drawableTransforms[i].first.get());
+    // find the drawables drawn with the same state as this one, which the
+    // sorting put right after it
+    std::size_t end = i + 1;
+    if (instancingEnabled_) {
+      const DrawState state = drawable.getDrawState();
+      while (state.shader && end < drawableTransforms.size()) {
+        const DrawState other =
+            static_cast<Drawable&>(drawableTransforms[end].first.get())
+                .getDrawState();
+        if (other.shader != state.shader ||
+            other.lightSetup != state.lightSetup ||
+            other.material != state.material || other.mesh != state.mesh) {
+          break;
+        }
+        ++end;
+      }
+    }
+
+    if (end - i > 1 &&
+        drawable.drawInstances({drawableTransforms.data() + i, end - i},
+                               camera)) {
+      ++drawStatistics_.instancedDrawCalls;
+      drawStatistics_.instances += end - i;
+      i = end;
+      continue;
+    }
+    for (; i < end; ++i) {
+      drawableTransforms[i].first.get().draw(drawableTransforms[i].second,
+                                             camera);
+    }
+  }
+}
+
+Magnum::GL::Buffer& DrawableGroup::instanceBuffer() {
+  if (!instanceBuffer_.id()) {
+    instanceBuffer_ = Magnum::GL::Buffer{};
+  }
+  return instanceBuffer_;
+}
+
+DrawableGroup::DrawStateChanges DrawableGroup::trackDrawState(
+    const DrawState& state) {
+  DrawStateChanges changes;
+  // a drawable that doesn't track its state may have changed anything
+  if (!state.shader || state.shader != drawnState_.shader) {
+    changes = DrawStateChange::Shader | DrawStateChange::LightSetup |
+              DrawStateChange::Material;
+  } else {
+    if (state.lightSetup != drawnState_.lightSetup) {
+      changes |= DrawStateChange::LightSetup;
+    }
+    if (state.material != drawnState_.material) {
+      changes |= DrawStateChange::Material;
+    }
+  }
+  drawnState_ = state;
+
+  ++drawStatistics_.drawCalls;
+  if (changes & DrawStateChange::Shader) {
+    ++drawStatistics_.shaderChanges;
+  }
+  if (changes & DrawStateChange::Material) {
+    ++drawStatistics_.materialChanges;
+  }
+  return changes;
+}
+
 bool DrawableGroup::registerDrawable(Drawable& drawable) {
   // if it is already registered, emplace will do nothing
   if (idToDrawable_.emplace(drawable.getDrawableId(), &drawable).second) {
+    // rebuilt on the next cull
+    bvh_.clear();
+    drawOrderDirty_ = true;
     return true;
   }
   return false;
@@ -49,6 +192,7 @@ bool DrawableGroup::unregisterDrawable(Drawable& drawable) {
   if (idToDrawable_.erase(drawable.getDrawableId()) == 0) {
     return false;
   }
+  bvh_.remove(drawable);
   return true;
 }
 
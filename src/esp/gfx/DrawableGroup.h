@@ -5,12 +5,20 @@
 #ifndef ESP_GFX_DRAWABLEGROUP_H_
 #define ESP_GFX_DRAWABLEGROUP_H_
 
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Containers/EnumSet.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/Math/Matrix4.h>
 #include <Magnum/SceneGraph/Drawable.h>
 #include <Magnum/SceneGraph/FeatureGroup.h>
 #include <Magnum/SceneGraph/SceneGraph.h>
 #include <unordered_map>
 
+#include <cstdint>
 #include <functional>
+#include <utility>
+#include <vector>
+#include "DrawableBVH.h"
 #include "esp/core/esp.h"
 
 namespace esp {
@@ -24,6 +32,58 @@ class Drawable;
  */
 class DrawableGroup : public Magnum::SceneGraph::DrawableGroup3D {
  public:
+  /**
+   * @brief A drawable of the group and its transformation relative to the
+   * camera, as drawn by @ref Magnum::SceneGraph::Camera3D::draw()
+   */
+  typedef std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                    Magnum::Matrix4>
+      DrawableTransform;
+
+  /**
+   * @brief The GPU state a drawable draws with, by identity
+   *
+   * Drawables sharing a shader, light setup, material or mesh have the same
+   * pointer in the corresponding field. A null shader means that the drawable
+   * doesn't track its state, see @ref trackDrawState().
+   */
+  struct DrawState {
+    const void* shader = nullptr;
+    const void* lightSetup = nullptr;
+    const void* material = nullptr;
+    const void* mesh = nullptr;
+  };
+
+  /**
+   * @brief Part of the @ref DrawState that a drawable has to set again
+   */
+  enum class DrawStateChange : uint8_t {
+    /** The shader, and with it all of its uniforms */
+    Shader = 1 << 0,
+    /** The uniforms and textures that come from the light setup */
+    LightSetup = 1 << 1,
+    /** The uniforms and textures that come from the material */
+    Material = 1 << 2,
+  };
+  typedef Corrade::Containers::EnumSet<DrawStateChange> DrawStateChanges;
+
+  /**
+   * @brief Counters of the draws of the group, see @ref drawStatistics()
+   */
+  struct DrawStatistics {
+    /** Number of drawables drawn */
+    std::size_t drawCalls = 0;
+    /** Number of times a drawable switched to a different shader */
+    std::size_t shaderChanges = 0;
+    /** Number of times a drawable set its material again */
+    std::size_t materialChanges = 0;
+    /** Number of draw calls that drew several drawables at once, each of
+     * which is also counted in @ref drawCalls */
+    std::size_t instancedDrawCalls = 0;
+    /** Number of drawables drawn by the instanced draw calls */
+    std::size_t instances = 0;
+  };
+
   ~DrawableGroup() override;
 
   /**
@@ -60,9 +120,87 @@ class DrawableGroup : public Magnum::SceneGraph::DrawableGroup3D {
   /**
    * @brief Prepare to draw group with given @ref RenderCamera
    *
+   * Sorts the drawables by their @ref DrawState, if drawables were added or
+   * changed since the last sort, so that drawables sharing state are drawn
+   * one after the other, see @ref sortForDraw().
    * @return Whether the @ref DrawableGroup is in a valid state to be drawn
    */
-  virtual bool prepareForDraw(const RenderCamera&) { return true; }
+  virtual bool prepareForDraw(const RenderCamera&);
+
+  /**
+   * @brief Sort drawables to be drawn into the draw order of the group
+   *
+   * Also starts a new draw, so that the first drawable sets its state in full.
+   * @param drawableTransforms Drawables of this group and their
+   * transformations relative to the camera
+   */
+  void sortForDraw(std::vector<DrawableTransform>& drawableTransforms);
+
+  /**
+   * @brief Draw drawables of this group that were sorted by @ref
+   * sortForDraw()
+   *
+   * Consecutive drawables with the same @ref DrawState are drawn with a
+   * single instanced draw call where the drawables support it, see @ref
+   * Drawable::drawInstances(). The other drawables are drawn one by one.
+   */
+  void draw(std::vector<DrawableTransform>& drawableTransforms,
+            Magnum::SceneGraph::Camera3D& camera);
+
+  /**
+   * @brief Whether drawables sharing their state are drawn instanced, see
+   * @ref draw(). Enabled by default.
+   */
+  void setInstancingEnabled(bool enabled) { instancingEnabled_ = enabled; }
+
+  bool isInstancingEnabled() const { return instancingEnabled_; }
+
+  /**
+   * @brief Buffer for the per-instance data of an instanced draw call
+   *
+   * Shared by all instanced draws of the group. Created on first use, so
+   * groups can exist without a GL context.
+   */
+  Magnum::GL::Buffer& instanceBuffer();
+
+  /**
+   * @brief Sort the drawables again before the next draw, e.g. because the
+   * shader of a drawable changed
+   */
+  void setDrawOrderDirty() { drawOrderDirty_ = true; }
+
+  /**
+   * @brief Record that a drawable is drawn with @p state
+   * @return The parts of @p state that differ from the state of the previous
+   * drawable of the current draw, and so have to be set. Everything, if the
+   * shader differs or is null.
+   *
+   * Uniforms of a shader keep their values between draws, and textures stay
+   * bound, so a drawable only has to set those that changed.
+   */
+  DrawStateChanges trackDrawState(const DrawState& state);
+
+  /**
+   * @brief Draw calls and state changes since the last @ref
+   * resetDrawStatistics()
+   */
+  const DrawStatistics& drawStatistics() const { return drawStatistics_; }
+
+  void resetDrawStatistics() { drawStatistics_ = DrawStatistics{}; }
+
+  /**
+   * @brief Frustum-cull the drawables of the group
+   *
+   * Uses a @ref DrawableBVH, which is built on the first call after drawables
+   * were added to the group and refit to moved dynamic drawables on every
+   * call.
+   * @param frustum The camera frustum, in world space
+   * @param[out] visibleDrawables Drawables whose absolute AABB intersects the
+   * frustum
+   */
+  void cull(const Magnum::Frustum& frustum,
+            std::vector<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>>&
+                visibleDrawables);
 
  protected:
   /**
@@ -87,9 +225,26 @@ class DrawableGroup : public Magnum::SceneGraph::DrawableGroup3D {
    * a lookup table, that maps a drawable id to the drawable object
    */
   std::unordered_map<uint64_t, Drawable*> idToDrawable_;
+  /**
+   * hierarchy over the drawables' AABBs for culling
+   */
+  DrawableBVH bvh_;
+
+ private:
+  void updateDrawOrder();
+
+  bool drawOrderDirty_ = true;
+  // state of the drawable drawn last in the current draw
+  DrawState drawnState_;
+  DrawStatistics drawStatistics_;
+  bool instancingEnabled_ = true;
+  Magnum::GL::Buffer instanceBuffer_{Magnum::NoCreate};
+
   ESP_SMART_POINTERS(DrawableGroup)
 };
 
+CORRADE_ENUMSET_OPERATORS(DrawableGroup::DrawStateChanges)
+
 }  // namespace gfx
 }  // namespace esp
 
@@ -6,16 +6,31 @@
 
 #include <Corrade/Containers/ArrayViewStl.h>
 #include <Corrade/Utility/FormatStl.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/Mesh.h>
 #include <Magnum/Math/Color.h>
 #include <Magnum/Math/Matrix3.h>
 
 #include "esp/scene/SceneNode.h"
 
+namespace Cr = Corrade;
 namespace Mn = Magnum;
 
 namespace esp {
 namespace gfx {
 
+namespace {
+// Per-instance attributes of drawInstances(), matching the instanced
+// attributes of Mn::Shaders::PhongGL
+struct InstanceData {
+  Mn::Matrix4 transformationMatrix;
+  Mn::Matrix3x3 normalMatrix;
+  Mn::UnsignedInt objectId;
+};
+static_assert(sizeof(InstanceData) == 16 * 4 + 9 * 4 + 4,
+              "InstanceData must be tightly packed");
+}  // namespace
+
 GenericDrawable::GenericDrawable(scene::SceneNode& node,
                                  Mn::GL::Mesh& mesh,
                                  Drawable::Flags& meshAttributeFlags,
@@ -70,52 +85,103 @@ void GenericDrawable::setLightSetup(const Mn::ResourceKey& resourceKey) {
   updateShader();
 }
 
+DrawableGroup::DrawState GenericDrawable::getDrawState() {
+  updateShader();
+  DrawableGroup::DrawState state;
+  state.shader = &*shader_;
+  state.lightSetup = &*lightSetup_;
+  state.material = &*materialData_;
+  state.mesh = &mesh_;
+  return state;
+}
+
 void GenericDrawable::updateShaderLightingParameters(
+    Mn::Shaders::PhongGL& shader,
     const Mn::Matrix4& transformationMatrix,
-    Mn::SceneGraph::Camera3D& camera) {
+    Mn::SceneGraph::Camera3D& camera,
+    DrawableGroup::DrawStateChanges changes) {
   const Mn::Matrix4 cameraMatrix = camera.cameraMatrix();
 
+  // the positions depend on the transformation of the drawable if the lights
+  // are relative to the object, so they are always set
   std::vector<Mn::Vector4> lightPositions;
   lightPositions.reserve(lightSetup_->size());
-  std::vector<Mn::Color3> lightColors;
-  lightColors.reserve(lightSetup_->size());
-  std::vector<Mn::Color3> lightSpecularColors;
-  lightSpecularColors.reserve(lightSetup_->size());
-  constexpr float dummyRange = Mn::Constants::inf();
-  std::vector<float> lightRanges(lightSetup_->size(), dummyRange);
-  const Mn::Color4 ambientLightColor = getAmbientLightColor(*lightSetup_);
-
   for (Mn::UnsignedInt i = 0; i < lightSetup_->size(); ++i) {
     const auto& lightInfo = (*lightSetup_)[i];
     lightPositions.emplace_back(Mn::Vector4(getLightPositionRelativeToCamera(
         lightInfo, transformationMatrix, cameraMatrix)));
+  }
+  shader.setLightPositions(lightPositions);
 
-    const auto& lightColor = (*lightSetup_)[i].color;
-    lightColors.emplace_back(lightColor);
+  if (changes & DrawableGroup::DrawStateChange::LightSetup) {
+    std::vector<Mn::Color3> lightColors;
+    lightColors.reserve(lightSetup_->size());
+    std::vector<Mn::Color3> lightSpecularColors;
+    lightSpecularColors.reserve(lightSetup_->size());
+    constexpr float dummyRange = Mn::Constants::inf();
+    std::vector<float> lightRanges(lightSetup_->size(), dummyRange);
 
-    // In general, a light's specular color should match its base color.
-    // However, negative lights have zero (black) specular.
-    constexpr Mn::Color3 blackColor(0.0, 0.0, 0.0);
-    bool isNegativeLight = lightColor.x() < 0;
-    lightSpecularColors.emplace_back(isNegativeLight ? blackColor : lightColor);
+    for (Mn::UnsignedInt i = 0; i < lightSetup_->size(); ++i) {
+      const auto& lightColor = (*lightSetup_)[i].color;
+      lightColors.emplace_back(lightColor);
+
+      // In general, a light's specular color should match its base color.
+      // However, negative lights have zero (black) specular.
+      constexpr Mn::Color3 blackColor(0.0, 0.0, 0.0);
+      bool isNegativeLight = lightColor.x() < 0;
+      lightSpecularColors.emplace_back(isNegativeLight ? blackColor
+                                                       : lightColor);
+    }
+
+    shader.setLightColors(lightColors).setLightRanges(lightRanges);
   }
 
   // See documentation in src/deps/magnum/src/Magnum/Shaders/Phong.h
-  (*shader_)
-      .setAmbientColor(materialData_->ambientColor * ambientLightColor)
-      .setDiffuseColor(materialData_->diffuseColor)
-      .setSpecularColor(materialData_->specularColor)
-      .setShininess(materialData_->shininess)
-      .setLightPositions(lightPositions)
-      .setLightColors(lightColors)
-      .setLightRanges(lightRanges);
+  if (changes & (DrawableGroup::DrawStateChange::LightSetup |
+                 DrawableGroup::DrawStateChange::Material)) {
+    const Mn::Color4 ambientLightColor = getAmbientLightColor(*lightSetup_);
+    shader.setAmbientColor(materialData_->ambientColor * ambientLightColor);
+  }
+  if (changes & DrawableGroup::DrawStateChange::Material) {
+    shader.setDiffuseColor(materialData_->diffuseColor)
+        .setSpecularColor(materialData_->specularColor)
+        .setShininess(materialData_->shininess);
+  }
+}
+
+void GenericDrawable::updateShaderTextureParameters(
+    Mn::Shaders::PhongGL& shader,
+    DrawableGroup::DrawStateChanges changes) {
+  if (!(changes & DrawableGroup::DrawStateChange::Material)) {
+    return;
+  }
+  if ((flags_ & Mn::Shaders::PhongGL::Flag::TextureTransformation) &&
+      materialData_->textureMatrix != Mn::Matrix3{}) {
+    shader.setTextureMatrix(materialData_->textureMatrix);
+  }
+
+  if (flags_ & Mn::Shaders::PhongGL::Flag::AmbientTexture) {
+    shader.bindAmbientTexture(*(materialData_->ambientTexture));
+  }
+  if (flags_ & Mn::Shaders::PhongGL::Flag::DiffuseTexture) {
+    shader.bindDiffuseTexture(*(materialData_->diffuseTexture));
+  }
+  if (flags_ & Mn::Shaders::PhongGL::Flag::SpecularTexture) {
+    shader.bindSpecularTexture(*(materialData_->specularTexture));
+  }
+  if (flags_ & Mn::Shaders::PhongGL::Flag::NormalTexture) {
+    shader.bindNormalTexture(*(materialData_->normalTexture));
+  }
 }
 
 void GenericDrawable::draw(const Mn::Matrix4& transformationMatrix,
                            Mn::SceneGraph::Camera3D& camera) {
-  updateShader();
+  // updates the shader, and tells which uniforms and textures the previous
+  // drawable of the group didn't already set
+  const DrawableGroup::DrawStateChanges changes = trackDrawState();
 
-  updateShaderLightingParameters(transformationMatrix, camera);
+  updateShaderLightingParameters(*shader_, transformationMatrix, camera,
+                                 changes);
 
   (*shader_)
       // e.g., semantic mesh has its own per vertex annotation, which has been
@@ -126,51 +192,121 @@ void GenericDrawable::draw(const Mn::Matrix4& transformationMatrix,
               ? drawableId_
               : (materialData_->perVertexObjectId ? 0 : node_.getSemanticId()))
       .setTransformationMatrix(transformationMatrix)
-      .setProjectionMatrix(camera.projectionMatrix())
       .setNormalMatrix(transformationMatrix.normalMatrix());
 
-  if ((flags_ & Mn::Shaders::PhongGL::Flag::TextureTransformation) &&
-      materialData_->textureMatrix != Mn::Matrix3{}) {
-    shader_->setTextureMatrix(materialData_->textureMatrix);
+  // the projection is the same for all drawables of a draw
+  if (changes & DrawableGroup::DrawStateChange::Shader) {
+    shader_->setProjectionMatrix(camera.projectionMatrix());
   }
 
-  if (flags_ & Mn::Shaders::PhongGL::Flag::AmbientTexture) {
-    shader_->bindAmbientTexture(*(materialData_->ambientTexture));
+  updateShaderTextureParameters(*shader_, changes);
+
+  shader_->draw(mesh_);
+}
+
+bool GenericDrawable::drawInstances(
+    Cr::Containers::ArrayView<const DrawableGroup::DrawableTransform>
+        instances,
+    Mn::SceneGraph::Camera3D& camera) {
+#ifdef MAGNUM_TARGET_GLES2
+  return false;
+#else
+  DrawableGroup* group = drawables();
+  // semantic meshes already use the instanced object id attribute for their
+  // per-vertex ids
+  if (!group || materialData_->perVertexObjectId) {
+    return false;
   }
-  if (flags_ & Mn::Shaders::PhongGL::Flag::DiffuseTexture) {
-    shader_->bindDiffuseTexture(*(materialData_->diffuseTexture));
+  for (Mn::UnsignedInt i = 0; i < lightSetup_->size(); ++i) {
+    if ((*lightSetup_)[i].model == LightPositionModel::Object) {
+      return false;
+    }
   }
-  if (flags_ & Mn::Shaders::PhongGL::Flag::SpecularTexture) {
-    shader_->bindSpecularTexture(*(materialData_->specularTexture));
+
+  fetchShader(instancedShader_,
+              flags_ | Mn::Shaders::PhongGL::Flag::InstancedTransformation |
+                  Mn::Shaders::PhongGL::Flag::InstancedObjectId);
+
+  // all instances have the state of this drawable, so they are generic
+  // drawables as well
+  const bool useDrawableIds =
+      static_cast<RenderCamera&>(camera).useDrawableIds();
+  std::vector<InstanceData> instanceData;
+  instanceData.reserve(instances.size());
+  for (const DrawableGroup::DrawableTransform& instance : instances) {
+    const auto& drawable =
+        static_cast<const GenericDrawable&>(instance.first.get());
+    instanceData.push_back(
+        {instance.second, instance.second.normalMatrix(),
+         Mn::UnsignedInt(useDrawableIds ? drawable.drawableId_
+                                        : drawable.node_.getSemanticId())});
   }
-  if (flags_ & Mn::Shaders::PhongGL::Flag::NormalTexture) {
-    shader_->bindNormalTexture(*(materialData_->normalTexture));
+  Mn::GL::Buffer& instanceBuffer = group->instanceBuffer();
+  instanceBuffer.setData(instanceData, Mn::GL::BufferUsage::StreamDraw);
+  // the buffer is shared by all meshes of the group, so it is attached again
+  // on every draw
+  mesh_.addVertexBufferInstanced(instanceBuffer, 1, 0,
+                                 Mn::Shaders::PhongGL::TransformationMatrix{},
+                                 Mn::Shaders::PhongGL::NormalMatrix{},
+                                 Mn::Shaders::PhongGL::ObjectId{});
+
+  DrawableGroup::DrawState state = getDrawState();
+  state.shader = &*instancedShader_;
+  const DrawableGroup::DrawStateChanges changes = group->trackDrawState(state);
+
+  // the lights aren't relative to the object, so any transformation gives the
+  // same positions
+  updateShaderLightingParameters(*instancedShader_, instances[0].second,
+                                 camera, changes);
+  // the per-instance attributes are multiplied with the uniforms, which are
+  // left at their defaults: identity transformations and object id 0
+  if (changes & DrawableGroup::DrawStateChange::Shader) {
+    instancedShader_->setProjectionMatrix(camera.projectionMatrix());
   }
+  updateShaderTextureParameters(*instancedShader_, changes);
 
-  shader_->draw(mesh_);
+  mesh_.setInstanceCount(instances.size());
+  instancedShader_->draw(mesh_);
+  mesh_.setInstanceCount(1);
+  return true;
+#endif
 }
 
 void GenericDrawable::updateShader() {
+  if (fetchShader(shader_, flags_)) {
+    // the drawable is sorted by its shader
+    if (DrawableGroup* group = drawables()) {
+      group->setDrawOrderDirty();
+    }
+  }
+}
+
+bool GenericDrawable::fetchShader(
+    Mn::Resource<Mn::GL::AbstractShaderProgram, Mn::Shaders::PhongGL>& shader,
+    Mn::Shaders::PhongGL::Flags flags) {
   Mn::UnsignedInt lightCount = lightSetup_->size();
 
-  if (!shader_ || shader_->lightCount() != lightCount ||
-      shader_->flags() != flags_) {
-    // if the number of lights or flags have changed, we need to fetch a
-    // compatible shader
-    shader_ =
-        shaderManager_.get<Mn::GL::AbstractShaderProgram, Mn::Shaders::PhongGL>(
-            getShaderKey(lightCount, flags_));
-
-    // if no shader with desired number of lights and flags exists, create one
-    if (!shader_) {
-      shaderManager_.set<Mn::GL::AbstractShaderProgram>(
-          shader_.key(), new Mn::Shaders::PhongGL{flags_, lightCount},
-          Mn::ResourceDataState::Final, Mn::ResourcePolicy::ReferenceCounted);
-    }
+  if (shader && shader->lightCount() == lightCount &&
+      shader->flags() == flags) {
+    return false;
+  }
+
+  // if the number of lights or flags have changed, we need to fetch a
+  // compatible shader
+  shader =
+      shaderManager_.get<Mn::GL::AbstractShaderProgram, Mn::Shaders::PhongGL>(
+          getShaderKey(lightCount, flags));
 
-    CORRADE_INTERNAL_ASSERT(shader_ && shader_->lightCount() == lightCount &&
-                            shader_->flags() == flags_);
+  // if no shader with desired number of lights and flags exists, create one
+  if (!shader) {
+    shaderManager_.set<Mn::GL::AbstractShaderProgram>(
+        shader.key(), new Mn::Shaders::PhongGL{flags, lightCount},
+        Mn::ResourceDataState::Final, Mn::ResourcePolicy::ReferenceCounted);
   }
+
+  CORRADE_INTERNAL_ASSERT(shader && shader->lightCount() == lightCount &&
+                          shader->flags() == flags);
+  return true;
 }
 
 Mn::ResourceKey GenericDrawable::getShaderKey(
@@ -27,6 +27,25 @@ class GenericDrawable : public Drawable {
                            DrawableGroup* group = nullptr);
 
   void setLightSetup(const Magnum::ResourceKey& lightSetupKey) override;
+
+  DrawableGroup::DrawState getDrawState() override;
+
+  /**
+   * @brief Draw drawables sharing this drawable's mesh, material and light
+   * setup with a Phong shader that takes the transformation and object id of
+   * each drawable as instanced attributes
+   *
+   * Falls back to drawing one by one for materials with per-vertex object ids
+   * and for lights relative to the object, whose positions differ per
+   * drawable. The instanced object ids stay attached to the mesh afterwards,
+   * so a mesh drawn instanced shouldn't also be drawn with a per-vertex object
+   * id material.
+   */
+  bool drawInstances(
+      Corrade::Containers::ArrayView<const DrawableGroup::DrawableTransform>
+          instances,
+      Magnum::SceneGraph::Camera3D& camera) override;
+
   static constexpr const char* SHADER_KEY_TEMPLATE = "Phong-lights={}-flags={}";
 
  protected:
@@ -34,9 +53,21 @@ class GenericDrawable : public Drawable {
             Magnum::SceneGraph::Camera3D& camera) override;
 
   void updateShader();
+  /**
+   * @brief Fetch the shader for @p flags and the current light count into
+   * @p shader, if it doesn't match already
+   * @return Whether @p shader changed
+   */
+  bool fetchShader(Magnum::Resource<Magnum::GL::AbstractShaderProgram,
+                                    Magnum::Shaders::PhongGL>& shader,
+                   Magnum::Shaders::PhongGL::Flags flags);
   void updateShaderLightingParameters(
+      Magnum::Shaders::PhongGL& shader,
       const Magnum::Matrix4& transformationMatrix,
-      Magnum::SceneGraph::Camera3D& camera);
+      Magnum::SceneGraph::Camera3D& camera,
+      DrawableGroup::DrawStateChanges changes);
+  void updateShaderTextureParameters(Magnum::Shaders::PhongGL& shader,
+                                     DrawableGroup::DrawStateChanges changes);
 
   Magnum::ResourceKey getShaderKey(Magnum::UnsignedInt lightCount,
                                    Magnum::Shaders::PhongGL::Flags flags) const;
@@ -45,6 +76,9 @@ class GenericDrawable : public Drawable {
   ShaderManager& shaderManager_;
   Magnum::Resource<Magnum::GL::AbstractShaderProgram, Magnum::Shaders::PhongGL>
       shader_;
+  // shader for drawInstances(), fetched on first use
+  Magnum::Resource<Magnum::GL::AbstractShaderProgram, Magnum::Shaders::PhongGL>
+      instancedShader_;
   Magnum::Resource<MaterialData, PhongMaterialData> materialData_;
   Magnum::Resource<LightSetup> lightSetup_;
 
@@ -43,6 +43,8 @@ PTexMeshDrawable::PTexMeshDrawable(scene::SceneNode& node,
 
 void PTexMeshDrawable::draw(const Magnum::Matrix4& transformationMatrix,
                             Magnum::SceneGraph::Camera3D& camera) {
+  trackDrawState();
+
   (*shader_)
       .setExposure(exposure_)
       .setGamma(gamma_)
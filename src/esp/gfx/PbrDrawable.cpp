@@ -78,11 +78,24 @@ void PbrDrawable::setLightSetup(const Mn::ResourceKey& lightSetupKey) {
   lightSetup_ = shaderManager_.get<LightSetup>(lightSetupKey);
 }
 
+DrawableGroup::DrawState PbrDrawable::getDrawState() {
+  updateShader();
+  DrawableGroup::DrawState state;
+  state.shader = &*shader_;
+  state.lightSetup = &*lightSetup_;
+  state.material = &*materialData_;
+  state.mesh = &mesh_;
+  return state;
+}
+
 void PbrDrawable::draw(const Mn::Matrix4& transformationMatrix,
                        Mn::SceneGraph::Camera3D& camera) {
-  updateShader()
-      .updateShaderLightParameters()
-      .updateShaderLightDirectionParameters(transformationMatrix, camera);
+  // skip the uniforms and textures the previous drawable has set already
+  const DrawableGroup::DrawStateChanges changes = trackDrawState();
+  if (changes & DrawableGroup::DrawStateChange::LightSetup) {
+    updateShaderLightParameters();
+  }
+  updateShaderLightDirectionParameters(transformationMatrix, camera);
 
   // Assume that in a model, double-sided meshes are significantly less than
   // single-sided meshes.
@@ -105,44 +118,52 @@ void PbrDrawable::draw(const Mn::Matrix4& transformationMatrix,
               ? drawableId_
               : (materialData_->perVertexObjectId ? 0 : node_.getSemanticId()))
       .setTransformationMatrix(transformationMatrix)  // modelview matrix
-      .setProjectionMatrix(camera.projectionMatrix())
-      .setNormalMatrix(transformationMatrix.normalMatrix())
-      .setBaseColor(materialData_->baseColor)
-      .setRoughness(materialData_->roughness)
-      .setMetallic(materialData_->metallic)
-      .setEmissiveColor(materialData_->emissiveColor);
-
-  if ((flags_ & PbrShader::Flag::BaseColorTexture) &&
-      materialData_->baseColorTexture) {
-    shader_->bindBaseColorTexture(*materialData_->baseColorTexture);
-  }
-
-  if (flags_ &
-      (PbrShader::Flag::RoughnessTexture | PbrShader::Flag::MetallicTexture)) {
-    Magnum::GL::Texture2D* metallicRoughnessTexture =
-        materialData_->roughnessTexture;
-    if (!metallicRoughnessTexture) {
-      metallicRoughnessTexture = materialData_->metallicTexture;
-    }
-    CORRADE_ASSERT(metallicRoughnessTexture,
-                   "PbrDrawable::draw(): texture pointer cannot be nullptr if "
-                   "RoughnessTexture or MetallicTexture is enabled.", );
-    shader_->bindMetallicRoughnessTexture(*metallicRoughnessTexture);
-  }
+      .setNormalMatrix(transformationMatrix.normalMatrix());
 
-  if ((flags_ & PbrShader::Flag::NormalTexture) &&
-      materialData_->normalTexture) {
-    shader_->bindNormalTexture(*materialData_->normalTexture);
+  // the camera doesn't change during a draw
+  if (changes & DrawableGroup::DrawStateChange::Shader) {
+    shader_->setProjectionMatrix(camera.projectionMatrix());
   }
 
-  if ((flags_ & PbrShader::Flag::EmissiveTexture) &&
-      materialData_->emissiveTexture) {
-    shader_->bindEmissiveTexture(*materialData_->emissiveTexture);
-  }
+  if (changes & DrawableGroup::DrawStateChange::Material) {
+    (*shader_)
+        .setBaseColor(materialData_->baseColor)
+        .setRoughness(materialData_->roughness)
+        .setMetallic(materialData_->metallic)
+        .setEmissiveColor(materialData_->emissiveColor);
+
+    if ((flags_ & PbrShader::Flag::BaseColorTexture) &&
+        materialData_->baseColorTexture) {
+      shader_->bindBaseColorTexture(*materialData_->baseColorTexture);
+    }
 
-  if ((flags_ & PbrShader::Flag::TextureTransformation) &&
-      (materialData_->textureMatrix != Mn::Matrix3{})) {
-    shader_->setTextureMatrix(materialData_->textureMatrix);
+    if (flags_ & (PbrShader::Flag::RoughnessTexture |
+                  PbrShader::Flag::MetallicTexture)) {
+      Magnum::GL::Texture2D* metallicRoughnessTexture =
+          materialData_->roughnessTexture;
+      if (!metallicRoughnessTexture) {
+        metallicRoughnessTexture = materialData_->metallicTexture;
+      }
+      CORRADE_ASSERT(metallicRoughnessTexture,
+                     "PbrDrawable::draw(): texture pointer cannot be nullptr "
+                     "if RoughnessTexture or MetallicTexture is enabled.", );
+      shader_->bindMetallicRoughnessTexture(*metallicRoughnessTexture);
+    }
+
+    if ((flags_ & PbrShader::Flag::NormalTexture) &&
+        materialData_->normalTexture) {
+      shader_->bindNormalTexture(*materialData_->normalTexture);
+    }
+
+    if ((flags_ & PbrShader::Flag::EmissiveTexture) &&
+        materialData_->emissiveTexture) {
+      shader_->bindEmissiveTexture(*materialData_->emissiveTexture);
+    }
+
+    if ((flags_ & PbrShader::Flag::TextureTransformation) &&
+        (materialData_->textureMatrix != Mn::Matrix3{})) {
+      shader_->setTextureMatrix(materialData_->textureMatrix);
+    }
   }
 
   shader_->draw(mesh_);
@@ -173,6 +194,11 @@ PbrDrawable& PbrDrawable::updateShader() {
 
     CORRADE_INTERNAL_ASSERT(shader_ && shader_->lightCount() == lightCount &&
                             shader_->flags() == flags_);
+
+    // the draw order of the group depends on the shader
+    if (DrawableGroup* group = drawables()) {
+      group->setDrawOrderDirty();
+    }
   }
 
   return *this;
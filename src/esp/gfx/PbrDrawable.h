@@ -34,6 +34,8 @@ class PbrDrawable : public Drawable {
    */
   void setLightSetup(const Magnum::ResourceKey& lightSetupkey) override;
 
+  DrawableGroup::DrawState getDrawState() override;
+
   static constexpr const char* SHADER_KEY_TEMPLATE = "PBR-lights={}-flags={}";
 
  protected:
@@ -136,6 +136,41 @@ size_t RenderCamera::cull(
   return (newEndIter - drawableTransforms.begin());
 }
 
+std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                      Mn::Matrix4>>
+RenderCamera::drawableTransformations(
+    const std::vector<std::reference_wrapper<Mn::SceneGraph::Drawable3D>>&
+        drawables) {
+  std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
+                        Mn::Matrix4>>
+      drawableTransforms;
+  if (drawables.empty()) {
+    return drawableTransforms;
+  }
+
+  // Same as MagnumCamera::drawableTransformations, which only takes a group.
+  // Computing the transformations in one batch reuses those of shared parents.
+  std::vector<std::reference_wrapper<Mn::SceneGraph::AbstractObject3D>>
+      objects;
+  objects.reserve(drawables.size());
+  for (const auto& drawable : drawables) {
+    objects.emplace_back(drawable.get().object());
+  }
+  Mn::SceneGraph::AbstractObject3D* scene = node().scene();
+  CORRADE_ASSERT(scene,
+                 "RenderCamera::drawableTransformations(): the camera is not "
+                 "part of a scene",
+                 drawableTransforms);
+  const std::vector<Mn::Matrix4> transformations =
+      scene->transformationMatrices(objects, cameraMatrix());
+
+  drawableTransforms.reserve(drawables.size());
+  for (size_t i = 0; i < drawables.size(); ++i) {
+    drawableTransforms.emplace_back(drawables[i], transformations[i]);
+  }
+  return drawableTransforms;
+}
+
 size_t RenderCamera::removeNonObjects(
     std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
                           Mn::Matrix4>>& drawableTransforms) {
@@ -155,7 +190,8 @@ size_t RenderCamera::removeNonObjects(
 
 uint32_t RenderCamera::draw(MagnumDrawableGroup& drawables, Flags flags) {
   previousNumVisibleDrawables_ = drawables.size();
-  if (flags == Flags()) {  // empty set
+  auto* group = dynamic_cast<DrawableGroup*>(&drawables);
+  if (flags == Flags() && !group) {  // empty set
     MagnumCamera::draw(drawables);
     return drawables.size();
   }
@@ -166,7 +202,18 @@ uint32_t RenderCamera::draw(MagnumDrawableGroup& drawables, Flags flags) {
 
   std::vector<std::pair<std::reference_wrapper<Mn::SceneGraph::Drawable3D>,
                         Mn::Matrix4>>
-      drawableTransforms = drawableTransformations(drawables);
+      drawableTransforms;
+  if ((flags & Flag::FrustumCulling) && group) {
+    // cull with the group's BVH first, so only the visible drawables need
+    // their transformations computed
+    std::vector<std::reference_wrapper<Mn::SceneGraph::Drawable3D>>
+        visibleDrawables;
+    group->cull(Mn::Frustum::fromMatrix(projectionMatrix() * cameraMatrix()),
+                visibleDrawables);
+    drawableTransforms = drawableTransformations(visibleDrawables);
+  } else {
+    drawableTransforms = drawableTransformations(drawables);
+  }
 
   if (flags & Flag::ObjectsOnly) {
     // draw just the OBJECTS
@@ -176,15 +223,27 @@ uint32_t RenderCamera::draw(MagnumDrawableGroup& drawables, Flags flags) {
   }
 
   if (flags & Flag::FrustumCulling) {
-    // draw just the visible part
-    previousNumVisibleDrawables_ = cull(drawableTransforms);
-    // erase all items that did not pass the frustum visibility test
-    drawableTransforms.erase(
-        drawableTransforms.begin() + previousNumVisibleDrawables_,
-        drawableTransforms.end());
+    if (!group) {
+      // draw just the visible part
+      size_t numVisibleDrawables = cull(drawableTransforms);
+      // erase all items that did not pass the frustum visibility test
+      drawableTransforms.erase(
+          drawableTransforms.begin() + numVisibleDrawables,
+          drawableTransforms.end());
+    }
+    previousNumVisibleDrawables_ = drawableTransforms.size();
   }
 
-  MagnumCamera::draw(drawableTransforms);
+  if (group) {
+    // drawables sharing a shader and material are drawn one after the other,
+    // so they can skip setting what the previous one set
+    group->sortForDraw(drawableTransforms);
+    // which also batches drawables sharing all of their state into instanced
+    // draws
+    group->draw(drawableTransforms, *this);
+  } else {
+    MagnumCamera::draw(drawableTransforms);
+  }
 
   // reset
   if (useDrawableIds_) {
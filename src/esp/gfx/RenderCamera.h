@@ -179,6 +179,10 @@ class RenderCamera : public MagnumCamera {
    * @param drawables a drawable group containing all the drawables
    * @param flags state flags to direct drawing
    * @return the number of drawables that are drawn
+   *
+   * The drawables of a @ref DrawableGroup are drawn in its draw order, see
+   * @ref DrawableGroup::sortForDraw(), and those sharing their state are
+   * drawn instanced, see @ref DrawableGroup::draw().
    */
   uint32_t draw(MagnumDrawableGroup& drawables, Flags flags = {});
 
@@ -196,6 +200,21 @@ class RenderCamera : public MagnumCamera {
               std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
                         Magnum::Matrix4>>& drawableTransforms);
 
+  using MagnumCamera::drawableTransformations;
+
+  /**
+   * @brief Compute the transformations of a subset of drawables relative to
+   * the camera, e.g. of the drawables that passed frustum culling
+   * @param drawables the drawables, which must be in the camera's scene
+   * @return a vector of pairs of Drawable3D object and its transformation
+   * relative to the camera
+   */
+  std::vector<std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>,
+                        Magnum::Matrix4>>
+  drawableTransformations(
+      const std::vector<
+          std::reference_wrapper<Magnum::SceneGraph::Drawable3D>>& drawables);
+
   /**
    * @brief Cull Drawables for SceneNodes which are not OBJECT type.
    *
@@ -2,8 +2,14 @@
 // This source code is licensed under the MIT license found in the
 // LICENSE file in the root directory of this source tree.
 
+#include <array>
+#include <utility>
+
+#include <Corrade/Utility/Algorithms.h>
 #include <Magnum/GL/Buffer.h>
+#ifndef MAGNUM_TARGET_WEBGL
 #include <Magnum/GL/BufferImage.h>
+#endif
 #include <Magnum/GL/DefaultFramebuffer.h>
 #include <Magnum/GL/Framebuffer.h>
 #include <Magnum/GL/PixelFormat.h>
@@ -43,6 +49,8 @@ const Mn::GL::Framebuffer::ColorAttachment ObjectIdTextureColorAttachment =
 const Mn::GL::Framebuffer::ColorAttachment UnprojectedDepthBufferAttachment =
     Mn::GL::Framebuffer::ColorAttachment{0};
 
+constexpr int RenderTarget::MaxPendingReads;
+
 struct RenderTarget::Impl {
   Impl(const Mn::Vector2i& size,
        const Mn::Vector2& depthUnprojection,
@@ -103,6 +111,14 @@ struct RenderTarget::Impl {
           Mn::GL::Framebuffer::BufferAttachment::Depth, unprojectedDepth_);
     }
 
+    mapForDraw();
+
+    CORRADE_INTERNAL_ASSERT(
+        framebuffer_.checkStatus(Mn::GL::FramebufferTarget::Draw) ==
+        Mn::GL::Framebuffer::Status::Complete);
+  }
+
+  void mapForDraw() {
     framebuffer_.mapForDraw(
         {{Mn::Shaders::GenericGL3D::ColorOutput,
           (flags_ & Flag::RgbaAttachment
@@ -112,10 +128,6 @@ struct RenderTarget::Impl {
           (flags_ & Flag::ObjectIdAttachment
                ? ObjectIdTextureColorAttachment
                : Mn::GL::Framebuffer::DrawAttachment::None)}});
-
-    CORRADE_INTERNAL_ASSERT(
-        framebuffer_.checkStatus(Mn::GL::FramebufferTarget::Draw) ==
-        Mn::GL::Framebuffer::Status::Complete);
   }
 
   void initDepthUnprojector() {
@@ -198,6 +210,43 @@ struct RenderTarget::Impl {
         Mn::GL::FramebufferBlitFilter::Nearest);
   }
 
+  void blitTo(Impl& target, Flags attachments) {
+    CORRADE_ASSERT(framebufferSize() == target.framebufferSize(),
+                   "RenderTarget::Impl::blitTo(): the render targets differ "
+                   "in size", );
+    CORRADE_ASSERT((flags_ & attachments) == attachments &&
+                       (target.flags_ & attachments) == attachments,
+                   "RenderTarget::Impl::blitTo(): both render targets must "
+                   "have the attachments to copy", );
+    const Mn::Range2Di viewport = framebuffer_.viewport();
+
+    if (attachments & Flag::DepthTextureAttachment) {
+      Mn::GL::AbstractFramebuffer::blit(
+          framebuffer_, target.framebuffer_, viewport, viewport,
+          Mn::GL::FramebufferBlit::Depth,
+          Mn::GL::FramebufferBlitFilter::Nearest);
+    }
+    // a color blit writes to every draw buffer of the target, so only the
+    // attachment being copied is mapped for the duration of the blit
+    for (const auto& attachment :
+         {std::make_pair(Flag::RgbaAttachment, RgbaBufferAttachment),
+          std::make_pair(Flag::ObjectIdAttachment,
+                         ObjectIdTextureColorAttachment)}) {
+      if (!(attachments & attachment.first)) {
+        continue;
+      }
+      framebuffer_.mapForRead(attachment.second);
+      target.framebuffer_.mapForDraw(attachment.second);
+      Mn::GL::AbstractFramebuffer::blit(
+          framebuffer_, target.framebuffer_, viewport, viewport,
+          Mn::GL::FramebufferBlit::Color,
+          Mn::GL::FramebufferBlitFilter::Nearest);
+    }
+    target.mapForDraw();
+  }
+
+  Flags flags() const { return flags_; }
+
   void readFrameRgba(const Mn::MutableImageView2D& view) {
     CORRADE_ASSERT(flags_ & Flag::RgbaAttachment,
                    "RenderTarget::Impl::readFrameRgba(): this render target "
@@ -234,6 +283,78 @@ struct RenderTarget::Impl {
         .read(framebuffer_.viewport(), view);
   }
 
+#ifndef MAGNUM_TARGET_WEBGL
+  void readFrameRgbaAsync(Mn::PixelFormat format) {
+    CORRADE_ASSERT(
+        flags_ & Flag::RgbaAttachment,
+        "RenderTarget::Impl::readFrameRgbaAsync(): this render target "
+        "was not created with rgba render buffer enabled.", );
+    framebuffer_.mapForRead(RgbaBufferAttachment);
+    readFrameAsync(framebuffer_, Mn::GL::pixelFormat(format),
+                   Mn::GL::pixelType(format), false);
+  }
+
+  void readFrameDepthAsync() {
+    CORRADE_ASSERT(
+        flags_ & Flag::DepthTextureAttachment,
+        "RenderTarget::Impl::readFrameDepthAsync(): this render target "
+        "was not created with depth texture enabled.", );
+    if (depthShader_) {
+      unprojectDepthGPU();
+      depthUnprojectionFrameBuffer_.mapForRead(
+          UnprojectedDepthBufferAttachment);
+      readFrameAsync(depthUnprojectionFrameBuffer_, Mn::GL::PixelFormat::Red,
+                     Mn::GL::PixelType::Float, false);
+    } else {
+      // unprojected on the CPU once the read is finished
+      readFrameAsync(framebuffer_, Mn::GL::PixelFormat::DepthComponent,
+                     Mn::GL::PixelType::Float, true);
+    }
+  }
+
+  void readFrameObjectIdAsync(Mn::PixelFormat format) {
+    CORRADE_ASSERT(
+        flags_ & Flag::ObjectIdAttachment,
+        "RenderTarget::Impl::readFrameObjectIdAsync(): this render target "
+        "was not created with objectId render texture enabled.", );
+    framebuffer_.mapForRead(ObjectIdTextureColorAttachment);
+    readFrameAsync(framebuffer_, Mn::GL::pixelFormat(format),
+                   Mn::GL::pixelType(format), false);
+  }
+
+  int numPendingReads() const { return numPendingReads_; }
+
+  void finishReadFrame(const Mn::MutableImageView2D& view) {
+    CORRADE_ASSERT(numPendingReads_ > 0,
+                   "RenderTarget::Impl::finishReadFrame(): there is no "
+                   "pending read.", );
+    AsyncRead& read = asyncReads_[firstPendingRead_];
+    firstPendingRead_ = (firstPendingRead_ + 1) % MaxPendingReads;
+    --numPendingReads_;
+
+    const std::size_t size = read.image.dataSize();
+    CORRADE_ASSERT(view.data().size() == size,
+                   "RenderTarget::Impl::finishReadFrame(): expected a view of"
+                       << size << "bytes but got" << view.data().size(), );
+    // waits for the transfer to complete, if it hasn't yet
+    Cr::Containers::ArrayView<char> data = read.image.buffer().map(
+        0, size, Mn::GL::Buffer::MapFlag::Read);
+    CORRADE_INTERNAL_ASSERT(data);
+    Cr::Utility::copy(data, view.data());
+    read.image.buffer().unmap();
+
+    if (read.unprojectDepth) {
+      unprojectDepth(depthUnprojection_,
+                     Cr::Containers::arrayCast<Mn::Float>(view.data()));
+    }
+  }
+
+  void discardPendingReads() {
+    firstPendingRead_ = 0;
+    numPendingReads_ = 0;
+  }
+#endif
+
   Mn::Vector2i framebufferSize() const {
     return framebuffer_.viewport().size();
   }
@@ -347,6 +468,36 @@ struct RenderTarget::Impl {
 #endif
 
  private:
+#ifndef MAGNUM_TARGET_WEBGL
+  // Issue a read of the currently mapped attachment of framebuffer into the
+  // next pixel buffer object of the ring
+  void readFrameAsync(Mn::GL::Framebuffer& framebuffer,
+                      Mn::GL::PixelFormat format,
+                      Mn::GL::PixelType type,
+                      bool unprojectDepth) {
+    CORRADE_ASSERT(numPendingReads_ < MaxPendingReads,
+                   "RenderTarget::Impl::readFrameAsync(): there are already"
+                       << MaxPendingReads << "pending reads.", );
+    AsyncRead& read = asyncReads_[(firstPendingRead_ + numPendingReads_) %
+                                  MaxPendingReads];
+    // the buffer is reused as long as the format doesn't change
+    if (!read.image.buffer().id() || read.image.format() != format ||
+        read.image.type() != type) {
+      read.image = Mn::GL::BufferImage2D{format, type};
+    }
+    framebuffer.read(framebuffer_.viewport(), read.image,
+                     Mn::GL::BufferUsage::StreamRead);
+    read.unprojectDepth = unprojectDepth;
+    ++numPendingReads_;
+  }
+
+  struct AsyncRead {
+    Mn::GL::BufferImage2D image{Mn::NoCreate};
+    // whether the depth has to be unprojected once the read is finished
+    bool unprojectDepth = false;
+  };
+#endif
+
   Mn::GL::Renderbuffer colorBuffer_;
   Mn::GL::Texture2D objectIdTexture_;
   Mn::GL::Texture2D depthRenderTexture_;
@@ -362,6 +513,13 @@ struct RenderTarget::Impl {
 
   const sensor::VisualSensor* visualSensor_ = nullptr;
 
+#ifndef MAGNUM_TARGET_WEBGL
+  // ring of pixel buffer objects for asynchronous reads
+  std::array<AsyncRead, MaxPendingReads> asyncReads_;
+  int firstPendingRead_ = 0;
+  int numPendingReads_ = 0;
+#endif
+
 #ifdef ESP_BUILD_WITH_CUDA
   cudaGraphicsResource_t colorBufferCugl_ = nullptr;
   cudaGraphicsResource_t objecIdBufferCugl_ = nullptr;
@@ -404,6 +562,40 @@ void RenderTarget::readFrameObjectId(const Mn::MutableImageView2D& view) {
   pimpl_->readFrameObjectId(view);
 }
 
+#ifndef MAGNUM_TARGET_WEBGL
+void RenderTarget::readFrameRgbaAsync(Mn::PixelFormat format) {
+  pimpl_->readFrameRgbaAsync(format);
+}
+
+void RenderTarget::readFrameDepthAsync() {
+  pimpl_->readFrameDepthAsync();
+}
+
+void RenderTarget::readFrameObjectIdAsync(Mn::PixelFormat format) {
+  pimpl_->readFrameObjectIdAsync(format);
+}
+
+int RenderTarget::numPendingReads() const {
+  return pimpl_->numPendingReads();
+}
+
+void RenderTarget::finishReadFrame(const Mn::MutableImageView2D& view) {
+  pimpl_->finishReadFrame(view);
+}
+
+void RenderTarget::discardPendingReads() {
+  pimpl_->discardPendingReads();
+}
+#endif
+
+void RenderTarget::blitTo(RenderTarget& target, Flags attachments) {
+  pimpl_->blitTo(*target.pimpl_, attachments);
+}
+
+RenderTarget::Flags RenderTarget::flags() const {
+  return pimpl_->flags();
+}
+
 void RenderTarget::blitRgbaToDefault() {
   pimpl_->blitRgbaToDefault();
 }
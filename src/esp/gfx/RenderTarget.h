@@ -7,6 +7,7 @@
 
 #include <Corrade/Containers/EnumSet.h>
 #include <Magnum/Magnum.h>
+#include <Magnum/PixelFormat.h>
 
 #include "esp/core/esp.h"
 
@@ -145,6 +146,87 @@ class RenderTarget {
    */
   void readFrameObjectId(const Magnum::MutableImageView2D& view);
 
+#ifndef MAGNUM_TARGET_WEBGL
+  /**
+   * @brief Maximum number of asynchronous reads that can be pending at once.
+   * See @ref readFrameRgbaAsync().
+   *
+   * Pixel buffer objects can't be mapped on WebGL, so the asynchronous reads
+   * are not available there. Use @ref readFrameRgba() and friends instead.
+   */
+  static constexpr int MaxPendingReads = 2;
+
+  /**
+   * @brief Start reading the RGBA rendering results into a pixel buffer
+   * object, without waiting for the GPU to finish rendering.
+   *
+   * The pixel buffer objects form a ring of @ref MaxPendingReads entries.
+   * Retrieve the results with @ref finishReadFrame(), in the order the reads
+   * were started. Finishing a read as late as possible, e.g. after the next
+   * frame has been drawn, avoids stalling the pipeline.
+   *
+   * @param format The pixel format to read the results as
+   */
+  void readFrameRgbaAsync(
+      Magnum::PixelFormat format = Magnum::PixelFormat::RGBA8Unorm);
+
+  /**
+   * @brief Start reading the depth rendering results into a pixel buffer
+   * object. See @ref readFrameRgbaAsync().
+   *
+   * The results are finished as @ref Magnum::PixelFormat::R32F. If the render
+   * target has no DepthShader, the depth is unprojected on the CPU in @ref
+   * finishReadFrame().
+   */
+  void readFrameDepthAsync();
+
+  /**
+   * @brief Start reading the ObjectID rendering results into a pixel buffer
+   * object. See @ref readFrameRgbaAsync() and @ref readFrameObjectId().
+   *
+   * @param format The pixel format to read the results as
+   */
+  void readFrameObjectIdAsync(
+      Magnum::PixelFormat format = Magnum::PixelFormat::R32UI);
+
+  /**
+   * @brief Number of reads started with @ref readFrameRgbaAsync(), @ref
+   * readFrameDepthAsync() or @ref readFrameObjectIdAsync() that were not
+   * finished yet
+   */
+  int numPendingReads() const;
+
+  /**
+   * @brief Retrieve the results of the oldest pending asynchronous read.
+   * Waits for the GPU if the results aren't available yet.
+   *
+   * @param[in, out] view Preallocated memory that will be populated with the
+   * result. Its size must match the size of the read.
+   */
+  void finishReadFrame(const Magnum::MutableImageView2D& view);
+
+  /**
+   * @brief Drop all pending asynchronous reads without retrieving them
+   */
+  void discardPendingReads();
+#endif
+
+  /**
+   * @brief Copy attachments of this render target into another one of the
+   * same size, e.g. to share a render pass between sensors with the same pose
+   * and projection.
+   *
+   * @param target      The render target to copy into
+   * @param attachments The attachments to copy. Both render targets must have
+   *                    them.
+   */
+  void blitTo(RenderTarget& target, Flags attachments);
+
+  /**
+   * @brief The flags the render target was created with
+   */
+  Flags flags() const;
+
   /**
    * @brief Blits the rgba buffer from internal FBO to default frame buffer
    * which in case of EmscriptenApplication will be a canvas element.
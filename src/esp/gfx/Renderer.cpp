@@ -4,6 +4,8 @@
 
 #include "Renderer.h"
 
+#include <algorithm>
+
 #include <Corrade/Containers/StridedArrayView.h>
 #include <Magnum/GL/Buffer.h>
 #include <Magnum/GL/BufferImage.h>
@@ -24,6 +26,7 @@
 #include "esp/gfx/RenderTarget.h"
 #include "esp/gfx/TextureVisualizerShader.h"
 #include "esp/gfx/magnum.h"
+#include "esp/sensor/CameraSensor.h"
 #include "esp/sensor/VisualSensor.h"
 #include "esp/sim/Simulator.h"
 
@@ -59,15 +62,56 @@ struct Renderer::Impl {
   }
 
   void draw(sensor::VisualSensor& visualSensor, sim::Simulator& sim) {
-    if (visualSensor.specification()->sensorType ==
-        sensor::SensorType::Semantic) {
-      ESP_CHECK(sim.semanticSceneExists(),
-                "Renderer::Impl::draw(): SemanticSensor observation requested "
-                "but no SemanticScene is loaded");
-    }
+    checkSemanticScene(visualSensor, sim);
     visualSensor.drawObservation(sim);
   }
 
+  void draw(const std::vector<std::reference_wrapper<sensor::VisualSensor>>&
+                visualSensors,
+            sim::Simulator& sim) {
+    // color sensors lead the shared passes, since they need the clear color
+    std::vector<std::reference_wrapper<sensor::VisualSensor>> sensors{
+        visualSensors};
+    std::stable_partition(
+        sensors.begin(), sensors.end(), [](const sensor::VisualSensor& s) {
+          return s.specification()->sensorType == sensor::SensorType::Color;
+        });
+
+    std::vector<bool> isDrawn(sensors.size(), false);
+    std::vector<size_t> followers;
+    for (size_t i = 0; i < sensors.size(); ++i) {
+      if (isDrawn[i]) {
+        continue;
+      }
+      sensor::VisualSensor& leader = sensors[i];
+      checkSemanticScene(leader, sim);
+
+      followers.clear();
+      RenderTarget::Flags followerAttachments;
+      for (size_t j = i + 1; j < sensors.size(); ++j) {
+        if (!isDrawn[j] && canShareRenderPass(leader, sensors[j], sim)) {
+          checkSemanticScene(sensors[j], sim);
+          followers.push_back(j);
+          followerAttachments |= renderTargetAttachment(sensors[j]);
+          isDrawn[j] = true;
+        }
+      }
+
+      const RenderTarget::Flags leaderFlags = leader.renderTarget().flags();
+      if ((leaderFlags & followerAttachments) != followerAttachments) {
+        // happens once, the leader keeps the new render target
+        createRenderTarget(leader, leaderFlags | followerAttachments);
+      }
+
+      leader.drawObservation(sim);
+      for (const size_t j : followers) {
+        sensor::VisualSensor& follower = sensors[j];
+        leader.renderTarget().blitTo(follower.renderTarget(),
+                                     renderTargetAttachment(follower));
+      }
+    }
+  }
+
   void visualize(sensor::VisualSensor& visualSensor,
                  float colorMapOffset,
                  float colorMapScale) {
@@ -185,12 +229,72 @@ struct Renderer::Impl {
         break;
     }
 
-    sensor.bindRenderTarget(RenderTarget::create_unique(
-        sensor.framebufferSize(), *depthUnprojection, depthShader_.get(),
-        renderTargetFlags, &sensor));
+    createRenderTarget(sensor, renderTargetFlags);
   }
 
  private:
+  void createRenderTarget(sensor::VisualSensor& sensor,
+                          RenderTarget::Flags renderTargetFlags) {
+    sensor.bindRenderTarget(RenderTarget::create_unique(
+        sensor.framebufferSize(), *sensor.depthUnprojection(),
+        depthShader_.get(), renderTargetFlags, &sensor));
+  }
+
+  static void checkSemanticScene(const sensor::VisualSensor& visualSensor,
+                                 const sim::Simulator& sim) {
+    if (visualSensor.specification()->sensorType ==
+        sensor::SensorType::Semantic) {
+      ESP_CHECK(sim.semanticSceneExists(),
+                "Renderer::Impl::draw(): SemanticSensor observation requested "
+                "but no SemanticScene is loaded");
+    }
+  }
+
+  // The attachment holding the observation of a sensor
+  static RenderTarget::Flag renderTargetAttachment(
+      const sensor::VisualSensor& visualSensor) {
+    switch (visualSensor.specification()->sensorType) {
+      case sensor::SensorType::Depth:
+        return RenderTarget::Flag::DepthTextureAttachment;
+      case sensor::SensorType::Semantic:
+        return RenderTarget::Flag::ObjectIdAttachment;
+      default:
+        return RenderTarget::Flag::RgbaAttachment;
+    }
+  }
+
+  // Whether the observation of follower can be copied from the render pass
+  // of leader
+  static bool canShareRenderPass(sensor::VisualSensor& leader,
+                                 sensor::VisualSensor& follower,
+                                 sim::Simulator& sim) {
+    // other sensors, e.g. fisheye ones, draw several passes
+    if (!dynamic_cast<sensor::CameraSensor*>(&leader) ||
+        !dynamic_cast<sensor::CameraSensor*>(&follower)) {
+      return false;
+    }
+    const sensor::SensorType leaderType = leader.specification()->sensorType;
+    const sensor::SensorType followerType =
+        follower.specification()->sensorType;
+    // a semantic sensor draws the semantic scene graph, if it is separate
+    if ((leaderType == sensor::SensorType::Semantic ||
+         followerType == sensor::SensorType::Semantic) &&
+        &sim.getActiveSemanticSceneGraph() != &sim.getActiveSceneGraph()) {
+      return false;
+    }
+    if (followerType == sensor::SensorType::Color &&
+        (leaderType != sensor::SensorType::Color ||
+         leader.specification()->clearColor !=
+             follower.specification()->clearColor)) {
+      return false;
+    }
+    return leader.framebufferSize() == follower.framebufferSize() &&
+           leader.getRenderCamera()->projectionMatrix() ==
+               follower.getRenderCamera()->projectionMatrix() &&
+           leader.node().absoluteTransformationMatrix() ==
+               follower.node().absoluteTransformationMatrix();
+  }
+
   // TODO: shall we use shader resource manager from now?
   std::unique_ptr<DepthShader> depthShader_;
   const Flags flags_;
@@ -269,6 +373,13 @@ void Renderer::draw(sensor::VisualSensor& visualSensor, sim::Simulator& sim) {
   pimpl_->draw(visualSensor, sim);
 }
 
+void Renderer::draw(
+    const std::vector<std::reference_wrapper<sensor::VisualSensor>>&
+        visualSensors,
+    sim::Simulator& sim) {
+  pimpl_->draw(visualSensors, sim);
+}
+
 void Renderer::bindRenderTarget(sensor::VisualSensor& sensor,
                                 Flags bindingFlags) {
   pimpl_->bindRenderTarget(sensor, bindingFlags);
@@ -5,6 +5,9 @@
 #ifndef ESP_GFX_RENDERER_H_
 #define ESP_GFX_RENDERER_H_
 
+#include <functional>
+#include <vector>
+
 #include "esp/core/esp.h"
 #include "esp/gfx/RenderCamera.h"
 #include "esp/scene/SceneGraph.h"
@@ -60,6 +63,22 @@ class Renderer {
    */
   void draw(sensor::VisualSensor& visualSensor, sim::Simulator& sim);
 
+  /**
+   * @brief draw the active scene in current sim using several visual sensors
+   *
+   * Camera sensors with the same pose and projection, e.g. the color, depth
+   * and semantic sensors of an agent, share a single pass: the scene is
+   * transformed, culled and drawn once, into a render target that has the
+   * attachments all of them need, which are then copied into the render
+   * targets of the others. The remaining sensors are drawn one by one.
+   * @param[in] visualSensors, the visual sensors, which must have render
+   * targets
+   * @param[in] sim, the simulator instance
+   */
+  void draw(const std::vector<std::reference_wrapper<sensor::VisualSensor>>&
+                visualSensors,
+            sim::Simulator& sim);
+
   /**
    * @brief visualize the observation of a non-rgb visual sensor, e.g., depth,
    * semantic
@@ -0,0 +1,803 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "KeyframeFile.h"
+
+#include <Corrade/Utility/Directory.h>
+#include <Corrade/Utility/String.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <unordered_map>
+
+#include "esp/core/esp.h"
+#include "esp/io/JsonAllTypes.h"
+#include "esp/io/json.h"
+
+namespace Cr = Corrade;
+
+namespace esp {
+namespace gfx {
+namespace replay {
+
+namespace {
+const uint32_t KEYFRAME_FILE_MAGIC =
+    'G' << 24 | 'F' << 16 | 'X' << 8 | 'R';  //'GFXR'
+// Version 1 wrote every field of every state update and the name of every
+// user transform. Version 2 leaves out unchanged rotations and semantic ids,
+// and writes each user transform name once per chunk.
+const uint32_t KEYFRAME_FILE_VERSION = 2;
+const uint32_t KEYFRAME_CHUNK_MAGIC =
+    'C' << 24 | 'H' << 16 | 'N' << 8 | 'K';  //'CHNK'
+
+struct KeyframeFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t reserved;
+};
+
+struct KeyframeChunkHeader {
+  uint32_t magic;
+  uint32_t numKeyframes;
+  uint64_t size;
+};
+
+// Instance translations are stored in multiples of this, in meters
+const float TRANSLATION_QUANTUM = 1e-4f;
+// Quaternions are stored as their three smallest components, which are at
+// most 1/sqrt(2) in magnitude
+const float ROTATION_COMPONENT_MAX = 0.70710678f;
+
+// Which fields of a state update are written, since version 2
+enum : uint32_t {
+  STATE_UPDATE_ROTATION = 1 << 0,
+  STATE_UPDATE_SEMANTIC_ID = 1 << 1,
+  STATE_UPDATE_ALL = STATE_UPDATE_ROTATION | STATE_UPDATE_SEMANTIC_ID
+};
+
+struct QuantizedRotation {
+  uint8_t largest = 0;
+  std::array<int16_t, 3> components{};
+
+  bool operator==(const QuantizedRotation& rhs) const {
+    return largest == rhs.largest && components == rhs.components;
+  }
+  bool operator!=(const QuantizedRotation& rhs) const {
+    return !(*this == rhs);
+  }
+};
+
+QuantizedRotation quantizeRotation(const Magnum::Quaternion& rotation) {
+  const Magnum::Quaternion q = rotation.normalized();
+  const float c[4] = {q.vector().x(), q.vector().y(), q.vector().z(),
+                      q.scalar()};
+  int largest = 0;
+  for (int i = 1; i < 4; ++i) {
+    if (std::abs(c[i]) > std::abs(c[largest]))
+      largest = i;
+  }
+  // q and -q are the same rotation, so the largest component can be made
+  // positive and left out
+  const float sign = c[largest] < 0 ? -1.0f : 1.0f;
+  QuantizedRotation quantized;
+  quantized.largest = uint8_t(largest);
+  int j = 0;
+  for (int i = 0; i < 4; ++i) {
+    if (i == largest)
+      continue;
+    const float normalized =
+        std::min(std::max(sign * c[i] / ROTATION_COMPONENT_MAX, -1.0f), 1.0f);
+    quantized.components[j++] = int16_t(std::lround(normalized * 32767.0f));
+  }
+  return quantized;
+}
+
+Magnum::Quaternion dequantizeRotation(const QuantizedRotation& quantized) {
+  float c[4];
+  float sumSquares = 0;
+  int j = 0;
+  for (int i = 0; i < 4; ++i) {
+    if (i == quantized.largest)
+      continue;
+    c[i] = quantized.components[j++] / 32767.0f * ROTATION_COMPONENT_MAX;
+    sumSquares += c[i] * c[i];
+  }
+  c[quantized.largest] = std::sqrt(std::max(0.0f, 1.0f - sumSquares));
+  return Magnum::Quaternion{{c[0], c[1], c[2]}, c[3]}.normalized();
+}
+
+class ByteWriter {
+ public:
+  explicit ByteWriter(std::vector<uint8_t>& bytes) : bytes_{bytes} {}
+
+  void writeUnsigned(uint64_t value) {
+    while (value >= 0x80) {
+      bytes_.push_back(uint8_t(value) | 0x80);
+      value >>= 7;
+    }
+    bytes_.push_back(uint8_t(value));
+  }
+
+  // Zig-zag coded, so small magnitudes take few bytes
+  void writeSigned(int64_t value) {
+    writeUnsigned((uint64_t(value) << 1) ^ uint64_t(value >> 63));
+  }
+
+  void writeBytes(const void* data, size_t size) {
+    const uint8_t* begin = static_cast<const uint8_t*>(data);
+    bytes_.insert(bytes_.end(), begin, begin + size);
+  }
+
+  void writeFloat(float value) { writeBytes(&value, sizeof(value)); }
+
+  void writeVector3(const Magnum::Vector3& value) {
+    writeBytes(value.data(), sizeof(value));
+  }
+
+  void writeQuaternion(const Magnum::Quaternion& value) {
+    writeVector3(value.vector());
+    writeFloat(value.scalar());
+  }
+
+  void writeString(const std::string& value) {
+    writeUnsigned(value.size());
+    writeBytes(value.data(), value.size());
+  }
+
+  void writeQuantizedRotation(const QuantizedRotation& rotation) {
+    bytes_.push_back(rotation.largest);
+    writeBytes(rotation.components.data(), sizeof(rotation.components));
+  }
+
+ private:
+  std::vector<uint8_t>& bytes_;
+};
+
+class ByteReader {
+ public:
+  ByteReader(const uint8_t* data, size_t size)
+      : data_{data}, end_{data + size} {}
+
+  // Reads past the end leave the reader failed and return zeros
+  bool failed() const { return failed_; }
+
+  uint64_t readUnsigned() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (!check(1))
+        return 0;
+      const uint8_t byte = *data_++;
+      value |= uint64_t(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return value;
+    }
+    failed_ = true;
+    return 0;
+  }
+
+  int64_t readSigned() {
+    const uint64_t value = readUnsigned();
+    return int64_t(value >> 1) ^ -int64_t(value & 1);
+  }
+
+  // Counts are bounded by the remaining bytes, so corrupt files can't cause
+  // huge allocations
+  size_t readCount() {
+    const uint64_t count = readUnsigned();
+    if (count > uint64_t(end_ - data_)) {
+      failed_ = true;
+      return 0;
+    }
+    return size_t(count);
+  }
+
+  void readBytes(void* data, size_t size) {
+    if (!check(size)) {
+      std::memset(data, 0, size);
+      return;
+    }
+    std::memcpy(data, data_, size);
+    data_ += size;
+  }
+
+  float readFloat() {
+    float value = 0;
+    readBytes(&value, sizeof(value));
+    return value;
+  }
+
+  Magnum::Vector3 readVector3() {
+    Magnum::Vector3 value;
+    readBytes(value.data(), sizeof(value));
+    return value;
+  }
+
+  Magnum::Quaternion readQuaternion() {
+    const Magnum::Vector3 vector = readVector3();
+    return Magnum::Quaternion{vector, readFloat()};
+  }
+
+  std::string readString() {
+    const size_t size = readCount();
+    if (!check(size))
+      return {};
+    std::string value(reinterpret_cast<const char*>(data_), size);
+    data_ += size;
+    return value;
+  }
+
+  QuantizedRotation readQuantizedRotation() {
+    QuantizedRotation rotation;
+    readBytes(&rotation.largest, 1);
+    readBytes(rotation.components.data(), sizeof(rotation.components));
+    if (rotation.largest > 3) {
+      failed_ = true;
+      return {};
+    }
+    return rotation;
+  }
+
+ private:
+  bool check(size_t size) {
+    if (failed_ || size > size_t(end_ - data_))
+      failed_ = true;
+    return !failed_;
+  }
+
+  const uint8_t* data_;
+  const uint8_t* end_;
+  bool failed_ = false;
+};
+
+// What was last written for an instance in the current chunk
+struct InstanceCodingState {
+  std::array<int64_t, 3> translation{};
+  QuantizedRotation rotation;
+  int semanticId = 0;
+};
+}  // namespace
+
+// Everything a chunk's keyframes are coded against. Reset for every chunk.
+struct KeyframeChunkState {
+  uint32_t version = KEYFRAME_FILE_VERSION;
+  std::unordered_map<RenderAssetInstanceKey, InstanceCodingState> instances;
+  // Interned user transform names: the writer looks up indices, the reader
+  // looks up names
+  std::unordered_map<std::string, uint32_t> nameIndices;
+  std::vector<std::string> names;
+
+  void clear() {
+    instances.clear();
+    nameIndices.clear();
+    names.clear();
+  }
+};
+
+namespace {
+
+void writeAssetInfo(ByteWriter& out, const esp::assets::AssetInfo& info) {
+  out.writeUnsigned(uint32_t(info.type));
+  out.writeString(info.filepath);
+  out.writeBytes(info.frame.up().data(), 3 * sizeof(float));
+  out.writeBytes(info.frame.front().data(), 3 * sizeof(float));
+  out.writeBytes(info.frame.origin().data(), 3 * sizeof(float));
+  out.writeFloat(info.virtualUnitToMeters);
+  out.writeUnsigned(info.requiresLighting);
+  out.writeUnsigned(info.splitInstanceMesh);
+}
+
+esp::assets::AssetInfo readAssetInfo(ByteReader& in) {
+  esp::assets::AssetInfo info;
+  info.type = esp::assets::AssetType(in.readUnsigned());
+  info.filepath = in.readString();
+  vec3f up, front, origin;
+  in.readBytes(up.data(), 3 * sizeof(float));
+  in.readBytes(front.data(), 3 * sizeof(float));
+  in.readBytes(origin.data(), 3 * sizeof(float));
+  info.frame = esp::geo::CoordinateFrame(up, front, origin);
+  info.virtualUnitToMeters = in.readFloat();
+  info.requiresLighting = in.readUnsigned();
+  info.splitInstanceMesh = in.readUnsigned();
+  return info;
+}
+
+void writeCreation(ByteWriter& out,
+                   const esp::assets::RenderAssetInstanceCreationInfo& x) {
+  out.writeString(x.filepath);
+  out.writeUnsigned(bool(x.scale));
+  if (x.scale)
+    out.writeVector3(*x.scale);
+  out.writeUnsigned(static_cast<unsigned int>(x.flags));
+  out.writeString(x.lightSetupKey);
+}
+
+esp::assets::RenderAssetInstanceCreationInfo readCreation(ByteReader& in) {
+  esp::assets::RenderAssetInstanceCreationInfo x;
+  x.filepath = in.readString();
+  if (in.readUnsigned())
+    x.scale = in.readVector3();
+  x.flags = esp::assets::RenderAssetInstanceCreationInfo::Flags(
+      esp::assets::RenderAssetInstanceCreationInfo::Flag(in.readUnsigned()));
+  x.lightSetupKey = in.readString();
+  return x;
+}
+
+void writeKeyframe(ByteWriter& out,
+                   const Keyframe& keyframe,
+                   KeyframeChunkState& chunkState) {
+  out.writeUnsigned(keyframe.loads.size());
+  for (const auto& info : keyframe.loads) {
+    writeAssetInfo(out, info);
+  }
+
+  out.writeUnsigned(keyframe.creations.size());
+  for (const auto& pair : keyframe.creations) {
+    out.writeSigned(pair.first);
+    writeCreation(out, pair.second);
+  }
+
+  out.writeUnsigned(keyframe.deletions.size());
+  for (const auto instanceKey : keyframe.deletions) {
+    out.writeSigned(instanceKey);
+  }
+
+  out.writeUnsigned(keyframe.stateUpdates.size());
+  for (const auto& pair : keyframe.stateUpdates) {
+    const auto& state = pair.second;
+    auto found = chunkState.instances.find(pair.first);
+    const bool isFirst = found == chunkState.instances.end();
+    InstanceCodingState& prev =
+        isFirst ? chunkState.instances[pair.first] : found->second;
+    const QuantizedRotation rotation =
+        quantizeRotation(state.absTransform.rotation);
+    uint32_t fields = STATE_UPDATE_ALL;
+    if (!isFirst) {
+      if (rotation == prev.rotation)
+        fields &= ~STATE_UPDATE_ROTATION;
+      if (state.semanticId == prev.semanticId)
+        fields &= ~STATE_UPDATE_SEMANTIC_ID;
+    }
+    out.writeSigned(pair.first);
+    out.writeUnsigned(fields);
+    // Instances move little between keyframes, so the deltas are small
+    for (int i = 0; i < 3; ++i) {
+      const int64_t quantized = std::llround(
+          double(state.absTransform.translation[i]) / TRANSLATION_QUANTUM);
+      out.writeSigned(quantized - prev.translation[i]);
+      prev.translation[i] = quantized;
+    }
+    if (fields & STATE_UPDATE_ROTATION) {
+      out.writeQuantizedRotation(rotation);
+      prev.rotation = rotation;
+    }
+    if (fields & STATE_UPDATE_SEMANTIC_ID) {
+      out.writeSigned(state.semanticId);
+      prev.semanticId = state.semanticId;
+    }
+  }
+
+  // Sorted by name, so files don't depend on the hash map's order
+  std::vector<const std::pair<const std::string, Transform>*> userTransforms;
+  for (const auto& pair : keyframe.userTransforms) {
+    userTransforms.push_back(&pair);
+  }
+  std::sort(userTransforms.begin(), userTransforms.end(),
+            [](const auto* a, const auto* b) { return a->first < b->first; });
+  out.writeUnsigned(userTransforms.size());
+  for (const auto* pair : userTransforms) {
+    // A name is written the first time it's used in the chunk and referred to
+    // by index after that. The next unused index marks a new name.
+    const uint32_t nextIndex = chunkState.nameIndices.size();
+    auto inserted = chunkState.nameIndices.emplace(pair->first, nextIndex);
+    out.writeUnsigned(inserted.first->second);
+    if (inserted.second)
+      out.writeString(pair->first);
+    out.writeVector3(pair->second.translation);
+    out.writeQuaternion(pair->second.rotation);
+  }
+}
+
+bool readKeyframe(ByteReader& in,
+                  Keyframe& keyframe,
+                  KeyframeChunkState& chunkState) {
+  keyframe = Keyframe{};
+  const size_t numLoads = in.readCount();
+  for (size_t i = 0; i < numLoads && !in.failed(); ++i) {
+    keyframe.loads.push_back(readAssetInfo(in));
+  }
+
+  const size_t numCreations = in.readCount();
+  for (size_t i = 0; i < numCreations && !in.failed(); ++i) {
+    const RenderAssetInstanceKey instanceKey = in.readSigned();
+    keyframe.creations.emplace_back(instanceKey, readCreation(in));
+  }
+
+  const size_t numDeletions = in.readCount();
+  for (size_t i = 0; i < numDeletions && !in.failed(); ++i) {
+    keyframe.deletions.push_back(in.readSigned());
+  }
+
+  const size_t numStateUpdates = in.readCount();
+  for (size_t i = 0; i < numStateUpdates && !in.failed(); ++i) {
+    const RenderAssetInstanceKey instanceKey = in.readSigned();
+    auto found = chunkState.instances.find(instanceKey);
+    const bool isFirst = found == chunkState.instances.end();
+    InstanceCodingState& prev =
+        isFirst ? chunkState.instances[instanceKey] : found->second;
+    const uint32_t fields =
+        chunkState.version >= 2 ? in.readUnsigned() : STATE_UPDATE_ALL;
+    // The first update of an instance in a chunk has every field
+    if (isFirst && fields != STATE_UPDATE_ALL)
+      return false;
+    RenderAssetInstanceState state;
+    for (int j = 0; j < 3; ++j) {
+      prev.translation[j] += in.readSigned();
+      state.absTransform.translation[j] =
+          float(double(prev.translation[j]) * TRANSLATION_QUANTUM);
+    }
+    if (fields & STATE_UPDATE_ROTATION)
+      prev.rotation = in.readQuantizedRotation();
+    if (fields & STATE_UPDATE_SEMANTIC_ID)
+      prev.semanticId = in.readSigned();
+    state.absTransform.rotation = dequantizeRotation(prev.rotation);
+    state.semanticId = prev.semanticId;
+    keyframe.stateUpdates.emplace_back(instanceKey, state);
+  }
+
+  const size_t numUserTransforms = in.readCount();
+  for (size_t i = 0; i < numUserTransforms && !in.failed(); ++i) {
+    std::string name;
+    if (chunkState.version >= 2) {
+      const uint64_t index = in.readUnsigned();
+      if (index == chunkState.names.size()) {
+        chunkState.names.push_back(in.readString());
+      } else if (index > chunkState.names.size()) {
+        return false;
+      }
+      name = chunkState.names[index];
+    } else {
+      name = in.readString();
+    }
+    Transform transform;
+    transform.translation = in.readVector3();
+    transform.rotation = in.readQuaternion();
+    keyframe.userTransforms[std::move(name)] = transform;
+  }
+
+  return !in.failed();
+}
+}  // namespace
+
+bool isBinaryKeyframeFilepath(const std::string& filepath) {
+  return Cr::Utility::String::endsWith(filepath, ".bin");
+}
+
+KeyframeWriter::KeyframeWriter(int keyframesPerChunk)
+    : keyframesPerChunk_{std::max(keyframesPerChunk, 1)},
+      chunkState_{std::make_unique<KeyframeChunkState>()} {}
+
+KeyframeWriter::~KeyframeWriter() {
+  close();
+}
+
+bool KeyframeWriter::open(const std::string& filepath) {
+  close();
+  file_ = fopen(filepath.c_str(), "wb");
+  if (!file_) {
+    LOG(ERROR) << "KeyframeWriter::open: could not create " << filepath;
+    return false;
+  }
+  filepath_ = filepath;
+
+  KeyframeFileHeader header{};
+  header.magic = KEYFRAME_FILE_MAGIC;
+  header.version = KEYFRAME_FILE_VERSION;
+  if (fwrite(&header, sizeof(header), 1, file_) != 1) {
+    LOG(ERROR) << "KeyframeWriter::open: could not write to " << filepath;
+    close();
+    return false;
+  }
+  return true;
+}
+
+void KeyframeWriter::writeKeyframe(const Keyframe& keyframe) {
+  ASSERT(isOpen());
+  ByteWriter out{chunk_};
+  replay::writeKeyframe(out, keyframe, *chunkState_);
+  if (++numChunkKeyframes_ >= keyframesPerChunk_)
+    flush();
+}
+
+void KeyframeWriter::flush() {
+  if (!file_ || numChunkKeyframes_ == 0)
+    return;
+
+  KeyframeChunkHeader header{};
+  header.magic = KEYFRAME_CHUNK_MAGIC;
+  header.numKeyframes = numChunkKeyframes_;
+  header.size = chunk_.size();
+  if (fwrite(&header, sizeof(header), 1, file_) != 1 ||
+      fwrite(chunk_.data(), 1, chunk_.size(), file_) != chunk_.size()) {
+    LOG(ERROR) << "KeyframeWriter::flush: could not write to " << filepath_;
+  }
+  // Readers see complete chunks even while the recording continues
+  fflush(file_);
+
+  chunk_.clear();
+  numChunkKeyframes_ = 0;
+  chunkState_->clear();
+}
+
+bool KeyframeWriter::close() {
+  if (!file_)
+    return true;
+  flush();
+  // ferror covers every fwrite and fflush since the file was opened
+  const bool hadError = ferror(file_) != 0;
+  const bool success = fclose(file_) == 0 && !hadError;
+  file_ = nullptr;
+  if (!success) {
+    LOG(ERROR) << "KeyframeWriter::close: could not write " << filepath_;
+  }
+  return success;
+}
+
+AsyncKeyframeWriter::AsyncKeyframeWriter(int maxQueuedKeyframes,
+                                         int keyframesPerChunk)
+    : writer_{keyframesPerChunk}, queue_(std::max(maxQueuedKeyframes, 0)) {}
+
+AsyncKeyframeWriter::~AsyncKeyframeWriter() {
+  close();
+}
+
+bool AsyncKeyframeWriter::open(const std::string& filepath) {
+  close();
+  if (!writer_.open(filepath)) {
+    return false;
+  }
+  isOpen_ = true;
+  if (!queue_.empty()) {
+    head_ = 0;
+    tail_ = 0;
+    thread_ = std::thread(&AsyncKeyframeWriter::run, this);
+  }
+  return true;
+}
+
+void AsyncKeyframeWriter::writeKeyframe(Keyframe&& keyframe) {
+  ASSERT(isOpen());
+  if (!thread_.joinable()) {
+    writer_.writeKeyframe(keyframe);
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock{mutex_};
+  if (tail_ - head_ >= queue_.size()) {
+    ++numStalls_;
+    notFull_.wait(lock, [&] { return tail_ - head_ < queue_.size(); });
+  }
+  // The thread only touches slots in [head_, tail_), so this slot can be
+  // filled without holding the lock
+  const size_t tail = tail_;
+  lock.unlock();
+  queue_[tail % queue_.size()] = std::move(keyframe);
+  lock.lock();
+  tail_ = tail + 1;
+  lock.unlock();
+  notEmpty_.notify_one();
+}
+
+bool AsyncKeyframeWriter::close() {
+  if (!isOpen_) {
+    return true;
+  }
+  bool success = true;
+  if (thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      closing_ = true;
+    }
+    notEmpty_.notify_one();
+    thread_.join();
+    closing_ = false;
+    success = closeSuccess_;
+  } else {
+    success = writer_.close();
+  }
+  isOpen_ = false;
+  return success;
+}
+
+void AsyncKeyframeWriter::run() {
+  std::unique_lock<std::mutex> lock{mutex_};
+  while (true) {
+    // closing_ is set after the last keyframe is queued, so everything queued
+    // is written before stopping
+    notEmpty_.wait(lock, [&] { return head_ != tail_ || closing_; });
+    if (head_ == tail_) {
+      break;
+    }
+    const size_t head = head_;
+    lock.unlock();
+
+    Keyframe& keyframe = queue_[head % queue_.size()];
+    writer_.writeKeyframe(keyframe);
+    // release the keyframe's memory before handing the slot back
+    keyframe = Keyframe{};
+
+    lock.lock();
+    head_ = head + 1;
+    notFull_.notify_one();
+  }
+  lock.unlock();
+  closeSuccess_ = writer_.close();
+}
+
+KeyframeReader::~KeyframeReader() {
+  if (file_)
+    fclose(file_);
+}
+
+bool KeyframeReader::isBinaryFile(const std::string& filepath) {
+  FILE* file = fopen(filepath.c_str(), "rb");
+  if (!file)
+    return false;
+  KeyframeFileHeader header{};
+  const bool isBinary = fread(&header, sizeof(header), 1, file) == 1 &&
+                        header.magic == KEYFRAME_FILE_MAGIC;
+  fclose(file);
+  return isBinary;
+}
+
+bool KeyframeReader::open(const std::string& filepath) {
+  if (file_)
+    fclose(file_);
+  chunks_.clear();
+  numKeyframes_ = 0;
+
+  file_ = fopen(filepath.c_str(), "rb");
+  if (!file_) {
+    LOG(ERROR) << "KeyframeReader::open: could not open " << filepath;
+    return false;
+  }
+  filepath_ = filepath;
+
+  KeyframeFileHeader header{};
+  if (fread(&header, sizeof(header), 1, file_) != 1 ||
+      header.magic != KEYFRAME_FILE_MAGIC ||
+      header.version < 1 || header.version > KEYFRAME_FILE_VERSION) {
+    LOG(ERROR) << "KeyframeReader::open: " << filepath
+               << " is not a keyframe file of a supported version";
+    fclose(file_);
+    file_ = nullptr;
+    return false;
+  }
+  version_ = header.version;
+
+  // Index the chunks by skipping over their contents
+  fseek(file_, 0, SEEK_END);
+  const int64_t fileSize = ftell(file_);
+  int64_t offset = sizeof(header);
+  while (offset + int64_t(sizeof(KeyframeChunkHeader)) <= fileSize) {
+    KeyframeChunkHeader chunkHeader{};
+    fseek(file_, offset, SEEK_SET);
+    if (fread(&chunkHeader, sizeof(chunkHeader), 1, file_) != 1 ||
+        chunkHeader.magic != KEYFRAME_CHUNK_MAGIC)
+      break;
+    offset += sizeof(chunkHeader);
+    if (chunkHeader.size > uint64_t(fileSize - offset))
+      break;
+    chunks_.push_back({offset, chunkHeader.size, numKeyframes_,
+                       int(chunkHeader.numKeyframes)});
+    numKeyframes_ += chunkHeader.numKeyframes;
+    offset += chunkHeader.size;
+  }
+  if (offset != fileSize) {
+    LOG(WARNING) << "KeyframeReader::open: ignoring truncated or invalid data "
+                    "at the end of "
+                 << filepath;
+  }
+  return true;
+}
+
+int KeyframeReader::findChunk(int keyframeIndex) const {
+  ASSERT(keyframeIndex >= 0 && keyframeIndex < numKeyframes_);
+  auto it = std::upper_bound(chunks_.begin(), chunks_.end(), keyframeIndex,
+                             [](int index, const Chunk& chunk) {
+                               return index < chunk.firstKeyframe;
+                             });
+  return int(it - chunks_.begin()) - 1;
+}
+
+bool KeyframeReader::readChunk(int chunkIndex,
+                               std::vector<Keyframe>& keyframes) {
+  ASSERT(file_);
+  ASSERT(chunkIndex >= 0 && chunkIndex < getNumChunks());
+  const Chunk& chunk = chunks_[chunkIndex];
+  std::vector<uint8_t> bytes(chunk.size);
+  if (fseek(file_, chunk.offset, SEEK_SET) != 0 ||
+      fread(bytes.data(), 1, bytes.size(), file_) != bytes.size()) {
+    LOG(ERROR) << "KeyframeReader::readChunk: could not read chunk "
+               << chunkIndex << " of " << filepath_;
+    return false;
+  }
+
+  ByteReader in{bytes.data(), bytes.size()};
+  KeyframeChunkState chunkState;
+  chunkState.version = version_;
+  keyframes.resize(chunk.numKeyframes);
+  for (auto& keyframe : keyframes) {
+    if (!readKeyframe(in, keyframe, chunkState)) {
+      LOG(ERROR) << "KeyframeReader::readChunk: chunk " << chunkIndex << " of "
+                 << filepath_ << " is invalid";
+      keyframes.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+bool readKeyframesFromFile(const std::string& filepath,
+                           std::vector<Keyframe>& keyframes) {
+  keyframes.clear();
+  if (KeyframeReader::isBinaryFile(filepath)) {
+    KeyframeReader reader;
+    if (!reader.open(filepath))
+      return false;
+    keyframes.reserve(reader.getNumKeyframes());
+    std::vector<Keyframe> chunk;
+    for (int i = 0; i < reader.getNumChunks(); ++i) {
+      if (!reader.readChunk(i, chunk))
+        return false;
+      std::move(chunk.begin(), chunk.end(), std::back_inserter(keyframes));
+    }
+    return true;
+  }
+
+  if (!Cr::Utility::Directory::exists(filepath)) {
+    LOG(ERROR) << "readKeyframesFromFile: file " << filepath << " not found.";
+    return false;
+  }
+  try {
+    auto document = esp::io::parseJsonFile(filepath);
+    esp::io::readMember(document, "keyframes", keyframes);
+  } catch (...) {
+    LOG(ERROR) << "readKeyframesFromFile: failed to parse keyframes from "
+               << filepath << ".";
+    return false;
+  }
+  return true;
+}
+
+bool writeKeyframesToFile(const std::string& filepath,
+                          const std::vector<Keyframe>& keyframes) {
+  if (isBinaryKeyframeFilepath(filepath)) {
+    KeyframeWriter writer;
+    if (!writer.open(filepath))
+      return false;
+    for (const auto& keyframe : keyframes) {
+      writer.writeKeyframe(keyframe);
+    }
+    return writer.close();
+  }
+
+  rapidjson::Document document(rapidjson::kObjectType);
+  rapidjson::Document::AllocatorType& allocator = document.GetAllocator();
+  esp::io::addMember(document, "keyframes", keyframes, allocator);
+  return esp::io::writeJsonToFile(document, filepath);
+}
+
+bool convertKeyframeFile(const std::string& inputFilepath,
+                         const std::string& outputFilepath) {
+  std::vector<Keyframe> keyframes;
+  return readKeyframesFromFile(inputFilepath, keyframes) &&
+         writeKeyframesToFile(outputFilepath, keyframes);
+}
+
+}  // namespace replay
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,253 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_REPLAY_KEYFRAMEFILE_H_
+#define ESP_GFX_REPLAY_KEYFRAMEFILE_H_
+
+#include "Keyframe.h"
+
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace esp {
+namespace gfx {
+namespace replay {
+
+/**
+ * @brief Whether keyframes written to @p filepath use the binary format,
+ * which is the case for the ".bin" extension. All other files are JSON.
+ */
+bool isBinaryKeyframeFilepath(const std::string& filepath);
+
+struct KeyframeChunkState;
+
+/**
+ * @brief Appends keyframes to a binary keyframe file.
+ *
+ * The file is a small header followed by chunks of keyframes. Each chunk is
+ * written as soon as it is full, so keyframes can be streamed to disk while
+ * they are recorded. Instance rotations are quantized to 16 bits per component
+ * and translations to 0.1 mm; translations are delta-coded against the
+ * previous state of the same instance in the chunk, and rotations and
+ * semantic ids are only written when they change. User transform names are
+ * written once per chunk and referred to by index after that. Everything else
+ * is stored losslessly. Chunks are independent, so a reader can decode any of
+ * them without reading the ones before it.
+ */
+class KeyframeWriter {
+ public:
+  /**
+   * @param keyframesPerChunk How many keyframes to buffer before a chunk is
+   * written
+   */
+  explicit KeyframeWriter(int keyframesPerChunk = 64);
+
+  ~KeyframeWriter();
+
+  /**
+   * @brief Create @p filepath, replacing an existing file, and write the
+   * header
+   */
+  bool open(const std::string& filepath);
+
+  bool isOpen() const { return file_ != nullptr; }
+
+  /**
+   * @brief Append a keyframe
+   */
+  void writeKeyframe(const Keyframe& keyframe);
+
+  /**
+   * @brief Write the buffered keyframes, if any, as a chunk
+   */
+  void flush();
+
+  /**
+   * @brief Flush and close the file
+   *
+   * @return false if anything written since @ref open failed to reach the
+   * file
+   */
+  bool close();
+
+ private:
+  const int keyframesPerChunk_;
+  FILE* file_ = nullptr;
+  std::string filepath_;
+  std::vector<uint8_t> chunk_;
+  int numChunkKeyframes_ = 0;
+  //! What the current chunk's keyframes are coded against
+  std::unique_ptr<KeyframeChunkState> chunkState_;
+
+  ESP_SMART_POINTERS(KeyframeWriter)
+};
+
+/**
+ * @brief A @ref KeyframeWriter that encodes and writes keyframes on a
+ * background thread.
+ *
+ * Keyframes are handed to the thread through a ring buffer guarded by a
+ * mutex. The lock is only held to update the queue's indices; keyframes are
+ * moved in and written out without it. At most maxQueuedKeyframes keyframes
+ * are queued; when the queue is full, @ref writeKeyframe blocks on a
+ * condition variable until the thread frees a slot, so memory use stays
+ * bounded. The thread likewise sleeps while the queue is empty. With
+ * maxQueuedKeyframes = 0 no thread is started and keyframes are written by
+ * the calling thread.
+ *
+ * All public functions must be called from the same thread.
+ */
+class AsyncKeyframeWriter {
+ public:
+  /**
+   * @param maxQueuedKeyframes How many keyframes may wait to be written
+   * @param keyframesPerChunk See @ref KeyframeWriter::KeyframeWriter
+   */
+  explicit AsyncKeyframeWriter(int maxQueuedKeyframes,
+                               int keyframesPerChunk = 64);
+
+  ~AsyncKeyframeWriter();
+
+  /**
+   * @brief Create @p filepath and start the writer thread
+   */
+  bool open(const std::string& filepath);
+
+  bool isOpen() const { return isOpen_; }
+
+  /**
+   * @brief Queue a keyframe to be written
+   */
+  void writeKeyframe(Keyframe&& keyframe);
+
+  /**
+   * @brief Write all queued keyframes, stop the writer thread, and close the
+   * file
+   *
+   * @return false if anything written since @ref open failed to reach the
+   * file. See @ref KeyframeWriter::close.
+   */
+  bool close();
+
+  /**
+   * @brief How many times @ref writeKeyframe had to wait for a free slot in
+   * the queue
+   */
+  int getNumStalls() const { return numStalls_; }
+
+ private:
+  void run();
+
+  KeyframeWriter writer_;
+  std::vector<Keyframe> queue_;
+  // Monotonic counts of keyframes taken by the thread and queued by the
+  // caller. Slot i % queue_.size() holds keyframe i. head_, tail_ and
+  // closing_ are guarded by mutex_.
+  size_t head_ = 0;
+  size_t tail_ = 0;
+  bool closing_ = false;
+  std::mutex mutex_;
+  // Signaled when the thread frees a slot
+  std::condition_variable notFull_;
+  // Signaled when the caller queues a keyframe or starts closing
+  std::condition_variable notEmpty_;
+  std::thread thread_;
+  // Result of closing writer_ on the thread, read after it is joined
+  bool closeSuccess_ = true;
+  bool isOpen_ = false;
+  int numStalls_ = 0;
+
+  ESP_SMART_POINTERS(AsyncKeyframeWriter)
+};
+
+/**
+ * @brief Reads a binary keyframe file written by @ref KeyframeWriter.
+ *
+ * Opening the file only reads the chunk headers. Chunks are decoded one at a
+ * time on request. A truncated last chunk, e.g. from a recording that was
+ * interrupted, is ignored.
+ */
+class KeyframeReader {
+ public:
+  ~KeyframeReader();
+
+  /**
+   * @brief Whether @p filepath starts with the header of a binary keyframe
+   * file
+   */
+  static bool isBinaryFile(const std::string& filepath);
+
+  /**
+   * @brief Open @p filepath and index its chunks
+   */
+  bool open(const std::string& filepath);
+
+  int getNumKeyframes() const { return numKeyframes_; }
+
+  int getNumChunks() const { return chunks_.size(); }
+
+  /**
+   * @brief Index of the chunk containing keyframe @p keyframeIndex
+   */
+  int findChunk(int keyframeIndex) const;
+
+  /**
+   * @brief Index of the first keyframe of chunk @p chunkIndex
+   */
+  int getChunkFirstKeyframe(int chunkIndex) const {
+    return chunks_[chunkIndex].firstKeyframe;
+  }
+
+  /**
+   * @brief Decode the keyframes of chunk @p chunkIndex into @p keyframes
+   */
+  bool readChunk(int chunkIndex, std::vector<Keyframe>& keyframes);
+
+ private:
+  struct Chunk {
+    int64_t offset;
+    uint64_t size;
+    int firstKeyframe;
+    int numKeyframes;
+  };
+
+  FILE* file_ = nullptr;
+  std::string filepath_;
+  std::vector<Chunk> chunks_;
+  int numKeyframes_ = 0;
+  uint32_t version_ = 0;
+
+  ESP_SMART_POINTERS(KeyframeReader)
+};
+
+/**
+ * @brief Read all keyframes of a JSON or binary keyframe file
+ */
+bool readKeyframesFromFile(const std::string& filepath,
+                           std::vector<Keyframe>& keyframes);
+
+/**
+ * @brief Write keyframes to a file, in the binary format if @ref
+ * isBinaryKeyframeFilepath or as JSON otherwise
+ */
+bool writeKeyframesToFile(const std::string& filepath,
+                          const std::vector<Keyframe>& keyframes);
+
+/**
+ * @brief Convert a keyframe file between the JSON and binary formats. The
+ * output format is chosen by @ref isBinaryKeyframeFilepath.
+ */
+bool convertKeyframeFile(const std::string& inputFilepath,
+                         const std::string& outputFilepath);
+
+}  // namespace replay
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_REPLAY_KEYFRAMEFILE_H_
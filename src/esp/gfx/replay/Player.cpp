@@ -10,6 +10,8 @@
 
 #include <rapidjson/document.h>
 
+#include <algorithm>
+
 namespace esp {
 namespace gfx {
 namespace replay {
@@ -19,12 +21,22 @@ void Player::readKeyframesFromJsonDocument(const rapidjson::Document& d) {
   esp::io::readMember(d, "keyframes", keyframes_);
 }
 
-Player::Player(const LoadAndCreateRenderAssetInstanceCallback& callback)
-    : loadAndCreateRenderAssetInstanceCallback(callback) {}
+Player::Player(const LoadAndCreateRenderAssetInstanceCallback& callback,
+               int keyframesPerSnapshot)
+    : loadAndCreateRenderAssetInstanceCallback(callback),
+      keyframesPerSnapshot_(keyframesPerSnapshot) {}
 
 void Player::readKeyframesFromFile(const std::string& filepath) {
   close();
 
+  if (KeyframeReader::isBinaryFile(filepath)) {
+    auto reader = KeyframeReader::create_unique();
+    if (reader->open(filepath)) {
+      reader_ = std::move(reader);
+    }
+    return;
+  }
+
   if (!Corrade::Utility::Directory::exists(filepath)) {
     LOG(ERROR) << "Player::readKeyframesFromFile: file " << filepath
                << " not found.";
@@ -49,19 +61,110 @@ int Player::getKeyframeIndex() const {
 }
 
 int Player::getNumKeyframes() const {
-  return keyframes_.size();
+  return reader_ ? reader_->getNumKeyframes() : keyframes_.size();
+}
+
+const Keyframe& Player::getKeyframe(int frameIndex) const {
+  if (!reader_) {
+    return keyframes_[frameIndex];
+  }
+  const int chunkIndex = reader_->findChunk(frameIndex);
+  if (chunkIndex != chunkIndex_) {
+    chunkIndex_ = ID_UNDEFINED;
+    if (!reader_->readChunk(chunkIndex, chunkKeyframes_)) {
+      // an unreadable chunk plays back as empty keyframes
+      static const Keyframe emptyKeyframe;
+      return emptyKeyframe;
+    }
+    chunkIndex_ = chunkIndex;
+  }
+  const int firstFrameIndex = reader_->getChunkFirstKeyframe(chunkIndex);
+  return chunkKeyframes_[frameIndex - firstFrameIndex];
+}
+
+void Player::resetSnapshots() {
+  snapshots_.clear();
+  trackedState_ = Snapshot{};
+  numTrackedChanges_ = 0;
+}
+
+void Player::extendSnapshots(int frameIndex) {
+  if (keyframesPerSnapshot_ <= 0) {
+    return;
+  }
+
+  // Track the scene state without instantiating anything
+  Snapshot& snapshot = trackedState_;
+  for (int i = snapshot.frameIndex + 1; i <= frameIndex; ++i) {
+    const auto& keyframe = getKeyframe(i);
+    for (const auto& assetInfo : keyframe.loads) {
+      snapshot.assetInfos[assetInfo.filepath] = assetInfo;
+    }
+    for (const auto& pair : keyframe.creations) {
+      snapshot.instances[pair.first] = Snapshot::Instance{pair.second, {}};
+    }
+    for (const auto& deletionInstanceKey : keyframe.deletions) {
+      snapshot.instances.erase(deletionInstanceKey);
+    }
+    for (const auto& pair : keyframe.stateUpdates) {
+      const auto& it = snapshot.instances.find(pair.first);
+      if (it != snapshot.instances.end()) {
+        it->second.state = pair.second;
+      }
+    }
+    for (const auto& pair : keyframe.userTransforms) {
+      snapshot.userTransforms[pair.first] = pair.second;
+    }
+    snapshot.frameIndex = i;
+    numTrackedChanges_ += keyframe.loads.size() + keyframe.creations.size() +
+                          keyframe.deletions.size() +
+                          keyframe.stateUpdates.size() +
+                          keyframe.userTransforms.size();
+
+    // Only store a snapshot once the keyframes since the last one hold at
+    // least as many changes as the snapshot, so snapshots never take more
+    // memory than the keyframes they stand for
+    const int lastFrameIndex =
+        snapshots_.empty() ? -1 : snapshots_.back().frameIndex;
+    const std::size_t snapshotSize = snapshot.assetInfos.size() +
+                                     snapshot.instances.size() +
+                                     snapshot.userTransforms.size();
+    if (i - lastFrameIndex >= keyframesPerSnapshot_ &&
+        numTrackedChanges_ >= snapshotSize) {
+      snapshots_.push_back(snapshot);
+      numTrackedChanges_ = 0;
+    }
+  }
+}
+
+const Player::Snapshot* Player::findSnapshot(int frameIndex) const {
+  auto it = std::upper_bound(snapshots_.begin(), snapshots_.end(), frameIndex,
+                             [](int index, const Snapshot& snapshot) {
+                               return index < snapshot.frameIndex;
+                             });
+  return it == snapshots_.begin() ? nullptr : &*(it - 1);
 }
 
 void Player::setKeyframeIndex(int frameIndex) {
   ASSERT(frameIndex == -1 ||
          (frameIndex >= 0 && frameIndex < getNumKeyframes()));
 
-  if (frameIndex < frameIndex_) {
+  // Snapshots are only taken up to the furthest keyframe played so far, so
+  // opening a file doesn't decode all of it
+  extendSnapshots(frameIndex);
+
+  // Jump to the closest snapshot unless playing forward from the current
+  // keyframe is shorter
+  const Snapshot* snapshot = findSnapshot(frameIndex);
+  if (snapshot &&
+      (frameIndex < frameIndex_ || snapshot->frameIndex > frameIndex_)) {
+    applySnapshot(*snapshot);
+  } else if (frameIndex < frameIndex_) {
     clearFrame();
   }
 
   while (frameIndex_ < frameIndex) {
-    applyKeyframe(keyframes_[++frameIndex_]);
+    applyKeyframe(getKeyframe(++frameIndex_));
   }
 }
 
@@ -71,9 +174,8 @@ bool Player::getUserTransform(const std::string& name,
   ASSERT(frameIndex_ >= 0 && frameIndex_ < getNumKeyframes());
   ASSERT(translation);
   ASSERT(rotation);
-  const auto& keyframe = keyframes_[frameIndex_];
-  const auto& it = keyframe.userTransforms.find(name);
-  if (it != keyframe.userTransforms.end()) {
+  const auto& it = userTransforms_.find(name);
+  if (it != userTransforms_.end()) {
     *translation = it->second.translation;
     *rotation = it->second.rotation;
     return true;
@@ -85,6 +187,10 @@ bool Player::getUserTransform(const std::string& name,
 void Player::close() {
   clearFrame();
   keyframes_.clear();
+  reader_ = nullptr;
+  resetSnapshots();
+  chunkKeyframes_.clear();
+  chunkIndex_ = ID_UNDEFINED;
 }
 
 void Player::clearFrame() {
@@ -96,9 +202,81 @@ void Player::clearFrame() {
   }
   createdInstances_.clear();
   assetInfos_.clear();
+  userTransforms_.clear();
   frameIndex_ = -1;
 }
 
+void Player::applySnapshot(const Snapshot& snapshot) {
+  assetInfos_.clear();
+  for (const auto& pair : snapshot.assetInfos) {
+    if (!failedFilepaths_.count(pair.first)) {
+      assetInfos_.insert(pair);
+    }
+  }
+
+  // Delete instances that don't exist in the snapshot. Instances without a
+  // state update are recreated, since their nodes may have moved since
+  // creation.
+  for (auto it = createdInstances_.begin(); it != createdInstances_.end();) {
+    const auto& snapshotIt = snapshot.instances.find(it->first);
+    if (snapshotIt == snapshot.instances.end() || !snapshotIt->second.state) {
+      delete it->second;
+      it = createdInstances_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  for (const auto& pair : snapshot.instances) {
+    const auto& instanceKey = pair.first;
+    const auto& instance = pair.second;
+    if (!createdInstances_.count(instanceKey) &&
+        !createInstance(instanceKey, instance.creation)) {
+      continue;
+    }
+    if (instance.state) {
+      applyInstanceState(createdInstances_[instanceKey], *instance.state);
+    }
+  }
+
+  userTransforms_ = snapshot.userTransforms;
+  frameIndex_ = snapshot.frameIndex;
+}
+
+bool Player::createInstance(
+    RenderAssetInstanceKey instanceKey,
+    const esp::assets::RenderAssetInstanceCreationInfo& creation) {
+  if (!assetInfos_.count(creation.filepath)) {
+    if (!failedFilepaths_.count(creation.filepath)) {
+      LOG(WARNING) << "Player: missing asset info for [" << creation.filepath
+                   << "]";
+      failedFilepaths_.insert(creation.filepath);
+    }
+    return false;
+  }
+  auto* node = loadAndCreateRenderAssetInstanceCallback(
+      assetInfos_[creation.filepath], creation);
+  if (!node) {
+    if (!failedFilepaths_.count(creation.filepath)) {
+      LOG(WARNING) << "Player: load failed for asset [" << creation.filepath
+                   << "]";
+      failedFilepaths_.insert(creation.filepath);
+    }
+    return false;
+  }
+
+  ASSERT(createdInstances_.count(instanceKey) == 0);
+  createdInstances_[instanceKey] = node;
+  return true;
+}
+
+void Player::applyInstanceState(esp::scene::SceneNode* node,
+                                const RenderAssetInstanceState& state) {
+  node->setTranslation(state.absTransform.translation);
+  node->setRotation(state.absTransform.rotation);
+  setSemanticIdForSubtree(node, state.semanticId);
+}
+
 void Player::applyKeyframe(const Keyframe& keyframe) {
   for (const auto& assetInfo : keyframe.loads) {
     ASSERT(assetInfos_.count(assetInfo.filepath) == 0);
@@ -109,30 +287,7 @@ void Player::applyKeyframe(const Keyframe& keyframe) {
   }
 
   for (const auto& pair : keyframe.creations) {
-    const auto& creation = pair.second;
-    if (!assetInfos_.count(creation.filepath)) {
-      if (!failedFilepaths_.count(creation.filepath)) {
-        LOG(WARNING) << "Player: missing asset info for [" << creation.filepath
-                     << "]";
-        failedFilepaths_.insert(creation.filepath);
-      }
-      continue;
-    }
-    ASSERT(assetInfos_.count(creation.filepath));
-    auto* node = loadAndCreateRenderAssetInstanceCallback(
-        assetInfos_[creation.filepath], creation);
-    if (!node) {
-      if (!failedFilepaths_.count(creation.filepath)) {
-        LOG(WARNING) << "Player: load failed for asset [" << creation.filepath
-                     << "]";
-        failedFilepaths_.insert(creation.filepath);
-      }
-      continue;
-    }
-
-    const auto& instanceKey = pair.first;
-    ASSERT(createdInstances_.count(instanceKey) == 0);
-    createdInstances_[instanceKey] = node;
+    createInstance(pair.first, pair.second);
   }
 
   for (const auto& deletionInstanceKey : keyframe.deletions) {
@@ -155,11 +310,11 @@ void Player::applyKeyframe(const Keyframe& keyframe) {
       // creation
       continue;
     }
-    auto* node = it->second;
-    const auto& state = pair.second;
-    node->setTranslation(state.absTransform.translation);
-    node->setRotation(state.absTransform.rotation);
-    setSemanticIdForSubtree(node, state.semanticId);
+    applyInstanceState(it->second, pair.second);
+  }
+
+  for (const auto& pair : keyframe.userTransforms) {
+    userTransforms_[pair.first] = pair.second;
   }
 }
 
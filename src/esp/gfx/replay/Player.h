@@ -6,6 +6,7 @@
 #define ESP_GFX_REPLAY_PLAYER_H_
 
 #include "Keyframe.h"
+#include "KeyframeFile.h"
 
 #include "esp/assets/Asset.h"
 #include "esp/assets/RenderAssetInstanceCreationInfo.h"
@@ -15,6 +16,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace esp {
@@ -34,7 +36,13 @@ namespace replay {
  * reproduced (from the same camera perspective or a different one). A loaded
  * keyframe can be set (applied to the scene) with setKeyframeIndex; render
  * asset instances are added to the scene as needed and new observations can be
- * rendered. Render assets are loaded as needed. See also @ref Recorder. See
+ * rendered. Render assets are loaded as needed.
+ *
+ * To make seeking cheap, the Player records a snapshot of the full scene state
+ * (loaded assets, live instances, and their latest states) every few keyframes
+ * as keyframes are first played. Seeking jumps to the nearest earlier snapshot
+ * and applies only the remaining keyframes, reusing instances that already
+ * exist in the scene. See also @ref Recorder. See
  * examples/replay_tutorial.py for usage of this class through bindings (coming
  * soon).
  */
@@ -48,14 +56,27 @@ class Player {
   /**
    * @brief Construct a Player.
    * @param callback A function to load and create a render asset instance.
+   * @param keyframesPerSnapshot The minimum number of keyframes between
+   * snapshots of the scene state for seeking. Pass 0 to disable snapshots.
+   *
+   * A snapshot stores every live instance, so scenes with many instances get
+   * fewer snapshots: one is only taken once the keyframes since the previous
+   * one hold at least as many changes as the snapshot would store. Snapshots
+   * thus take at most about as much memory as the keyframes played so far.
    */
-  explicit Player(const LoadAndCreateRenderAssetInstanceCallback& callback);
+  explicit Player(const LoadAndCreateRenderAssetInstanceCallback& callback,
+                  int keyframesPerSnapshot = 32);
 
   ~Player();
 
   /**
    * @brief Read keyframes. See also @ref Recorder::writeSavedKeyframesToFile.
    * After calling this, use @ref setKeyframeIndex to set a keyframe.
+   *
+   * JSON files are read entirely. Binary files are only indexed here; their
+   * keyframes are decoded a chunk at a time as they are played. Scene
+   * snapshots for seeking are taken as keyframes are first played, not here,
+   * and grow with the number of keyframes played; see @ref Player::Player.
    * @param filepath
    */
   void readKeyframesFromFile(const std::string& filepath);
@@ -79,6 +100,10 @@ class Player {
   /**
    * @brief Get a user transform. See @ref Recorder::addUserTransformToKeyframe
    * for usage tips.
+   *
+   * This is the value from the latest keyframe, up to the current one, that
+   * includes the user transform, since unchanged user transforms are left out
+   * of keyframes.
    */
   bool getUserTransform(const std::string& name,
                         Magnum::Vector3* translation,
@@ -93,22 +118,58 @@ class Player {
    * @brief Reserved for unit-testing.
    */
   void debugSetKeyframes(std::vector<Keyframe>&& keyframes) {
+    reader_ = nullptr;
+    chunkIndex_ = ID_UNDEFINED;
     keyframes_ = std::move(keyframes);
+    resetSnapshots();
   }
 
  private:
+  // Scene state after applying keyframes [0, frameIndex]
+  struct Snapshot {
+    struct Instance {
+      esp::assets::RenderAssetInstanceCreationInfo creation;
+      Corrade::Containers::Optional<RenderAssetInstanceState> state;
+    };
+    int frameIndex = ID_UNDEFINED;
+    std::map<std::string, esp::assets::AssetInfo> assetInfos;
+    std::map<RenderAssetInstanceKey, Instance> instances;
+    std::unordered_map<std::string, Transform> userTransforms;
+  };
+
   void readKeyframesFromJsonDocument(const rapidjson::Document& d);
+  const Keyframe& getKeyframe(int frameIndex) const;
+  void resetSnapshots();
+  void extendSnapshots(int frameIndex);
+  const Snapshot* findSnapshot(int frameIndex) const;
   void clearFrame();
+  void applySnapshot(const Snapshot& snapshot);
   void applyKeyframe(const Keyframe& keyframe);
+  bool createInstance(RenderAssetInstanceKey instanceKey,
+                      const esp::assets::RenderAssetInstanceCreationInfo&
+                          creation);
+  static void applyInstanceState(esp::scene::SceneNode* node,
+                                 const RenderAssetInstanceState& state);
   static void setSemanticIdForSubtree(esp::scene::SceneNode* rootNode,
                                       int semanticId);
 
   LoadAndCreateRenderAssetInstanceCallback
       loadAndCreateRenderAssetInstanceCallback;
   int frameIndex_ = -1;
+  const int keyframesPerSnapshot_;
   std::vector<Keyframe> keyframes_;
+  std::vector<Snapshot> snapshots_;
+  // scene state after the furthest keyframe played so far, and the number of
+  // changes applied to it since the last snapshot
+  Snapshot trackedState_;
+  std::size_t numTrackedChanges_ = 0;
+  // binary files are decoded on demand, one chunk at a time
+  KeyframeReader::uptr reader_;
+  mutable std::vector<Keyframe> chunkKeyframes_;
+  mutable int chunkIndex_ = ID_UNDEFINED;
   std::map<std::string, esp::assets::AssetInfo> assetInfos_;
   std::map<RenderAssetInstanceKey, scene::SceneNode*> createdInstances_;
+  std::unordered_map<std::string, Transform> userTransforms_;
   std::set<std::string> failedFilepaths_;
 
   ESP_SMART_POINTERS(Player)
@@ -9,28 +9,69 @@
 #include "esp/io/json.h"
 #include "esp/scene/SceneNode.h"
 
+#include <Magnum/Math/Functions.h>
+
+#include <cmath>
+
 namespace esp {
 namespace gfx {
 namespace replay {
 
 /**
  * @brief Helper class to get notified when a SceneNode is about to be
- * destroyed.
+ * destroyed. It also caches the node's absolute transformation and tracks
+ * whether the node moved since the transformation was last sampled.
  */
 class NodeDeletionHelper : public Magnum::SceneGraph::AbstractFeature3D {
  public:
   NodeDeletionHelper(scene::SceneNode& node_, Recorder* writer)
       : Magnum::SceneGraph::AbstractFeature3D(node_),
         node(&node_),
-        recorder_(writer) {}
+        recorder_(writer),
+        absoluteTransformation_(node_.absoluteTransformation()) {
+    setCachedTransformations(
+        Magnum::SceneGraph::CachedTransformation::Absolute);
+  }
 
   ~NodeDeletionHelper() override {
-    recorder_->onDeleteRenderAssetInstance(node);
+    if (recorder_) {
+      recorder_->onDeleteRenderAssetInstance(node);
+    }
+  }
+
+  /**
+   * @brief Stop notifying the Recorder, which is being destroyed
+   */
+  void detach() { recorder_ = nullptr; }
+
+  /**
+   * @brief Whether the node or one of its ancestors moved since the last
+   * call to sampleAbsoluteTransformation
+   */
+  bool isDirty() const { return isDirty_; }
+
+  /**
+   * @brief Clean the node and get its absolute transformation
+   */
+  const Magnum::Matrix4& sampleAbsoluteTransformation() {
+    // Magnum only notifies features when a clean node becomes dirty, so the
+    // node must be cleaned to hear about its next move
+    object().setClean();
+    isDirty_ = false;
+    return absoluteTransformation_;
   }
 
  private:
+  void markDirty() override { isDirty_ = true; }
+
+  void clean(const Magnum::Matrix4& absoluteTransformation) override {
+    absoluteTransformation_ = absoluteTransformation;
+  }
+
   Recorder* recorder_ = nullptr;
   const scene::SceneNode* node = nullptr;
+  Magnum::Matrix4 absoluteTransformation_;
+  bool isDirty_ = true;
 };
 
 Recorder::~Recorder() {
@@ -38,6 +79,9 @@ Recorder::~Recorder() {
   // pointers to this Recorder and these pointers would become dangling
   // (invalid) after this Recorder is destroyed.
   for (auto& instanceRecord : instanceRecords_) {
+    // Deleting a helper would otherwise remove its record from
+    // instanceRecords_ while we iterate over it.
+    instanceRecord.deletionHelper->detach();
     delete instanceRecord.deletionHelper;
   }
 }
@@ -55,50 +99,73 @@ void Recorder::onCreateRenderAssetInstance(
   RenderAssetInstanceKey instanceKey = getNewInstanceKey();
 
   getKeyframe().creations.emplace_back(std::make_pair(instanceKey, creation));
+  currCreationKeys_.insert(instanceKey);
 
   // Constructing NodeDeletionHelper here is equivalent to calling
   // node->addFeature. We keep a pointer to deletionHelper so we can delete it
   // manually later if necessary.
   NodeDeletionHelper* deletionHelper = new NodeDeletionHelper{*node, this};
 
+  instanceRecordIndices_[node] = instanceRecords_.size();
   instanceRecords_.emplace_back(InstanceRecord{
       node, instanceKey, Corrade::Containers::NullOpt, deletionHelper});
 }
 
 void Recorder::saveKeyframe() {
   updateInstanceStates();
+  updateUserTransforms();
   advanceKeyframe();
 }
 
+void Recorder::setChangeThresholds(float translationEpsilon,
+                                   Magnum::Rad rotationEpsilon) {
+  CORRADE_ASSERT(translationEpsilon >= 0.0f &&
+                     rotationEpsilon >= Magnum::Rad{0.0f},
+                 "Recorder::setChangeThresholds(): thresholds must not be "
+                 "negative", );
+  translationEpsilon_ = translationEpsilon;
+  rotationEpsilon_ = rotationEpsilon;
+  minRotationDot_ = Magnum::Math::cos(0.5f * rotationEpsilon);
+}
+
 void Recorder::addUserTransformToKeyframe(const std::string& name,
                                           const Magnum::Vector3& translation,
                                           const Magnum::Quaternion& rotation) {
   getKeyframe().userTransforms[name] = Transform{translation, rotation};
 }
 
-void Recorder::addLoadsCreationsDeletions(KeyframeIterator begin,
-                                          KeyframeIterator end,
-                                          Keyframe* dest) {
+void Recorder::addLoadsCreationsDeletions(
+    KeyframeIterator begin,
+    KeyframeIterator end,
+    Keyframe* dest,
+    std::unordered_set<RenderAssetInstanceKey>* destCreationKeys) {
   ASSERT(dest);
+  ASSERT(destCreationKeys);
   for (KeyframeIterator curr = begin; curr != end; curr++) {
     const auto& keyframe = *curr;
     dest->loads.insert(dest->loads.end(), keyframe.loads.begin(),
                        keyframe.loads.end());
     dest->creations.insert(dest->creations.end(), keyframe.creations.begin(),
                            keyframe.creations.end());
+    for (const auto& pair : keyframe.creations) {
+      destCreationKeys->insert(pair.first);
+    }
     for (const auto& deletionInstanceKey : keyframe.deletions) {
-      checkAndAddDeletion(dest, deletionInstanceKey);
+      checkAndAddDeletion(dest, destCreationKeys, deletionInstanceKey);
     }
   }
 }
 
-void Recorder::checkAndAddDeletion(Keyframe* keyframe,
-                                   RenderAssetInstanceKey instanceKey) {
-  auto it =
-      std::find_if(keyframe->creations.begin(), keyframe->creations.end(),
-                   [&](const auto& pair) { return pair.first == instanceKey; });
-  if (it != keyframe->creations.end()) {
+void Recorder::checkAndAddDeletion(
+    Keyframe* keyframe,
+    std::unordered_set<RenderAssetInstanceKey>* creationKeys,
+    RenderAssetInstanceKey instanceKey) {
+  if (creationKeys->erase(instanceKey)) {
     // this deletion just cancels out with an earlier creation
+    auto it = std::find_if(
+        keyframe->creations.begin(), keyframe->creations.end(),
+        [&](const auto& pair) { return pair.first == instanceKey; });
+    ASSERT(it != keyframe->creations.end());
     keyframe->creations.erase(it);
   } else {
     // This deletion has no matching creation so it can't be canceled out.
@@ -113,9 +180,15 @@ void Recorder::onDeleteRenderAssetInstance(const scene::SceneNode* node) {
 
   auto instanceKey = instanceRecords_[index].instanceKey;
 
-  checkAndAddDeletion(&getKeyframe(), instanceKey);
+  checkAndAddDeletion(&getKeyframe(), &currCreationKeys_, instanceKey);
 
-  instanceRecords_.erase(instanceRecords_.begin() + index);
+  // swap with the last record so the removal is O(1)
+  instanceRecordIndices_.erase(node);
+  if (index != int(instanceRecords_.size()) - 1) {
+    instanceRecords_[index] = std::move(instanceRecords_.back());
+    instanceRecordIndices_[instanceRecords_[index].node] = index;
+  }
+  instanceRecords_.pop_back();
 }
 
 Keyframe& Recorder::getKeyframe() {
@@ -127,46 +200,137 @@ RenderAssetInstanceKey Recorder::getNewInstanceKey() {
 }
 
 int Recorder::findInstance(const scene::SceneNode* queryNode) {
-  auto it = std::find_if(instanceRecords_.begin(), instanceRecords_.end(),
-                         [&queryNode](const InstanceRecord& record) {
-                           return record.node == queryNode;
-                         });
+  auto it = instanceRecordIndices_.find(queryNode);
+  return it == instanceRecordIndices_.end() ? ID_UNDEFINED : it->second;
+}
 
-  return it == instanceRecords_.end() ? ID_UNDEFINED
-                                      : int(it - instanceRecords_.begin());
+void Recorder::updateInstanceStates() {
+  for (auto& instanceRecord : instanceRecords_) {
+    updateInstanceState(instanceRecord);
+  }
 }
 
-RenderAssetInstanceState Recorder::getInstanceState(
-    const scene::SceneNode* node) {
-  const auto absTransformMat = node->absoluteTransformation();
+void Recorder::updateInstanceState(InstanceRecord& instanceRecord) {
+  // Only nodes that moved need their transformation sampled. The semantic id
+  // doesn't dirty the node, so it's checked separately.
+  const int semanticId = instanceRecord.node->getSemanticId();
+  auto* deletionHelper = instanceRecord.deletionHelper;
+  if (instanceRecord.recentState && !deletionHelper->isDirty() &&
+      instanceRecord.recentState->semanticId == semanticId) {
+    return;
+  }
+
+  const auto& absTransformMat = deletionHelper->sampleAbsoluteTransformation();
   Transform absTransform{
       absTransformMat.translation(),
       Magnum::Quaternion::fromMatrix(absTransformMat.rotationShear())};
-
-  return RenderAssetInstanceState{absTransform, node->getSemanticId()};
+  RenderAssetInstanceState state{absTransform, semanticId};
+  if (!instanceRecord.recentState ||
+      semanticId != instanceRecord.recentState->semanticId ||
+      hasMoved(instanceRecord.recentState->absTransform, absTransform)) {
+    getKeyframe().stateUpdates.emplace_back(instanceRecord.instanceKey, state);
+    instanceRecord.recentState = state;
+  }
 }
 
-void Recorder::updateInstanceStates() {
-  for (auto& instanceRecord : instanceRecords_) {
-    auto state = getInstanceState(instanceRecord.node);
-    if (!instanceRecord.recentState || state != instanceRecord.recentState) {
-      getKeyframe().stateUpdates.emplace_back(instanceRecord.instanceKey,
-                                              state);
-      instanceRecord.recentState = state;
+void Recorder::updateUserTransforms() {
+  auto& userTransforms = getKeyframe().userTransforms;
+  for (auto it = userTransforms.begin(); it != userTransforms.end();) {
+    auto inserted = recentUserTransforms_.emplace(it->first, it->second);
+    if (inserted.second || hasMoved(inserted.first->second, it->second)) {
+      inserted.first->second = it->second;
+      ++it;
+    } else {
+      it = userTransforms.erase(it);
     }
   }
 }
 
+bool Recorder::hasMoved(const Transform& from, const Transform& to) const {
+  if (translationEpsilon_ > 0.0f
+          ? (to.translation - from.translation).dot() >
+                translationEpsilon_ * translationEpsilon_
+          : to.translation != from.translation) {
+    return true;
+  }
+  // q and -q are the same rotation, hence the abs
+  return rotationEpsilon_ > Magnum::Rad{0.0f}
+             ? std::abs(Magnum::Math::dot(from.rotation, to.rotation)) <
+                   minRotationDot_
+             : to.rotation != from.rotation;
+}
+
 void Recorder::advanceKeyframe() {
   savedKeyframes_.emplace_back(std::move(currKeyframe_));
   currKeyframe_ = Keyframe{};
+  currCreationKeys_.clear();
+
+  if (keyframeWriter_) {
+    addLoadsCreationsDeletions(savedKeyframes_.begin(), savedKeyframes_.end(),
+                               &streamedKeyframes_, &streamedCreationKeys_);
+    keyframeWriter_->writeKeyframe(std::move(savedKeyframes_.back()));
+    savedKeyframes_.clear();
+  }
 }
 
-void Recorder::writeSavedKeyframesToFile(const std::string& filepath) {
-  auto document = writeKeyframesToJsonDocument();
-  esp::io::writeJsonToFile(document, filepath);
+bool Recorder::writeSavedKeyframesToFile(const std::string& filepath) {
+  bool success = false;
+  if (isBinaryKeyframeFilepath(filepath)) {
+    if (savedKeyframes_.empty()) {
+      LOG(WARNING) << "Recorder::writeSavedKeyframesToFile: no saved "
+                      "keyframes to write";
+    }
+    success = writeKeyframesToFile(filepath, savedKeyframes_);
+  } else {
+    auto document = writeKeyframesToJsonDocument();
+    success = esp::io::writeJsonToFile(document, filepath);
+  }
+  if (!success) {
+    LOG(ERROR) << "Recorder::writeSavedKeyframesToFile: failed to write "
+               << filepath;
+  }
 
   consolidateSavedKeyframes();
+  return success;
+}
+
+bool Recorder::startStreamingKeyframesToFile(const std::string& filepath,
+                                             int maxQueuedKeyframes) {
+  stopStreamingKeyframes();
+
+  auto writer = AsyncKeyframeWriter::create_unique(maxQueuedKeyframes);
+  if (!writer->open(filepath)) {
+    return false;
+  }
+  addLoadsCreationsDeletions(savedKeyframes_.begin(), savedKeyframes_.end(),
+                             &streamedKeyframes_, &streamedCreationKeys_);
+  for (auto& keyframe : savedKeyframes_) {
+    writer->writeKeyframe(std::move(keyframe));
+  }
+  savedKeyframes_.clear();
+  keyframeWriter_ = std::move(writer);
+  return true;
+}
+
+bool Recorder::stopStreamingKeyframes() {
+  if (!keyframeWriter_) {
+    return true;
+  }
+  const bool success = keyframeWriter_->close();
+  keyframeWriter_ = nullptr;
+  if (!success) {
+    LOG(ERROR) << "Recorder::stopStreamingKeyframes: failed to finish the "
+                  "keyframe file";
+  }
+
+  // Like after writeSavedKeyframesToFile, the next file must start with the
+  // loads and creations that went into this one.
+  ASSERT(savedKeyframes_.empty());
+  savedKeyframes_.emplace_back(std::move(streamedKeyframes_));
+  streamedKeyframes_ = Keyframe{};
+  streamedCreationKeys_.clear();
+  consolidateSavedKeyframes();
+  return success;
 }
 
 std::string Recorder::writeSavedKeyframesToString() {
@@ -180,12 +344,19 @@ std::string Recorder::writeSavedKeyframesToString() {
 void Recorder::consolidateSavedKeyframes() {
   // consolidate saved keyframes into current keyframe
   addLoadsCreationsDeletions(savedKeyframes_.begin(), savedKeyframes_.end(),
-                             &getKeyframe());
+                             &getKeyframe(), &currCreationKeys_);
   // clear instanceRecord.recentState to ensure updates get included in the next
   // saved keyframe.
   for (auto& instanceRecord : instanceRecords_) {
     instanceRecord.recentState = Corrade::Containers::NullOpt;
   }
+  // likewise for user transforms, including ones that aren't being updated
+  // anymore
+  auto& userTransforms = getKeyframe().userTransforms;
+  for (const auto& pair : recentUserTransforms_) {
+    userTransforms.emplace(pair.first, pair.second);
+  }
+  recentUserTransforms_.clear();
   savedKeyframes_.clear();
 }
 
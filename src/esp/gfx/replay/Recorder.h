@@ -6,10 +6,14 @@
 #define ESP_GFX_REPLAY_RECORDER_H_
 
 #include "Keyframe.h"
+#include "KeyframeFile.h"
 
+#include <Magnum/Math/Angle.h>
 #include <rapidjson/document.h>
 
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace esp {
 namespace assets {
@@ -80,6 +84,9 @@ class Recorder {
    * The user transform gets added to the "current" keyframe and will get saved
    * on the next call to saveKeyframe (but not later keyframes). For
    * "persistent" user objects, the expected usage is to call this every frame.
+   * A user transform that didn't change since it was last saved (see @ref
+   * setChangeThresholds) is left out of the keyframe; @ref Player keeps the
+   * last saved value.
    *
    * @param name A name, to be used to retrieve the transform later.
    * @param translation
@@ -90,10 +97,55 @@ class Recorder {
                                   const Magnum::Quaternion& rotation);
 
   /**
-   * @brief write saved keyframes to file.
+   * @brief Set how far an instance or user transform must move before a new
+   * state is saved for it.
+   *
+   * By default, any change is saved, so physics jitter on objects at rest
+   * produces a state update every keyframe. Changes are measured against the
+   * last saved state, so slow drift still gets saved once it adds up.
+   * @param translationEpsilon Distance, in meters
+   * @param rotationEpsilon Angle between the rotations
+   */
+  void setChangeThresholds(float translationEpsilon,
+                           Magnum::Rad rotationEpsilon);
+
+  float getTranslationChangeThreshold() const { return translationEpsilon_; }
+
+  Magnum::Rad getRotationChangeThreshold() const { return rotationEpsilon_; }
+
+  /**
+   * @brief write saved keyframes to file. Files with the ".bin" extension use
+   * the binary format (see @ref KeyframeWriter); all others use JSON.
    * @param filepath
+   * @return Whether the file was completely written
    */
-  void writeSavedKeyframesToFile(const std::string& filepath);
+  bool writeSavedKeyframesToFile(const std::string& filepath);
+
+  /**
+   * @brief Start appending keyframes to a binary keyframe file as they are
+   * saved, instead of keeping them in memory.
+   *
+   * Already-saved keyframes are written first. Chunks of keyframes are written
+   * while recording, so the file is usable even if the recording is
+   * interrupted.
+   * @param filepath
+   * @param maxQueuedKeyframes If positive, keyframes are encoded and written
+   * on a background thread, with at most this many keyframes waiting to be
+   * written. See @ref AsyncKeyframeWriter.
+   * @return Whether the file could be created
+   */
+  bool startStreamingKeyframesToFile(const std::string& filepath,
+                                     int maxQueuedKeyframes = 0);
+
+  /**
+   * @brief Finish the file started by @ref startStreamingKeyframesToFile.
+   * Keyframes saved later are kept in memory again.
+   * @return false if the file could not be completely written. Also true if
+   * no file was being streamed.
+   */
+  bool stopStreamingKeyframes();
+
+  bool isStreamingKeyframes() const { return keyframeWriter_ != nullptr; }
 
   /**
    * @brief write saved keyframes to string.
@@ -111,7 +163,8 @@ class Recorder {
   // NodeDeletionHelper calls onDeleteRenderAssetInstance
   friend class NodeDeletionHelper;
 
-  // Helper for tracking render asset instances
+  // Helper for tracking render asset instances. deletionHelper also tracks
+  // whether the node moved since its state was last sampled.
   struct InstanceRecord {
     scene::SceneNode* node = nullptr;
     RenderAssetInstanceKey instanceKey = ID_UNDEFINED;
@@ -127,19 +180,39 @@ class Recorder {
   void advanceKeyframe();
   RenderAssetInstanceKey getNewInstanceKey();
   int findInstance(const scene::SceneNode* queryNode);
-  RenderAssetInstanceState getInstanceState(const scene::SceneNode* node);
   void updateInstanceStates();
-  void checkAndAddDeletion(Keyframe* keyframe,
-                           RenderAssetInstanceKey instanceKey);
-  void addLoadsCreationsDeletions(KeyframeIterator begin,
-                                  KeyframeIterator end,
-                                  Keyframe* dest);
+  void updateInstanceState(InstanceRecord& instanceRecord);
+  void updateUserTransforms();
+  bool hasMoved(const Transform& from, const Transform& to) const;
+  void checkAndAddDeletion(
+      Keyframe* keyframe,
+      std::unordered_set<RenderAssetInstanceKey>* creationKeys,
+      RenderAssetInstanceKey instanceKey);
+  void addLoadsCreationsDeletions(
+      KeyframeIterator begin,
+      KeyframeIterator end,
+      Keyframe* dest,
+      std::unordered_set<RenderAssetInstanceKey>* destCreationKeys);
   void consolidateSavedKeyframes();
 
   std::vector<InstanceRecord> instanceRecords_;
+  // index into instanceRecords_ for each instance's root node
+  std::unordered_map<const scene::SceneNode*, int> instanceRecordIndices_;
   Keyframe currKeyframe_;
+  // keys of currKeyframe_.creations, so deletions can check them in O(1)
+  std::unordered_set<RenderAssetInstanceKey> currCreationKeys_;
   std::vector<Keyframe> savedKeyframes_;
   RenderAssetInstanceKey nextInstanceKey_ = 0;
+  AsyncKeyframeWriter::uptr keyframeWriter_;
+  // loads, creations, and deletions of all streamed keyframes
+  Keyframe streamedKeyframes_;
+  std::unordered_set<RenderAssetInstanceKey> streamedCreationKeys_;
+  // last saved value of each user transform
+  std::unordered_map<std::string, Transform> recentUserTransforms_;
+  float translationEpsilon_ = 0.0f;
+  Magnum::Rad rotationEpsilon_{0.0f};
+  // |dot| of two quaternions rotationEpsilon_ apart
+  float minRotationDot_ = 1.0f;
 };
 
 }  // namespace replay
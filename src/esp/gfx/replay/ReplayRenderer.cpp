@@ -0,0 +1,184 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "ReplayRenderer.h"
+
+#include <Magnum/GL/Context.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/PixelFormat.h>
+
+#include "esp/assets/ResourceManager.h"
+#include "esp/gfx/DepthUnprojection.h"
+#include "esp/gfx/RenderCamera.h"
+#include "esp/gfx/RenderTarget.h"
+#include "esp/gfx/Renderer.h"
+#include "esp/gfx/WindowlessContext.h"
+#include "esp/metadata/MetadataMediator.h"
+#include "esp/scene/SceneManager.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace gfx {
+namespace replay {
+
+ReplayRenderer::ReplayRenderer(const std::vector<CameraSpec>& cameras,
+                               int gpuDeviceId) {
+  if (!Mn::GL::Context::hasCurrent()) {
+    context_ = WindowlessContext::create_unique(gpuDeviceId);
+  }
+  metadataMediator_ = metadata::MetadataMediator::create();
+  resourceManager_ =
+      std::make_unique<assets::ResourceManager>(metadataMediator_);
+  sceneManager_ = scene::SceneManager::create_unique();
+  sceneID_ = sceneManager_->initSceneGraph();
+  renderer_ = Renderer::create();
+  depthShader_ =
+      std::make_unique<DepthShader>(DepthShader::Flag::UnprojectExistingDepth);
+
+  auto& rootNode = sceneManager_->getSceneGraph(sceneID_).getRootNode();
+  for (const auto& spec : cameras) {
+    CORRADE_ASSERT(spec.sensorType == sensor::SensorType::Color ||
+                       spec.sensorType == sensor::SensorType::Depth ||
+                       spec.sensorType == sensor::SensorType::Semantic,
+                   "ReplayRenderer::ReplayRenderer(): cameras must be of "
+                   "sensor type Color, Depth, or Semantic", );
+    Camera camera;
+    camera.spec = spec;
+    // The rig follows the user transform, the camera node is offset from it
+    camera.rigNode = &rootNode.createChild();
+    auto& cameraNode = camera.rigNode->createChild();
+    cameraNode.setTranslation(spec.transform.translation);
+    cameraNode.setRotation(spec.transform.rotation);
+
+    // Same projection as a pinhole sensor::CameraSensor
+    const int width = spec.resolution[1];
+    const int height = spec.resolution[0];
+    Mn::Vector2 nearPlaneSize{1.0f, float(height) / width};
+    nearPlaneSize *= 2.0f * spec.near * Mn::Math::tan(0.5f * spec.hfov);
+    const auto projection =
+        Mn::Matrix4::perspectiveProjection(nearPlaneSize, spec.near, spec.far);
+    camera.renderCamera = new RenderCamera(cameraNode);
+    camera.renderCamera->setProjectionMatrix(width, height, projection);
+
+    RenderTarget::Flags flags;
+    if (spec.sensorType == sensor::SensorType::Color) {
+      flags |= RenderTarget::Flag::RgbaAttachment;
+    } else if (spec.sensorType == sensor::SensorType::Depth) {
+      flags |= RenderTarget::Flag::DepthTextureAttachment;
+    } else {
+      flags |= RenderTarget::Flag::ObjectIdAttachment;
+    }
+    camera.renderTarget = RenderTarget::create_unique(
+        Mn::Vector2i{width, height}, calculateDepthUnprojection(projection),
+        depthShader_.get(), flags);
+
+    cameras_.emplace_back(std::move(camera));
+  }
+
+  // Semantic instances go to the same scene graph
+  player_ = Player::create_unique(
+      [this](const assets::AssetInfo& assetInfo,
+             const assets::RenderAssetInstanceCreationInfo& creation) {
+        std::vector<int> tempIDs{sceneID_, sceneID_};
+        return resourceManager_->loadAndCreateRenderAssetInstance(
+            assetInfo, creation, sceneManager_.get(), tempIDs);
+      });
+}
+
+ReplayRenderer::~ReplayRenderer() = default;
+
+void ReplayRenderer::readKeyframesFromFile(const std::string& filepath) {
+  player_->readKeyframesFromFile(filepath);
+}
+
+void ReplayRenderer::setCameraTransform(int cameraIndex,
+                                        const Transform& transform) {
+  ASSERT(cameraIndex >= 0 && cameraIndex < getNumCameras());
+  Camera& camera = cameras_[cameraIndex];
+  camera.spec.transform = transform;
+  auto& cameraNode = static_cast<scene::SceneNode&>(
+      camera.renderCamera->object());
+  cameraNode.setTranslation(transform.translation);
+  cameraNode.setRotation(transform.rotation);
+}
+
+void ReplayRenderer::updateCameraRigs() {
+  for (auto& camera : cameras_) {
+    if (camera.spec.userTransformName.empty()) {
+      continue;
+    }
+    Mn::Vector3 translation;
+    Mn::Quaternion rotation;
+    if (player_->getUserTransform(camera.spec.userTransformName, &translation,
+                                  &rotation)) {
+      camera.rigNode->setTranslation(translation);
+      camera.rigNode->setRotation(rotation);
+    } else {
+      LOG(WARNING) << "ReplayRenderer: keyframe " << player_->getKeyframeIndex()
+                   << " has no user transform "
+                   << camera.spec.userTransformName
+                   << ", keeping the previous camera pose";
+    }
+  }
+}
+
+std::vector<core::Buffer::ptr> ReplayRenderer::renderKeyframes(
+    const std::vector<int>& keyframeIndices) {
+  std::vector<core::Buffer::ptr> buffers;
+  for (const auto& camera : cameras_) {
+    size_t channels = 1;
+    core::DataType dataType = core::DataType::DT_FLOAT;
+    if (camera.spec.sensorType == sensor::SensorType::Color) {
+      channels = 4;
+      dataType = core::DataType::DT_UINT8;
+    } else if (camera.spec.sensorType == sensor::SensorType::Semantic) {
+      dataType = core::DataType::DT_UINT32;
+    }
+    buffers.emplace_back(core::Buffer::create(
+        std::vector<size_t>{keyframeIndices.size(),
+                            size_t(camera.spec.resolution[0]),
+                            size_t(camera.spec.resolution[1]), channels},
+        dataType));
+  }
+
+  auto& sceneGraph = sceneManager_->getSceneGraph(sceneID_);
+  for (size_t i = 0; i < keyframeIndices.size(); ++i) {
+    player_->setKeyframeIndex(keyframeIndices[i]);
+    updateCameraRigs();
+    for (size_t j = 0; j < cameras_.size(); ++j) {
+      Camera& camera = cameras_[j];
+      camera.renderTarget->renderEnter();
+      renderer_->draw(*camera.renderCamera, sceneGraph);
+      camera.renderTarget->renderExit();
+      readFrame(camera, *buffers[j], i);
+    }
+  }
+  return buffers;
+}
+
+void ReplayRenderer::readFrame(Camera& camera,
+                               core::Buffer& buffer,
+                               size_t frameIndex) {
+  const size_t frameSize = buffer.data.size() / buffer.shape[0];
+  Cr::Containers::ArrayView<uint8_t> frame =
+      buffer.data.slice(frameIndex * frameSize, (frameIndex + 1) * frameSize);
+  RenderTarget& renderTarget = *camera.renderTarget;
+  const Mn::Vector2i size = renderTarget.framebufferSize();
+  if (camera.spec.sensorType == sensor::SensorType::Semantic) {
+    renderTarget.readFrameObjectId(
+        Mn::MutableImageView2D{Mn::PixelFormat::R32UI, size, frame});
+  } else if (camera.spec.sensorType == sensor::SensorType::Depth) {
+    renderTarget.readFrameDepth(
+        Mn::MutableImageView2D{Mn::PixelFormat::R32F, size, frame});
+  } else {
+    renderTarget.readFrameRgba(
+        Mn::MutableImageView2D{Mn::PixelFormat::RGBA8Unorm, size, frame});
+  }
+}
+
+}  // namespace replay
+}  // namespace gfx
+}  // namespace esp
@@ -0,0 +1,140 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_GFX_REPLAY_REPLAYRENDERER_H_
+#define ESP_GFX_REPLAY_REPLAYRENDERER_H_
+
+#include "Player.h"
+
+#include "esp/core/Buffer.h"
+#include "esp/sensor/Sensor.h"
+
+#include <Magnum/Math/Angle.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace esp {
+namespace assets {
+class ResourceManager;
+}
+namespace metadata {
+class MetadataMediator;
+}
+namespace scene {
+class SceneManager;
+}
+namespace gfx {
+class DepthShader;
+class RenderCamera;
+class RenderTarget;
+class Renderer;
+class WindowlessContext;
+namespace replay {
+
+/**
+ * @brief Renders observations of a replay without a Simulator.
+ *
+ * The renderer owns a scene graph, a @ref Player that populates it, and a set
+ * of cameras. Only render assets are loaded, through @ref
+ * assets::ResourceManager; there is no physics, navmesh, or agent. Scene nodes
+ * are reused from one rendered keyframe to the next (see @ref Player).
+ *
+ * Each camera renders color, depth, or semantic observations into its own
+ * render target. A camera can follow a user transform recorded in the replay
+ * (see @ref Recorder::addUserTransformToKeyframe), e.g. to re-render an
+ * agent's view with a new sensor, or stay at a fixed pose.
+ */
+class ReplayRenderer {
+ public:
+  struct CameraSpec {
+    //! Color, Depth, or Semantic
+    sensor::SensorType sensorType = sensor::SensorType::Color;
+    //! Height x width, as in @ref sensor::VisualSensorSpec::resolution
+    Magnum::Vector2i resolution{128, 128};
+    Magnum::Deg hfov{90.0f};
+    float near = 0.01f;
+    float far = 1000.0f;
+    //! If set, the camera follows this user transform of the replay
+    std::string userTransformName;
+    //! Pose relative to the user transform, or in world space if there is none
+    Transform transform{{}, Magnum::Quaternion{Magnum::Math::IdentityInit}};
+  };
+
+  /**
+   * @brief Construct a renderer. Creates a windowless GL context on @p
+   * gpuDeviceId unless a context is already current.
+   */
+  explicit ReplayRenderer(const std::vector<CameraSpec>& cameras,
+                          int gpuDeviceId = 0);
+
+  ~ReplayRenderer();
+
+  /**
+   * @brief Read a JSON or binary replay file
+   */
+  void readKeyframesFromFile(const std::string& filepath);
+
+  /**
+   * @brief The Player of this renderer, e.g. to set keyframes directly
+   */
+  Player& getPlayer() { return *player_; }
+
+  int getNumKeyframes() const { return player_->getNumKeyframes(); }
+
+  int getNumCameras() const { return cameras_.size(); }
+
+  const CameraSpec& getCameraSpec(int cameraIndex) const {
+    return cameras_[cameraIndex].spec;
+  }
+
+  /**
+   * @brief Change a camera's pose. See @ref CameraSpec::transform.
+   */
+  void setCameraTransform(int cameraIndex, const Transform& transform);
+
+  /**
+   * @brief Render keyframes from every camera.
+   *
+   * @param keyframeIndices Keyframes to render. Any order works, but
+   * increasing order is fastest.
+   * @return An observation buffer per camera, with shape {number of keyframes,
+   * height, width, channels}. Color is 4-channel uint8, depth is 1-channel
+   * float, and semantic is 1-channel uint32.
+   */
+  std::vector<core::Buffer::ptr> renderKeyframes(
+      const std::vector<int>& keyframeIndices);
+
+ private:
+  struct Camera {
+    CameraSpec spec;
+    scene::SceneNode* rigNode = nullptr;
+    RenderCamera* renderCamera = nullptr;
+    std::unique_ptr<RenderTarget> renderTarget;
+  };
+
+  void updateCameraRigs();
+  void readFrame(Camera& camera, core::Buffer& buffer, size_t frameIndex);
+
+  std::unique_ptr<WindowlessContext> context_;
+  std::shared_ptr<metadata::MetadataMediator> metadataMediator_;
+  // must be declared in this order to avoid deallocation errors
+  std::unique_ptr<assets::ResourceManager> resourceManager_;
+  std::unique_ptr<scene::SceneManager> sceneManager_;
+  int sceneID_ = ID_UNDEFINED;
+  std::shared_ptr<Renderer> renderer_;
+  std::unique_ptr<DepthShader> depthShader_;
+  std::vector<Camera> cameras_;
+  // destroyed first, since it deletes the nodes it created
+  Player::uptr player_;
+
+  ESP_SMART_POINTERS(ReplayRenderer)
+};
+
+}  // namespace replay
+}  // namespace gfx
+}  // namespace esp
+
+#endif  // ESP_GFX_REPLAY_REPLAYRENDERER_H_
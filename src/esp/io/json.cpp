@@ -36,7 +36,10 @@ bool writeJsonToFile(const JsonDocument& document,
 
   rapidjson::PrettyWriter<rapidjson::FileWriteStream> writer(os);
   bool writeSuccess = document.Accept(writer);
-  fclose(f);
+  os.Flush();
+  writeSuccess = writeSuccess && !ferror(f);
+  // fclose writes out whatever stdio still buffers
+  writeSuccess = fclose(f) == 0 && writeSuccess;
 
   return writeSuccess;
 }
@@ -0,0 +1,373 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "ClearanceField.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "DetourNavMeshQuery.h"
+
+namespace esp {
+namespace nav {
+
+namespace {
+const int CLEARANCE_MAGIC = 'C' << 24 | 'L' << 16 | 'R' << 8 | 'F';  //'CLRF'
+const int CLEARANCE_VERSION = 1;
+
+// Samples of a cell closer than this in height are the same surface
+const float SAMPLE_MERGE_HEIGHT = 0.1f;
+// Boundary edges and queries only count for samples within this height, the
+// same tolerance as the default of isNavigable
+const float HEIGHT_TOLERANCE = 0.5f;
+
+struct ClearanceFileHeader {
+  int magic;
+  int version;
+  uint64_t navMeshSignature;
+  float cellSize;
+  float maxDistance;
+  float originX;
+  float originZ;
+  int width;
+  int height;
+  uint32_t numSamples;
+  uint32_t reserved;
+};
+
+struct BoundaryEdge {
+  vec2f a, b;
+  float ymin, ymax;
+};
+
+float distancePtSegSqr2D(const vec2f& pt, const vec2f& a, const vec2f& b) {
+  const vec2f ab = b - a;
+  const float lengthSqr = ab.squaredNorm();
+  float t = lengthSqr > 0 ? (pt - a).dot(ab) / lengthSqr : 0.0f;
+  t = std::min(std::max(t, 0.0f), 1.0f);
+  return (a + t * ab - pt).squaredNorm();
+}
+
+// Vertex k of a detail triangle of poly, which indexes the polygon vertices
+// first and the detail vertices after them
+vec3f detailVertex(const dtMeshTile* tile,
+                   const dtPoly* poly,
+                   const dtPolyDetail* detail,
+                   const unsigned char* tri,
+                   const int k) {
+  const float* v =
+      tri[k] < poly->vertCount
+          ? &tile->verts[poly->verts[tri[k]] * 3]
+          : &tile->detailVerts[(detail->vertBase + tri[k] - poly->vertCount) *
+                               3];
+  return vec3f(v[0], v[1], v[2]);
+}
+}  // namespace
+
+ClearanceField::ClearanceField(const dtNavMesh* navMesh) : navMesh_{navMesh} {}
+
+bool ClearanceField::build(const dtQueryFilter* filter,
+                           const float cellSize,
+                           const float maxDistance) {
+  if (cellSize <= 0 || maxDistance <= 0) {
+    LOG(ERROR) << "cellSize and maxDistance must be positive";
+    return false;
+  }
+
+  // Walkable surface and its boundary, i.e. the polygon edges without a
+  // walkable neighbour.  These are the walls dtNavMeshQuery::findDistanceToWall
+  // finds
+  std::vector<BoundaryEdge> edges;
+  std::vector<std::array<vec3f, 3>> triangles;
+  vec2f bmin = vec2f::Constant(std::numeric_limits<float>::infinity());
+  vec2f bmax = -bmin;
+  for (int iTile = 0; iTile < navMesh_->getMaxTiles(); ++iTile) {
+    const dtMeshTile* tile = navMesh_->getTile(iTile);
+    if (!tile || !tile->header)
+      continue;
+
+    for (int jPoly = 0; jPoly < tile->header->polyCount; ++jPoly) {
+      const dtPoly* poly = &tile->polys[jPoly];
+      const dtPolyRef ref = navMesh_->encodePolyId(tile->salt, iTile, jPoly);
+      if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION ||
+          !filter->passFilter(ref, tile, poly))
+        continue;
+
+      for (int j = 0; j < poly->vertCount; ++j) {
+        bool solid = true;
+        for (unsigned int iLink = poly->firstLink; iLink != DT_NULL_LINK;
+             iLink = tile->links[iLink].next) {
+          const dtLink& link = tile->links[iLink];
+          if (link.edge != j)
+            continue;
+          const dtMeshTile* neighbourTile = nullptr;
+          const dtPoly* neighbourPoly = nullptr;
+          navMesh_->getTileAndPolyByRefUnsafe(link.ref, &neighbourTile,
+                                              &neighbourPoly);
+          if (filter->passFilter(link.ref, neighbourTile, neighbourPoly)) {
+            solid = false;
+            break;
+          }
+        }
+
+        const float* va = &tile->verts[poly->verts[j] * 3];
+        const float* vb =
+            &tile->verts[poly->verts[(j + 1) % poly->vertCount] * 3];
+        bmin = bmin.cwiseMin(vec2f(va[0], va[2]));
+        bmax = bmax.cwiseMax(vec2f(va[0], va[2]));
+        if (solid) {
+          edges.push_back({vec2f(va[0], va[2]), vec2f(vb[0], vb[2]),
+                           std::min(va[1], vb[1]), std::max(va[1], vb[1])});
+        }
+      }
+
+      const dtPolyDetail* detail = &tile->detailMeshes[jPoly];
+      for (int j = 0; j < detail->triCount; ++j) {
+        const unsigned char* tri = &tile->detailTris[(detail->triBase + j) * 4];
+        triangles.push_back({detailVertex(tile, poly, detail, tri, 0),
+                             detailVertex(tile, poly, detail, tri, 1),
+                             detailVertex(tile, poly, detail, tri, 2)});
+      }
+    }
+  }
+  if (triangles.empty()) {
+    LOG(ERROR) << "Navmesh has no walkable polygons";
+    return false;
+  }
+
+  // One cell of padding on every side so lookups near the edge of the navmesh
+  // still have four cells to interpolate between
+  cellSize_ = cellSize;
+  maxDistance_ = maxDistance;
+  origin_ = bmin - vec2f::Constant(cellSize);
+  width_ = static_cast<int>(std::ceil((bmax[0] - bmin[0]) / cellSize)) + 2;
+  height_ = static_cast<int>(std::ceil((bmax[1] - bmin[1]) / cellSize)) + 2;
+
+  // Sample every detail triangle at the cell centers inside it
+  std::vector<std::pair<uint32_t, float>> samples;
+  for (const auto& tri : triangles) {
+    const vec2f a(tri[0][0], tri[0][2]), b(tri[1][0], tri[1][2]),
+        c(tri[2][0], tri[2][2]);
+    const float area = (b - a)[0] * (c - a)[1] - (b - a)[1] * (c - a)[0];
+    if (std::abs(area) < 1e-8f)
+      continue;
+
+    const vec2f tmin = (a.cwiseMin(b).cwiseMin(c) - origin_) / cellSize_;
+    const vec2f tmax = (a.cwiseMax(b).cwiseMax(c) - origin_) / cellSize_;
+    const int i0 = std::max(0, static_cast<int>(std::ceil(tmin[0] - 0.5f)));
+    const int i1 =
+        std::min(width_ - 1, static_cast<int>(std::floor(tmax[0] - 0.5f)));
+    const int j0 = std::max(0, static_cast<int>(std::ceil(tmin[1] - 0.5f)));
+    const int j1 =
+        std::min(height_ - 1, static_cast<int>(std::floor(tmax[1] - 0.5f)));
+    for (int j = j0; j <= j1; ++j) {
+      for (int i = i0; i <= i1; ++i) {
+        const vec2f p = origin_ + vec2f(i + 0.5f, j + 0.5f) * cellSize_;
+        // Barycentric coordinates, shared edges are sampled by both triangles
+        const float u = ((c - b)[0] * (p - b)[1] - (c - b)[1] * (p - b)[0]) /
+                        area;
+        const float v = ((a - c)[0] * (p - c)[1] - (a - c)[1] * (p - c)[0]) /
+                        area;
+        const float w = 1.0f - u - v;
+        if (u < -1e-4f || v < -1e-4f || w < -1e-4f)
+          continue;
+        samples.emplace_back(j * width_ + i,
+                             u * tri[0][1] + v * tri[1][1] + w * tri[2][1]);
+      }
+    }
+  }
+  std::sort(samples.begin(), samples.end());
+
+  const uint32_t numCells = width_ * height_;
+  cellStart_.assign(numCells + 1, 0);
+  sampleHeights_.clear();
+  for (size_t i = 0; i < samples.size(); ++i) {
+    if (i > 0 && samples[i].first == samples[i - 1].first &&
+        samples[i].second - sampleHeights_.back() < SAMPLE_MERGE_HEIGHT)
+      continue;
+    ++cellStart_[samples[i].first + 1];
+    sampleHeights_.push_back(samples[i].second);
+  }
+  for (uint32_t i = 0; i < numCells; ++i) {
+    cellStart_[i + 1] += cellStart_[i];
+  }
+  std::vector<std::pair<uint32_t, float>>().swap(samples);
+
+  // Bucket the edges by the cells of a coarser grid, as large as the maximum
+  // distance, so only the 3 x 3 buckets around a sample need to be searched
+  const float bucketSize = std::max(maxDistance_, cellSize_);
+  const int bucketsWidth =
+      static_cast<int>(std::ceil(width_ * cellSize_ / bucketSize)) + 1;
+  const int bucketsHeight =
+      static_cast<int>(std::ceil(height_ * cellSize_ / bucketSize)) + 1;
+  const auto bucketOf = [&](float x, int size) {
+    return std::min(std::max(static_cast<int>(x / bucketSize), 0), size - 1);
+  };
+  std::vector<std::vector<uint32_t>> buckets(bucketsWidth * bucketsHeight);
+  for (uint32_t e = 0; e < edges.size(); ++e) {
+    const vec2f emin = edges[e].a.cwiseMin(edges[e].b) - origin_;
+    const vec2f emax = edges[e].a.cwiseMax(edges[e].b) - origin_;
+    for (int j = bucketOf(emin[1], bucketsHeight);
+         j <= bucketOf(emax[1], bucketsHeight); ++j) {
+      for (int i = bucketOf(emin[0], bucketsWidth);
+           i <= bucketOf(emax[0], bucketsWidth); ++i) {
+        buckets[j * bucketsWidth + i].push_back(e);
+      }
+    }
+  }
+
+  // Exact distances, clamped to the maximum.  Every row is independent
+  sampleDistances_.assign(sampleHeights_.size(), maxDistance_);
+  const float maxDistanceSqr = maxDistance_ * maxDistance_;
+#pragma omp parallel for schedule(dynamic)
+  for (int j = 0; j < height_; ++j) {
+    for (int i = 0; i < width_; ++i) {
+      const uint32_t cell = j * width_ + i;
+      if (cellStart_[cell] == cellStart_[cell + 1])
+        continue;
+
+      const vec2f p = origin_ + vec2f(i + 0.5f, j + 0.5f) * cellSize_;
+      const int bi = bucketOf(p[0] - origin_[0], bucketsWidth);
+      const int bj = bucketOf(p[1] - origin_[1], bucketsHeight);
+      for (uint32_t s = cellStart_[cell]; s < cellStart_[cell + 1]; ++s) {
+        const float y = sampleHeights_[s];
+        float distSqr = maxDistanceSqr;
+        for (int nj = std::max(bj - 1, 0);
+             nj <= std::min(bj + 1, bucketsHeight - 1); ++nj) {
+          for (int ni = std::max(bi - 1, 0);
+               ni <= std::min(bi + 1, bucketsWidth - 1); ++ni) {
+            for (const uint32_t e : buckets[nj * bucketsWidth + ni]) {
+              const BoundaryEdge& edge = edges[e];
+              if (y < edge.ymin - HEIGHT_TOLERANCE ||
+                  y > edge.ymax + HEIGHT_TOLERANCE)
+                continue;
+              distSqr =
+                  std::min(distSqr, distancePtSegSqr2D(p, edge.a, edge.b));
+            }
+          }
+        }
+        sampleDistances_[s] = std::sqrt(distSqr);
+      }
+    }
+  }
+
+  LOG(INFO) << "Built navmesh clearance field with " << sampleHeights_.size()
+            << " samples on a " << width_ << " x " << height_ << " grid";
+  return true;
+}
+
+int ClearanceField::findSample(const int i, const int j, const float y) const {
+  const uint32_t cell = j * width_ + i;
+  int best = -1;
+  float bestDelta = HEIGHT_TOLERANCE;
+  for (uint32_t s = cellStart_[cell]; s < cellStart_[cell + 1]; ++s) {
+    const float delta = std::abs(sampleHeights_[s] - y);
+    if (delta <= bestDelta) {
+      best = static_cast<int>(s);
+      bestDelta = delta;
+    }
+  }
+  return best;
+}
+
+float ClearanceField::lookup(const vec3f& pt) const {
+  const float u = (pt[0] - origin_[0]) / cellSize_ - 0.5f;
+  const float v = (pt[2] - origin_[1]) / cellSize_ - 0.5f;
+  const int i = static_cast<int>(std::floor(u));
+  const int j = static_cast<int>(std::floor(v));
+  if (!(i >= 0 && j >= 0 && i + 1 < width_ && j + 1 < height_))
+    return NAN;
+
+  float dist[4];
+  for (int k = 0; k < 4; ++k) {
+    const int s = findSample(i + (k & 1), j + (k >> 1), pt[1]);
+    if (s < 0)
+      return NAN;
+    dist[k] = sampleDistances_[s];
+  }
+  const float fu = u - i;
+  const float fv = v - j;
+  return (1 - fv) * ((1 - fu) * dist[0] + fu * dist[1]) +
+         fv * ((1 - fu) * dist[2] + fu * dist[3]);
+}
+
+bool ClearanceField::save(const std::string& path) const {
+  FILE* fp = fopen(path.c_str(), "wb");
+  if (!fp)
+    return false;
+
+  ClearanceFileHeader header{};
+  header.magic = CLEARANCE_MAGIC;
+  header.version = CLEARANCE_VERSION;
+  header.navMeshSignature = impl::navMeshSignature(navMesh_);
+  header.cellSize = cellSize_;
+  header.maxDistance = maxDistance_;
+  header.originX = origin_[0];
+  header.originZ = origin_[1];
+  header.width = width_;
+  header.height = height_;
+  header.numSamples = sampleHeights_.size();
+  const bool success = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+                       impl::writeArray(fp, cellStart_) &&
+                       impl::writeArray(fp, sampleHeights_) &&
+                       impl::writeArray(fp, sampleDistances_);
+  fclose(fp);
+
+  if (!success)
+    LOG(ERROR) << "Could not write navmesh clearance file " << path;
+  return success;
+}
+
+bool ClearanceField::load(const std::string& path) {
+  FILE* fp = fopen(path.c_str(), "rb");
+  if (!fp)
+    return false;
+
+  ClearanceFileHeader header{};
+  if (fread(&header, sizeof(header), 1, fp) != 1 ||
+      header.magic != CLEARANCE_MAGIC || header.version != CLEARANCE_VERSION ||
+      !(header.cellSize > 0) || header.width <= 0 || header.height <= 0) {
+    fclose(fp);
+    LOG(WARNING) << "Navmesh clearance file " << path << " is invalid";
+    return false;
+  }
+  if (header.navMeshSignature != impl::navMeshSignature(navMesh_)) {
+    fclose(fp);
+    LOG(WARNING) << "Navmesh clearance file " << path
+                 << " was computed for a different navmesh, ignoring it";
+    return false;
+  }
+
+  const size_t numCells = size_t(header.width) * header.height;
+  const bool success =
+      impl::readArray(fp, cellStart_, numCells + 1) &&
+      impl::readArray(fp, sampleHeights_, header.numSamples) &&
+      impl::readArray(fp, sampleDistances_, header.numSamples) &&
+      cellStart_.front() == 0 && cellStart_.back() == header.numSamples &&
+      std::is_sorted(cellStart_.begin(), cellStart_.end());
+  fclose(fp);
+  if (!success) {
+    LOG(WARNING) << "Navmesh clearance file " << path << " is invalid";
+    cellStart_.clear();
+    sampleHeights_.clear();
+    sampleDistances_.clear();
+    return false;
+  }
+
+  cellSize_ = header.cellSize;
+  maxDistance_ = header.maxDistance;
+  origin_ = vec2f(header.originX, header.originZ);
+  width_ = header.width;
+  height_ = header.height;
+  return true;
+}
+
+}  // namespace nav
+}  // namespace esp
@@ -0,0 +1,90 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_NAV_CLEARANCEFIELD_H_
+#define ESP_NAV_CLEARANCEFIELD_H_
+
+#include <string>
+#include <vector>
+
+#include "esp/core/esp.h"
+
+#include "NavMeshUtils.h"
+
+class dtQueryFilter;
+
+namespace esp {
+namespace nav {
+/**
+ * @brief Precomputed distance to the closest navmesh boundary
+ *
+ * The navmesh is sampled at the centers of a regular grid in the x-z plane.
+ * Each cell has one sample per walkable surface above or below it, so
+ * multi-floor navmeshes are covered as well.  Every sample stores the exact
+ * horizontal distance to the closest boundary edge at a similar height, up to
+ * a maximum distance.  Queries interpolate bilinearly between the samples of
+ * the four surrounding cells.
+ */
+class ClearanceField {
+ public:
+  explicit ClearanceField(const dtNavMesh* navMesh);
+
+  /**
+   * @brief Samples the navmesh every @p cellSize and computes distances up to
+   * @p maxDistance
+   */
+  bool build(const dtQueryFilter* filter, float cellSize, float maxDistance);
+
+  /**
+   * @brief Saves the sampled distances
+   */
+  bool save(const std::string& path) const;
+
+  /**
+   * @brief Loads distances saved by @ref save. Fails if they were computed for
+   * a different navmesh.
+   */
+  bool load(const std::string& path);
+
+  /**
+   * @brief The interpolated distance from @p pt to the closest boundary, at
+   * most @ref maxDistance
+   *
+   * @return NAN if @p pt isn't surrounded by samples at its height, in which
+   * case the distance should be found with a Detour query
+   */
+  float lookup(const vec3f& pt) const;
+
+  float cellSize() const { return cellSize_; }
+
+  float maxDistance() const { return maxDistance_; }
+
+  int numSamples() const { return sampleHeights_.size(); }
+
+ private:
+  // Index of the sample of cell (i, j) closest to height y, -1 if there is
+  // none within the height tolerance
+  int findSample(int i, int j, float y) const;
+
+  const dtNavMesh* navMesh_;
+
+  float cellSize_ = 0;
+  float maxDistance_ = 0;
+  // Grid of width_ x height_ cells with its corner at origin_ (x, z)
+  vec2f origin_;
+  int width_ = 0;
+  int height_ = 0;
+
+  // Samples of cell i are [cellStart_[i], cellStart_[i + 1]), sorted by height
+  std::vector<uint32_t> cellStart_;
+  std::vector<float> sampleHeights_;
+  std::vector<float> sampleDistances_;
+
+  ESP_SMART_POINTERS(ClearanceField)
+};
+
+}  // namespace nav
+}  // namespace esp
+
+#endif  // ESP_NAV_CLEARANCEFIELD_H_
@@ -1,5 +1,8 @@
 #include "esp/nav/GreedyFollower.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include <Magnum/EigenIntegration/GeometryIntegration.h>
 #include <Magnum/EigenIntegration/Integration.h>
 
@@ -12,6 +15,14 @@ using Mn::EigenIntegration::cast;
 namespace esp {
 namespace nav {
 
+namespace {
+// Quantization of cached poses, positions in meters
+constexpr float positionQuantum = 1e-4f;
+constexpr float rotationQuantum = 1e-4f;
+// Caches are cleared once they hold this many entries
+constexpr size_t maxCacheSize = 1 << 16;
+}  // namespace
+
 GreedyGeodesicFollowerImpl::GreedyGeodesicFollowerImpl(
     PathFinder::ptr& pathfinder,
     MoveFn& moveForward,
@@ -32,17 +43,79 @@ GreedyGeodesicFollowerImpl::GreedyGeodesicFollowerImpl(
       fixThrashing_{fixThrashing},
       thrashingThreshold_{thrashingThreshold} {};
 
+bool GreedyGeodesicFollowerImpl::PoseKey::operator==(
+    const PoseKey& other) const {
+  return std::equal(v, v + 7, other.v);
+}
+
+size_t GreedyGeodesicFollowerImpl::PoseKeyHash::operator()(
+    const PoseKey& key) const {
+  size_t hash = 0;
+  for (const int32_t x : key.v) {
+    hash ^= std::hash<int32_t>{}(x) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  }
+  return hash;
+}
+
+GreedyGeodesicFollowerImpl::PoseKey GreedyGeodesicFollowerImpl::poseKey(
+    const Mn::Vector3& translation,
+    const Mn::Quaternion& rotation) {
+  PoseKey key;
+  for (int i = 0; i < 3; ++i) {
+    key.v[i] = std::lround(translation[i] / positionQuantum);
+    key.v[3 + i] = std::lround(rotation.vector()[i] / rotationQuantum);
+  }
+  key.v[6] = std::lround(rotation.scalar() / rotationQuantum);
+  return key;
+}
+
+void GreedyGeodesicFollowerImpl::validateCaches(const Mn::Vector3& end) {
+  const uint64_t navMeshVersion = pathfinder_->getNavMeshVersion();
+  if (end == cacheGoal_ && navMeshVersion == cacheNavMeshVersion_)
+    return;
+
+  geoDistCache_.clear();
+  tryStepCache_.clear();
+  cacheGoal_ = end;
+  cacheNavMeshVersion_ = navMeshVersion;
+}
+
 float GreedyGeodesicFollowerImpl::geoDist(const Mn::Vector3& start,
                                           const Mn::Vector3& end) {
+  validateCaches(end);
+  const PoseKey key = poseKey(start);
+  auto it = geoDistCache_.find(key);
+  if (it != geoDistCache_.end()) {
+    ++cacheStats_.geoDistHits;
+    return it->second;
+  }
+  ++cacheStats_.geoDistMisses;
+
   geoDistPath_.requestedStart = cast<vec3f>(start);
   geoDistPath_.requestedEnd = cast<vec3f>(end);
   pathfinder_->findPath(geoDistPath_);
+
+  if (geoDistCache_.size() >= maxCacheSize)
+    geoDistCache_.clear();
+  geoDistCache_.emplace(key, geoDistPath_.geodesicDistance);
   return geoDistPath_.geodesicDistance;
 }
 
 GreedyGeodesicFollowerImpl::TryStepResult GreedyGeodesicFollowerImpl::tryStep(
     const scene::SceneNode& node,
     const Mn::Vector3& end) {
+  validateCaches(end);
+  const PoseKey key = poseKey(node.MagnumObject::translation(),
+                              node.MagnumObject::rotation());
+  if (tryStepCacheEnabled_) {
+    auto it = tryStepCache_.find(key);
+    if (it != tryStepCache_.end()) {
+      ++cacheStats_.tryStepHits;
+      return it->second;
+    }
+    ++cacheStats_.tryStepMisses;
+  }
+
   tryStepDummyNode_.MagnumObject::setTransformation(
       node.MagnumObject::transformation());
 
@@ -53,7 +126,13 @@ GreedyGeodesicFollowerImpl::TryStepResult GreedyGeodesicFollowerImpl::tryStep(
   const float distToObsAfter = pathfinder_->distanceToClosestObstacle(
       cast<vec3f>(newPose), 1.1 * closeToObsThreshold_);
 
-  return {geoDistAfter, distToObsAfter, didCollide};
+  const TryStepResult result{geoDistAfter, distToObsAfter, didCollide};
+  if (tryStepCacheEnabled_) {
+    if (tryStepCache_.size() >= maxCacheSize)
+      tryStepCache_.clear();
+    tryStepCache_.emplace(key, result);
+  }
+  return result;
 }
 
 float GreedyGeodesicFollowerImpl::computeReward(const scene::SceneNode& node,
@@ -157,10 +236,11 @@ bool GreedyGeodesicFollowerImpl::isThrashing() {
 GreedyGeodesicFollowerImpl::CODES GreedyGeodesicFollowerImpl::nextActionAlong(
     const core::RigidState& start,
     const Mn::Vector3& end) {
+  // Only the distance of the path is needed for planning
   ShortestPath path;
   path.requestedStart = cast<vec3f>(start.translation);
   path.requestedEnd = cast<vec3f>(end);
-  pathfinder_->findPath(path);
+  path.geodesicDistance = geoDist(start.translation, end);
 
   CODES nextAction;
   if (fixThrashing_ && thrashingActions_.size() > 0) {
@@ -197,7 +277,7 @@ GreedyGeodesicFollowerImpl::findPath(const core::RigidState& start,
     ShortestPath path;
     path.requestedStart = cast<vec3f>(state.translation);
     path.requestedEnd = cast<vec3f>(end);
-    pathfinder_->findPath(path);
+    path.geodesicDistance = geoDist(state.translation, end);
     const auto nextPrim = nextBestPrimAlong(state, path);
     if (nextPrim.size() == 0) {
       actions_.emplace_back(CODES::ERROR);
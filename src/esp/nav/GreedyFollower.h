@@ -5,6 +5,8 @@
 #ifndef ESP_NAV_GREEDYFOLLOWER_H_
 #define ESP_NAV_GREEDYFOLLOWER_H_
 
+#include <unordered_map>
+
 #include "esp/core/RigidState.h"
 #include "esp/core/esp.h"
 #include "esp/nav/PathFinder.h"
@@ -44,6 +46,19 @@ class GreedyGeodesicFollowerImpl {
     RIGHT = 2
   };
 
+  /**
+   * @brief Hit and miss counts of the planning caches
+   *
+   * Geodesic distances are cached by position and simulated forward steps by
+   * pose, for the current goal.
+   */
+  struct CacheStats {
+    uint64_t geoDistHits = 0;
+    uint64_t geoDistMisses = 0;
+    uint64_t tryStepHits = 0;
+    uint64_t tryStepMisses = 0;
+  };
+
   /**
    * @brief Helper typedef for function pointer to a function that manipulates a
    * scene node.
@@ -120,6 +135,25 @@ class GreedyGeodesicFollowerImpl {
    */
   void reset();
 
+  /**
+   * @brief Hit and miss counts of the planning caches since construction or
+   * the last call to @ref resetCacheStats
+   */
+  const CacheStats& getCacheStats() const { return cacheStats_; }
+
+  void resetCacheStats() { cacheStats_ = CacheStats{}; }
+
+  /**
+   * @brief Whether simulated forward steps are cached by pose. Enabled by
+   * default.
+   *
+   * Disable if the move functions have actuation noise, as the cache would
+   * otherwise repeat the first noisy outcome of each pose.
+   */
+  void setTryStepCacheEnabled(bool enabled) { tryStepCacheEnabled_ = enabled; }
+
+  bool isTryStepCacheEnabled() const { return tryStepCacheEnabled_; }
+
  private:
   PathFinder::ptr pathfinder_;
   MoveFn moveForward_, turnLeft_, turnRight_;
@@ -146,6 +180,29 @@ class GreedyGeodesicFollowerImpl {
     bool didCollide;
   };
 
+  // Poses quantized finely enough that only repeated poses, e.g. from turning
+  // in place or thrashing, share a key
+  struct PoseKey {
+    int32_t v[7];
+    bool operator==(const PoseKey& other) const;
+  };
+  struct PoseKeyHash {
+    size_t operator()(const PoseKey& key) const;
+  };
+  static PoseKey poseKey(const Magnum::Vector3& translation,
+                         const Magnum::Quaternion& rotation = {});
+
+  // Clears the caches if the goal or the navmesh changed since they were
+  // filled
+  void validateCaches(const Magnum::Vector3& end);
+
+  std::unordered_map<PoseKey, float, PoseKeyHash> geoDistCache_;
+  std::unordered_map<PoseKey, TryStepResult, PoseKeyHash> tryStepCache_;
+  Magnum::Vector3 cacheGoal_;
+  uint64_t cacheNavMeshVersion_ = 0;
+  CacheStats cacheStats_;
+  bool tryStepCacheEnabled_ = true;
+
   TryStepResult tryStep(const scene::SceneNode& node,
                         const Magnum::Vector3& end);
 
@@ -0,0 +1,449 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "HierarchicalPlanner.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <tuple>
+#include <unordered_map>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "DetourNavMeshQuery.h"
+
+namespace esp {
+namespace nav {
+
+namespace {
+constexpr uint32_t NONE = ~uint32_t{0};
+
+const int HIERARCHY_MAGIC = 'H' << 24 | 'P' << 16 | 'A' << 8 | 'S';  //'HPAS'
+const int HIERARCHY_VERSION = 1;
+
+struct HierarchyFileHeader {
+  int magic;
+  int version;
+  uint64_t navMeshSignature;
+  int maxRegionPolys;
+  int numRegions;
+  uint32_t numPolys;
+  uint32_t numCrossings;
+  uint32_t numEdges;
+  uint32_t reserved;
+};
+}  // namespace
+
+HierarchicalPlanner::HierarchicalPlanner(const dtNavMesh* navMesh)
+    : navMesh_{navMesh}, polyIndex_{navMesh} {}
+
+void HierarchicalPlanner::initLinks(const dtQueryFilter* filter) {
+  const uint32_t numPolys = polyIndex_.size();
+  polyRefs_.assign(numPolys, 0);
+  linkStart_.assign(numPolys + 1, 0);
+  linkOwner_.clear();
+  linkTo_.clear();
+  linkPoints_.clear();
+
+  for (int iTile = 0; iTile < navMesh_->getMaxTiles(); ++iTile) {
+    const dtMeshTile* tile = navMesh_->getTile(iTile);
+    if (!tile || !tile->header)
+      continue;
+
+    for (int jPoly = 0; jPoly < tile->header->polyCount; ++jPoly) {
+      const dtPolyRef ref = navMesh_->encodePolyId(tile->salt, iTile, jPoly);
+      const uint32_t iPoly = polyIndex_(ref);
+      const dtPoly* poly = &tile->polys[jPoly];
+      polyRefs_[iPoly] = ref;
+      linkStart_[iPoly] = linkTo_.size();
+      if (!filter->passFilter(ref, tile, poly))
+        continue;
+
+      for (unsigned int iLink = poly->firstLink; iLink != DT_NULL_LINK;
+           iLink = tile->links[iLink].next) {
+        const dtLink& link = tile->links[iLink];
+        const dtMeshTile* neighbourTile = nullptr;
+        const dtPoly* neighbourPoly = nullptr;
+        navMesh_->getTileAndPolyByRefUnsafe(link.ref, &neighbourTile,
+                                            &neighbourPoly);
+        if (!filter->passFilter(link.ref, neighbourTile, neighbourPoly))
+          continue;
+
+        linkOwner_.push_back(iPoly);
+        linkTo_.push_back(polyIndex_(link.ref));
+        linkPoints_.push_back(impl::linkMidpoint(tile, poly, link));
+      }
+    }
+  }
+  linkStart_.back() = linkTo_.size();
+}
+
+void HierarchicalPlanner::initCrossings() {
+  const uint32_t numLinks = linkTo_.size();
+  linkCrossing_.assign(numLinks, NONE);
+  for (uint32_t i = 0; i < crossingLink_.size(); ++i) {
+    linkCrossing_[crossingLink_[i]] = i;
+  }
+
+  // The twin is the link of the neighbour back to the owner whose portal is
+  // closest
+  crossingTwin_.assign(crossingLink_.size(), NONE);
+  for (uint32_t i = 0; i < crossingLink_.size(); ++i) {
+    const uint32_t link = crossingLink_[i];
+    const uint32_t neighbour = linkTo_[link];
+    float bestDist = std::numeric_limits<float>::infinity();
+    for (uint32_t j = linkStart_[neighbour]; j < linkStart_[neighbour + 1];
+         ++j) {
+      if (linkTo_[j] != linkOwner_[link] || linkCrossing_[j] == NONE)
+        continue;
+      const float dist = (linkPoints_[j] - linkPoints_[link]).norm();
+      if (dist < bestDist) {
+        bestDist = dist;
+        crossingTwin_[i] = linkCrossing_[j];
+      }
+    }
+  }
+}
+
+bool HierarchicalPlanner::build(const dtQueryFilter* filter,
+                                const int maxRegionPolys) {
+  if (maxRegionPolys <= 0) {
+    LOG(ERROR) << "maxRegionPolys must be positive";
+    return false;
+  }
+  initLinks(filter);
+  const uint32_t numPolys = polyIndex_.size();
+
+  // Grow regions breadth-first from the first unassigned walkable polygon
+  // until they reach the maximum size.  This keeps them compact.
+  maxRegionPolys_ = maxRegionPolys;
+  numRegions_ = 0;
+  polyRegion_.assign(numPolys, NONE);
+  std::vector<uint32_t> queue;
+  for (uint32_t seed = 0; seed < numPolys; ++seed) {
+    if (polyRegion_[seed] != NONE || linkStart_[seed] == linkStart_[seed + 1])
+      continue;
+
+    const uint32_t region = numRegions_++;
+    queue.assign(1, seed);
+    polyRegion_[seed] = region;
+    int regionSize = 1;
+    for (size_t head = 0; head < queue.size(); ++head) {
+      const uint32_t poly = queue[head];
+      for (uint32_t i = linkStart_[poly];
+           i < linkStart_[poly + 1] && regionSize < maxRegionPolys; ++i) {
+        const uint32_t neighbour = linkTo_[i];
+        if (polyRegion_[neighbour] != NONE)
+          continue;
+        polyRegion_[neighbour] = region;
+        queue.push_back(neighbour);
+        ++regionSize;
+      }
+    }
+  }
+
+  crossingLink_.clear();
+  for (uint32_t i = 0; i < linkTo_.size(); ++i) {
+    if (polyRegion_[linkOwner_[i]] != polyRegion_[linkTo_[i]])
+      crossingLink_.push_back(i);
+  }
+  initCrossings();
+
+  // Costs from entering a region through a portal to leaving it through any
+  // other portal.  Every portal is independent, so they are computed in
+  // parallel
+  const int numCrossings = crossingLink_.size();
+  std::vector<std::vector<std::pair<uint32_t, float>>> edges(numCrossings);
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < numCrossings; ++i) {
+    const uint32_t link = crossingLink_[i];
+    regionDistances(linkTo_[link], linkPoints_[link], edges[i]);
+  }
+
+  edgeStart_.assign(numCrossings + 1, 0);
+  edgeTo_.clear();
+  edgeCost_.clear();
+  for (int i = 0; i < numCrossings; ++i) {
+    edgeStart_[i] = edgeTo_.size();
+    for (const auto& edge : edges[i]) {
+      // Turning around through the same portal never helps
+      if (edge.first == crossingTwin_[i])
+        continue;
+      edgeTo_.push_back(edge.first);
+      edgeCost_.push_back(edge.second);
+    }
+  }
+  edgeStart_.back() = edgeTo_.size();
+
+  LOG(INFO) << "Built navmesh hierarchy with " << numRegions_ << " regions, "
+            << numCrossings << " portals and " << edgeTo_.size() << " edges";
+  return true;
+}
+
+void HierarchicalPlanner::regionDistances(
+    const uint32_t poly,
+    const vec3f& pt,
+    std::vector<std::pair<uint32_t, float>>& exits) const {
+  exits.clear();
+  const uint32_t region = polyRegion_[poly];
+
+  // Dijkstra over the link midpoints of the polygons in the region
+  typedef std::pair<float, uint32_t> QueueEntry;
+  std::priority_queue<QueueEntry, std::vector<QueueEntry>,
+                      std::greater<QueueEntry>>
+      queue;
+  std::unordered_map<uint32_t, float> dist;
+  const auto relax = [&](uint32_t link, float d) {
+    auto it = dist.find(link);
+    if (it == dist.end() || d < it->second) {
+      dist[link] = d;
+      queue.emplace(d, link);
+    }
+  };
+
+  for (uint32_t i = linkStart_[poly]; i < linkStart_[poly + 1]; ++i) {
+    relax(i, (linkPoints_[i] - pt).norm());
+  }
+
+  while (!queue.empty()) {
+    const float d = queue.top().first;
+    const uint32_t link = queue.top().second;
+    queue.pop();
+    if (d > dist[link])
+      continue;
+
+    const uint32_t neighbour = linkTo_[link];
+    if (polyRegion_[neighbour] != region) {
+      exits.emplace_back(linkCrossing_[link], d);
+      continue;
+    }
+
+    for (uint32_t i = linkStart_[neighbour]; i < linkStart_[neighbour + 1];
+         ++i) {
+      relax(i, d + (linkPoints_[i] - linkPoints_[link]).norm());
+    }
+  }
+}
+
+bool HierarchicalPlanner::findCorridor(dtNavMeshQuery& navQuery,
+                                       const dtQueryFilter* filter,
+                                       const dtPolyRef startRef,
+                                       const vec3f& start,
+                                       const dtPolyRef endRef,
+                                       const vec3f& end,
+                                       std::vector<dtPolyRef>& corridor) const {
+  const uint32_t startPoly = polyIndex_(startRef);
+  const uint32_t endPoly = polyIndex_(endRef);
+  if (startPoly >= polyRegion_.size() || endPoly >= polyRegion_.size())
+    return false;
+  const uint32_t startRegion = polyRegion_[startPoly];
+  const uint32_t endRegion = polyRegion_[endPoly];
+  if (startRegion == NONE || endRegion == NONE || startRegion == endRegion)
+    return false;
+
+  std::vector<std::pair<uint32_t, float>> startExits, endExits;
+  regionDistances(startPoly, start, startExits);
+  regionDistances(endPoly, end, endExits);
+
+  // Cost from entering the end region through a portal to reaching the end
+  std::unordered_map<uint32_t, float> goalCost;
+  for (const auto& exit : endExits) {
+    const uint32_t entry = crossingTwin_[exit.first];
+    if (entry != NONE)
+      goalCost[entry] = exit.second;
+  }
+  if (goalCost.empty())
+    return false;
+
+  // A* over the portal graph with a virtual goal node
+  const uint32_t goal = crossingLink_.size();
+  const auto heuristic = [&](uint32_t crossing) {
+    return (linkPoints_[crossingLink_[crossing]] - end).norm();
+  };
+  typedef std::tuple<float, float, uint32_t> QueueEntry;
+  std::priority_queue<QueueEntry, std::vector<QueueEntry>,
+                      std::greater<QueueEntry>>
+      queue;
+  std::unordered_map<uint32_t, std::pair<float, uint32_t>> best;
+  const auto relax = [&](uint32_t crossing, float g, uint32_t parent) {
+    auto it = best.find(crossing);
+    if (it != best.end() && it->second.first <= g)
+      return;
+    best[crossing] = std::make_pair(g, parent);
+    queue.emplace(g + (crossing == goal ? 0.0f : heuristic(crossing)), g,
+                  crossing);
+  };
+
+  for (const auto& exit : startExits) {
+    relax(exit.first, exit.second, NONE);
+  }
+  bool found = false;
+  while (!queue.empty()) {
+    const float g = std::get<1>(queue.top());
+    const uint32_t crossing = std::get<2>(queue.top());
+    queue.pop();
+    if (crossing == goal) {
+      found = true;
+      break;
+    }
+    if (g > best[crossing].first)
+      continue;
+
+    auto goalIt = goalCost.find(crossing);
+    if (goalIt != goalCost.end())
+      relax(goal, g + goalIt->second, crossing);
+    for (uint32_t i = edgeStart_[crossing]; i < edgeStart_[crossing + 1];
+         ++i) {
+      relax(edgeTo_[i], g + edgeCost_[i], crossing);
+    }
+  }
+  if (!found)
+    return false;
+
+  std::vector<uint32_t> crossings;
+  for (uint32_t crossing = best[goal].second; crossing != NONE;
+       crossing = best[crossing].second) {
+    crossings.push_back(crossing);
+  }
+  std::reverse(crossings.begin(), crossings.end());
+
+  // Refine with short Detour queries from portal to portal
+  static const int MAX_POLYS = 256;
+  dtPolyRef polys[MAX_POLYS];
+  corridor.clear();
+  const auto appendSegment = [&](dtPolyRef fromRef, const vec3f& from,
+                                 dtPolyRef toRef, const vec3f& to) {
+    int numPolys = 0;
+    const dtStatus status =
+        navQuery.findPath(fromRef, toRef, from.data(), to.data(), filter, polys,
+                          &numPolys, MAX_POLYS);
+    if (status != DT_SUCCESS || numPolys == 0)
+      return false;
+    corridor.insert(corridor.end(), polys, polys + numPolys);
+    return true;
+  };
+
+  dtPolyRef segmentRef = startRef;
+  vec3f segmentStart = start;
+  for (const uint32_t crossing : crossings) {
+    const uint32_t link = crossingLink_[crossing];
+    if (!appendSegment(segmentRef, segmentStart, polyRefs_[linkOwner_[link]],
+                       linkPoints_[link]))
+      return false;
+    segmentRef = polyRefs_[linkTo_[link]];
+    segmentStart = linkPoints_[link];
+  }
+  if (!appendSegment(segmentRef, segmentStart, endRef, end))
+    return false;
+
+  // Cut out loops where consecutive segments overlap
+  std::unordered_map<dtPolyRef, size_t> position;
+  size_t size = 0;
+  for (size_t i = 0; i < corridor.size(); ++i) {
+    auto it = position.find(corridor[i]);
+    if (it != position.end()) {
+      const size_t loopStart = it->second;
+      for (size_t j = loopStart + 1; j < size; ++j) {
+        position.erase(corridor[j]);
+      }
+      size = loopStart + 1;
+      continue;
+    }
+    position[corridor[i]] = size;
+    corridor[size++] = corridor[i];
+  }
+  corridor.resize(size);
+
+  return true;
+}
+
+bool HierarchicalPlanner::save(const std::string& path) const {
+  FILE* fp = fopen(path.c_str(), "wb");
+  if (!fp)
+    return false;
+
+  HierarchyFileHeader header{};
+  header.magic = HIERARCHY_MAGIC;
+  header.version = HIERARCHY_VERSION;
+  header.navMeshSignature = impl::navMeshSignature(navMesh_);
+  header.maxRegionPolys = maxRegionPolys_;
+  header.numRegions = numRegions_;
+  header.numPolys = polyRegion_.size();
+  header.numCrossings = crossingLink_.size();
+  header.numEdges = edgeTo_.size();
+  const bool success = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+                       impl::writeArray(fp, polyRegion_) &&
+                       impl::writeArray(fp, crossingLink_) &&
+                       impl::writeArray(fp, edgeStart_) &&
+                       impl::writeArray(fp, edgeTo_) &&
+                       impl::writeArray(fp, edgeCost_);
+  fclose(fp);
+
+  if (!success)
+    LOG(ERROR) << "Could not write navmesh hierarchy file " << path;
+  return success;
+}
+
+bool HierarchicalPlanner::load(const std::string& path,
+                               const dtQueryFilter* filter) {
+  FILE* fp = fopen(path.c_str(), "rb");
+  if (!fp)
+    return false;
+
+  HierarchyFileHeader header{};
+  if (fread(&header, sizeof(header), 1, fp) != 1 ||
+      header.magic != HIERARCHY_MAGIC ||
+      header.version != HIERARCHY_VERSION) {
+    fclose(fp);
+    LOG(WARNING) << "Navmesh hierarchy file " << path << " is invalid";
+    return false;
+  }
+  if (header.navMeshSignature != impl::navMeshSignature(navMesh_) ||
+      header.numPolys != polyIndex_.size()) {
+    fclose(fp);
+    LOG(WARNING) << "Navmesh hierarchy file " << path
+                 << " was computed for a different navmesh, ignoring it";
+    return false;
+  }
+
+  initLinks(filter);
+  bool success = impl::readArray(fp, polyRegion_, header.numPolys) &&
+                 impl::readArray(fp, crossingLink_, header.numCrossings) &&
+                 impl::readArray(fp, edgeStart_, header.numCrossings + 1) &&
+                 impl::readArray(fp, edgeTo_, header.numEdges) &&
+                 impl::readArray(fp, edgeCost_, header.numEdges);
+  fclose(fp);
+
+  // Everything that is used as an index has to be in range
+  for (size_t i = 0; success && i < crossingLink_.size(); ++i) {
+    success = crossingLink_[i] < linkTo_.size();
+  }
+  for (size_t i = 0; success && i < edgeTo_.size(); ++i) {
+    success = edgeTo_[i] < header.numCrossings;
+  }
+  for (size_t i = 0; success && i < polyRegion_.size(); ++i) {
+    success = polyRegion_[i] == NONE ||
+              polyRegion_[i] < static_cast<uint32_t>(header.numRegions);
+  }
+  success = success && edgeStart_.back() == header.numEdges &&
+            std::is_sorted(edgeStart_.begin(), edgeStart_.end());
+  if (!success) {
+    LOG(WARNING) << "Navmesh hierarchy file " << path << " is invalid";
+    polyRegion_.clear();
+    crossingLink_.clear();
+    return false;
+  }
+
+  maxRegionPolys_ = header.maxRegionPolys;
+  numRegions_ = header.numRegions;
+  initCrossings();
+  return true;
+}
+
+}  // namespace nav
+}  // namespace esp
@@ -0,0 +1,114 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_NAV_HIERARCHICALPLANNER_H_
+#define ESP_NAV_HIERARCHICALPLANNER_H_
+
+#include <string>
+#include <vector>
+
+#include "esp/core/esp.h"
+
+#include "NavMeshUtils.h"
+
+class dtNavMeshQuery;
+class dtQueryFilter;
+
+namespace esp {
+namespace nav {
+/**
+ * @brief Two-level path planner for long queries on large navmeshes
+ *
+ * Walkable polygons are clustered into regions of connected polygons.  The
+ * edges between polygons of different regions are the portals of an abstract
+ * graph, whose costs within each region are precomputed.  Queries between
+ * regions are planned on the abstract graph first and then refined with short
+ * Detour queries between consecutive portals, which are concatenated into a
+ * single polygon corridor.
+ */
+class HierarchicalPlanner {
+ public:
+  explicit HierarchicalPlanner(const dtNavMesh* navMesh);
+
+  /**
+   * @brief Clusters the navmesh into regions of at most @p maxRegionPolys
+   * polygons and precomputes the portal graph
+   */
+  bool build(const dtQueryFilter* filter, int maxRegionPolys);
+
+  /**
+   * @brief Saves the precomputed regions and portal graph
+   */
+  bool save(const std::string& path) const;
+
+  /**
+   * @brief Loads regions and a portal graph saved by @ref save. Fails if they
+   * were computed for a different navmesh.
+   */
+  bool load(const std::string& path, const dtQueryFilter* filter);
+
+  /**
+   * @brief Finds a polygon corridor from @p start to @p end
+   *
+   * @return False if both are in the same region or no corridor was found, in
+   * which case a regular Detour query should be used
+   */
+  bool findCorridor(dtNavMeshQuery& navQuery,
+                    const dtQueryFilter* filter,
+                    dtPolyRef startRef,
+                    const vec3f& start,
+                    dtPolyRef endRef,
+                    const vec3f& end,
+                    std::vector<dtPolyRef>& corridor) const;
+
+  int numRegions() const { return numRegions_; }
+
+  int numPortals() const { return crossingLink_.size(); }
+
+ private:
+  // Walkable links of all polygons, independent of the regions
+  void initLinks(const dtQueryFilter* filter);
+  // Portals and their twins, once the regions are known
+  void initCrossings();
+
+  // Distances from pt in polygon poly to the portals leaving its region,
+  // staying within the region
+  void regionDistances(uint32_t poly,
+                       const vec3f& pt,
+                       std::vector<std::pair<uint32_t, float>>& exits) const;
+
+  const dtNavMesh* navMesh_;
+  impl::PolyIndex polyIndex_;
+  std::vector<dtPolyRef> polyRefs_;
+
+  // Links of polygon i are [linkStart_[i], linkStart_[i + 1])
+  std::vector<uint32_t> linkStart_;
+  std::vector<uint32_t> linkOwner_;
+  std::vector<uint32_t> linkTo_;
+  std::vector<vec3f> linkPoints_;
+
+  int maxRegionPolys_ = 0;
+  int numRegions_ = 0;
+  std::vector<uint32_t> polyRegion_;
+
+  // Portals are the links between regions.  Each has a twin going the other
+  // way
+  std::vector<uint32_t> crossingLink_;
+  std::vector<uint32_t> crossingTwin_;
+  std::vector<uint32_t> linkCrossing_;
+
+  // Portal graph, edges of portal i are [edgeStart_[i], edgeStart_[i + 1]).
+  // An edge from portal i to j is the cost of going from where i enters its
+  // region to where j leaves it
+  std::vector<uint32_t> edgeStart_;
+  std::vector<uint32_t> edgeTo_;
+  std::vector<float> edgeCost_;
+
+  ESP_SMART_POINTERS(HierarchicalPlanner)
+};
+
+}  // namespace nav
+}  // namespace esp
+
+#endif  // ESP_NAV_HIERARCHICALPLANNER_H_
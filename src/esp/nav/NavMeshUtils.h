@@ -0,0 +1,105 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_NAV_NAVMESHUTILS_H_
+#define ESP_NAV_NAVMESHUTILS_H_
+
+#include <cstdio>
+#include <vector>
+
+#include "esp/core/esp.h"
+
+#include "DetourNavMesh.h"
+
+namespace esp {
+namespace nav {
+namespace impl {
+
+// Maps polygon refs to dense indices, in tile order.  Gives O(1) lookup
+// without hashing and takes O(ntiles) to construct
+class PolyIndex {
+ public:
+  explicit PolyIndex(const dtNavMesh* navMesh)
+      : navMesh_{navMesh}, tileBase_(navMesh->getMaxTiles() + 1, 0) {
+    uint32_t numPolys = 0;
+    for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
+      tileBase_[iTile] = numPolys;
+      const dtMeshTile* tile = navMesh->getTile(iTile);
+      if (tile && tile->header)
+        numPolys += tile->header->polyCount;
+    }
+    tileBase_.back() = numPolys;
+  }
+
+  uint32_t size() const { return tileBase_.back(); }
+
+  // Index of a valid polygon ref
+  inline uint32_t operator()(dtPolyRef ref) const {
+    unsigned int salt = 0, iTile = 0, iPoly = 0;
+    navMesh_->decodePolyId(ref, salt, iTile, iPoly);
+    return tileBase_[iTile] + iPoly;
+  }
+
+ private:
+  const dtNavMesh* navMesh_;
+  std::vector<uint32_t> tileBase_;
+};
+
+// Midpoint of the part of a polygon edge covered by a link.  Links to other
+// tiles can cover only part of the edge
+inline vec3f linkMidpoint(const dtMeshTile* tile,
+                          const dtPoly* poly,
+                          const dtLink& link) {
+  vec3f left =
+      Eigen::Map<const vec3f>(&tile->verts[poly->verts[link.edge] * 3]);
+  vec3f right = Eigen::Map<const vec3f>(
+      &tile->verts[poly->verts[(link.edge + 1) % poly->vertCount] * 3]);
+  if (link.side != 0xff && (link.bmin != 0 || link.bmax != 255)) {
+    const vec3f edge = right - left;
+    right = left + edge * (link.bmax / 255.0f);
+    left = left + edge * (link.bmin / 255.0f);
+  }
+  return 0.5f * (left + right);
+}
+
+// Identifies the tile and polygon layout of a navmesh, which data stored
+// by polygon index depends on.  FNV-1a over the tile refs and sizes
+inline uint64_t navMeshSignature(const dtNavMesh* navMesh) {
+  uint64_t hash = 14695981039346656037ull;
+  const auto add = [&hash](uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+      hash = (hash ^ ((value >> (8 * i)) & 0xff)) * 1099511628211ull;
+    }
+  };
+  add(navMesh->getMaxTiles());
+  for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
+    const dtMeshTile* tile = navMesh->getTile(iTile);
+    if (!tile || !tile->header)
+      continue;
+    add(navMesh->getTileRef(tile));
+    add(tile->header->polyCount);
+    add(tile->header->vertCount);
+  }
+  return hash;
+}
+
+// Helpers for the binary files of data derived from a navmesh
+template <typename T>
+bool writeArray(FILE* fp, const std::vector<T>& array) {
+  return array.empty() ||
+         fwrite(array.data(), sizeof(T), array.size(), fp) == array.size();
+}
+
+template <typename T>
+bool readArray(FILE* fp, std::vector<T>& array, size_t size) {
+  array.resize(size);
+  return array.empty() ||
+         fread(array.data(), sizeof(T), array.size(), fp) == array.size();
+}
+
+}  // namespace impl
+}  // namespace nav
+}  // namespace esp
+
+#endif  // ESP_NAV_NAVMESHUTILS_H_
@@ -3,8 +3,11 @@
 // LICENSE file in the root directory of this source tree.
 
 #include "PathFinder.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <numeric>
-#include <stack>
+#include <queue>
 #include <unordered_map>
 
 #include <Magnum/Magnum.h>
@@ -14,16 +17,31 @@
 #include <Magnum/EigenIntegration/Integration.h>
 
 #include <Corrade/Containers/Optional.h>
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/Directory.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <cstdio>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 // NOLINTNEXTLINE
 #define _USE_MATH_DEFINES
 #include <cmath>
 #include <limits>
 
 #include "esp/assets/MeshData.h"
+#include "esp/core/Check.h"
 #include "esp/core/esp.h"
+#include "esp/core/random.h"
 
+#include "ClearanceField.h"
+#include "HierarchicalPlanner.h"
+
+#include "DetourCommon.h"
 #include "DetourNavMesh.h"
 #include "DetourNavMeshBuilder.h"
 #include "DetourNavMeshQuery.h"
@@ -85,134 +103,321 @@ std::tuple<dtStatus, dtPolyRef, vec3f> projectToPoly(
 
   return std::make_tuple(status, polyRef, polyXYZ);
 }
+
+// Number of threads the batched queries are spread over
+int maxThreads() {
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+// Index of the calling thread within a parallel region
+int threadIndex() {
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
 }  // namespace
 
 namespace impl {
 
+// A private, copy-on-write memory mapping of a file.  Detour writes links into
+// the tile data it is given, so only the pages it touches get copied while the
+// rest stays shared with the page cache
+class MappedFile {
+ public:
+  static std::unique_ptr<MappedFile> open(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return nullptr;
+
+    struct stat st {};
+    void* data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      data = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+                  0);
+    }
+    // The mapping stays valid after the file is closed
+    close(fd);
+    if (data == MAP_FAILED)
+      return nullptr;
+
+    return std::unique_ptr<MappedFile>{
+        new MappedFile{static_cast<unsigned char*>(data),
+                       static_cast<size_t>(st.st_size)}};
+  }
+
+  ~MappedFile() { munmap(data_, size_); }
+
+  unsigned char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  MappedFile(unsigned char* data, size_t size) : data_{data}, size_{size} {}
+
+  unsigned char* data_;
+  size_t size_;
+};
+
+constexpr uint32_t NO_ISLAND = ~uint32_t{0};
+
 // Runs connected component analysis on the navmesh to figure out which polygons
 // are connected This gives O(1) lookup for if a path between two polygons
 // exists or not
 // Takes O(npolys) to construct
 class IslandSystem {
  public:
-  IslandSystem(const dtNavMesh* navMesh, const dtQueryFilter* filter) {
-    std::vector<vec3f> islandVerts;
-
-    // Iterate over all tiles
-    for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
+  IslandSystem(const dtNavMesh* navMesh, const dtQueryFilter* filter)
+      : polyIndex_{navMesh} {
+    const int numTiles = navMesh->getMaxTiles();
+    const uint32_t numPolys = polyIndex_.size();
+
+    // Union-find over the dense polygon indices.  Polygons that aren't
+    // walkable are never joined and don't get an island
+    std::vector<uint32_t> parent(numPolys);
+    std::iota(parent.begin(), parent.end(), 0);
+    std::vector<char> walkable(numPolys, 0);
+
+    // Links within a tile only ever touch the polygons of that tile, so tiles
+    // can be processed in parallel.  Links between tiles are joined after
+    const auto forEachLink = [&](int iTile, bool sameTile) {
       const dtMeshTile* tile = navMesh->getTile(iTile);
-      if (!tile)
-        continue;
+      if (!tile || !tile->header)
+        return;
 
-      // Iterate over all polygons in a tile
       for (int jPoly = 0; jPoly < tile->header->polyCount; ++jPoly) {
-        // Get the polygon reference from the tile and polygon id
-        dtPolyRef startRef = navMesh->encodePolyId(tile->salt, iTile, jPoly);
-
-        // If the polygon ref is valid, and we haven't seen it yet,
-        // start connected component analysis from this polygon
-        if (navMesh->isValidPolyRef(startRef) &&
-            (polyToIsland_.find(startRef) == polyToIsland_.end())) {
-          uint32_t newIslandId = islandRadius_.size();
-          expandFrom(navMesh, filter, newIslandId, startRef, islandVerts);
-
-          // The radius is calculated as the max deviation from the mean for all
-          // points in the island
-          vec3f centroid = vec3f::Zero();
-          for (auto& v : islandVerts) {
-            centroid += v;
-          }
-          centroid /= islandVerts.size();
+        const dtPolyRef ref = navMesh->encodePolyId(tile->salt, iTile, jPoly);
+        const uint32_t polyIdx = polyIndex_(ref);
+        const dtPoly* poly = &tile->polys[jPoly];
+        if (sameTile) {
+          walkable[polyIdx] = filter->passFilter(ref, tile, poly);
+        }
+        if (!walkable[polyIdx])
+          continue;
 
-          float maxRadius = 0.0;
-          for (auto& v : islandVerts) {
-            maxRadius = std::max(maxRadius, (v - centroid).norm());
-          }
+        for (unsigned int iLink = poly->firstLink; iLink != DT_NULL_LINK;
+             iLink = tile->links[iLink].next) {
+          const dtPolyRef neighbourRef = tile->links[iLink].ref;
+          if ((navMesh->decodePolyIdTile(neighbourRef) ==
+               static_cast<unsigned int>(iTile)) != sameTile)
+            continue;
+
+          const dtMeshTile* neighbourTile = nullptr;
+          const dtPoly* neighbourPoly = nullptr;
+          navMesh->getTileAndPolyByRefUnsafe(neighbourRef, &neighbourTile,
+                                             &neighbourPoly);
+
+          // If a neighbour isn't walkable, don't join it
+          if (!filter->passFilter(neighbourRef, neighbourTile, neighbourPoly))
+            continue;
 
-          islandRadius_.emplace_back(maxRadius);
+          join(parent, polyIdx, polyIndex_(neighbourRef));
         }
       }
+    };
+
+#pragma omp parallel for schedule(dynamic)
+    for (int iTile = 0; iTile < numTiles; ++iTile) {
+      forEachLink(iTile, true);
+    }
+    for (int iTile = 0; iTile < numTiles; ++iTile) {
+      forEachLink(iTile, false);
+    }
+
+    // Number the islands in the order of their first polygon
+    polyToIsland_.assign(numPolys, NO_ISLAND);
+    std::vector<uint32_t> rootToIsland(numPolys, NO_ISLAND);
+    for (uint32_t i = 0; i < numPolys; ++i) {
+      if (!walkable[i])
+        continue;
+      uint32_t& island = rootToIsland[find(parent, i)];
+      if (island == NO_ISLAND)
+        island = numIslands_++;
+      polyToIsland_[i] = island;
+    }
+
+    // The radius is calculated as the max deviation from the mean for all
+    // points in the island
+    std::vector<vec3f> centroids(numIslands_, vec3f::Zero());
+    std::vector<int> numVerts(numIslands_, 0);
+    forEachPolyVert(navMesh, [&](uint32_t island, const vec3f& v) {
+      centroids[island] += v;
+      ++numVerts[island];
+    });
+    for (uint32_t i = 0; i < numIslands_; ++i) {
+      centroids[i] /= numVerts[i];
     }
+
+    islandRadius_.assign(numIslands_, 0.0f);
+    forEachPolyVert(navMesh, [&](uint32_t island, const vec3f& v) {
+      islandRadius_[island] =
+          std::max(islandRadius_[island], (v - centroids[island]).norm());
+    });
   }
 
   inline bool hasConnection(dtPolyRef startRef, dtPolyRef endRef) const {
     // If both polygons are on the same island, there must be a path between
     // them
-    auto itStart = polyToIsland_.find(startRef);
-    if (itStart == polyToIsland_.end())
-      return false;
-
-    auto itEnd = polyToIsland_.find(endRef);
-    if (itEnd == polyToIsland_.end())
-      return false;
-
-    return itStart->second == itEnd->second;
+    const uint32_t startIsland = islandId(startRef);
+    return startIsland != NO_ISLAND && startIsland == islandId(endRef);
   }
 
   inline float islandRadius(dtPolyRef ref) const {
-    auto itRef = polyToIsland_.find(ref);
-    if (itRef == polyToIsland_.end())
+    const uint32_t island = islandId(ref);
+    if (island == NO_ISLAND)
       return 0.0;
 
-    return islandRadius_[itRef->second];
+    return islandRadius_[island];
   }
 
+  inline uint32_t islandId(dtPolyRef ref) const {
+    if (ref == 0)
+      return NO_ISLAND;
+    return polyToIsland_[polyIndex_(ref)];
+  }
+
+  uint32_t numIslands() const { return numIslands_; }
+
  private:
-  std::unordered_map<dtPolyRef, uint32_t> polyToIsland_;
+  PolyIndex polyIndex_;
+  std::vector<uint32_t> polyToIsland_;
   std::vector<float> islandRadius_;
+  uint32_t numIslands_ = 0;
 
-  void expandFrom(const dtNavMesh* navMesh,
-                  const dtQueryFilter* filter,
-                  const uint32_t newIslandId,
-                  const dtPolyRef& startRef,
-                  std::vector<vec3f>& islandVerts) {
-    polyToIsland_.emplace(startRef, newIslandId);
-    islandVerts.clear();
-
-    // Force std::stack to be implemented via an std::vector as linked
-    // lists are gross
-    std::stack<dtPolyRef, std::vector<dtPolyRef>> stack;
-
-    // Add the start ref to the stack
-    stack.push(startRef);
-    while (!stack.empty()) {
-      dtPolyRef ref = stack.top();
-      stack.pop();
-
-      const dtMeshTile* tile = nullptr;
-      const dtPoly* poly = nullptr;
-      navMesh->getTileAndPolyByRefUnsafe(ref, &tile, &poly);
-
-      for (int iVert = 0; iVert < poly->vertCount; ++iVert) {
-        islandVerts.emplace_back(
-            Eigen::Map<vec3f>(&tile->verts[poly->verts[iVert] * 3]));
-      }
+  static uint32_t find(std::vector<uint32_t>& parent, uint32_t i) {
+    // Path halving
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  }
 
-      // Iterate over all neighbours
-      for (unsigned int iLink = poly->firstLink; iLink != DT_NULL_LINK;
-           iLink = tile->links[iLink].next) {
-        dtPolyRef neighbourRef = tile->links[iLink].ref;
-        // If we've already visited this poly, skip it!
-        if (polyToIsland_.find(neighbourRef) != polyToIsland_.end())
-          continue;
+  static void join(std::vector<uint32_t>& parent, uint32_t a, uint32_t b) {
+    a = find(parent, a);
+    b = find(parent, b);
+    // Keep the smaller index as the root so the result doesn't depend on the
+    // order the links are visited in
+    if (a < b)
+      parent[b] = a;
+    else if (b < a)
+      parent[a] = b;
+  }
 
-        const dtMeshTile* neighbourTile = nullptr;
-        const dtPoly* neighbourPoly = nullptr;
-        navMesh->getTileAndPolyByRefUnsafe(neighbourRef, &neighbourTile,
-                                           &neighbourPoly);
+  template <typename F>
+  void forEachPolyVert(const dtNavMesh* navMesh, F&& f) const {
+    for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
+      const dtMeshTile* tile = navMesh->getTile(iTile);
+      if (!tile || !tile->header)
+        continue;
 
-        // If a neighbour isn't walkable, don't add it
-        if (!filter->passFilter(neighbourRef, neighbourTile, neighbourPoly))
+      for (int jPoly = 0; jPoly < tile->header->polyCount; ++jPoly) {
+        const uint32_t island = islandId(
+            navMesh->encodePolyId(tile->salt, iTile, jPoly));
+        if (island == NO_ISLAND)
           continue;
 
-        polyToIsland_.emplace(neighbourRef, newIslandId);
-        stack.push(neighbourRef);
+        const dtPoly* poly = &tile->polys[jPoly];
+        for (int iVert = 0; iVert < poly->vertCount; ++iVert) {
+          f(island, Eigen::Map<const vec3f>(
+                        &tile->verts[poly->verts[iVert] * 3]));
+        }
       }
     }
   }
 };
 }  // namespace impl
 
+namespace {
+//! A navmesh version that no navmesh of the process had before
+uint64_t nextNavMeshVersion() {
+  static std::atomic<uint64_t> counter{0};
+  return ++counter;
+}
+}  // namespace
+
+struct GoalDistanceField::Impl {
+  std::vector<vec3f> goals;
+
+  //! Version of the navmesh the field was computed for, 0 if none. Versions
+  //! are unique within the process, see nextNavMeshVersion().
+  uint64_t navMeshVersion = 0;
+
+  Cr::Containers::Optional<impl::PolyIndex> polyIndex;
+  //! Portals of polygon i are [portalStart[i], portalStart[i + 1])
+  std::vector<uint32_t> portalStart;
+  //! Midpoint of each portal and its geodesic distance to the closest goal
+  std::vector<vec3f> portalPoints;
+  std::vector<float> portalDist;
+  //! Goals projected onto the navmesh, by polygon index
+  std::unordered_map<uint32_t, std::vector<vec3f>> goalsByPoly;
+};
+
+GoalDistanceField::GoalDistanceField()
+    : pimpl_{spimpl::make_unique_impl<Impl>()} {};
+
+void GoalDistanceField::setGoals(const std::vector<vec3f>& newGoals) {
+  pimpl_->goals = newGoals;
+  pimpl_->navMeshVersion = 0;
+}
+
+const std::vector<vec3f>& GoalDistanceField::getGoals() const {
+  return pimpl_->goals;
+}
+
+namespace {
+// Layout of a navmesh built from tiles, kept around so that single tiles can be
+// rebuilt later
+struct TileLayout {
+  NavMeshSettings settings;
+  //! Config of the whole navmesh
+  rcConfig cfg{};
+  //! Config shared by all tiles, the bounds are set per tile
+  rcConfig tileCfg{};
+  int tilesX = 0;
+  int tilesZ = 0;
+
+  float tileWorldSize() const { return settings.tileSize * cfg.cs; }
+  float borderWorldSize() const { return tileCfg.borderSize * cfg.cs; }
+
+  // Range of tiles whose area including the border overlaps the given
+  // rectangle in the x-z plane.  Clamped to the existing tiles.
+  void tileRange(const float minX,
+                 const float minZ,
+                 const float maxX,
+                 const float maxZ,
+                 int& x0,
+                 int& z0,
+                 int& x1,
+                 int& z1) const {
+    const auto toTile = [this](float v, float orig, int numTiles) {
+      const int t = static_cast<int>(std::floor((v - orig) / tileWorldSize()));
+      return std::min(std::max(t, 0), numTiles - 1);
+    };
+    x0 = toTile(minX - borderWorldSize(), cfg.bmin[0], tilesX);
+    x1 = toTile(maxX + borderWorldSize(), cfg.bmin[0], tilesX);
+    z0 = toTile(minZ - borderWorldSize(), cfg.bmin[2], tilesZ);
+    z1 = toTile(maxZ + borderWorldSize(), cfg.bmin[2], tilesZ);
+  }
+
+  // Config of the tile at (x, z) including its border
+  rcConfig configForTile(const int x, const int z) const {
+    rcConfig localCfg = tileCfg;
+    localCfg.bmin[0] = cfg.bmin[0] + x * tileWorldSize() - borderWorldSize();
+    localCfg.bmin[2] = cfg.bmin[2] + z * tileWorldSize() - borderWorldSize();
+    localCfg.bmax[0] =
+        cfg.bmin[0] + (x + 1) * tileWorldSize() + borderWorldSize();
+    localCfg.bmax[2] =
+        cfg.bmin[2] + (z + 1) * tileWorldSize() + borderWorldSize();
+    return localCfg;
+  }
+};
+}  // namespace
+
 struct PathFinder::Impl {
   Impl();
   ~Impl() = default;
@@ -226,13 +431,51 @@ struct PathFinder::Impl {
              const float* bmax);
   bool build(const NavMeshSettings& bs, const esp::assets::MeshData& mesh);
 
+  bool rebuildTiles(const esp::assets::MeshData& mesh,
+                    const std::vector<std::pair<vec3f, vec3f>>& regions);
+
   vec3f getRandomNavigablePoint(int maxTries);
 
+  RowMatrixXf sampleNavigablePoints(
+      int n,
+      const NavigablePointSamplingOptions& options);
+
   bool findPath(ShortestPath& path);
   bool findPath(MultiGoalShortestPath& path);
 
+  bool buildHierarchy(int maxRegionPolys);
+  bool hasHierarchy() const { return hierarchy_ != nullptr; }
+  bool loadHierarchy(const std::string& path);
+  bool saveHierarchy(const std::string& path);
+  bool findPathHierarchical(ShortestPath& path);
+
+  bool buildClearanceField(float cellSize, float maxDistance);
+  bool hasClearanceField() const { return clearanceField_ != nullptr; }
+  bool loadClearanceField(const std::string& path);
+  bool saveClearanceField(const std::string& path);
+
+  int findPaths(std::vector<ShortestPath>& paths);
+  std::vector<float> geodesicDistances(const std::vector<vec3f>& starts,
+                                       const std::vector<vec3f>& ends);
+
+  float geodesicDistanceToGoals(const vec3f& pt, GoalDistanceField& field);
+
+  template <typename T>
+  T tryStep(const T& start, const T& end, bool allowSliding) {
+    return tryStep(start, end, allowSliding, *navQuery_);
+  }
+
   template <typename T>
-  T tryStep(const T& start, const T& end, bool allowSliding);
+  T tryStep(const T& start,
+            const T& end,
+            bool allowSliding,
+            dtNavMeshQuery& navQuery);
+
+  RowMatrixXf trySteps(const Eigen::Ref<const RowMatrixXf>& starts,
+                       const Eigen::Ref<const RowMatrixXf>& ends,
+                       bool allowSliding);
+
+  RowMatrixXf snapPoints(const Eigen::Ref<const RowMatrixXf>& points);
 
   template <typename T>
   T snapPoint(const T& pt);
@@ -241,7 +484,10 @@ struct PathFinder::Impl {
 
   bool saveNavMesh(const std::string& path);
 
+  uint64_t getSourceHash() const { return sourceHash_; };
+
   bool isLoaded() const { return navMesh_ != nullptr; };
+  uint64_t getNavMeshVersion() const { return navMeshVersion_; }
 
   float getNavigableArea() const { return navMeshArea_; };
 
@@ -249,6 +495,10 @@ struct PathFinder::Impl {
 
   float islandRadius(const vec3f& pt) const;
 
+  int getIslandId(const vec3f& pt) const;
+
+  int numIslands() const;
+
   float distanceToClosestObstacle(const vec3f& pt,
                                   const float maxSearchRadius = 2.0) const;
   HitRecord closestObstacleSurfacePoint(
@@ -273,10 +523,28 @@ struct PathFinder::Impl {
     void operator()(dtNavMeshQuery* query) { dtFreeNavMeshQuery(query); }
   };
 
+  //! Backs the tiles of a navmesh loaded from a mapped file.  Declared before
+  //! the navmesh so it outlives it
+  std::unique_ptr<impl::MappedFile> navMeshFile_ = nullptr;
   std::unique_ptr<dtNavMesh, NavMeshDeleter> navMesh_ = nullptr;
   std::unique_ptr<dtNavMeshQuery, NavQueryDeleter> navQuery_ = nullptr;
   std::unique_ptr<dtQueryFilter> filter_ = nullptr;
   std::unique_ptr<impl::IslandSystem> islandSystem_ = nullptr;
+  //! Optional, for long queries
+  std::unique_ptr<HierarchicalPlanner> hierarchy_ = nullptr;
+  //! Optional, for cheap obstacle distances
+  std::unique_ptr<ClearanceField> clearanceField_ = nullptr;
+
+  //! Hash of the source mesh and settings the navmesh was built from, 0 if
+  //! unknown
+  uint64_t sourceHash_ = 0;
+
+  //! Changes whenever polygon refs may have changed. Used to invalidate data
+  //! derived from the navmesh that is stored outside of the PathFinder. Taken
+  //! from a process-wide counter, so that data derived from another
+  //! PathFinder, even one that used to live at the same address, never
+  //! matches. 0 until a navmesh is loaded.
+  uint64_t navMeshVersion_ = 0;
 
   //! Holds triangulated geom/topo. Generated when queried. Reset with
   //! navQuery_.
@@ -288,21 +556,73 @@ struct PathFinder::Impl {
 
   std::pair<vec3f, vec3f> bounds_;
 
+  //! Set if the navmesh was built from tiles. See rebuildTiles.
+  Cr::Containers::Optional<TileLayout> tileLayout_;
+
   void removeZeroAreaPolys();
 
+  bool buildTiled(const rcConfig& cfg,
+                  const NavMeshSettings& bs,
+                  const float* verts,
+                  const int nverts,
+                  const int* tris,
+                  const int ntris,
+                  int& numVerts,
+                  int& numPolys);
+
   bool initNavQuery();
 
+  //! One query per thread for the batched queries, created on demand. A
+  //! dtNavMeshQuery isn't thread-safe, but the dtNavMesh they share is only
+  //! read from.
+  std::vector<std::unique_ptr<dtNavMeshQuery, NavQueryDeleter>> queryPool_;
+  //! Held by the batched queries while they use the pool, as concurrent calls
+  //! from different threads would each hand out the same thread indices
+  std::mutex queryPoolMutex_;
+
+  bool initQueryPool();
+
+  bool loadMappedNavMesh(const std::string& path);
+
+  void updateSampleTriangles();
+
+  //! Detail triangles of all walkable polygons, with their areas and
+  //! polygons, for sampling points. Valid for @ref sampleTrianglesVersion_
+  std::vector<vec3f> sampleTriangleVerts_;
+  std::vector<float> sampleTriangleAreas_;
+  std::vector<dtPolyRef> sampleTrianglePolys_;
+  uint64_t sampleTrianglesVersion_ = 0;
+  //! Seeds the point samplings that don't have a seed. Seeded by seed().
+  core::Random sampleRandom_;
+  //! Held while sampling points, which releases the GIL, as it updates the
+  //! sample triangles and draws from sampleRandom_
+  std::mutex sampleMutex_;
+
+  void computeGoalDistanceField(GoalDistanceField::Impl& field);
+
+  bool findPath(ShortestPath& path, dtNavMeshQuery& navQuery);
+  bool findPath(MultiGoalShortestPath& path, dtNavMeshQuery& navQuery);
+
   Cr::Containers::Optional<std::tuple<float, std::vector<vec3f>>>
-  findPathInternal(const vec3f& start,
+  findPathInternal(dtNavMeshQuery& navQuery,
+                   const vec3f& start,
                    dtPolyRef startRef,
                    const vec3f& pathStart,
                    const vec3f& end,
                    dtPolyRef endRef,
                    const vec3f& pathEnd);
 
-  bool findPathSetup(MultiGoalShortestPath& path,
+  bool findPathSetup(dtNavMeshQuery& navQuery,
+                     MultiGoalShortestPath& path,
                      dtPolyRef& startRef,
                      vec3f& pathStart);
+
+  // Index of the end of path closest to the start by a single Dijkstra search
+  // over polygons, seeded at the start and stopped at the first end reached.
+  // -1 if no end is reachable
+  int findClosestEnd(const MultiGoalShortestPath& path,
+                     dtPolyRef startRef,
+                     const vec3f& pathStart) const;
 };
 
 namespace {
@@ -332,29 +652,10 @@ enum PolyFlags {
   POLYFLAGS_DISABLED = 0x04,  // disabled polygon
   POLYFLAGS_ALL = 0xffff      // all abilities
 };
-}  // namespace
-
-PathFinder::Impl::Impl() {
-  filter_ = std::make_unique<dtQueryFilter>();
-  filter_->setIncludeFlags(POLYFLAGS_WALK);
-  filter_->setExcludeFlags(0);
-}
-
-bool PathFinder::Impl::build(const NavMeshSettings& bs,
-                             const float* verts,
-                             const int nverts,
-                             const int* tris,
-                             const int ntris,
-                             const float* bmin,
-                             const float* bmax) {
-  Workspace ws;
-  rcContext ctx;
-
-  //
-  // Step 1. Initialize build config.
-  //
 
-  // Init build configuration from GUI
+// Init the parts of the build configuration that are shared by all tiles.  The
+// grid size and the bounds are filled in by the caller.
+rcConfig makeRecastConfig(const NavMeshSettings& bs) {
   rcConfig cfg{};
   memset(&cfg, 0, sizeof(cfg));
   cfg.cs = bs.cellSize;
@@ -373,15 +674,33 @@ bool PathFinder::Impl::build(const NavMeshSettings& bs,
   cfg.detailSampleDist =
       bs.detailSampleDist < 0.9f ? 0 : bs.cellSize * bs.detailSampleDist;
   cfg.detailSampleMaxError = bs.cellHeight * bs.detailSampleMaxError;
+  return cfg;
+}
 
-  // Set the area where the navigation will be build.
-  // Here the bounds of the input mesh are used, but the
-  // area could be specified by an user defined box, etc.
-  rcVcopy(cfg.bmin, bmin);
-  rcVcopy(cfg.bmax, bmax);
-  rcCalcGridSize(cfg.bmin, cfg.bmax, cfg.cs, &cfg.width, &cfg.height);
-  LOG(INFO) << "Building navmesh with " << cfg.width << "x" << cfg.height
-            << " cells";
+// Detour data of a single tile. navData is nullptr if the tile doesn't contain
+// any walkable polygons.  Ownership of navData is passed on to the dtNavMesh
+// the tile is added to.
+struct TileBuildResult {
+  unsigned char* navData = nullptr;
+  int navDataSize = 0;
+  int numVerts = 0;
+  int numPolys = 0;
+};
+
+// Runs the Recast pipeline over the given triangles for the area described by
+// cfg and creates the Detour data for the tile at (tileX, tileY).
+// Only uses local state, so it is safe to build several tiles concurrently.
+bool buildTileNavData(const rcConfig& cfg,
+                      const NavMeshSettings& bs,
+                      const float* verts,
+                      const int nverts,
+                      const int* tris,
+                      const int ntris,
+                      const int tileX,
+                      const int tileY,
+                      TileBuildResult& result) {
+  Workspace ws;
+  rcContext ctx;
 
   //
   // Step 2. Rasterize input polygon soup.
@@ -505,7 +824,7 @@ bool PathFinder::Impl::build(const NavMeshSettings& bs,
     return false;
   }
   // Partition the walkable surface into simple regions without holes.
-  if (!rcBuildRegions(&ctx, *ws.chf, 0, cfg.minRegionArea,
+  if (!rcBuildRegions(&ctx, *ws.chf, cfg.borderSize, cfg.minRegionArea,
                       cfg.mergeRegionArea)) {
     LOG(ERROR) << "Could not build watershed regions";
     return false;
@@ -569,113 +888,429 @@ bool PathFinder::Impl::build(const NavMeshSettings& bs,
   // ws.pmesh. See duDebugDrawPolyMesh or dtCreateNavMeshData as examples how to
   // access the data.
 
+  // Nothing walkable in this area, which is fine for a single tile of a tiled
+  // navmesh.  It is up to the caller to decide whether this is an error.
+  if (ws.pmesh->npolys == 0) {
+    return true;
+  }
+
   //
   // (Optional) Step 8. Create Detour data from Recast poly mesh.
   //
 
-  // The GUI may allow more max points per polygon than Detour can handle.
-  // Only build the detour navmesh if we do not exceed the limit.
-  if (cfg.maxVertsPerPoly <= DT_VERTS_PER_POLYGON) {
-    unsigned char* navData = nullptr;
-    int navDataSize = 0;
-
-    // Update poly flags from areas.
-    for (int i = 0; i < ws.pmesh->npolys; ++i) {
-      if (ws.pmesh->areas[i] == RC_WALKABLE_AREA) {
-        ws.pmesh->areas[i] = POLYAREA_GROUND;
-      }
-      if (ws.pmesh->areas[i] == POLYAREA_GROUND) {
-        ws.pmesh->flags[i] = POLYFLAGS_WALK;
-      } else if (ws.pmesh->areas[i] == POLYAREA_DOOR) {
-        ws.pmesh->flags[i] = POLYFLAGS_WALK | POLYFLAGS_DOOR;
+  // Update poly flags from areas.
+  for (int i = 0; i < ws.pmesh->npolys; ++i) {
+    if (ws.pmesh->areas[i] == RC_WALKABLE_AREA) {
+      ws.pmesh->areas[i] = POLYAREA_GROUND;
+    }
+    if (ws.pmesh->areas[i] == POLYAREA_GROUND) {
+      ws.pmesh->flags[i] = POLYFLAGS_WALK;
+    } else if (ws.pmesh->areas[i] == POLYAREA_DOOR) {
+      ws.pmesh->flags[i] = POLYFLAGS_WALK | POLYFLAGS_DOOR;
+    }
+  }
+
+  dtNavMeshCreateParams params{};
+  memset(&params, 0, sizeof(params));
+  params.verts = ws.pmesh->verts;
+  params.vertCount = ws.pmesh->nverts;
+  params.polys = ws.pmesh->polys;
+  params.polyAreas = ws.pmesh->areas;
+  params.polyFlags = ws.pmesh->flags;
+  params.polyCount = ws.pmesh->npolys;
+  params.nvp = ws.pmesh->nvp;
+  params.detailMeshes = ws.dmesh->meshes;
+  params.detailVerts = ws.dmesh->verts;
+  params.detailVertsCount = ws.dmesh->nverts;
+  params.detailTris = ws.dmesh->tris;
+  params.detailTriCount = ws.dmesh->ntris;
+  // params.offMeshConVerts = geom->getOffMeshConnectionVerts();
+  // params.offMeshConRad = geom->getOffMeshConnectionRads();
+  // params.offMeshConDir = geom->getOffMeshConnectionDirs();
+  // params.offMeshConAreas = geom->getOffMeshConnectionAreas();
+  // params.offMeshConFlags = geom->getOffMeshConnectionFlags();
+  // params.offMeshConUserID = geom->getOffMeshConnectionId();
+  // params.offMeshConCount = geom->getOffMeshConnectionCount();
+  params.walkableHeight = bs.agentHeight;
+  params.walkableRadius = bs.agentRadius;
+  params.walkableClimb = bs.agentMaxClimb;
+  params.tileX = tileX;
+  params.tileY = tileY;
+  rcVcopy(params.bmin, ws.pmesh->bmin);
+  rcVcopy(params.bmax, ws.pmesh->bmax);
+  params.cs = cfg.cs;
+  params.ch = cfg.ch;
+  params.buildBvTree = true;
+
+  if (!dtCreateNavMeshData(&params, &result.navData, &result.navDataSize)) {
+    LOG(ERROR) << "Could not build Detour navmesh";
+    return false;
+  }
+
+  result.numVerts = ws.pmesh->nverts;
+  result.numPolys = ws.pmesh->npolys;
+
+  return true;
+}
+
+// Builds the Detour data of the given (x, z) tiles in parallel, results are in
+// the same order as tiles.  On failure no data is returned.
+bool buildTilesNavData(const TileLayout& layout,
+                       const std::vector<std::pair<int, int>>& tiles,
+                       const float* verts,
+                       const int nverts,
+                       const int* tris,
+                       const int ntris,
+                       std::vector<TileBuildResult>& results) {
+  const int numTiles = tiles.size();
+  std::vector<int> tileToSlot(layout.tilesX * layout.tilesZ, -1);
+  for (int i = 0; i < numTiles; ++i) {
+    tileToSlot[tiles[i].second * layout.tilesX + tiles[i].first] = i;
+  }
+
+  // Bucket the triangles by the tiles they overlap in x-z so that each tile
+  // only rasterizes what can affect it.
+  std::vector<std::vector<int>> tileTris(tiles.size());
+  for (int iTri = 0; iTri < ntris; ++iTri) {
+    const int* tri = &tris[iTri * 3];
+    float minX = verts[tri[0] * 3], maxX = minX;
+    float minZ = verts[tri[0] * 3 + 2], maxZ = minZ;
+    for (int k = 1; k < 3; ++k) {
+      minX = std::min(minX, verts[tri[k] * 3]);
+      maxX = std::max(maxX, verts[tri[k] * 3]);
+      minZ = std::min(minZ, verts[tri[k] * 3 + 2]);
+      maxZ = std::max(maxZ, verts[tri[k] * 3 + 2]);
+    }
+
+    int x0 = 0, z0 = 0, x1 = 0, z1 = 0;
+    layout.tileRange(minX, minZ, maxX, maxZ, x0, z0, x1, z1);
+    for (int z = z0; z <= z1; ++z) {
+      for (int x = x0; x <= x1; ++x) {
+        const int slot = tileToSlot[z * layout.tilesX + x];
+        if (slot >= 0)
+          tileTris[slot].insert(tileTris[slot].end(), tri, tri + 3);
       }
     }
+  }
+
+  results.assign(tiles.size(), TileBuildResult{});
+  // Not a std::vector<bool> as that can't be written to concurrently
+  std::vector<char> succeeded(tiles.size(), 1);
+
+#pragma omp parallel for schedule(dynamic)
+  for (int i = 0; i < numTiles; ++i) {
+    if (tileTris[i].empty())
+      continue;
+
+    const int x = tiles[i].first;
+    const int z = tiles[i].second;
+    succeeded[i] = buildTileNavData(
+        layout.configForTile(x, z), layout.settings, verts, nverts,
+        tileTris[i].data(), tileTris[i].size() / 3, x, z, results[i]);
+  }
+
+  if (std::find(succeeded.begin(), succeeded.end(), 0) != succeeded.end()) {
+    for (TileBuildResult& result : results) {
+      dtFree(result.navData);
+    }
+    results.clear();
+    return false;
+  }
+
+  return true;
+}
+}  // namespace
+
+PathFinder::Impl::Impl() {
+  filter_ = std::make_unique<dtQueryFilter>();
+  filter_->setIncludeFlags(POLYFLAGS_WALK);
+  filter_->setExcludeFlags(0);
+}
+
+bool PathFinder::Impl::build(const NavMeshSettings& bs,
+                             const float* verts,
+                             const int nverts,
+                             const int* tris,
+                             const int ntris,
+                             const float* bmin,
+                             const float* bmax) {
+  //
+  // Step 1. Initialize build config.
+  //
+
+  // Init build configuration from GUI
+  rcConfig cfg = makeRecastConfig(bs);
+
+  // The GUI may allow more max points per polygon than Detour can handle.
+  // Only build the detour navmesh if we do not exceed the limit.
+  if (cfg.maxVertsPerPoly > DT_VERTS_PER_POLYGON) {
+    LOG(ERROR) << "vertsPerPoly must be at most " << DT_VERTS_PER_POLYGON;
+    return false;
+  }
+
+  // Set the area where the navigation will be build.
+  // Here the bounds of the input mesh are used, but the
+  // area could be specified by an user defined box, etc.
+  rcVcopy(cfg.bmin, bmin);
+  rcVcopy(cfg.bmax, bmax);
+  rcCalcGridSize(cfg.bmin, cfg.bmax, cfg.cs, &cfg.width, &cfg.height);
+  LOG(INFO) << "Building navmesh with " << cfg.width << "x" << cfg.height
+            << " cells";
 
-    dtNavMeshCreateParams params{};
-    memset(&params, 0, sizeof(params));
-    params.verts = ws.pmesh->verts;
-    params.vertCount = ws.pmesh->nverts;
-    params.polys = ws.pmesh->polys;
-    params.polyAreas = ws.pmesh->areas;
-    params.polyFlags = ws.pmesh->flags;
-    params.polyCount = ws.pmesh->npolys;
-    params.nvp = ws.pmesh->nvp;
-    params.detailMeshes = ws.dmesh->meshes;
-    params.detailVerts = ws.dmesh->verts;
-    params.detailVertsCount = ws.dmesh->nverts;
-    params.detailTris = ws.dmesh->tris;
-    params.detailTriCount = ws.dmesh->ntris;
-    // params.offMeshConVerts = geom->getOffMeshConnectionVerts();
-    // params.offMeshConRad = geom->getOffMeshConnectionRads();
-    // params.offMeshConDir = geom->getOffMeshConnectionDirs();
-    // params.offMeshConAreas = geom->getOffMeshConnectionAreas();
-    // params.offMeshConFlags = geom->getOffMeshConnectionFlags();
-    // params.offMeshConUserID = geom->getOffMeshConnectionId();
-    // params.offMeshConCount = geom->getOffMeshConnectionCount();
-    params.walkableHeight = bs.agentHeight;
-    params.walkableRadius = bs.agentRadius;
-    params.walkableClimb = bs.agentMaxClimb;
-    rcVcopy(params.bmin, ws.pmesh->bmin);
-    rcVcopy(params.bmax, ws.pmesh->bmax);
-    params.cs = cfg.cs;
-    params.ch = cfg.ch;
-    params.buildBvTree = true;
-
-    if (!dtCreateNavMeshData(&params, &navData, &navDataSize)) {
+  int numVerts = 0;
+  int numPolys = 0;
+  if (bs.tileSize > 0) {
+    if (!buildTiled(cfg, bs, verts, nverts, tris, ntris, numVerts, numPolys)) {
+      return false;
+    }
+  } else {
+    TileBuildResult result;
+    if (!buildTileNavData(cfg, bs, verts, nverts, tris, ntris, 0, 0,
+                          result)) {
+      return false;
+    }
+    if (!result.navData) {
       LOG(ERROR) << "Could not build Detour navmesh";
       return false;
     }
 
     navMesh_.reset(dtAllocNavMesh());
     if (!navMesh_) {
-      dtFree(navData);
+      dtFree(result.navData);
       LOG(ERROR) << "Could not allocate Detour navmesh";
       return false;
     }
 
     dtStatus status = 0;
-    status = navMesh_->init(navData, navDataSize, DT_TILE_FREE_DATA);
+    status = navMesh_->init(result.navData, result.navDataSize,
+                            DT_TILE_FREE_DATA);
     if (dtStatusFailed(status)) {
-      dtFree(navData);
+      dtFree(result.navData);
       LOG(ERROR) << "Could not init Detour navmesh";
       return false;
     }
-    if (!initNavQuery()) {
-      return false;
-    }
+    numVerts = result.numVerts;
+    numPolys = result.numPolys;
+    tileLayout_ = Cr::Containers::NullOpt;
+  }
+
+  if (!initNavQuery()) {
+    return false;
   }
 
   bounds_ = std::make_pair(vec3f(bmin), vec3f(bmax));
+  navMeshFile_.reset();
+  sourceHash_ =
+      PathFinder::computeSourceHash(bs, verts, nverts, tris, ntris, bmin, bmax);
 
   // Added as we also need to remove these on navmesh recomputation
   removeZeroAreaPolys();
 
-  LOG(INFO) << "Created navmesh with " << ws.pmesh->nverts << " vertices "
-            << ws.pmesh->npolys << " polygons";
+  LOG(INFO) << "Created navmesh with " << numVerts << " vertices " << numPolys
+            << " polygons";
 
   return true;
 }
 
-bool PathFinder::Impl::initNavQuery() {
-  // if we are reinitializing the NavQuery, then also reset the MeshData
-  meshData_.reset();
+bool PathFinder::Impl::buildTiled(const rcConfig& cfg,
+                                  const NavMeshSettings& bs,
+                                  const float* verts,
+                                  const int nverts,
+                                  const int* tris,
+                                  const int ntris,
+                                  int& numVerts,
+                                  int& numPolys) {
+  TileLayout layout;
+  layout.settings = bs;
+  layout.cfg = cfg;
+  layout.tilesX = (cfg.width + bs.tileSize - 1) / bs.tileSize;
+  layout.tilesZ = (cfg.height + bs.tileSize - 1) / bs.tileSize;
+  // Each tile is rasterized with a border so that the eroded walkable area
+  // and the region partitioning match up with the neighbouring tiles.
+  layout.tileCfg = cfg;
+  layout.tileCfg.borderSize = cfg.walkableRadius + 3;
+  layout.tileCfg.tileSize = bs.tileSize;
+  layout.tileCfg.width = bs.tileSize + layout.tileCfg.borderSize * 2;
+  layout.tileCfg.height = bs.tileSize + layout.tileCfg.borderSize * 2;
+  const int numTiles = layout.tilesX * layout.tilesZ;
+
+  // Detour encodes the tile and the polygon index into a single dtPolyRef, so
+  // the more tiles there are, the fewer polygons each of them can hold.
+  const int tileBits =
+      std::min(static_cast<int>(dtIlog2(dtNextPow2(numTiles))), 14);
+  const int polyBits = 22 - tileBits;
+  if (numTiles > (1 << tileBits)) {
+    LOG(ERROR) << "Navmesh would need " << numTiles
+               << " tiles, which is more than Detour supports. Increase "
+                  "NavMeshSettings::tileSize";
+    return false;
+  }
+  LOG(INFO) << "Building navmesh as " << layout.tilesX << "x" << layout.tilesZ
+            << " tiles of " << bs.tileSize << "x" << bs.tileSize << " cells";
+
+  dtNavMeshParams params{};
+  memset(&params, 0, sizeof(params));
+  rcVcopy(params.orig, cfg.bmin);
+  params.tileWidth = layout.tileWorldSize();
+  params.tileHeight = layout.tileWorldSize();
+  params.maxTiles = 1 << tileBits;
+  params.maxPolys = 1 << polyBits;
+
+  std::unique_ptr<dtNavMesh, NavMeshDeleter> navMesh{dtAllocNavMesh()};
+  if (!navMesh) {
+    LOG(ERROR) << "Could not allocate Detour navmesh";
+    return false;
+  }
+  if (dtStatusFailed(navMesh->init(&params))) {
+    LOG(ERROR) << "Could not init Detour navmesh";
+    return false;
+  }
 
-  navQuery_.reset(dtAllocNavMeshQuery());
-  dtStatus status = navQuery_->init(navMesh_.get(), 2048);
-  if (dtStatusFailed(status)) {
-    LOG(ERROR) << "Could not init Detour navmesh query";
+  std::vector<std::pair<int, int>> tiles;
+  tiles.reserve(numTiles);
+  for (int z = 0; z < layout.tilesZ; ++z) {
+    for (int x = 0; x < layout.tilesX; ++x) {
+      tiles.emplace_back(x, z);
+    }
+  }
+
+  std::vector<TileBuildResult> results;
+  if (!buildTilesNavData(layout, tiles, verts, nverts, tris, ntris, results))
     return false;
+
+  // dtNavMesh::addTile isn't thread-safe, so the tiles are added afterwards
+  bool success = true;
+  for (TileBuildResult& result : results) {
+    if (!result.navData)
+      continue;
+
+    if (success &&
+        dtStatusFailed(navMesh->addTile(result.navData, result.navDataSize,
+                                        DT_TILE_FREE_DATA, 0, nullptr))) {
+      LOG(ERROR) << "Could not add tile to Detour navmesh";
+      success = false;
+    }
+    if (!success) {
+      dtFree(result.navData);
+      continue;
+    }
+
+    numVerts += result.numVerts;
+    numPolys += result.numPolys;
   }
 
-  islandSystem_ =
-      std::make_unique<impl::IslandSystem>(navMesh_.get(), filter_.get());
+  if (!success)
+    return false;
+
+  if (numPolys == 0) {
+    LOG(ERROR) << "Could not build Detour navmesh";
+    return false;
+  }
 
+  navMesh_ = std::move(navMesh);
+  tileLayout_ = std::move(layout);
   return true;
 }
 
-bool PathFinder::Impl::build(const NavMeshSettings& bs,
-                             const esp::assets::MeshData& mesh) {
-  const int numVerts = mesh.vbo.size();
+bool PathFinder::Impl::rebuildTiles(
+    const esp::assets::MeshData& mesh,
+    const std::vector<std::pair<vec3f, vec3f>>& regions) {
+  if (!isLoaded() || !tileLayout_) {
+    LOG(ERROR) << "PathFinder::rebuildTiles: the navmesh wasn't built with "
+                  "tiles, see NavMeshSettings::tileSize";
+    return false;
+  }
+  const TileLayout& layout = *tileLayout_;
+
+  std::vector<char> isDirty(layout.tilesX * layout.tilesZ, 0);
+  std::vector<std::pair<int, int>> tiles;
+  for (const auto& region : regions) {
+    int x0 = 0, z0 = 0, x1 = 0, z1 = 0;
+    layout.tileRange(region.first[0], region.first[2], region.second[0],
+                     region.second[2], x0, z0, x1, z1);
+    for (int z = z0; z <= z1; ++z) {
+      for (int x = x0; x <= x1; ++x) {
+        if (!isDirty[z * layout.tilesX + x]) {
+          isDirty[z * layout.tilesX + x] = 1;
+          tiles.emplace_back(x, z);
+        }
+      }
+    }
+  }
+  if (tiles.empty())
+    return true;
+
+  const float* verts = mesh.vbo.empty() ? nullptr : mesh.vbo[0].data();
+  std::vector<int> indices(mesh.ibo.begin(), mesh.ibo.end());
+  std::vector<TileBuildResult> results;
+  if (!buildTilesNavData(layout, tiles, verts, mesh.vbo.size(),
+                         indices.data(), indices.size() / 3, results))
+    return false;
+
+  bool success = true;
+  for (size_t i = 0; i < tiles.size(); ++i) {
+    const dtTileRef oldRef =
+        navMesh_->getTileRefAt(tiles[i].first, tiles[i].second, 0);
+    if (oldRef)
+      navMesh_->removeTile(oldRef, nullptr, nullptr);
+
+    TileBuildResult& result = results[i];
+    if (result.navData &&
+        dtStatusFailed(navMesh_->addTile(result.navData, result.navDataSize,
+                                         DT_TILE_FREE_DATA, 0, nullptr))) {
+      LOG(ERROR) << "Could not add tile to Detour navmesh";
+      dtFree(result.navData);
+      success = false;
+    }
+  }
+
+  LOG(INFO) << "Rebuilt " << tiles.size() << " navmesh tiles";
+
+  // The navmesh now matches the updated mesh, as if it was built from it with
+  // the original bounds. If a tile failed, it matches neither.
+  sourceHash_ =
+      success ? PathFinder::computeSourceHash(
+                    layout.settings, verts, mesh.vbo.size(), indices.data(),
+                    indices.size() / 3, layout.cfg.bmin, layout.cfg.bmax)
+              : 0;
+
+  // Polygon refs of the rebuilt tiles changed, so everything derived from
+  // them needs to be recomputed as well
+  navMeshVersion_ = nextNavMeshVersion();
+  hierarchy_.reset();
+  clearanceField_.reset();
+  meshData_.reset();
+  removeZeroAreaPolys();
+  islandSystem_ =
+      std::make_unique<impl::IslandSystem>(navMesh_.get(), filter_.get());
+
+  return success;
+}
+
+bool PathFinder::Impl::initNavQuery() {
+  // if we are reinitializing the NavQuery, then also reset the MeshData
+  meshData_.reset();
+
+  navQuery_.reset(dtAllocNavMeshQuery());
+  dtStatus status = navQuery_->init(navMesh_.get(), 2048);
+  if (dtStatusFailed(status)) {
+    LOG(ERROR) << "Could not init Detour navmesh query";
+    return false;
+  }
+  queryPool_.clear();
+  hierarchy_.reset();
+  clearanceField_.reset();
+  navMeshVersion_ = nextNavMeshVersion();
+
+  islandSystem_ =
+      std::make_unique<impl::IslandSystem>(navMesh_.get(), filter_.get());
+
+  return true;
+}
+
+bool PathFinder::Impl::build(const NavMeshSettings& bs,
+                             const esp::assets::MeshData& mesh) {
+  const int numVerts = mesh.vbo.size();
   const int numIndices = mesh.ibo.size();
   const float mf = std::numeric_limits<float>::max();
   vec3f bmin(mf, mf, mf);
@@ -714,6 +1349,52 @@ struct NavMeshTileHeader {
   int dataSize;
 };
 
+// Version 2 stores a table of tiles after the header, followed by the aligned
+// tile data, so the file can be mapped and the tiles used in place
+const int NAVMESHFILE_VERSION = 2;
+const size_t NAVMESHFILE_TILE_ALIGNMENT = 16;
+
+struct NavMeshFileHeader {
+  int magic;
+  int version;
+  int numTiles;
+  int reserved;
+  uint64_t sourceHash;
+  dtNavMeshParams params;
+};
+
+struct NavMeshFileTile {
+  dtTileRef tileRef;
+  int dataSize;
+  uint64_t dataOffset;
+};
+
+size_t alignTileOffset(size_t offset) {
+  return (offset + NAVMESHFILE_TILE_ALIGNMENT - 1) /
+         NAVMESHFILE_TILE_ALIGNMENT * NAVMESHFILE_TILE_ALIGNMENT;
+}
+
+// FNV-1a
+class SourceHasher {
+ public:
+  void add(const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+      hash_ = (hash_ ^ bytes[i]) * 1099511628211ull;
+    }
+  }
+
+  template <typename T>
+  void add(const T& value) {
+    add(&value, sizeof(T));
+  }
+
+  uint64_t hash() const { return hash_; }
+
+ private:
+  uint64_t hash_ = 14695981039346656037ull;
+};
+
 struct Triangle {
   std::vector<vec3f> v;
   Triangle() { v.resize(3); }
@@ -769,7 +1450,7 @@ void PathFinder::Impl::removeZeroAreaPolys() {
   for (int iTile = 0; iTile < navMesh_->getMaxTiles(); ++iTile) {
     const dtMeshTile* tile =
         const_cast<const dtNavMesh*>(navMesh_.get())->getTile(iTile);
-    if (!tile)
+    if (!tile || !tile->header)
       continue;
 
     // Iterate over all polygons in a tile
@@ -809,6 +1490,10 @@ bool PathFinder::Impl::loadNavMesh(const std::string& path) {
     fclose(fp);
     return false;
   }
+  if (header.version == NAVMESHFILE_VERSION) {
+    fclose(fp);
+    return loadMappedNavMesh(path);
+  }
   if (header.version != NAVMESHSET_VERSION) {
     fclose(fp);
     return false;
@@ -866,7 +1551,81 @@ bool PathFinder::Impl::loadNavMesh(const std::string& path) {
   fclose(fp);
 
   navMesh_.reset(mesh);
+  navMeshFile_.reset();
+  sourceHash_ = 0;
   bounds_ = std::make_pair(bmin, bmax);
+  tileLayout_ = Cr::Containers::NullOpt;
+
+  removeZeroAreaPolys();
+
+  return initNavQuery();
+}
+
+bool PathFinder::Impl::loadMappedNavMesh(const std::string& path) {
+  std::unique_ptr<impl::MappedFile> file = impl::MappedFile::open(path);
+  if (!file) {
+    LOG(ERROR) << "Could not map navmesh file " << path;
+    return false;
+  }
+
+  NavMeshFileHeader header{};
+  if (file->size() < sizeof(header)) {
+    LOG(ERROR) << "Navmesh file " << path << " is truncated";
+    return false;
+  }
+  memcpy(&header, file->data(), sizeof(header));
+  const size_t tilesOffset = sizeof(header);
+  if (header.numTiles < 0 ||
+      (file->size() - tilesOffset) / sizeof(NavMeshFileTile) <
+          static_cast<size_t>(header.numTiles)) {
+    LOG(ERROR) << "Navmesh file " << path << " is truncated";
+    return false;
+  }
+
+  // Declared after the file, so it is destroyed before the tile data it
+  // points into is unmapped
+  std::unique_ptr<dtNavMesh, NavMeshDeleter> mesh{dtAllocNavMesh()};
+  if (!mesh || dtStatusFailed(mesh->init(&header.params))) {
+    LOG(ERROR) << "Could not init Detour navmesh";
+    return false;
+  }
+
+  vec3f bmin, bmax;
+  for (int i = 0; i < header.numTiles; ++i) {
+    NavMeshFileTile tileEntry{};
+    memcpy(&tileEntry, file->data() + tilesOffset + i * sizeof(tileEntry),
+           sizeof(tileEntry));
+    if (tileEntry.dataSize <= 0 ||
+        tileEntry.dataOffset % NAVMESHFILE_TILE_ALIGNMENT != 0 ||
+        tileEntry.dataOffset > file->size() ||
+        file->size() - tileEntry.dataOffset <
+            static_cast<size_t>(tileEntry.dataSize)) {
+      LOG(ERROR) << "Navmesh file " << path << " has an invalid tile";
+      return false;
+    }
+
+    // No DT_TILE_FREE_DATA, the tile data is used directly from the mapping
+    if (dtStatusFailed(mesh->addTile(file->data() + tileEntry.dataOffset,
+                                     tileEntry.dataSize, 0, tileEntry.tileRef,
+                                     nullptr))) {
+      LOG(ERROR) << "Could not add tile to Detour navmesh";
+      return false;
+    }
+    const dtMeshTile* tile = mesh->getTileByRef(tileEntry.tileRef);
+    if (i == 0) {
+      bmin = vec3f(tile->header->bmin);
+      bmax = vec3f(tile->header->bmax);
+    } else {
+      bmin = bmin.array().min(Eigen::Array3f{tile->header->bmin});
+      bmax = bmax.array().max(Eigen::Array3f{tile->header->bmax});
+    }
+  }
+
+  navMesh_ = std::move(mesh);
+  navMeshFile_ = std::move(file);
+  sourceHash_ = header.sourceHash;
+  bounds_ = std::make_pair(bmin, bmax);
+  tileLayout_ = Cr::Containers::NullOpt;
 
   removeZeroAreaPolys();
 
@@ -878,39 +1637,72 @@ bool PathFinder::Impl::saveNavMesh(const std::string& path) {
   if (!navMesh)
     return false;
 
-  FILE* fp = fopen(path.c_str(), "wb");
-  if (!fp)
+  // Written next to the target and renamed over it once complete, so that a
+  // failed write keeps the old file, and a navmesh mapped from the old file
+  // keeps its data
+  const std::string tmpPath = path + ".tmp";
+  FILE* fp = fopen(tmpPath.c_str(), "wb");
+  if (!fp) {
+    LOG(ERROR) << "Could not open " << tmpPath << " for writing";
     return false;
+  }
 
-  // Store header.
-  NavMeshSetHeader header{};
-  header.magic = NAVMESHSET_MAGIC;
-  header.version = NAVMESHSET_VERSION;
-  header.numTiles = 0;
+  // Lay out the tile table, followed by the aligned tile data
+  std::vector<NavMeshFileTile> tileEntries;
+  std::vector<const dtMeshTile*> tiles;
   for (int i = 0; i < navMesh->getMaxTiles(); ++i) {
     const dtMeshTile* tile = navMesh->getTile(i);
     if (!tile || !tile->header || !tile->dataSize)
       continue;
-    header.numTiles++;
+    tiles.push_back(tile);
   }
+  size_t offset = alignTileOffset(sizeof(NavMeshFileHeader) +
+                                  tiles.size() * sizeof(NavMeshFileTile));
+  for (const dtMeshTile* tile : tiles) {
+    NavMeshFileTile tileEntry{};
+    tileEntry.tileRef = navMesh->getTileRef(tile);
+    tileEntry.dataSize = tile->dataSize;
+    tileEntry.dataOffset = offset;
+    tileEntries.push_back(tileEntry);
+    offset = alignTileOffset(offset + tile->dataSize);
+  }
+
+  // Store header.
+  NavMeshFileHeader header{};
+  header.magic = NAVMESHSET_MAGIC;
+  header.version = NAVMESHFILE_VERSION;
+  header.numTiles = tiles.size();
+  header.sourceHash = sourceHash_;
   memcpy(&header.params, navMesh->getParams(), sizeof(dtNavMeshParams));
-  fwrite(&header, sizeof(NavMeshSetHeader), 1, fp);
+  bool success = fwrite(&header, sizeof(header), 1, fp) == 1;
+  if (!tileEntries.empty()) {
+    success = success && fwrite(tileEntries.data(), sizeof(NavMeshFileTile),
+                                tileEntries.size(),
+                                fp) == tileEntries.size();
+  }
 
   // Store tiles.
-  for (int i = 0; i < navMesh->getMaxTiles(); ++i) {
-    const dtMeshTile* tile = navMesh->getTile(i);
-    if (!tile || !tile->header || !tile->dataSize)
-      continue;
-
-    NavMeshTileHeader tileHeader{};
-    tileHeader.tileRef = navMesh->getTileRef(tile);
-    tileHeader.dataSize = tile->dataSize;
-    fwrite(&tileHeader, sizeof(tileHeader), 1, fp);
-
-    fwrite(tile->data, tile->dataSize, 1, fp);
+  size_t written = sizeof(header) + tiles.size() * sizeof(NavMeshFileTile);
+  const unsigned char padding[NAVMESHFILE_TILE_ALIGNMENT]{};
+  for (size_t i = 0; success && i < tiles.size(); ++i) {
+    const size_t paddingSize = tileEntries[i].dataOffset - written;
+    if (paddingSize > 0)
+      success = fwrite(padding, paddingSize, 1, fp) == 1;
+    success = success && fwrite(tiles[i]->data, tiles[i]->dataSize, 1, fp) == 1;
+    written = tileEntries[i].dataOffset + tiles[i]->dataSize;
   }
 
-  fclose(fp);
+  success = fclose(fp) == 0 && success;
+  if (!success) {
+    LOG(ERROR) << "Could not write navmesh file " << tmpPath;
+    std::remove(tmpPath.c_str());
+    return false;
+  }
+  if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+    LOG(ERROR) << "Could not rename " << tmpPath << " to " << path;
+    std::remove(tmpPath.c_str());
+    return false;
+  }
 
   return true;
 }
@@ -919,6 +1711,8 @@ void PathFinder::Impl::seed(uint32_t newSeed) {
   // TODO: this should be using core::Random instead, but passing function
   // to navQuery_->findRandomPoint needs to be figured out first
   srand(newSeed);
+  std::lock_guard<std::mutex> lock{sampleMutex_};
+  sampleRandom_.seed(newSeed);
 }
 
 // Returns a random number [0..1]
@@ -952,6 +1746,144 @@ vec3f PathFinder::Impl::getRandomNavigablePoint(const int maxTries /*= 10*/) {
   }
 }
 
+void PathFinder::Impl::updateSampleTriangles() {
+  if (sampleTrianglesVersion_ == navMeshVersion_)
+    return;
+
+  sampleTriangleVerts_.clear();
+  sampleTriangleAreas_.clear();
+  sampleTrianglePolys_.clear();
+  for (int iTile = 0; iTile < navMesh_->getMaxTiles(); ++iTile) {
+    const dtMeshTile* tile =
+        const_cast<const dtNavMesh*>(navMesh_.get())->getTile(iTile);
+    if (!tile || !tile->header)
+      continue;
+
+    for (int jPoly = 0; jPoly < tile->header->polyCount; ++jPoly) {
+      const dtPoly* poly = &tile->polys[jPoly];
+      const dtPolyRef polyRef =
+          navMesh_->encodePolyId(tile->salt, iTile, jPoly);
+      if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION ||
+          !filter_->passFilter(polyRef, tile, poly))
+        continue;
+
+      for (const Triangle& tri : getPolygonTriangles(poly, tile)) {
+        const float area =
+            0.5 * (tri.v[1] - tri.v[0]).cross(tri.v[2] - tri.v[1]).norm();
+        if (area <= 0)
+          continue;
+        sampleTriangleVerts_.insert(sampleTriangleVerts_.end(), tri.v.begin(),
+                                    tri.v.end());
+        sampleTriangleAreas_.push_back(area);
+        sampleTrianglePolys_.push_back(polyRef);
+      }
+    }
+  }
+  sampleTrianglesVersion_ = navMeshVersion_;
+}
+
+RowMatrixXf PathFinder::Impl::sampleNavigablePoints(
+    const int n,
+    const NavigablePointSamplingOptions& options) {
+  if (n <= 0 || !isLoaded())
+    return RowMatrixXf(0, 3);
+  std::lock_guard<std::mutex> lock{sampleMutex_};
+  updateSampleTriangles();
+
+  // Cumulative area of the triangles that pass the island filters
+  std::vector<uint32_t> triangles;
+  std::vector<double> cdf;
+  double totalArea = 0;
+  for (uint32_t i = 0; i < sampleTriangleAreas_.size(); ++i) {
+    const dtPolyRef polyRef = sampleTrianglePolys_[i];
+    if (options.islandId != ID_UNDEFINED &&
+        islandSystem_->islandId(polyRef) !=
+            static_cast<uint32_t>(options.islandId))
+      continue;
+    if (options.minIslandRadius > 0 &&
+        islandSystem_->islandRadius(polyRef) < options.minIslandRadius)
+      continue;
+
+    totalArea += sampleTriangleAreas_[i];
+    triangles.push_back(i);
+    cdf.push_back(totalArea);
+  }
+  if (triangles.empty()) {
+    LOG(ERROR) << "No navigable area to sample points from";
+    return RowMatrixXf(0, 3);
+  }
+
+  core::Random random(options.seed >= 0 ? options.seed
+                                        : sampleRandom_.uniform_uint());
+
+  // Accepted points bucketed into cells of minDistance for Poisson-disk
+  // rejection
+  const float minDistance = options.minDistance;
+  std::unordered_map<uint64_t, std::vector<int>> grid;
+  const auto cellKey = [minDistance](const vec3f& pt, int dx, int dy, int dz) {
+    const auto coord = [&](int axis, int offset) {
+      return static_cast<uint64_t>(
+                 static_cast<int64_t>(std::floor(pt[axis] / minDistance)) +
+                 offset) &
+             0x1fffff;
+    };
+    return coord(0, dx) << 42 | coord(1, dy) << 21 | coord(2, dz);
+  };
+
+  std::vector<vec3f> points;
+  points.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    for (int iTry = 0; iTry < std::max(options.maxTries, 1); ++iTry) {
+      const double u = options.stratified
+                           ? (i + random.uniform_float_01()) / n
+                           : random.uniform_float_01();
+      const size_t k = std::min<size_t>(
+          std::upper_bound(cdf.begin(), cdf.end(), u * totalArea) -
+              cdf.begin(),
+          cdf.size() - 1);
+      const vec3f* tri = &sampleTriangleVerts_[3 * triangles[k]];
+
+      // Uniform point in the triangle
+      const float r1 = std::sqrt(random.uniform_float_01());
+      const float r2 = random.uniform_float_01();
+      const vec3f pt =
+          (1 - r1) * tri[0] + r1 * (1 - r2) * tri[1] + r1 * r2 * tri[2];
+
+      if (minDistance > 0) {
+        bool tooClose = false;
+        for (int dx = -1; dx <= 1 && !tooClose; ++dx) {
+          for (int dy = -1; dy <= 1 && !tooClose; ++dy) {
+            for (int dz = -1; dz <= 1 && !tooClose; ++dz) {
+              auto cell = grid.find(cellKey(pt, dx, dy, dz));
+              if (cell == grid.end())
+                continue;
+              for (const int j : cell->second) {
+                if ((points[j] - pt).norm() < minDistance) {
+                  tooClose = true;
+                  break;
+                }
+              }
+            }
+          }
+        }
+        if (tooClose)
+          continue;
+        grid[cellKey(pt, 0, 0, 0)].push_back(points.size());
+      }
+
+      points.push_back(pt);
+      break;
+    }
+  }
+
+  const int numPoints = points.size();
+  RowMatrixXf result(numPoints, 3);
+  for (int i = 0; i < numPoints; ++i) {
+    result.row(i) = points[i].transpose();
+  }
+  return result;
+}
+
 namespace {
 float pathLength(const std::vector<vec3f>& points) {
   CORRADE_INTERNAL_ASSERT(points.size() > 0);
@@ -968,19 +1900,120 @@ float pathLength(const std::vector<vec3f>& points) {
 }  // namespace
 
 bool PathFinder::Impl::findPath(ShortestPath& path) {
+  return findPath(path, *navQuery_);
+}
+
+bool PathFinder::Impl::findPath(ShortestPath& path, dtNavMeshQuery& navQuery) {
   MultiGoalShortestPath tmp;
   tmp.requestedStart = path.requestedStart;
   tmp.setRequestedEnds({path.requestedEnd});
 
-  bool status = findPath(tmp);
+  bool status = findPath(tmp, navQuery);
 
   path.geodesicDistance = tmp.geodesicDistance;
   path.points = std::move(tmp.points);
   return status;
 }
 
+bool PathFinder::Impl::buildHierarchy(const int maxRegionPolys) {
+  if (!isLoaded())
+    return false;
+
+  auto hierarchy = HierarchicalPlanner::create_unique(navMesh_.get());
+  if (!hierarchy->build(filter_.get(), maxRegionPolys))
+    return false;
+  hierarchy_ = std::move(hierarchy);
+  return true;
+}
+
+bool PathFinder::Impl::loadHierarchy(const std::string& path) {
+  if (!isLoaded())
+    return false;
+
+  auto hierarchy = HierarchicalPlanner::create_unique(navMesh_.get());
+  if (!hierarchy->load(path, filter_.get()))
+    return false;
+  hierarchy_ = std::move(hierarchy);
+  return true;
+}
+
+bool PathFinder::Impl::saveHierarchy(const std::string& path) {
+  return hierarchy_ && hierarchy_->save(path);
+}
+
+bool PathFinder::Impl::buildClearanceField(const float cellSize,
+                                           const float maxDistance) {
+  if (!isLoaded())
+    return false;
+
+  auto clearanceField = ClearanceField::create_unique(navMesh_.get());
+  if (!clearanceField->build(filter_.get(), cellSize, maxDistance))
+    return false;
+  clearanceField_ = std::move(clearanceField);
+  return true;
+}
+
+bool PathFinder::Impl::loadClearanceField(const std::string& path) {
+  if (!isLoaded())
+    return false;
+
+  auto clearanceField = ClearanceField::create_unique(navMesh_.get());
+  if (!clearanceField->load(path))
+    return false;
+  clearanceField_ = std::move(clearanceField);
+  return true;
+}
+
+bool PathFinder::Impl::saveClearanceField(const std::string& path) {
+  return clearanceField_ && clearanceField_->save(path);
+}
+
+bool PathFinder::Impl::findPathHierarchical(ShortestPath& path) {
+  if (!hierarchy_)
+    return findPath(path);
+
+  path.geodesicDistance = std::numeric_limits<float>::infinity();
+  path.points.clear();
+
+  dtStatus startStatus = 0, endStatus = 0;
+  dtPolyRef startRef = 0, endRef = 0;
+  vec3f pathStart, pathEnd;
+  std::tie(startStatus, startRef, pathStart) =
+      projectToPoly(path.requestedStart, navQuery_.get(), filter_.get());
+  std::tie(endStatus, endRef, pathEnd) =
+      projectToPoly(path.requestedEnd, navQuery_.get(), filter_.get());
+  if (startStatus != DT_SUCCESS || startRef == 0 || endStatus != DT_SUCCESS ||
+      endRef == 0)
+    return false;
+
+  if (!islandSystem_->hasConnection(startRef, endRef))
+    return false;
+
+  // Short queries within a region are left to Detour
+  std::vector<dtPolyRef> corridor;
+  if (!hierarchy_->findCorridor(*navQuery_, filter_.get(), startRef, pathStart,
+                                endRef, pathEnd, corridor))
+    return findPath(path);
+
+  const int maxPoints = corridor.size() + 2;
+  int numPoints = 0;
+  std::vector<vec3f> points(maxPoints);
+  dtStatus status = navQuery_->findStraightPath(
+      path.requestedStart.data(), path.requestedEnd.data(), corridor.data(),
+      corridor.size(), points[0].data(), nullptr, nullptr, &numPoints,
+      maxPoints);
+  if (status != DT_SUCCESS || numPoints == 0)
+    return findPath(path);
+
+  points.resize(numPoints);
+  path.geodesicDistance = pathLength(points);
+  path.points = std::move(points);
+  return true;
+}
+
 Cr::Containers::Optional<std::tuple<float, std::vector<vec3f>>>
-PathFinder::Impl::findPathInternal(const vec3f& start,
+PathFinder::Impl::findPathInternal(dtNavMeshQuery& navQuery,
+                                   const vec3f& start,
                                    dtPolyRef startRef,
                                    const vec3f& pathStart,
                                    const vec3f& end,
@@ -1001,17 +2034,17 @@ PathFinder::Impl::findPathInternal(const vec3f& start,
 
   int numPolys = 0;
   dtStatus status =
-      navQuery_->findPath(startRef, endRef, pathStart.data(), pathEnd.data(),
-                          filter_.get(), polys, &numPolys, MAX_POLYS);
+      navQuery.findPath(startRef, endRef, pathStart.data(), pathEnd.data(),
+                        filter_.get(), polys, &numPolys, MAX_POLYS);
   if (status != DT_SUCCESS || numPolys == 0) {
     return Cr::Containers::NullOpt;
   }
 
   int numPoints = 0;
   std::vector<vec3f> points(MAX_POLYS);
-  status = navQuery_->findStraightPath(start.data(), end.data(), polys,
-                                       numPolys, points[0].data(), nullptr,
-                                       nullptr, &numPoints, MAX_POLYS);
+  status = navQuery.findStraightPath(start.data(), end.data(), polys,
+                                     numPolys, points[0].data(), nullptr,
+                                     nullptr, &numPoints, MAX_POLYS);
   if (status != DT_SUCCESS || numPoints == 0) {
     return Corrade::Containers::NullOpt;
   }
@@ -1023,7 +2056,8 @@ PathFinder::Impl::findPathInternal(const vec3f& start,
   return std::make_tuple(length, std::move(points));
 }
 
-bool PathFinder::Impl::findPathSetup(MultiGoalShortestPath& path,
+bool PathFinder::Impl::findPathSetup(dtNavMeshQuery& navQuery,
+                                     MultiGoalShortestPath& path,
                                      dtPolyRef& startRef,
                                      vec3f& pathStart) {
   path.geodesicDistance = std::numeric_limits<float>::infinity();
@@ -1032,7 +2066,7 @@ bool PathFinder::Impl::findPathSetup(MultiGoalShortestPath& path,
   // find nearest polys and path
   dtStatus status = 0;
   std::tie(status, startRef, pathStart) =
-      projectToPoly(path.requestedStart, navQuery_.get(), filter_.get());
+      projectToPoly(path.requestedStart, &navQuery, filter_.get());
 
   if (status != DT_SUCCESS || startRef == 0) {
     return false;
@@ -1045,7 +2079,7 @@ bool PathFinder::Impl::findPathSetup(MultiGoalShortestPath& path,
     dtPolyRef endRef = 0;
     vec3f pathEnd;
     std::tie(status, endRef, pathEnd) =
-        projectToPoly(rqEnd, navQuery_.get(), filter_.get());
+        projectToPoly(rqEnd, &navQuery, filter_.get());
 
     if (status != DT_SUCCESS || endRef == 0) {
       return false;
@@ -1058,10 +2092,86 @@ bool PathFinder::Impl::findPathSetup(MultiGoalShortestPath& path,
   return true;
 }
 
+int PathFinder::Impl::findClosestEnd(const MultiGoalShortestPath& path,
+                                     const dtPolyRef startRef,
+                                     const vec3f& pathStart) const {
+  const auto& endRefs = path.pimpl_->endRefs;
+  const auto& pathEnds = path.pimpl_->pathEnds;
+  const int numEnds = endRefs.size();
+  std::unordered_multimap<dtPolyRef, int> endsByPoly;
+  for (int i = 0; i < numEnds; ++i) {
+    endsByPoly.emplace(endRefs[i], i);
+  }
+
+  // Costs are between portal midpoints, the same as Detour's findPath.  Ends
+  // are virtual nodes reached from their polygon, so the first one popped is
+  // the closest
+  struct Node {
+    float cost;
+    vec3f pos;
+  };
+  std::unordered_map<dtPolyRef, Node> nodes;
+  typedef std::tuple<float, dtPolyRef, int> QueueEntry;
+  std::priority_queue<QueueEntry, std::vector<QueueEntry>,
+                      std::greater<QueueEntry>>
+      queue;
+  const auto reachEnds = [&](dtPolyRef ref, float cost, const vec3f& pos) {
+    auto range = endsByPoly.equal_range(ref);
+    for (auto it = range.first; it != range.second; ++it) {
+      queue.emplace(cost + (pathEnds[it->second] - pos).norm(), ref,
+                    it->second);
+    }
+  };
+
+  nodes[startRef] = {0.0f, pathStart};
+  queue.emplace(0.0f, startRef, -1);
+  reachEnds(startRef, 0.0f, pathStart);
+  while (!queue.empty()) {
+    const float cost = std::get<0>(queue.top());
+    const dtPolyRef ref = std::get<1>(queue.top());
+    const int end = std::get<2>(queue.top());
+    queue.pop();
+    if (end >= 0)
+      return end;
+    const Node node = nodes[ref];
+    if (cost > node.cost)
+      continue;
+
+    const dtMeshTile* tile = nullptr;
+    const dtPoly* poly = nullptr;
+    navMesh_->getTileAndPolyByRefUnsafe(ref, &tile, &poly);
+    for (unsigned int iLink = poly->firstLink; iLink != DT_NULL_LINK;
+         iLink = tile->links[iLink].next) {
+      const dtLink& link = tile->links[iLink];
+      const dtMeshTile* neighbourTile = nullptr;
+      const dtPoly* neighbourPoly = nullptr;
+      navMesh_->getTileAndPolyByRefUnsafe(link.ref, &neighbourTile,
+                                          &neighbourPoly);
+      if (!filter_->passFilter(link.ref, neighbourTile, neighbourPoly))
+        continue;
+
+      const vec3f pos = impl::linkMidpoint(tile, poly, link);
+      const float neighbourCost = node.cost + (pos - node.pos).norm();
+      auto it = nodes.find(link.ref);
+      if (it != nodes.end() && it->second.cost <= neighbourCost)
+        continue;
+      nodes[link.ref] = {neighbourCost, pos};
+      queue.emplace(neighbourCost, link.ref, -1);
+      reachEnds(link.ref, neighbourCost, pos);
+    }
+  }
+  return -1;
+}
+
 bool PathFinder::Impl::findPath(MultiGoalShortestPath& path) {
+  return findPath(path, *navQuery_);
+}
+
+bool PathFinder::Impl::findPath(MultiGoalShortestPath& path,
+                                dtNavMeshQuery& navQuery) {
   dtPolyRef startRef = 0;
   vec3f pathStart;
-  if (!findPathSetup(path, startRef, pathStart))
+  if (!findPathSetup(navQuery, path, startRef, pathStart))
     return false;
 
   if (path.pimpl_->requestedEnds.size() > 1) {
@@ -1072,7 +2182,7 @@ bool PathFinder::Impl::findPath(MultiGoalShortestPath& path) {
     ShortestPath prevPath;
     prevPath.requestedStart = path.requestedStart;
     prevPath.requestedEnd = path.pimpl_->prevRequestedStart;
-    findPath(prevPath);
+    findPath(prevPath, navQuery);
     const float movedAmount = prevPath.geodesicDistance;
 
     for (int i = 0; i < path.pimpl_->requestedEnds.size(); ++i) {
@@ -1082,6 +2192,22 @@ bool PathFinder::Impl::findPath(MultiGoalShortestPath& path) {
     }
 
     path.pimpl_->prevRequestedStart = path.requestedStart;
+
+    // Finding the closest end first gives a tight bound on the distance, so
+    // most of the other ends are pruned without a query of their own
+    const int closest = findClosestEnd(path, startRef, pathStart);
+    if (closest < 0)
+      return false;
+    const Cr::Containers::Optional<std::tuple<float, std::vector<vec3f>>>
+        findResult = findPathInternal(
+            navQuery, path.requestedStart, startRef, pathStart,
+            path.pimpl_->requestedEnds[closest], path.pimpl_->endRefs[closest],
+            path.pimpl_->pathEnds[closest]);
+    if (findResult) {
+      path.pimpl_->minTheoreticalDist[closest] = std::get<0>(*findResult);
+      path.geodesicDistance = std::get<0>(*findResult);
+      path.points = std::get<1>(*findResult);
+    }
   }
 
   // Explore possible goal points by their minimum theoretical distance.
@@ -1094,14 +2220,14 @@ bool PathFinder::Impl::findPath(MultiGoalShortestPath& path) {
             });
 
   for (size_t i : ordering) {
-    if (path.pimpl_->minTheoreticalDist[i] > path.geodesicDistance)
-      continue;
+    if (path.pimpl_->minTheoreticalDist[i] >= path.geodesicDistance)
+      break;
 
     const Cr::Containers::Optional<std::tuple<float, std::vector<vec3f>>>
-        findResult =
-            findPathInternal(path.requestedStart, startRef, pathStart,
-                             path.pimpl_->requestedEnds[i],
-                             path.pimpl_->endRefs[i], path.pimpl_->pathEnds[i]);
+        findResult = findPathInternal(
+            navQuery, path.requestedStart, startRef, pathStart,
+            path.pimpl_->requestedEnds[i], path.pimpl_->endRefs[i],
+            path.pimpl_->pathEnds[i]);
 
     if (findResult && std::get<0>(*findResult) < path.geodesicDistance) {
       path.pimpl_->minTheoreticalDist[i] = std::get<0>(*findResult);
@@ -1113,8 +2239,218 @@ bool PathFinder::Impl::findPath(MultiGoalShortestPath& path) {
   return path.geodesicDistance < std::numeric_limits<float>::infinity();
 }
 
+bool PathFinder::Impl::initQueryPool() {
+  const size_t numThreads = maxThreads();
+  while (queryPool_.size() < numThreads) {
+    queryPool_.emplace_back(dtAllocNavMeshQuery());
+    if (!queryPool_.back() ||
+        dtStatusFailed(queryPool_.back()->init(navMesh_.get(), 2048))) {
+      queryPool_.pop_back();
+      LOG(ERROR) << "Could not init Detour navmesh query";
+      return false;
+    }
+  }
+  return true;
+}
+
+int PathFinder::Impl::findPaths(std::vector<ShortestPath>& paths) {
+  std::lock_guard<std::mutex> lock{queryPoolMutex_};
+  if (!isLoaded() || !initQueryPool())
+    return 0;
+
+  // at most one thread per query of the pool
+  const int numThreads = queryPool_.size();
+  const int numPaths = paths.size();
+  int numFound = 0;
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic) \
+    reduction(+ : numFound)
+  for (int i = 0; i < numPaths; ++i) {
+    if (findPath(paths[i], *queryPool_[threadIndex()]))
+      ++numFound;
+  }
+
+  return numFound;
+}
+
+std::vector<float> PathFinder::Impl::geodesicDistances(
+    const std::vector<vec3f>& starts,
+    const std::vector<vec3f>& ends) {
+  ESP_CHECK(starts.size() == ends.size(),
+            "PathFinder::geodesicDistances(): got"
+                << starts.size() << "starts but" << ends.size() << "ends");
+
+  std::vector<ShortestPath> paths(starts.size());
+  for (size_t i = 0; i < paths.size(); ++i) {
+    paths[i].requestedStart = starts[i];
+    paths[i].requestedEnd = ends[i];
+    paths[i].geodesicDistance = std::numeric_limits<float>::infinity();
+  }
+  findPaths(paths);
+
+  std::vector<float> distances(paths.size());
+  for (size_t i = 0; i < paths.size(); ++i) {
+    distances[i] = paths[i].geodesicDistance;
+  }
+  return distances;
+}
+
+// Runs a multi-source Dijkstra from the goals over a graph whose nodes are the
+// midpoints of the portal edges between polygons.  Within a (convex) polygon,
+// all of its portals are connected by straight lines.
+void PathFinder::Impl::computeGoalDistanceField(
+    GoalDistanceField::Impl& field) {
+  const dtNavMesh* navMesh = navMesh_.get();
+  field.polyIndex.emplace(navMesh);
+  const impl::PolyIndex& polyIndex = *field.polyIndex;
+
+  field.portalStart.assign(polyIndex.size() + 1, 0);
+  field.portalPoints.clear();
+  // Polygon a portal belongs to and the polygon it leads to
+  std::vector<uint32_t> portalOwner;
+  std::vector<dtPolyRef> portalOwnerRef, portalNeighbourRef;
+  for (int iTile = 0; iTile < navMesh->getMaxTiles(); ++iTile) {
+    const dtMeshTile* tile = navMesh->getTile(iTile);
+    if (!tile || !tile->header)
+      continue;
+
+    for (int jPoly = 0; jPoly < tile->header->polyCount; ++jPoly) {
+      const dtPolyRef ref = navMesh->encodePolyId(tile->salt, iTile, jPoly);
+      const uint32_t iPoly = polyIndex(ref);
+      const dtPoly* poly = &tile->polys[jPoly];
+      field.portalStart[iPoly] = field.portalPoints.size();
+      if (!filter_->passFilter(ref, tile, poly))
+        continue;
+
+      for (unsigned int iLink = poly->firstLink; iLink != DT_NULL_LINK;
+           iLink = tile->links[iLink].next) {
+        const dtLink& link = tile->links[iLink];
+        const dtMeshTile* neighbourTile = nullptr;
+        const dtPoly* neighbourPoly = nullptr;
+        navMesh->getTileAndPolyByRefUnsafe(link.ref, &neighbourTile,
+                                           &neighbourPoly);
+        if (!filter_->passFilter(link.ref, neighbourTile, neighbourPoly))
+          continue;
+
+        field.portalPoints.emplace_back(impl::linkMidpoint(tile, poly, link));
+        portalOwner.push_back(iPoly);
+        portalOwnerRef.push_back(ref);
+        portalNeighbourRef.push_back(link.ref);
+      }
+    }
+  }
+  field.portalStart.back() = field.portalPoints.size();
+  const uint32_t numPortals = field.portalPoints.size();
+
+  // Each portal has a twin on the other side, belonging to the neighbour
+  std::vector<uint32_t> twin(numPortals);
+  std::vector<float> twinDist(numPortals);
+  for (uint32_t i = 0; i < numPortals; ++i) {
+    const uint32_t neighbour = polyIndex(portalNeighbourRef[i]);
+    float bestDist = std::numeric_limits<float>::infinity();
+    twin[i] = i;
+    for (uint32_t j = field.portalStart[neighbour];
+         j < field.portalStart[neighbour + 1]; ++j) {
+      if (portalNeighbourRef[j] != portalOwnerRef[i])
+        continue;
+      const float dist = (field.portalPoints[j] - field.portalPoints[i]).norm();
+      if (dist < bestDist) {
+        bestDist = dist;
+        twin[i] = j;
+      }
+    }
+    twinDist[i] = twin[i] == i ? 0.0f : bestDist;
+  }
+
+  typedef std::pair<float, uint32_t> QueueEntry;
+  std::priority_queue<QueueEntry, std::vector<QueueEntry>,
+                      std::greater<QueueEntry>>
+      queue;
+  field.portalDist.assign(numPortals, std::numeric_limits<float>::infinity());
+  const auto relax = [&](uint32_t portal, float dist) {
+    if (dist < field.portalDist[portal]) {
+      field.portalDist[portal] = dist;
+      queue.emplace(dist, portal);
+    }
+  };
+
+  field.goalsByPoly.clear();
+  for (const vec3f& goal : field.goals) {
+    dtStatus status = 0;
+    dtPolyRef goalRef = 0;
+    vec3f goalPt;
+    std::tie(status, goalRef, goalPt) =
+        projectToPoly(goal, navQuery_.get(), filter_.get());
+    if (status != DT_SUCCESS || goalRef == 0)
+      continue;
+
+    const uint32_t iPoly = polyIndex(goalRef);
+    field.goalsByPoly[iPoly].push_back(goalPt);
+    for (uint32_t i = field.portalStart[iPoly];
+         i < field.portalStart[iPoly + 1]; ++i) {
+      relax(i, (field.portalPoints[i] - goalPt).norm());
+    }
+  }
+
+  while (!queue.empty()) {
+    const float dist = queue.top().first;
+    const uint32_t portal = queue.top().second;
+    queue.pop();
+    if (dist > field.portalDist[portal])
+      continue;
+
+    relax(twin[portal], dist + twinDist[portal]);
+    const uint32_t owner = portalOwner[portal];
+    for (uint32_t i = field.portalStart[owner];
+         i < field.portalStart[owner + 1]; ++i) {
+      relax(i,
+            dist + (field.portalPoints[i] - field.portalPoints[portal]).norm());
+    }
+  }
+
+  field.navMeshVersion = navMeshVersion_;
+}
+
+float PathFinder::Impl::geodesicDistanceToGoals(const vec3f& pt,
+                                                GoalDistanceField& field) {
+  if (!isLoaded())
+    return std::numeric_limits<float>::infinity();
+
+  GoalDistanceField::Impl& fieldImpl = *field.pimpl_;
+  if (fieldImpl.navMeshVersion != navMeshVersion_)
+    computeGoalDistanceField(fieldImpl);
+
+  dtStatus status = 0;
+  dtPolyRef ptRef = 0;
+  vec3f polyPt;
+  std::tie(status, ptRef, polyPt) =
+      projectToPoly(pt, navQuery_.get(), filter_.get());
+  if (status != DT_SUCCESS || ptRef == 0)
+    return std::numeric_limits<float>::infinity();
+
+  // Straight lines within the polygon either directly to a goal or to one of
+  // its portals
+  const uint32_t iPoly = (*fieldImpl.polyIndex)(ptRef);
+  float dist = std::numeric_limits<float>::infinity();
+  auto goals = fieldImpl.goalsByPoly.find(iPoly);
+  if (goals != fieldImpl.goalsByPoly.end()) {
+    for (const vec3f& goal : goals->second) {
+      dist = std::min(dist, (goal - polyPt).norm());
+    }
+  }
+  for (uint32_t i = fieldImpl.portalStart[iPoly];
+       i < fieldImpl.portalStart[iPoly + 1]; ++i) {
+    dist = std::min(dist, fieldImpl.portalDist[i] +
+                              (fieldImpl.portalPoints[i] - polyPt).norm());
+  }
+
+  return dist;
+}
+
 template <typename T>
-T PathFinder::Impl::tryStep(const T& start, const T& end, bool allowSliding) {
+T PathFinder::Impl::tryStep(const T& start,
+                            const T& end,
+                            bool allowSliding,
+                            dtNavMeshQuery& navQuery) {
   static const int MAX_POLYS = 256;
   dtPolyRef polys[MAX_POLYS];
 
@@ -1122,9 +2458,9 @@ T PathFinder::Impl::tryStep(const T& start, const T& end, bool allowSliding) {
   dtPolyRef startRef = 0, endRef = 0;
   vec3f pathStart;
   std::tie(startStatus, startRef, pathStart) =
-      projectToPoly(start, navQuery_.get(), filter_.get());
+      projectToPoly(start, &navQuery, filter_.get());
   std::tie(endStatus, endRef, std::ignore) =
-      projectToPoly(end, navQuery_.get(), filter_.get());
+      projectToPoly(end, &navQuery, filter_.get());
 
   if (dtStatusFailed(startStatus) || dtStatusFailed(endStatus)) {
     return start;
@@ -1136,9 +2472,9 @@ T PathFinder::Impl::tryStep(const T& start, const T& end, bool allowSliding) {
 
   vec3f endPoint;
   int numPolys = 0;
-  navQuery_->moveAlongSurface(startRef, pathStart.data(), end.data(),
-                              filter_.get(), endPoint.data(), polys, &numPolys,
-                              MAX_POLYS, allowSliding);
+  navQuery.moveAlongSurface(startRef, pathStart.data(), end.data(),
+                            filter_.get(), endPoint.data(), polys, &numPolys,
+                            MAX_POLYS, allowSliding);
   // If there isn't any possible path between start and end, just return
   // start, that is cleanest
   if (numPolys == 0) {
@@ -1153,7 +2489,7 @@ T PathFinder::Impl::tryStep(const T& start, const T& end, bool allowSliding) {
   // surface at the endPoint and set its height to that.
   // Note, this will never fail as endPoint is always within in the poly
   // polys[numPolys - 1]
-  navQuery_->getPolyHeight(polys[numPolys - 1], endPoint.data(), &endPoint[1]);
+  navQuery.getPolyHeight(polys[numPolys - 1], endPoint.data(), &endPoint[1]);
 
   // Hack to deal with infinitely thin walls in recast allowing you to
   // transition between two different connected components
@@ -1161,7 +2497,7 @@ T PathFinder::Impl::tryStep(const T& start, const T& end, bool allowSliding) {
   // is in the same connected component as the startRef according to
   // findNearestPoly
   std::tie(std::ignore, endRef, std::ignore) =
-      projectToPoly(endPoint, navQuery_.get(), filter_.get());
+      projectToPoly(endPoint, &navQuery, filter_.get());
   if (!this->islandSystem_->hasConnection(startRef, endRef)) {
     // There isn't a connection!  This happens when endPoint is on an edge
     // shared between two different connected components (aka infinitely thin
@@ -1202,6 +2538,49 @@ T PathFinder::Impl::snapPoint(const T& pt) {
   }
 }
 
+RowMatrixXf PathFinder::Impl::trySteps(
+    const Eigen::Ref<const RowMatrixXf>& starts,
+    const Eigen::Ref<const RowMatrixXf>& ends,
+    const bool allowSliding) {
+  ESP_CHECK(starts.cols() == 3 && ends.cols() == 3 &&
+                starts.rows() == ends.rows(),
+            "PathFinder::trySteps(): expected two N x 3 arrays but got"
+                << starts.rows() << "x" << starts.cols() << "and"
+                << ends.rows() << "x" << ends.cols());
+  RowMatrixXf result = starts;
+  std::lock_guard<std::mutex> lock{queryPoolMutex_};
+  if (!isLoaded() || !initQueryPool())
+    return result;
+
+  const int numThreads = queryPool_.size();
+  const int numSteps = starts.rows();
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic, 64)
+  for (int i = 0; i < numSteps; ++i) {
+    const vec3f start = starts.row(i).transpose();
+    const vec3f end = ends.row(i).transpose();
+    result.row(i) =
+        tryStep(start, end, allowSliding, *queryPool_[threadIndex()])
+            .transpose();
+  }
+  return result;
+}
+
+RowMatrixXf PathFinder::Impl::snapPoints(
+    const Eigen::Ref<const RowMatrixXf>& points) {
+  ESP_CHECK(points.cols() == 3,
+            "PathFinder::snapPoints(): expected an N x 3 array but got"
+                << points.rows() << "x" << points.cols());
+  RowMatrixXf result(points.rows(), 3);
+  const int numPoints = points.rows();
+  // Snapping only reads from the navmesh query, so it can be shared
+#pragma omp parallel for schedule(dynamic, 64)
+  for (int i = 0; i < numPoints; ++i) {
+    const vec3f pt = points.row(i).transpose();
+    result.row(i) = snapPoint(pt).transpose();
+  }
+  return result;
+}
+
 float PathFinder::Impl::islandRadius(const vec3f& pt) const {
   dtPolyRef ptRef = 0;
   dtStatus status = 0;
@@ -1214,9 +2593,34 @@ float PathFinder::Impl::islandRadius(const vec3f& pt) const {
   }
 }
 
+int PathFinder::Impl::getIslandId(const vec3f& pt) const {
+  dtPolyRef ptRef = 0;
+  dtStatus status = 0;
+  std::tie(status, ptRef, std::ignore) =
+      projectToPoly(pt, navQuery_.get(), filter_.get());
+  if (status != DT_SUCCESS || ptRef == 0)
+    return ID_UNDEFINED;
+
+  const uint32_t island = islandSystem_->islandId(ptRef);
+  return island == impl::NO_ISLAND ? ID_UNDEFINED : static_cast<int>(island);
+}
+
+int PathFinder::Impl::numIslands() const {
+  if (!islandSystem_)
+    return 0;
+  return islandSystem_->numIslands();
+}
+
 float PathFinder::Impl::distanceToClosestObstacle(
     const vec3f& pt,
     const float maxSearchRadius /*= 2.0*/) const {
+  // The field only knows distances up to its maximum and only covers points
+  // on the navmesh
+  if (clearanceField_ && maxSearchRadius <= clearanceField_->maxDistance()) {
+    const float dist = clearanceField_->lookup(pt);
+    if (!std::isnan(dist))
+      return std::min(dist, maxSearchRadius);
+  }
   return closestObstacleSurfacePoint(pt, maxSearchRadius).hitDist;
 }
 
@@ -1262,6 +2666,40 @@ bool PathFinder::Impl::isNavigable(const vec3f& pt,
 
 typedef Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic> MatrixXb;
 
+namespace {
+// The x range covered by the part of a triangle inside the slab z0 <= z <= z1,
+// ignoring its height.  Returns false if the triangle doesn't touch the slab
+bool triangleSlabXRange(const Triangle& tri,
+                        const float z0,
+                        const float z1,
+                        float& xmin,
+                        float& xmax) {
+  xmin = std::numeric_limits<float>::infinity();
+  xmax = -std::numeric_limits<float>::infinity();
+  const auto extend = [&](float x) {
+    xmin = std::min(xmin, x);
+    xmax = std::max(xmax, x);
+  };
+
+  for (int i = 0; i < 3; ++i) {
+    const vec3f& a = tri.v[i];
+    const vec3f& b = tri.v[(i + 1) % 3];
+    if (a[2] >= z0 && a[2] <= z1)
+      extend(a[0]);
+
+    // Where the edge crosses either side of the slab
+    for (const float z : {z0, z1}) {
+      if ((a[2] < z) != (b[2] < z)) {
+        const float t = (z - a[2]) / (b[2] - a[2]);
+        extend(a[0] + t * (b[0] - a[0]));
+      }
+    }
+  }
+
+  return xmin <= xmax;
+}
+}  // namespace
+
 Eigen::Matrix<bool, Eigen::Dynamic, Eigen::Dynamic>
 PathFinder::Impl::getTopDownView(const float metersPerPixel,
                                  const float height) const {
@@ -1275,18 +2713,104 @@ PathFinder::Impl::getTopDownView(const float metersPerPixel,
   int zResolution = zspan / metersPerPixel;
   float startx = fmin(bound1[0], bound2[0]);
   float startz = fmin(bound1[2], bound2[2]);
-  MatrixXb topdownMap(zResolution, xResolution);
+  MatrixXb topdownMap = MatrixXb::Constant(zResolution, xResolution, false);
+  if (xResolution <= 0 || zResolution <= 0)
+    return topdownMap;
 
-  float curz = startz;
+  // Pixel centers are accumulated the same way they always have been so the
+  // sampled points stay bit-identical
+  std::vector<float> xs(xResolution), zs(zResolution);
   float curx = startx;
+  for (int w = 0; w < xResolution; w++) {
+    xs[w] = curx;
+    curx = curx + metersPerPixel;
+  }
+  float curz = startz;
   for (int h = 0; h < zResolution; h++) {
+    zs[h] = curz;
+    curz = curz + metersPerPixel;
+  }
+
+  // A pixel can only be navigable if it's within isNavigable()'s horizontal
+  // tolerance of a walkable polygon whose height range is within the vertical
+  // one, so scan-convert the (slightly dilated) triangles of all such polygons
+  // to find the candidate pixels.  Only those get the exact isNavigable()
+  // check, which keeps the result identical to testing every pixel.
+  constexpr float maxYDelta = 0.5;
+  constexpr float margin = 2e-2;
+  std::vector<Triangle> triangles;
+  std::vector<std::vector<int>> rowTriangles(zResolution);
+  for (int iTile = 0; iTile < navMesh_->getMaxTiles(); ++iTile) {
+    const dtMeshTile* tile =
+        const_cast<const dtNavMesh*>(navMesh_.get())->getTile(iTile);
+    if (!tile || !tile->header)
+      continue;
+
+    for (int jPoly = 0; jPoly < tile->header->polyCount; ++jPoly) {
+      const dtPoly* poly = &tile->polys[jPoly];
+      const dtPolyRef polyRef =
+          navMesh_->encodePolyId(tile->salt, iTile, jPoly);
+      if (poly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION ||
+          !filter_->passFilter(polyRef, tile, poly))
+        continue;
+
+      const std::vector<Triangle> polyTriangles =
+          getPolygonTriangles(poly, tile);
+      float ymin = std::numeric_limits<float>::infinity();
+      float ymax = -std::numeric_limits<float>::infinity();
+      for (const Triangle& tri : polyTriangles) {
+        for (const vec3f& v : tri.v) {
+          ymin = std::min(ymin, v[1]);
+          ymax = std::max(ymax, v[1]);
+        }
+      }
+      if (ymin - margin > height + maxYDelta ||
+          ymax + margin < height - maxYDelta)
+        continue;
+
+      for (const Triangle& tri : polyTriangles) {
+        const float zmin =
+            std::min({tri.v[0][2], tri.v[1][2], tri.v[2][2]}) - margin;
+        const float zmax =
+            std::max({tri.v[0][2], tri.v[1][2], tri.v[2][2]}) + margin;
+        const int h0 =
+            std::lower_bound(zs.begin(), zs.end(), zmin) - zs.begin();
+        const int h1 =
+            std::upper_bound(zs.begin(), zs.end(), zmax) - zs.begin();
+        if (h0 >= h1)
+          continue;
+
+        for (int h = h0; h < h1; ++h) {
+          rowTriangles[h].push_back(triangles.size());
+        }
+        triangles.push_back(tri);
+      }
+    }
+  }
+
+  // Rows are independent, so they are split across threads.  The navmesh
+  // query is only read from by isNavigable()
+#pragma omp parallel for schedule(dynamic)
+  for (int h = 0; h < zResolution; h++) {
+    std::vector<char> candidates(xResolution, 0);
+    for (const int iTri : rowTriangles[h]) {
+      float xmin = 0, xmax = 0;
+      if (!triangleSlabXRange(triangles[iTri], zs[h] - margin, zs[h] + margin,
+                              xmin, xmax))
+        continue;
+
+      const auto w0 = std::lower_bound(xs.begin(), xs.end(), xmin - margin);
+      const auto w1 = std::upper_bound(xs.begin(), xs.end(), xmax + margin);
+      std::fill(candidates.begin() + (w0 - xs.begin()),
+                candidates.begin() + (w1 - xs.begin()), 1);
+    }
+
     for (int w = 0; w < xResolution; w++) {
-      vec3f point = vec3f(curx, height, curz);
-      topdownMap(h, w) = isNavigable(point, 0.5);
-      curx = curx + metersPerPixel;
+      if (candidates[w]) {
+        vec3f point = vec3f(xs[w], height, zs[h]);
+        topdownMap(h, w) = isNavigable(point, maxYDelta);
+      }
     }
-    curz = curz + metersPerPixel;
-    curx = startx;
   }
 
   return topdownMap;
@@ -1302,7 +2826,7 @@ const assets::MeshData::ptr PathFinder::Impl::getNavMeshData() {
     for (int iTile = 0; iTile < navMesh_->getMaxTiles(); ++iTile) {
       const dtMeshTile* tile =
           const_cast<const dtNavMesh*>(navMesh_.get())->getTile(iTile);
-      if (!tile)
+      if (!tile || !tile->header)
         continue;
 
       // Iterate over all polygons in a tile
@@ -1346,6 +2870,18 @@ bool PathFinder::build(const NavMeshSettings& bs,
   return pimpl_->build(bs, mesh);
 }
 
+bool PathFinder::rebuildTiles(
+    const esp::assets::MeshData& mesh,
+    const std::vector<std::pair<vec3f, vec3f>>& regions) {
+  return pimpl_->rebuildTiles(mesh, regions);
+}
+
+RowMatrixXf PathFinder::sampleNavigablePoints(
+    const int n,
+    const NavigablePointSamplingOptions& options) {
+  return pimpl_->sampleNavigablePoints(n, options);
+}
+
 vec3f PathFinder::getRandomNavigablePoint(const int maxTries /*= 10*/) {
   return pimpl_->getRandomNavigablePoint(maxTries);
 }
@@ -1358,6 +2894,21 @@ bool PathFinder::findPath(MultiGoalShortestPath& path) {
   return pimpl_->findPath(path);
 }
 
+int PathFinder::findPaths(std::vector<ShortestPath>& paths) {
+  return pimpl_->findPaths(paths);
+}
+
+std::vector<float> PathFinder::geodesicDistances(
+    const std::vector<vec3f>& starts,
+    const std::vector<vec3f>& ends) {
+  return pimpl_->geodesicDistances(starts, ends);
+}
+
+float PathFinder::geodesicDistanceToGoals(const vec3f& pt,
+                                          GoalDistanceField& field) {
+  return pimpl_->geodesicDistanceToGoals(pt, field);
+}
+
 template vec3f PathFinder::tryStep<vec3f>(const vec3f&, const vec3f&);
 template Mn::Vector3 PathFinder::tryStep<Mn::Vector3>(const Mn::Vector3&,
                                                       const Mn::Vector3&);
@@ -1385,18 +2936,129 @@ T PathFinder::snapPoint(const T& pt) {
   return pimpl_->snapPoint(pt);
 }
 
+RowMatrixXf PathFinder::trySteps(const Eigen::Ref<const RowMatrixXf>& starts,
+                                 const Eigen::Ref<const RowMatrixXf>& ends) {
+  return pimpl_->trySteps(starts, ends, /*allowSliding=*/true);
+}
+
+RowMatrixXf PathFinder::tryStepsNoSliding(
+    const Eigen::Ref<const RowMatrixXf>& starts,
+    const Eigen::Ref<const RowMatrixXf>& ends) {
+  return pimpl_->trySteps(starts, ends, /*allowSliding=*/false);
+}
+
+RowMatrixXf PathFinder::snapPoints(
+    const Eigen::Ref<const RowMatrixXf>& points) {
+  return pimpl_->snapPoints(points);
+}
+
+namespace {
+// The hierarchy and clearance field are stored next to the navmesh they
+// belong to
+std::string hierarchyFilename(const std::string& navMeshFilename) {
+  return navMeshFilename + ".hpa";
+}
+
+std::string clearanceFieldFilename(const std::string& navMeshFilename) {
+  return navMeshFilename + ".clearance";
+}
+}  // namespace
+
 bool PathFinder::loadNavMesh(const std::string& path) {
-  return pimpl_->loadNavMesh(path);
+  if (!pimpl_->loadNavMesh(path))
+    return false;
+
+  // The hierarchy and clearance field are optional, the navmesh is usable
+  // without them
+  const std::string hierarchyPath = hierarchyFilename(path);
+  if (Cr::Utility::Directory::exists(hierarchyPath))
+    pimpl_->loadHierarchy(hierarchyPath);
+  const std::string clearanceFieldPath = clearanceFieldFilename(path);
+  if (Cr::Utility::Directory::exists(clearanceFieldPath))
+    pimpl_->loadClearanceField(clearanceFieldPath);
+  return true;
 }
 
 bool PathFinder::saveNavMesh(const std::string& path) {
-  return pimpl_->saveNavMesh(path);
+  if (!pimpl_->saveNavMesh(path))
+    return false;
+  return (!pimpl_->hasHierarchy() ||
+          pimpl_->saveHierarchy(hierarchyFilename(path))) &&
+         (!pimpl_->hasClearanceField() ||
+          pimpl_->saveClearanceField(clearanceFieldFilename(path)));
+}
+
+bool PathFinder::buildHierarchy(const int maxRegionPolys) {
+  return pimpl_->buildHierarchy(maxRegionPolys);
+}
+
+bool PathFinder::hasHierarchy() const {
+  return pimpl_->hasHierarchy();
+}
+
+bool PathFinder::buildClearanceField(const float cellSize,
+                                     const float maxDistance) {
+  return pimpl_->buildClearanceField(cellSize, maxDistance);
+}
+
+bool PathFinder::hasClearanceField() const {
+  return pimpl_->hasClearanceField();
+}
+
+bool PathFinder::findPathHierarchical(ShortestPath& path) {
+  return pimpl_->findPathHierarchical(path);
+}
+
+uint64_t PathFinder::getSourceHash() const {
+  return pimpl_->getSourceHash();
+}
+
+uint64_t PathFinder::computeSourceHash(const NavMeshSettings& bs,
+                                       const float* verts,
+                                       const int nverts,
+                                       const int* tris,
+                                       const int ntris,
+                                       const float* bmin,
+                                       const float* bmax) {
+  SourceHasher hasher;
+  // Field by field, so padding doesn't end up in the hash
+  hasher.add(bs.cellSize);
+  hasher.add(bs.cellHeight);
+  hasher.add(bs.agentHeight);
+  hasher.add(bs.agentRadius);
+  hasher.add(bs.agentMaxClimb);
+  hasher.add(bs.agentMaxSlope);
+  hasher.add(bs.regionMinSize);
+  hasher.add(bs.regionMergeSize);
+  hasher.add(bs.edgeMaxLen);
+  hasher.add(bs.edgeMaxError);
+  hasher.add(bs.vertsPerPoly);
+  hasher.add(bs.detailSampleDist);
+  hasher.add(bs.detailSampleMaxError);
+  hasher.add(bs.navMeshBMin.data(), 3 * sizeof(float));
+  hasher.add(bs.navMeshBMax.data(), 3 * sizeof(float));
+  hasher.add(bs.filterLowHangingObstacles);
+  hasher.add(bs.filterLedgeSpans);
+  hasher.add(bs.filterWalkableLowHeightSpans);
+  hasher.add(bs.tileSize);
+
+  hasher.add(nverts);
+  hasher.add(verts, nverts * 3 * sizeof(float));
+  hasher.add(ntris);
+  hasher.add(tris, ntris * 3 * sizeof(int));
+  hasher.add(bmin, 3 * sizeof(float));
+  hasher.add(bmax, 3 * sizeof(float));
+  return hasher.hash();
 }
 
 bool PathFinder::isLoaded() const {
   return pimpl_->isLoaded();
 }
 
+uint64_t PathFinder::getNavMeshVersion() const {
+  return pimpl_->getNavMeshVersion();
+}
+
 void PathFinder::seed(uint32_t newSeed) {
   return pimpl_->seed(newSeed);
 }
@@ -1405,6 +3067,14 @@ float PathFinder::islandRadius(const vec3f& pt) const {
   return pimpl_->islandRadius(pt);
 }
 
+int PathFinder::getIslandId(const vec3f& pt) const {
+  return pimpl_->getIslandId(pt);
+}
+
+int PathFinder::numIslands() const {
+  return pimpl_->numIslands();
+}
+
 float PathFinder::distanceToClosestObstacle(const vec3f& pt,
                                             const float maxSearchRadius) const {
   return pimpl_->distanceToClosestObstacle(pt, maxSearchRadius);
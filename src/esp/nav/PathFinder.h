@@ -100,6 +100,29 @@ struct MultiGoalShortestPath {
   ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(MultiGoalShortestPath)
 };
 
+/**
+ * @brief Geodesic distances from anywhere on the navmesh to the closest point
+ * in a set of goals.
+ *
+ * The distances are computed once over the whole navmesh the first time the
+ * field is queried with @ref PathFinder::geodesicDistanceToGoals and reused
+ * until the goals or the navmesh change.
+ */
+struct GoalDistanceField {
+  GoalDistanceField();
+
+  /**
+   * @brief Set the goals the distances are computed to
+   */
+  void setGoals(const std::vector<vec3f>& newGoals);
+
+  const std::vector<vec3f>& getGoals() const;
+
+  friend class PathFinder;
+
+  ESP_SMART_POINTERS_WITH_UNIQUE_PIMPL(GoalDistanceField)
+};
+
 struct NavMeshSettings {
   //! Cell size in world units
   float cellSize{};
@@ -134,6 +157,11 @@ struct NavMeshSettings {
   bool filterLedgeSpans{};
   bool filterWalkableLowHeightSpans{};
 
+  //! Tile size in cells. If positive, the navmesh is split into tiles of
+  //! tileSize x tileSize cells which are built in parallel. If 0, the whole
+  //! navmesh is built as a single tile.
+  int tileSize{};
+
   void setDefaults() {
     cellSize = 0.05f;
     cellHeight = 0.2f;
@@ -151,6 +179,7 @@ struct NavMeshSettings {
     filterLowHangingObstacles = true;
     filterLedgeSpans = true;
     filterWalkableLowHeightSpans = true;
+    tileSize = 0;
   }
 
   NavMeshSettings() { setDefaults(); }
@@ -158,6 +187,46 @@ struct NavMeshSettings {
   ESP_SMART_POINTERS(NavMeshSettings)
 };
 
+/**
+ * @brief Options for @ref PathFinder::sampleNavigablePoints
+ */
+struct NavigablePointSamplingOptions {
+  //! Only sample from the island with this id, see @ref
+  //! PathFinder::getIslandId. @ref ID_UNDEFINED to sample from all islands
+  int islandId{};
+  //! Only sample from islands with at least this radius, see @ref
+  //! PathFinder::islandRadius
+  float minIslandRadius{};
+  //! If true, the i-th of n points is drawn from the i-th of n equal-area
+  //! strata of the navmesh, so every polygon gets a number of points
+  //! proportional to its area up to rounding. Otherwise points are drawn
+  //! independently, weighted by area.
+  bool stratified{};
+  //! Minimum distance between any two points (Poisson-disk sampling), 0 to
+  //! disable
+  float minDistance{};
+  //! Number of candidates drawn for each point before giving up on it when
+  //! they are all closer than @ref minDistance to a previous point
+  int maxTries{};
+  //! Seed of the sampler, the same seed and options give the same points. If
+  //! negative, the seed is drawn from the generator seeded by @ref
+  //! PathFinder::seed
+  int seed{};
+
+  void setDefaults() {
+    islandId = ID_UNDEFINED;
+    minIslandRadius = 0.0f;
+    stratified = false;
+    minDistance = 0.0f;
+    maxTries = 10;
+    seed = ID_UNDEFINED;
+  }
+
+  NavigablePointSamplingOptions() { setDefaults(); }
+
+  ESP_SMART_POINTERS(NavigablePointSamplingOptions)
+};
+
 /** Loads and/or builds a navigation mesh and then performs path
  * finding and collision queries on that navmesh
  *
@@ -179,6 +248,23 @@ class PathFinder {
              const float* bmax);
   bool build(const NavMeshSettings& bs, const esp::assets::MeshData& mesh);
 
+  /**
+   * @brief Rebuilds the tiles of a tiled navmesh that are affected by changes
+   * of the input geometry within the given regions.
+   *
+   * The navmesh must have been built by @ref build with a positive @ref
+   * NavMeshSettings::tileSize, whose settings and bounds are reused.  All
+   * other tiles are left as they are.
+   *
+   * @param[in] mesh The full input geometry after the change
+   * @param[in] regions Axis aligned boxes (min, max) around the geometry that
+   * changed.  For moved geometry, both the old and new bounds are needed.
+   *
+   * @return Whether or not the tiles were successfully rebuilt
+   */
+  bool rebuildTiles(const esp::assets::MeshData& mesh,
+                    const std::vector<std::pair<vec3f, vec3f>>& regions);
+
   /**
    * @brief Returns a random navigable point
    *
@@ -193,6 +279,25 @@ class PathFinder {
    */
   vec3f getRandomNavigablePoint(int maxTries = 10);
 
+  /**
+   * @brief Samples many random navigable points in one call
+   *
+   * Points are sampled uniformly by area from the triangles of the navmesh
+   * polygons, using a cumulative distribution over their areas that is
+   * computed once per navmesh.
+   *
+   * @param[in] n The number of points to sample
+   * @param[in] options Filters and sampling strategy, see @ref
+   * NavigablePointSamplingOptions
+   *
+   * @return An n x 3 matrix with one point per row. It has fewer rows if
+   * @ref NavigablePointSamplingOptions::minDistance couldn't be satisfied for
+   * all points, and none if nothing passes the island filters.
+   */
+  RowMatrixXf sampleNavigablePoints(
+      int n,
+      const NavigablePointSamplingOptions& options = {});
+
   /**
    * @brief Finds the shortest path between two points on the navigation mesh
    *
@@ -220,6 +325,77 @@ class PathFinder {
    */
   bool findPath(MultiGoalShortestPath& path);
 
+  /**
+   * @brief Precomputes the hierarchy used by @ref findPathHierarchical
+   *
+   * Walkable polygons are clustered into regions of at most @p
+   * maxRegionPolys connected polygons and the costs between the portals of
+   * each region are precomputed. The hierarchy is saved by @ref saveNavMesh
+   * next to the navmesh and loaded with it by @ref loadNavMesh. It is
+   * discarded whenever the navmesh changes.
+   *
+   * @return Whether or not the hierarchy was built
+   */
+  bool buildHierarchy(int maxRegionPolys = 64);
+
+  /**
+   * @return Whether or not a hierarchy was built or loaded
+   */
+  bool hasHierarchy() const;
+
+  /**
+   * @brief Same as @ref findPath(ShortestPath&), but plans long paths on the
+   * hierarchy built by @ref buildHierarchy first and then refines them with
+   * short Detour queries.
+   *
+   * Unlike @ref findPath, the length of the found paths isn't limited by the
+   * size of the Detour search. Paths within a single region, or all paths if
+   * there is no hierarchy, are found with @ref findPath.
+   *
+   * @param[inout] path The @ref ShortestPath structure contain the starting
+   * and end point. This method will populate the @ref ShortestPath.points
+   * and @ref ShortestPath.geodesicDistance fields
+   *
+   * @return Whether or not a path exists
+   */
+  bool findPathHierarchical(ShortestPath& path);
+
+  /**
+   * @brief Finds the shortest paths for a batch of start and end points.
+   *
+   * Same as calling @ref findPath(ShortestPath&) for each path, but the
+   * queries are spread over multiple threads, each with its own navmesh query.
+   *
+   * @param[inout] paths The @ref ShortestPath structures, whose points and
+   * geodesic distances are populated.
+   *
+   * @return The number of paths that exist
+   */
+  int findPaths(std::vector<ShortestPath>& paths);
+
+  /**
+   * @brief Computes the geodesic distance between each pair of @p starts and
+   * @p ends in parallel.
+   *
+   * @return The geodesic distances, inf for pairs without a path between them
+   */
+  std::vector<float> geodesicDistances(const std::vector<vec3f>& starts,
+                                       const std::vector<vec3f>& ends);
+
+  /**
+   * @brief Returns the geodesic distance from @p pt to the closest goal of
+   * @p field.
+   *
+   * The field is (re)computed with a single Dijkstra search over the navmesh
+   * polygons if it is stale, making each query afterwards a constant time
+   * lookup. Paths are routed through the midpoints of the edges shared between
+   * polygons, so the distance is an approximation that is never shorter than
+   * the true geodesic distance.
+   *
+   * @return The distance, inf if no goal is reachable from @p pt
+   */
+  float geodesicDistanceToGoals(const vec3f& pt, GoalDistanceField& field);
+
   /**
    * @brief Attempts to move from @ref start to @ref end and returns the
    * navigable point closest to @ref end that is feasibly reachable from @ref
@@ -250,9 +426,41 @@ class PathFinder {
   template <typename T>
   T snapPoint(const T& pt);
 
+  /**
+   * @brief Batched version of @ref tryStep
+   *
+   * The steps are spread over multiple threads, each with its own navmesh
+   * query.
+   *
+   * @param[in] starts The starting locations, one per row of an N x 3 matrix
+   * @param[in] ends The desired end locations, one per row of an N x 3 matrix
+   *
+   * @return The found end locations, one per row
+   */
+  RowMatrixXf trySteps(const Eigen::Ref<const RowMatrixXf>& starts,
+                       const Eigen::Ref<const RowMatrixXf>& ends);
+
+  /**
+   * @brief Batched version of @ref tryStepNoSliding, see @ref trySteps
+   */
+  RowMatrixXf tryStepsNoSliding(const Eigen::Ref<const RowMatrixXf>& starts,
+                                const Eigen::Ref<const RowMatrixXf>& ends);
+
+  /**
+   * @brief Batched version of @ref snapPoint, processed in parallel
+   *
+   * @param[in] points The points to snap, one per row of an N x 3 matrix
+   *
+   * @return The snapped points, one per row
+   */
+  RowMatrixXf snapPoints(const Eigen::Ref<const RowMatrixXf>& points);
+
   /**
    * @brief Loads a navigation meshed saved by @ref saveNavMesh
    *
+   * Files in the current format are memory mapped and their tiles are used in
+   * place without copying. Files in the older format are still read.
+   *
    * @param[in] path The saved navigation mesh file, generally has extension
    * ``.navmesh``
    *
@@ -269,11 +477,40 @@ class PathFinder {
    */
   bool saveNavMesh(const std::string& path);
 
+  /**
+   * @brief Returns the hash of the source mesh and @ref NavMeshSettings the
+   * navmesh was built from.
+   *
+   * The hash is stored by @ref saveNavMesh, so a saved navmesh can be checked
+   * against its source with @ref computeSourceHash. It is 0 if unknown, e.g.
+   * for navmeshes loaded from files in the older format.
+   */
+  uint64_t getSourceHash() const;
+
+  /**
+   * @brief Computes the hash @ref getSourceHash returns for a navmesh built
+   * by @ref build with the same arguments.
+   */
+  static uint64_t computeSourceHash(const NavMeshSettings& bs,
+                                    const float* verts,
+                                    const int nverts,
+                                    const int* tris,
+                                    const int ntris,
+                                    const float* bmin,
+                                    const float* bmax);
+
   /**
    * @return If a navigation mesh is current loaded or not
    */
   bool isLoaded() const;
 
+  /**
+   * @brief Returns a version that changes whenever the navmesh is loaded,
+   * built or partially rebuilt, so results derived from it can be
+   * invalidated. Versions are unique across all PathFinders of the process.
+   */
+  uint64_t getNavMeshVersion() const;
+
   /**
    * @brief Seed the pathfinder.  Useful for @ref getRandomNavigablePoint
    *
@@ -292,6 +529,23 @@ class PathFinder {
    */
   float islandRadius(const vec3f& pt) const;
 
+  /**
+   * @brief returns the id of the connected component @ref pt belongs to.
+   *
+   * Ids are in [0, @ref numIslands()), so they can be used to index per-island
+   * data, e.g. to restrict sampling to a single island.
+   *
+   * @param[in] pt The point to specify the connected component
+   *
+   * @return The island id or @ref ID_UNDEFINED if @ref pt isn't on the navmesh
+   */
+  int getIslandId(const vec3f& pt) const;
+
+  /**
+   * @brief returns the number of connected components of the navmesh.
+   */
+  int numIslands() const;
+
   /**
    * @brief Finds the distance to the closest non-navigable location
    *
@@ -312,6 +566,27 @@ class PathFinder {
       const vec3f& pt,
       const float maxSearchRadius = 2.0) const;
 
+  /**
+   * @brief Precomputes the distance to the closest obstacle on a grid, which
+   * makes @ref distanceToClosestObstacle a bilinear lookup
+   *
+   * The navmesh is sampled every @p cellSize in the x-z plane, once per
+   * walkable surface, and the exact distance from each sample to the closest
+   * navmesh boundary is stored up to @p maxDistance. Queries with a larger
+   * search radius or outside the sampled surface still use Detour, as does
+   * @ref closestObstacleSurfacePoint. The field is saved by @ref saveNavMesh
+   * next to the navmesh and loaded with it by @ref loadNavMesh. It is
+   * discarded whenever the navmesh changes.
+   *
+   * @return Whether or not the field was built
+   */
+  bool buildClearanceField(float cellSize = 0.05, float maxDistance = 2.0);
+
+  /**
+   * @return Whether or not a clearance field was built or loaded
+   */
+  bool hasClearanceField() const;
+
   /**
    * @brief Query whether or not a given location is navigable
    *
@@ -27,24 +27,80 @@ constexpr struct {
 } MultiGoalBenchMarkData[]{{"path to closest of 1000", false},
                            {"cached path to closest of 1000", true}};
 
+// A flat square floor centered at the origin, split into a grid of quads so
+// that its triangles span several navmesh tiles
+void makeFloor(const float size,
+               const int numQuads,
+               std::vector<float>& verts,
+               std::vector<int>& tris) {
+  const float step = size / numQuads;
+  for (int z = 0; z <= numQuads; ++z) {
+    for (int x = 0; x <= numQuads; ++x) {
+      verts.insert(verts.end(),
+                   {-size / 2 + x * step, 0.0f, -size / 2 + z * step});
+    }
+  }
+  for (int z = 0; z < numQuads; ++z) {
+    for (int x = 0; x < numQuads; ++x) {
+      const int i = z * (numQuads + 1) + x;
+      const int j = i + numQuads + 1;
+      tris.insert(tris.end(), {i, j, i + 1, i + 1, j, j + 1});
+    }
+  }
+}
+
 struct PathFinderTest : Cr::TestSuite::Tester {
   explicit PathFinderTest();
 
   void bounds();
   void tryStepNoSliding();
   void multiGoalPath();
+  void tiledBuild();
+  void findPaths();
+  void islands();
+  void topDownView();
+  void saveLoad();
+  void sampleNavigablePoints();
+  void batchedSteps();
+  void hierarchicalPath();
+  void goalDistanceField();
+  void clearanceField();
 
   void benchmarkSingleGoal();
   void benchmarkMultiGoal();
+  void benchmarkFindPathsSerial();
+  void benchmarkFindPathsBatched();
+  void benchmarkGoalDistanceField();
+  void benchmarkTopDownView();
+  void benchmarkLongPath();
+  void benchmarkLongPathHierarchical();
+  void benchmarkObstacleDistance();
+  void benchmarkObstacleDistanceField();
 
   void testCaching();
 };
 
 PathFinderTest::PathFinderTest() {
   addTests({&PathFinderTest::bounds, &PathFinderTest::tryStepNoSliding,
-            &PathFinderTest::multiGoalPath, &PathFinderTest::testCaching});
-
-  addBenchmarks({&PathFinderTest::benchmarkSingleGoal}, 1000);
+            &PathFinderTest::multiGoalPath, &PathFinderTest::tiledBuild,
+            &PathFinderTest::findPaths, &PathFinderTest::islands,
+            &PathFinderTest::topDownView, &PathFinderTest::saveLoad,
+            &PathFinderTest::sampleNavigablePoints,
+            &PathFinderTest::batchedSteps, &PathFinderTest::hierarchicalPath,
+            &PathFinderTest::goalDistanceField,
+            &PathFinderTest::clearanceField, &PathFinderTest::testCaching});
+
+  addBenchmarks({&PathFinderTest::benchmarkSingleGoal,
+                 &PathFinderTest::benchmarkGoalDistanceField,
+                 &PathFinderTest::benchmarkLongPath,
+                 &PathFinderTest::benchmarkLongPathHierarchical,
+                 &PathFinderTest::benchmarkObstacleDistance,
+                 &PathFinderTest::benchmarkObstacleDistanceField},
+                1000);
+  addBenchmarks({&PathFinderTest::benchmarkFindPathsSerial,
+                 &PathFinderTest::benchmarkFindPathsBatched,
+                 &PathFinderTest::benchmarkTopDownView},
+                10);
   addInstancedBenchmarks({&PathFinderTest::benchmarkMultiGoal}, 100,
                          Cr::Containers::arraySize(MultiGoalBenchMarkData));
 }
@@ -126,6 +182,446 @@ void PathFinderTest::multiGoalPath() {
   }
 }
 
+void PathFinderTest::tiledBuild() {
+  std::vector<float> verts;
+  std::vector<int> tris;
+  makeFloor(20.0f, 10, verts, tris);
+  const float bmin[3] = {-10.0f, -0.5f, -10.0f};
+  const float bmax[3] = {10.0f, 1.0f, 10.0f};
+
+  esp::nav::NavMeshSettings settings;
+  esp::nav::PathFinder singleTile;
+  CORRADE_VERIFY(singleTile.build(settings, verts.data(), verts.size() / 3,
+                                  tris.data(), tris.size() / 3, bmin, bmax));
+
+  // 3.2m tiles, so the floor is split into 7x7 tiles
+  settings.tileSize = 64;
+  esp::nav::PathFinder tiled;
+  CORRADE_VERIFY(tiled.build(settings, verts.data(), verts.size() / 3,
+                             tris.data(), tris.size() / 3, bmin, bmax));
+
+  CORRADE_COMPARE_AS(
+      std::abs(tiled.getNavigableArea() - singleTile.getNavigableArea()),
+      0.01f * singleTile.getNavigableArea(), Cr::TestSuite::Compare::Less);
+
+  // Paths cross the tile borders without detours and the whole floor is one
+  // island
+  esp::nav::ShortestPath path;
+  path.requestedStart = esp::vec3f{-8.0f, 0.0f, -8.0f};
+  path.requestedEnd = esp::vec3f{8.0f, 0.0f, 8.0f};
+  CORRADE_VERIFY(tiled.findPath(path));
+  CORRADE_COMPARE_AS(
+      std::abs(path.geodesicDistance -
+               (path.requestedEnd - path.requestedStart).norm()),
+      0.05f, Cr::TestSuite::Compare::Less);
+  CORRADE_COMPARE(tiled.islandRadius(path.requestedStart),
+                  tiled.islandRadius(path.requestedEnd));
+  CORRADE_COMPARE(tiled.numIslands(), 1);
+
+  const esp::vec3f end = tiled.tryStep(path.requestedStart, path.requestedEnd);
+  CORRADE_VERIFY(end.isApprox(path.requestedEnd, 1e-3));
+}
+
+void PathFinderTest::findPaths() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  pathFinder.seed(0);
+
+  std::vector<esp::nav::ShortestPath> paths(1000);
+  std::vector<esp::vec3f> starts, ends;
+  for (auto& path : paths) {
+    path.requestedStart = pathFinder.getRandomNavigablePoint();
+    path.requestedEnd = pathFinder.getRandomNavigablePoint();
+    starts.push_back(path.requestedStart);
+    ends.push_back(path.requestedEnd);
+  }
+  // Also a start that isn't on the navmesh at all
+  paths.back().requestedStart = esp::vec3f{1e2, 1e2, 1e2};
+  starts.back() = paths.back().requestedStart;
+
+  std::vector<esp::nav::ShortestPath> batch = paths;
+  const int numFound = pathFinder.findPaths(batch);
+  const std::vector<float> distances =
+      pathFinder.geodesicDistances(starts, ends);
+  CORRADE_COMPARE(distances.size(), paths.size());
+
+  int expectedNumFound = 0;
+  for (size_t i = 0; i < paths.size(); ++i) {
+    CORRADE_ITERATION(i);
+    if (pathFinder.findPath(paths[i]))
+      ++expectedNumFound;
+
+    CORRADE_COMPARE(batch[i].geodesicDistance, paths[i].geodesicDistance);
+    CORRADE_COMPARE(batch[i].points.size(), paths[i].points.size());
+    CORRADE_COMPARE(distances[i], paths[i].geodesicDistance);
+  }
+  CORRADE_COMPARE(numFound, expectedNumFound);
+  CORRADE_COMPARE(distances.back(), std::numeric_limits<float>::infinity());
+}
+
+void PathFinderTest::islands() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  pathFinder.seed(0);
+
+  const int numIslands = pathFinder.numIslands();
+  CORRADE_COMPARE_AS(numIslands, 0, Cr::TestSuite::Compare::Greater);
+  CORRADE_COMPARE(pathFinder.getIslandId(esp::vec3f{1e2, 1e2, 1e2}),
+                  esp::ID_UNDEFINED);
+
+  for (int i = 0; i < 500; ++i) {
+    CORRADE_ITERATION(i);
+    esp::nav::ShortestPath path;
+    path.requestedStart = pathFinder.getRandomNavigablePoint();
+    path.requestedEnd = pathFinder.getRandomNavigablePoint();
+
+    const int startIsland = pathFinder.getIslandId(path.requestedStart);
+    const int endIsland = pathFinder.getIslandId(path.requestedEnd);
+    CORRADE_COMPARE_AS(startIsland, 0, Cr::TestSuite::Compare::GreaterOrEqual);
+    CORRADE_COMPARE_AS(startIsland, numIslands, Cr::TestSuite::Compare::Less);
+
+    CORRADE_COMPARE(startIsland == endIsland, pathFinder.findPath(path));
+    if (startIsland == endIsland) {
+      CORRADE_COMPARE(pathFinder.islandRadius(path.requestedStart),
+                      pathFinder.islandRadius(path.requestedEnd));
+    }
+  }
+}
+
+void PathFinderTest::topDownView() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  pathFinder.seed(0);
+
+  const float metersPerPixel = 0.1f;
+  const float height = pathFinder.getRandomNavigablePoint()[1];
+  const auto topDownView = pathFinder.getTopDownView(metersPerPixel, height);
+
+  // Compare against testing every single pixel
+  const std::pair<esp::vec3f, esp::vec3f> bounds = pathFinder.bounds();
+  CORRADE_COMPARE(topDownView.rows(),
+                  int((bounds.second[2] - bounds.first[2]) / metersPerPixel));
+  CORRADE_COMPARE(topDownView.cols(),
+                  int((bounds.second[0] - bounds.first[0]) / metersPerPixel));
+  int numNavigable = 0;
+  float curz = bounds.first[2];
+  for (int h = 0; h < topDownView.rows(); h++) {
+    float curx = bounds.first[0];
+    for (int w = 0; w < topDownView.cols(); w++) {
+      CORRADE_ITERATION(h << " " << w);
+      CORRADE_COMPARE(topDownView(h, w),
+                      pathFinder.isNavigable({curx, height, curz}, 0.5));
+      numNavigable += topDownView(h, w);
+      curx = curx + metersPerPixel;
+    }
+    curz = curz + metersPerPixel;
+  }
+  CORRADE_COMPARE_AS(numNavigable, 0, Cr::TestSuite::Compare::Greater);
+}
+
+void PathFinderTest::saveLoad() {
+  std::vector<float> verts;
+  std::vector<int> tris;
+  makeFloor(20.0f, 10, verts, tris);
+  const float bmin[3] = {-10.0f, -0.5f, -10.0f};
+  const float bmax[3] = {10.0f, 1.0f, 10.0f};
+
+  esp::nav::NavMeshSettings settings;
+  settings.tileSize = 64;
+  esp::nav::PathFinder built;
+  CORRADE_VERIFY(built.build(settings, verts.data(), verts.size() / 3,
+                             tris.data(), tris.size() / 3, bmin, bmax));
+  const uint64_t sourceHash = esp::nav::PathFinder::computeSourceHash(
+      settings, verts.data(), verts.size() / 3, tris.data(), tris.size() / 3,
+      bmin, bmax);
+  CORRADE_COMPARE(built.getSourceHash(), sourceHash);
+
+  // Any change to the settings changes the hash
+  settings.agentRadius *= 2.0f;
+  CORRADE_VERIFY(esp::nav::PathFinder::computeSourceHash(
+                     settings, verts.data(), verts.size() / 3, tris.data(),
+                     tris.size() / 3, bmin, bmax) != sourceHash);
+
+  const std::string file =
+      Cr::Utility::Directory::join(Cr::Utility::Directory::tmp(),
+                                   "PathFinderTest-saveLoad.navmesh");
+  CORRADE_VERIFY(built.saveNavMesh(file));
+
+  esp::nav::PathFinder loaded;
+  CORRADE_VERIFY(loaded.loadNavMesh(file));
+  CORRADE_COMPARE(loaded.getSourceHash(), sourceHash);
+  CORRADE_COMPARE(loaded.getNavigableArea(), built.getNavigableArea());
+  CORRADE_COMPARE(loaded.numIslands(), built.numIslands());
+
+  esp::nav::ShortestPath builtPath;
+  builtPath.requestedStart = esp::vec3f{-8.0f, 0.0f, -8.0f};
+  builtPath.requestedEnd = esp::vec3f{8.0f, 0.0f, 5.0f};
+  esp::nav::ShortestPath loadedPath = builtPath;
+  CORRADE_VERIFY(built.findPath(builtPath));
+  CORRADE_VERIFY(loaded.findPath(loadedPath));
+  CORRADE_COMPARE(loadedPath.geodesicDistance, builtPath.geodesicDistance);
+
+  // Navmeshes in the old format still load, without a hash, and round-trip
+  // through the new one
+  esp::nav::PathFinder old;
+  CORRADE_VERIFY(old.loadNavMesh(skokloster));
+  CORRADE_COMPARE(old.getSourceHash(), uint64_t{0});
+  CORRADE_VERIFY(old.saveNavMesh(file));
+  CORRADE_VERIFY(loaded.loadNavMesh(file));
+  CORRADE_COMPARE(loaded.getNavigableArea(), old.getNavigableArea());
+  CORRADE_COMPARE(loaded.numIslands(), old.numIslands());
+
+  CORRADE_VERIFY(Cr::Utility::Directory::rm(file));
+}
+
+void PathFinderTest::sampleNavigablePoints() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+
+  esp::nav::NavigablePointSamplingOptions options;
+  options.seed = 1;
+  const esp::RowMatrixXf points =
+      pathFinder.sampleNavigablePoints(1000, options);
+  CORRADE_COMPARE(points.rows(), 1000);
+  CORRADE_COMPARE(points.cols(), 3);
+  for (int i = 0; i < points.rows(); ++i) {
+    CORRADE_ITERATION(i);
+    CORRADE_VERIFY(pathFinder.isNavigable(points.row(i).transpose()));
+  }
+
+  // Deterministic for a given seed
+  CORRADE_VERIFY(pathFinder.sampleNavigablePoints(1000, options) == points);
+
+  // Restricted to a single island
+  const esp::vec3f start = points.row(0).transpose();
+  options.islandId = pathFinder.getIslandId(start);
+  options.stratified = true;
+  const esp::RowMatrixXf islandPoints =
+      pathFinder.sampleNavigablePoints(100, options);
+  CORRADE_COMPARE(islandPoints.rows(), 100);
+  for (int i = 0; i < islandPoints.rows(); ++i) {
+    CORRADE_ITERATION(i);
+    CORRADE_COMPARE(pathFinder.getIslandId(islandPoints.row(i).transpose()),
+                    options.islandId);
+  }
+
+  // Poisson-disk sampling keeps points apart, possibly returning fewer
+  options.islandId = esp::ID_UNDEFINED;
+  options.stratified = false;
+  options.minDistance = 1.0f;
+  const esp::RowMatrixXf spreadPoints =
+      pathFinder.sampleNavigablePoints(200, options);
+  CORRADE_COMPARE_AS(spreadPoints.rows(), 0,
+                     Cr::TestSuite::Compare::Greater);
+  for (int i = 0; i < spreadPoints.rows(); ++i) {
+    for (int j = 0; j < i; ++j) {
+      CORRADE_ITERATION(i << j);
+      CORRADE_COMPARE_AS(
+          (spreadPoints.row(i) - spreadPoints.row(j)).norm(), 1.0f,
+          Cr::TestSuite::Compare::GreaterOrEqual);
+    }
+  }
+}
+
+void PathFinderTest::batchedSteps() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  pathFinder.seed(0);
+
+  const int numSteps = 1000;
+  esp::RowMatrixXf starts(numSteps, 3), ends(numSteps, 3);
+  for (int i = 0; i < numSteps; ++i) {
+    starts.row(i) = pathFinder.getRandomNavigablePoint().transpose();
+    // Steps of up to a meter in a random direction, some into walls
+    ends.row(i) = starts.row(i) + esp::vec3f::Random().transpose();
+  }
+  // A point that can't be snapped
+  ends.row(numSteps - 1) << 1e2, 1e2, 1e2;
+
+  const esp::RowMatrixXf steps = pathFinder.trySteps(starts, ends);
+  const esp::RowMatrixXf stepsNoSliding =
+      pathFinder.tryStepsNoSliding(starts, ends);
+  const esp::RowMatrixXf snapped = pathFinder.snapPoints(ends);
+  CORRADE_COMPARE(steps.rows(), numSteps);
+  CORRADE_COMPARE(stepsNoSliding.rows(), numSteps);
+  CORRADE_COMPARE(snapped.rows(), numSteps);
+
+  for (int i = 0; i < numSteps; ++i) {
+    CORRADE_ITERATION(i);
+    const esp::vec3f start = starts.row(i).transpose();
+    const esp::vec3f end = ends.row(i).transpose();
+    CORRADE_VERIFY(steps.row(i).transpose() == pathFinder.tryStep(start, end));
+    CORRADE_VERIFY(stepsNoSliding.row(i).transpose() ==
+                   pathFinder.tryStepNoSliding(start, end));
+
+    const esp::vec3f snappedPoint = pathFinder.snapPoint(end);
+    if (std::isnan(snappedPoint[0])) {
+      CORRADE_VERIFY(std::isnan(snapped(i, 0)));
+    } else {
+      CORRADE_VERIFY(snapped.row(i).transpose() == snappedPoint);
+    }
+  }
+}
+
+void PathFinderTest::hierarchicalPath() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  CORRADE_VERIFY(!pathFinder.hasHierarchy());
+  pathFinder.seed(0);
+
+  // Small regions, so most paths go through the hierarchy
+  CORRADE_VERIFY(pathFinder.buildHierarchy(16));
+  CORRADE_VERIFY(pathFinder.hasHierarchy());
+
+  std::vector<esp::nav::ShortestPath> paths(200);
+  for (size_t i = 0; i < paths.size(); ++i) {
+    CORRADE_ITERATION(i);
+    esp::nav::ShortestPath& path = paths[i];
+    path.requestedStart = pathFinder.getRandomNavigablePoint();
+    path.requestedEnd = pathFinder.getRandomNavigablePoint();
+
+    esp::nav::ShortestPath detourPath = path;
+    const bool found = pathFinder.findPath(detourPath);
+    const bool foundHierarchical = pathFinder.findPathHierarchical(path);
+    if (!found)
+      continue;
+    CORRADE_VERIFY(foundHierarchical);
+
+    CORRADE_VERIFY(path.points.front().isApprox(detourPath.points.front()));
+    CORRADE_VERIFY(path.points.back().isApprox(detourPath.points.back()));
+    CORRADE_COMPARE_AS(
+        path.geodesicDistance,
+        (path.requestedEnd - path.requestedStart).norm() - 1e-3f,
+        Cr::TestSuite::Compare::GreaterOrEqual);
+    // Portals constrain where paths cross between regions, so they can be
+    // longer
+    CORRADE_COMPARE_AS(path.geodesicDistance,
+                       1.5f * detourPath.geodesicDistance + 1.0f,
+                       Cr::TestSuite::Compare::LessOrEqual);
+  }
+
+  // The hierarchy is saved and loaded along with the navmesh
+  const std::string file =
+      Cr::Utility::Directory::join(Cr::Utility::Directory::tmp(),
+                                   "PathFinderTest-hierarchicalPath.navmesh");
+  CORRADE_VERIFY(pathFinder.saveNavMesh(file));
+  esp::nav::PathFinder loaded;
+  CORRADE_VERIFY(loaded.loadNavMesh(file));
+  CORRADE_VERIFY(loaded.hasHierarchy());
+  for (size_t i = 0; i < paths.size(); ++i) {
+    CORRADE_ITERATION(i);
+    esp::nav::ShortestPath path = paths[i];
+    loaded.findPathHierarchical(path);
+    CORRADE_COMPARE(path.geodesicDistance, paths[i].geodesicDistance);
+  }
+  CORRADE_VERIFY(Cr::Utility::Directory::rm(file));
+  CORRADE_VERIFY(Cr::Utility::Directory::rm(file + ".hpa"));
+}
+
+void PathFinderTest::goalDistanceField() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  pathFinder.seed(0);
+
+  std::vector<esp::vec3f> goals;
+  for (int i = 0; i < 5; ++i) {
+    goals.emplace_back(pathFinder.getRandomNavigablePoint());
+  }
+  esp::nav::GoalDistanceField field;
+  field.setGoals(goals);
+
+  esp::nav::MultiGoalShortestPath path;
+  path.setRequestedEnds(goals);
+  for (int i = 0; i < 200; ++i) {
+    CORRADE_ITERATION(i);
+    path.requestedStart = pathFinder.getRandomNavigablePoint();
+    const bool found = pathFinder.findPath(path);
+    const float dist =
+        pathFinder.geodesicDistanceToGoals(path.requestedStart, field);
+    CORRADE_COMPARE(std::isfinite(dist), found);
+    if (!found)
+      continue;
+
+    float euclidDist = std::numeric_limits<float>::infinity();
+    for (const esp::vec3f& goal : goals) {
+      euclidDist = std::min(euclidDist, (goal - path.requestedStart).norm());
+    }
+    CORRADE_COMPARE_AS(dist, euclidDist - 1e-3f,
+                       Cr::TestSuite::Compare::GreaterOrEqual);
+  }
+
+  // Goals are on the navmesh, so their distance to themselves is zero
+  for (const esp::vec3f& goal : goals) {
+    CORRADE_COMPARE(pathFinder.geodesicDistanceToGoals(goal, field), 0.0f);
+  }
+
+  // Changing the goals recomputes the field
+  field.setGoals({goals.front()});
+  CORRADE_COMPARE_AS(pathFinder.geodesicDistanceToGoals(goals.back(), field),
+                     0.0f, Cr::TestSuite::Compare::Greater);
+}
+
+void PathFinderTest::clearanceField() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  pathFinder.seed(0);
+
+  const int numPoints = 500;
+  std::vector<esp::vec3f> points;
+  std::vector<float> expected;
+  for (int i = 0; i < numPoints; ++i) {
+    points.emplace_back(pathFinder.getRandomNavigablePoint());
+    expected.push_back(pathFinder.distanceToClosestObstacle(points.back()));
+  }
+
+  const float cellSize = 0.05f;
+  CORRADE_VERIFY(!pathFinder.hasClearanceField());
+  CORRADE_VERIFY(pathFinder.buildClearanceField(cellSize, 2.0f));
+  CORRADE_VERIFY(pathFinder.hasClearanceField());
+
+  // Interpolation between samples is only accurate to about a cell
+  int numClose = 0;
+  std::vector<float> dists;
+  for (int i = 0; i < numPoints; ++i) {
+    CORRADE_ITERATION(i);
+    dists.push_back(pathFinder.distanceToClosestObstacle(points[i]));
+    CORRADE_COMPARE_AS(dists.back(), 2.0f,
+                       Cr::TestSuite::Compare::LessOrEqual);
+    if (std::abs(dists.back() - expected[i]) <= 2 * cellSize)
+      ++numClose;
+  }
+  CORRADE_COMPARE_AS(numClose, numPoints * 95 / 100,
+                     Cr::TestSuite::Compare::GreaterOrEqual);
+
+  // Search radii beyond the field still use Detour
+  CORRADE_COMPARE(pathFinder.distanceToClosestObstacle(points[0], 5.0f),
+                  pathFinder.closestObstacleSurfacePoint(points[0], 5.0f)
+                      .hitDist);
+
+  // The field is saved and loaded along with the navmesh
+  const std::string file =
+      Cr::Utility::Directory::join(Cr::Utility::Directory::tmp(),
+                                   "PathFinderTest-clearanceField.navmesh");
+  CORRADE_VERIFY(pathFinder.saveNavMesh(file));
+  esp::nav::PathFinder loaded;
+  CORRADE_VERIFY(loaded.loadNavMesh(file));
+  CORRADE_VERIFY(loaded.hasClearanceField());
+  for (int i = 0; i < numPoints; ++i) {
+    CORRADE_ITERATION(i);
+    CORRADE_COMPARE(loaded.distanceToClosestObstacle(points[i]), dists[i]);
+  }
+  CORRADE_VERIFY(Cr::Utility::Directory::rm(file));
+  CORRADE_VERIFY(Cr::Utility::Directory::rm(file + ".clearance"));
+}
+
 void PathFinderTest::testCaching() {
   esp::nav::PathFinder pathFinder;
   pathFinder.loadNavMesh(skokloster);
@@ -173,6 +669,79 @@ void PathFinderTest::benchmarkSingleGoal() {
   CORRADE_VERIFY(status);
 }
 
+void PathFinderTest::benchmarkGoalDistanceField() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+
+  std::vector<esp::vec3f> goals;
+  for (int i = 0; i < 1000; ++i) {
+    goals.emplace_back(pathFinder.getRandomNavigablePoint());
+  }
+  esp::nav::GoalDistanceField field;
+  field.setGoals(goals);
+
+  const esp::vec3f start = pathFinder.getRandomNavigablePoint();
+  // Exclude the one-time computation of the field
+  pathFinder.geodesicDistanceToGoals(start, field);
+
+  float dist = 0;
+  CORRADE_BENCHMARK(5) {
+    dist = pathFinder.geodesicDistanceToGoals(start, field);
+  };
+  CORRADE_VERIFY(std::isfinite(dist));
+}
+
+void PathFinderTest::benchmarkTopDownView() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+
+  const float height = pathFinder.getRandomNavigablePoint()[1];
+  CORRADE_BENCHMARK(1) { pathFinder.getTopDownView(0.05f, height); };
+}
+
+namespace {
+// The longest of a few random paths
+esp::nav::ShortestPath longPath(esp::nav::PathFinder& pathFinder) {
+  pathFinder.seed(0);
+  esp::nav::ShortestPath longest;
+  longest.geodesicDistance = 0;
+  for (int i = 0; i < 100; ++i) {
+    esp::nav::ShortestPath path;
+    path.requestedStart = pathFinder.getRandomNavigablePoint();
+    path.requestedEnd = pathFinder.getRandomNavigablePoint();
+    if (pathFinder.findPath(path) &&
+        path.geodesicDistance > longest.geodesicDistance)
+      longest = path;
+  }
+  return longest;
+}
+}  // namespace
+
+void PathFinderTest::benchmarkLongPath() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+
+  esp::nav::ShortestPath path = longPath(pathFinder);
+  bool status = false;
+  CORRADE_BENCHMARK(5) { status = pathFinder.findPath(path); };
+  CORRADE_VERIFY(status);
+}
+
+void PathFinderTest::benchmarkLongPathHierarchical() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  CORRADE_VERIFY(pathFinder.buildHierarchy());
+
+  esp::nav::ShortestPath path = longPath(pathFinder);
+  bool status = false;
+  CORRADE_BENCHMARK(5) { status = pathFinder.findPathHierarchical(path); };
+  CORRADE_VERIFY(status);
+}
+
 void PathFinderTest::benchmarkMultiGoal() {
   esp::nav::PathFinder pathFinder;
   pathFinder.loadNavMesh(skokloster);
@@ -202,6 +771,85 @@ void PathFinderTest::benchmarkMultiGoal() {
   CORRADE_VERIFY(status);
 }
 
+void PathFinderTest::benchmarkFindPathsSerial() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  pathFinder.seed(0);
+
+  std::vector<esp::nav::ShortestPath> paths(1000);
+  for (auto& path : paths) {
+    path.requestedStart = pathFinder.getRandomNavigablePoint();
+    path.requestedEnd = pathFinder.getRandomNavigablePoint();
+  }
+
+  int numFound = 0;
+  CORRADE_BENCHMARK(1) {
+    for (auto& path : paths) {
+      numFound += pathFinder.findPath(path);
+    }
+  };
+  CORRADE_VERIFY(numFound > 0);
+}
+
+void PathFinderTest::benchmarkFindPathsBatched() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  pathFinder.seed(0);
+
+  std::vector<esp::nav::ShortestPath> paths(1000);
+  for (auto& path : paths) {
+    path.requestedStart = pathFinder.getRandomNavigablePoint();
+    path.requestedEnd = pathFinder.getRandomNavigablePoint();
+  }
+
+  int numFound = 0;
+  CORRADE_BENCHMARK(1) { numFound += pathFinder.findPaths(paths); };
+  CORRADE_VERIFY(numFound > 0);
+}
+
+void PathFinderTest::benchmarkObstacleDistance() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  pathFinder.seed(0);
+
+  std::vector<esp::vec3f> points;
+  for (int i = 0; i < 100; ++i) {
+    points.emplace_back(pathFinder.getRandomNavigablePoint());
+  }
+
+  float dist = 0;
+  CORRADE_BENCHMARK(5) {
+    for (const esp::vec3f& pt : points) {
+      dist += pathFinder.distanceToClosestObstacle(pt);
+    }
+  };
+  CORRADE_VERIFY(std::isfinite(dist));
+}
+
+void PathFinderTest::benchmarkObstacleDistanceField() {
+  esp::nav::PathFinder pathFinder;
+  pathFinder.loadNavMesh(skokloster);
+  CORRADE_VERIFY(pathFinder.isLoaded());
+  pathFinder.seed(0);
+  CORRADE_VERIFY(pathFinder.buildClearanceField());
+
+  std::vector<esp::vec3f> points;
+  for (int i = 0; i < 100; ++i) {
+    points.emplace_back(pathFinder.getRandomNavigablePoint());
+  }
+
+  float dist = 0;
+  CORRADE_BENCHMARK(5) {
+    for (const esp::vec3f& pt : points) {
+      dist += pathFinder.distanceToClosestObstacle(pt);
+    }
+  };
+  CORRADE_VERIFY(std::isfinite(dist));
+}
+
 }  // namespace
 
 CORRADE_TEST_MAIN(PathFinderTest)
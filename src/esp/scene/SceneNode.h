@@ -200,6 +200,10 @@ class SceneNode : public MagnumObject,
   //! set the global bounding box for mesh stored in this node
   void setAbsoluteAABB(Magnum::Range3D aabb) { aabb_ = aabb; };
 
+  //! whether the node has a global bounding box for a static mesh, set with
+  //! setAbsoluteAABB. Otherwise getAbsoluteAABB follows the node's motion.
+  bool hasStaticAABB() const { return bool(aabb_); }
+
   //! return the frustum plane in last frame that culls this node
   int getFrustumPlaneIndex() const { return frustumPlaneIndex; };
 
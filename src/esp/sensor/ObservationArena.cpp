@@ -0,0 +1,127 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#include "ObservationArena.h"
+
+#include <Magnum/ImageView.h>
+#include <Magnum/PixelFormat.h>
+
+#include <cstdint>
+
+#include "esp/sensor/VisualSensor.h"
+
+namespace Cr = Corrade;
+namespace Mn = Magnum;
+
+namespace esp {
+namespace sensor {
+
+constexpr std::size_t ObservationArena::Alignment;
+
+namespace {
+std::size_t alignUp(std::size_t value) {
+  return (value + ObservationArena::Alignment - 1) /
+         ObservationArena::Alignment * ObservationArena::Alignment;
+}
+}  // namespace
+
+std::size_t ObservationArena::layout(
+    const std::map<std::string, std::reference_wrapper<Sensor>>& sensors,
+    std::size_t batchSize,
+    std::vector<Slot>& slots) {
+  slots.clear();
+  std::size_t size = 0;
+  for (const auto& entry : sensors) {
+    Sensor& sensor = entry.second;
+    if (!sensor.isVisualSensor()) {
+      continue;
+    }
+    auto& visualSensor = static_cast<VisualSensor&>(sensor);
+    ObservationSpace space;
+    visualSensor.getObservationSpace(space);
+
+    Slot slot;
+    slot.uuid = entry.first;
+    slot.dataType = space.dataType;
+    slot.format = visualSensor.observationPixelFormat();
+    slot.size = visualSensor.framebufferSize();
+    slot.frameSize = Mn::pixelSize(slot.format) * slot.size.product();
+    // the channels of the pixel format, which is what is read back
+    const std::size_t channels =
+        slot.format == Mn::PixelFormat::RGBA8Unorm ? 4 : 1;
+    slot.shape = {std::size_t(slot.size.y()), std::size_t(slot.size.x()),
+                  channels};
+    slot.offset = size;
+    size = alignUp(size + slot.frameSize * batchSize);
+    slots.push_back(std::move(slot));
+  }
+  return size;
+}
+
+std::size_t ObservationArena::requiredSize(
+    const std::map<std::string, std::reference_wrapper<Sensor>>& sensors,
+    std::size_t batchSize) {
+  std::vector<Slot> slots;
+  return layout(sensors, batchSize, slots);
+}
+
+ObservationArena::ObservationArena(
+    const std::map<std::string, std::reference_wrapper<Sensor>>& sensors,
+    std::size_t batchSize)
+    : batchSize_{batchSize} {
+  const std::size_t size = layout(sensors, batchSize, slots_);
+  // over-allocate so that the start can be aligned
+  allocation_ = Cr::Containers::Array<char>{Cr::Containers::ValueInit,
+                                            size + Alignment};
+  const std::size_t start =
+      alignUp(reinterpret_cast<std::uintptr_t>(allocation_.data())) -
+      reinterpret_cast<std::uintptr_t>(allocation_.data());
+  memory_ = allocation_.slice(start, start + size);
+}
+
+ObservationArena::ObservationArena(
+    const std::map<std::string, std::reference_wrapper<Sensor>>& sensors,
+    std::size_t batchSize,
+    Cr::Containers::ArrayView<char> memory)
+    : batchSize_{batchSize} {
+  const std::size_t size = layout(sensors, batchSize, slots_);
+  CORRADE_ASSERT(memory.size() >= size,
+                 "ObservationArena::ObservationArena(): expected at least"
+                     << size << "bytes of memory but got" << memory.size(), );
+  CORRADE_ASSERT(
+      reinterpret_cast<std::uintptr_t>(memory.data()) % Alignment == 0,
+      "ObservationArena::ObservationArena(): the memory is not aligned to"
+          << Alignment << "bytes", );
+  memory_ = memory.prefix(size);
+}
+
+int ObservationArena::getSlotIndex(const std::string& uuid) const {
+  for (std::size_t i = 0; i < slots_.size(); ++i) {
+    if (slots_[i].uuid == uuid) {
+      return i;
+    }
+  }
+  return ID_UNDEFINED;
+}
+
+Mn::MutableImageView2D ObservationArena::getObservationView(
+    int slotIndex,
+    std::size_t batchIndex) {
+  CORRADE_ASSERT(slotIndex >= 0 && std::size_t(slotIndex) < slots_.size(),
+                 "ObservationArena::getObservationView(): slot index"
+                     << slotIndex << "out of range",
+                 (Mn::MutableImageView2D{Mn::PixelFormat::R8Unorm, {}}));
+  CORRADE_ASSERT(batchIndex < batchSize_,
+                 "ObservationArena::getObservationView(): batch index"
+                     << batchIndex << "out of range",
+                 (Mn::MutableImageView2D{Mn::PixelFormat::R8Unorm, {}}));
+  const Slot& slot = slots_[slotIndex];
+  return Mn::MutableImageView2D{
+      slot.format, slot.size,
+      memory_.slice(slot.offset + batchIndex * slot.frameSize,
+                    slot.offset + (batchIndex + 1) * slot.frameSize)};
+}
+
+}  // namespace sensor
+}  // namespace esp
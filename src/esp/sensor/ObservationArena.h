@@ -0,0 +1,129 @@
+// Copyright (c) Facebook, Inc. and its affiliates.
+// This source code is licensed under the MIT license found in the
+// LICENSE file in the root directory of this source tree.
+
+#ifndef ESP_SENSOR_OBSERVATIONARENA_H_
+#define ESP_SENSOR_OBSERVATIONARENA_H_
+
+#include <Corrade/Containers/Array.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Vector2.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "esp/core/Buffer.h"
+#include "esp/core/esp.h"
+
+namespace esp {
+namespace sensor {
+
+class Sensor;
+
+/**
+ * @brief Preallocated memory for the observations of the visual sensors of an
+ * agent.
+ *
+ * The arena is a single contiguous allocation with a fixed slot per visual
+ * sensor, ordered by uuid. Each slot holds @ref batchSize() observations back
+ * to back, e.g. one per simulator for @ref
+ * sim::Simulator::getBatchedSensorObservations(). Observations are read into
+ * the arena directly, so reading them allocates nothing and the slots can be
+ * handed out as views, e.g. as numpy arrays in Python.
+ *
+ * Like the observations of @ref Sensor::getObservation(), observations are
+ * stored bottom row first.
+ */
+class ObservationArena {
+ public:
+  /** @brief Alignment of the arena and of each slot, in bytes */
+  static constexpr std::size_t Alignment = 64;
+
+  struct Slot {
+    std::string uuid;
+    core::DataType dataType = core::DataType::DT_UINT8;
+    Magnum::PixelFormat format{};
+    //! Width and height of an observation, as the framebuffer size
+    Magnum::Vector2i size;
+    //! Height, width and channels of an observation
+    std::vector<std::size_t> shape;
+    //! Offset of the slot from the start of the arena, in bytes
+    std::size_t offset = 0;
+    //! Size of one observation, in bytes
+    std::size_t frameSize = 0;
+  };
+
+  /**
+   * @brief Lay out a slot for every visual sensor of @p sensors and allocate
+   * the arena
+   * @param sensors     The sensors, e.g. @ref
+   *                    agent::Agent::getSubtreeSensors(). Sensors that aren't
+   *                    visual are ignored.
+   * @param batchSize   Number of observations in each slot
+   */
+  explicit ObservationArena(
+      const std::map<std::string, std::reference_wrapper<Sensor>>& sensors,
+      std::size_t batchSize = 1);
+
+  /**
+   * @brief Lay out a slot for every visual sensor of @p sensors in
+   * caller-provided memory
+   * @param sensors     The sensors, see above
+   * @param batchSize   Number of observations in each slot
+   * @param memory      At least @ref requiredSize() bytes, aligned to @ref
+   *                    Alignment. Must outlive the arena.
+   */
+  ObservationArena(
+      const std::map<std::string, std::reference_wrapper<Sensor>>& sensors,
+      std::size_t batchSize,
+      Corrade::Containers::ArrayView<char> memory);
+
+  /**
+   * @brief Size of the memory an arena for @p sensors needs, in bytes
+   */
+  static std::size_t requiredSize(
+      const std::map<std::string, std::reference_wrapper<Sensor>>& sensors,
+      std::size_t batchSize = 1);
+
+  std::size_t batchSize() const { return batchSize_; }
+
+  const std::vector<Slot>& slots() const { return slots_; }
+
+  /**
+   * @brief The memory of the arena
+   */
+  Corrade::Containers::ArrayView<char> data() const { return memory_; }
+
+  /**
+   * @brief Index of the slot of a sensor, or @ref ID_UNDEFINED if the arena
+   * has none
+   */
+  int getSlotIndex(const std::string& uuid) const;
+
+  /**
+   * @brief View on observation @p batchIndex of slot @p slotIndex
+   */
+  Magnum::MutableImageView2D getObservationView(int slotIndex,
+                                                std::size_t batchIndex);
+
+ private:
+  static std::size_t layout(
+      const std::map<std::string, std::reference_wrapper<Sensor>>& sensors,
+      std::size_t batchSize,
+      std::vector<Slot>& slots);
+
+  std::size_t batchSize_;
+  std::vector<Slot> slots_;
+  // empty if the memory is provided by the caller
+  Corrade::Containers::Array<char> allocation_;
+  Corrade::Containers::ArrayView<char> memory_;
+
+  ESP_SMART_POINTERS(ObservationArena)
+};
+
+}  // namespace sensor
+}  // namespace esp
+
+#endif  // ESP_SENSOR_OBSERVATIONARENA_H_
@@ -98,7 +98,7 @@ bool VisualSensor::getObservationSpace(ObservationSpace& space) {
   return true;
 }
 
-void VisualSensor::readObservation(Observation& obs) {
+void VisualSensor::allocateBuffer() {
   // Make sure we have memory
   if (buffer_ == nullptr) {
     // TODO: check if our sensor was resized and resize our buffer if needed
@@ -106,25 +106,72 @@ void VisualSensor::readObservation(Observation& obs) {
     getObservationSpace(space);
     buffer_ = core::Buffer::create(space.shape, space.dataType);
   }
+}
+
+Mn::PixelFormat VisualSensor::observationPixelFormat() const {
+  if (visualSensorSpec_->sensorType == SensorType::Semantic) {
+    return Mn::PixelFormat::R32UI;
+  }
+  if (visualSensorSpec_->sensorType == SensorType::Depth) {
+    return Mn::PixelFormat::R32F;
+  }
+  return Mn::PixelFormat::RGBA8Unorm;
+}
+
+void VisualSensor::readObservation(Observation& obs) {
+  allocateBuffer();
   obs.buffer = buffer_;
+  readFrame(Mn::MutableImageView2D{observationPixelFormat(),
+                                   renderTarget().framebufferSize(),
+                                   obs.buffer->data});
+}
 
+void VisualSensor::readObservationPipelined(Observation& obs) {
+  allocateBuffer();
+  obs.buffer = buffer_;
+  readFramePipelined(Mn::MutableImageView2D{observationPixelFormat(),
+                                            renderTarget().framebufferSize(),
+                                            obs.buffer->data});
+}
+
+void VisualSensor::readFrame(const Mn::MutableImageView2D& view) {
   // TODO: have different classes for the different types of sensors
   // TODO: do we need to flip axis?
   if (visualSensorSpec_->sensorType == SensorType::Semantic) {
-    renderTarget().readFrameObjectId(Magnum::MutableImageView2D{
-        Magnum::PixelFormat::R32UI, renderTarget().framebufferSize(),
-        obs.buffer->data});
+    renderTarget().readFrameObjectId(view);
   } else if (visualSensorSpec_->sensorType == SensorType::Depth) {
-    renderTarget().readFrameDepth(Magnum::MutableImageView2D{
-        Magnum::PixelFormat::R32F, renderTarget().framebufferSize(),
-        obs.buffer->data});
+    renderTarget().readFrameDepth(view);
   } else {
-    renderTarget().readFrameRgba(Magnum::MutableImageView2D{
-        Magnum::PixelFormat::RGBA8Unorm, renderTarget().framebufferSize(),
-        obs.buffer->data});
+    renderTarget().readFrameRgba(view);
   }
 }
 
+void VisualSensor::readFramePipelined(const Mn::MutableImageView2D& view) {
+#ifdef MAGNUM_TARGET_WEBGL
+  // pixel buffer objects can't be mapped on WebGL
+  readFrame(view);
+#else
+  // Keep exactly one read in flight: start reading back the frame that was
+  // just drawn and retrieve the one started by the previous call, which the
+  // GPU most likely finished transferring by now. On the first call there is
+  // none, so the current frame is read synchronously instead.
+  const bool hasPendingRead = renderTarget().numPendingReads() > 0;
+  if (!hasPendingRead) {
+    readFrame(view);
+  }
+  if (visualSensorSpec_->sensorType == SensorType::Semantic) {
+    renderTarget().readFrameObjectIdAsync(view.format());
+  } else if (visualSensorSpec_->sensorType == SensorType::Depth) {
+    renderTarget().readFrameDepthAsync();
+  } else {
+    renderTarget().readFrameRgbaAsync(view.format());
+  }
+  if (hasPendingRead) {
+    renderTarget().finishReadFrame(view);
+  }
+#endif
+}
+
 bool VisualSensor::getObservation(sim::Simulator& sim, Observation& obs) {
   // TODO: check if sensor is valid?
   // TODO: have different classes for the different types of sensors
@@ -133,11 +180,35 @@ bool VisualSensor::getObservation(sim::Simulator& sim, Observation& obs) {
     return false;
 
   drawObservation(sim);
-  readObservation(obs);
+  retrieveObservation(sim, obs);
 
   return true;
 }
 
+void VisualSensor::retrieveObservation(sim::Simulator& sim, Observation& obs) {
+  if (sim.isPipelinedObservationsEnabled()) {
+    readObservationPipelined(obs);
+  } else {
+#ifndef MAGNUM_TARGET_WEBGL
+    // a frame read back before pipelining was disabled is stale by now
+    renderTarget().discardPendingReads();
+#endif
+    readObservation(obs);
+  }
+}
+
+void VisualSensor::retrieveObservation(sim::Simulator& sim,
+                                       const Mn::MutableImageView2D& view) {
+  if (sim.isPipelinedObservationsEnabled()) {
+    readFramePipelined(view);
+  } else {
+#ifndef MAGNUM_TARGET_WEBGL
+    renderTarget().discardPendingReads();
+#endif
+    readFrame(view);
+  }
+}
+
 Cr::Containers::Optional<Mn::Vector2> VisualSensor::depthUnprojection() const {
   float f = visualSensorSpec_->far;
   float n = visualSensorSpec_->near;
@@ -128,10 +128,51 @@ class VisualSensor : public Sensor {
    */
   virtual void readObservation(Observation& obs);
 
+  /**
+   * @brief Start reading back the observation that was rendered by the
+   * simulator, and read the one rendered before it. The first time, reads the
+   * observation that was just rendered instead. On WebGL, which can't map
+   * pixel buffer objects, always reads the observation that was just rendered.
+   * @param[in,out] obs Instance of Observation class in which the previous
+   * observation will be stored
+   */
+  void readObservationPipelined(Observation& obs);
+
+  /**
+   * @brief Read the observation that was drawn, with @ref readObservation()
+   * or, if @ref sim::Simulator::isPipelinedObservationsEnabled(), with @ref
+   * readObservationPipelined()
+   * @param[in] sim Instance of Simulator class the observation was drawn with
+   * @param[in,out] obs Instance of Observation class in which the observation
+   * will be stored
+   */
+  void retrieveObservation(sim::Simulator& sim, Observation& obs);
+
+  /**
+   * @brief Like @ref retrieveObservation(sim::Simulator&, Observation&), but
+   * reads into caller-provided memory instead of the sensor's memory buffer
+   * @param[in] sim Instance of Simulator class the observation was drawn with
+   * @param[in,out] view Preallocated memory that will be populated with the
+   * observation. Its format must be @ref observationPixelFormat() and its size
+   * the framebuffer size.
+   */
+  void retrieveObservation(sim::Simulator& sim,
+                           const Mn::MutableImageView2D& view);
+
+  /**
+   * @brief The pixel format observations are read as, e.g. @ref
+   * Magnum::PixelFormat::R32F for depth
+   */
+  Mn::PixelFormat observationPixelFormat() const;
+
   /*
    * @brief Display next observation from Simulator on default frame buffer
    * @brief Draws an observation to the frame buffer using simulator's renderer,
    * then reads the observation to the sensor's memory buffer
+   *
+   * If @ref sim::Simulator::isPipelinedObservationsEnabled(), the observation
+   * is read back asynchronously and @p obs receives the observation drawn by
+   * the previous call instead, see @ref readObservationPipelined().
    * @return true if success, otherwise false (e.g., failed to draw or read
    * observation)
    * @param[in] sim Instance of Simulator class for which the observation needs
@@ -193,6 +234,22 @@ class VisualSensor : public Sensor {
   Mn::Deg getFOV() const { return hfov_; }
 
  protected:
+  /**
+   * @brief Allocate the sensor's memory buffer, if it isn't yet
+   */
+  void allocateBuffer();
+
+  /**
+   * @brief Read the observation that was rendered into @p view
+   */
+  void readFrame(const Mn::MutableImageView2D& view);
+
+  /**
+   * @brief Read the observation rendered before the one that was just
+   * rendered into @p view. See @ref readObservationPipelined().
+   */
+  void readFramePipelined(const Mn::MutableImageView2D& view);
+
   /** @brief field of view
    */
   Mn::Deg hfov_ = 90.0_degf;
@@ -4,16 +4,22 @@
 
 #include "Simulator.h"
 
+#include <algorithm>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <Corrade/Utility/Directory.h>
 #include <Corrade/Utility/String.h>
 #include <Magnum/EigenIntegration/GeometryIntegration.h>
 #include <Magnum/GL/Context.h>
 #include <Magnum/GL/Renderer.h>
+#include <Magnum/ImageView.h>
 
+#include "esp/core/Check.h"
 #include "esp/core/esp.h"
 #include "esp/gfx/Drawable.h"
 #include "esp/gfx/RenderCamera.h"
@@ -26,6 +32,7 @@
 #include "esp/scene/ObjectControls.h"
 #include "esp/scene/SemanticScene.h"
 #include "esp/sensor/CameraSensor.h"
+#include "esp/sensor/ObservationArena.h"
 #include "esp/sensor/SensorFactory.h"
 #include "esp/sensor/VisualSensor.h"
 
@@ -56,6 +63,7 @@ Simulator::~Simulator() {
 
 void Simulator::close() {
   pathfinder_ = nullptr;
+  navMeshInput_ = nullptr;
   navMeshVisPrimID_ = esp::ID_UNDEFINED;
   navMeshVisNode_ = nullptr;
   agents_.clear();
@@ -113,6 +121,7 @@ void Simulator::reconfigure(const SimulatorConfiguration& cfg) {
   // otherwise set current configuration and initialize
   // TODO can optimize to do partial re-initialization instead of from-scratch
   config_ = cfg;
+  pipelinedObservations_ = config_.pipelinedObservations;
 
   if (requiresTextures_ == Cr::Containers::NullOpt) {
     requiresTextures_ = config_.requiresTextures;
@@ -184,6 +193,7 @@ Simulator::setSceneInstanceAttributes(const std::string& activeSceneName) {
   // Get name of navmesh and use to create pathfinder and load navmesh
   // create pathfinder and load navmesh if available
   pathfinder_ = nav::PathFinder::create();
+  navMeshInput_ = nullptr;
   if (FileUtil::exists(navmeshFileLoc)) {
     LOG(INFO) << "Simulator::setSceneInstanceAttributes : Loading navmesh from "
               << navmeshFileLoc;
@@ -886,6 +896,52 @@ Magnum::Vector3 Simulator::getGravity(const int sceneID) const {
   return Magnum::Vector3();
 }
 
+Simulator::NavMeshObjectInput Simulator::createNavMeshObjectInput(
+    const int objectID) {
+  NavMeshObjectInput input;
+  input.transformation = physicsManager_->getObjectVisualSceneNode(objectID)
+                             .absoluteTransformationMatrix();
+  auto objectTransform = Magnum::EigenIntegration::cast<
+      Eigen::Transform<float, 3, Eigen::Affine> >(input.transformation);
+  const metadata::attributes::ObjectAttributes::cptr initializationTemplate =
+      physicsManager_->getObjectInitAttributes(objectID);
+  objectTransform.scale(Magnum::EigenIntegration::cast<vec3f>(
+      initializationTemplate->getScale()));
+  input.meshHandle = initializationTemplate->getCollisionAssetHandle();
+  if (input.meshHandle.empty()) {
+    input.meshHandle = initializationTemplate->getRenderAssetHandle();
+  }
+
+  input.mesh = resourceManager_->createJoinedCollisionMesh(input.meshHandle);
+  const float mf = std::numeric_limits<float>::max();
+  input.aabb = std::make_pair(vec3f(mf, mf, mf), vec3f(-mf, -mf, -mf));
+  for (auto& vert : input.mesh->vbo) {
+    vert = objectTransform * vert;
+    input.aabb.first = input.aabb.first.cwiseMin(vert);
+    input.aabb.second = input.aabb.second.cwiseMax(vert);
+  }
+  return input;
+}
+
+assets::MeshData::uptr Simulator::joinNavMeshInput(
+    const NavMeshInput& input) const {
+  assets::MeshData::uptr joinedMesh = assets::MeshData::create_unique();
+  joinedMesh->vbo = input.stageMesh->vbo;
+  joinedMesh->ibo = input.stageMesh->ibo;
+  for (const auto& entry : input.objects) {
+    const assets::MeshData& objectMesh = *entry.second.mesh;
+    int prevNumIndices = joinedMesh->ibo.size();
+    int prevNumVerts = joinedMesh->vbo.size();
+    joinedMesh->ibo.resize(prevNumIndices + objectMesh.ibo.size());
+    for (size_t ix = 0; ix < objectMesh.ibo.size(); ++ix) {
+      joinedMesh->ibo[ix + prevNumIndices] = objectMesh.ibo[ix] + prevNumVerts;
+    }
+    joinedMesh->vbo.insert(joinedMesh->vbo.end(), objectMesh.vbo.begin(),
+                           objectMesh.vbo.end());
+  }
+  return joinedMesh;
+}
+
 bool Simulator::recomputeNavMesh(nav::PathFinder& pathfinder,
                                  const nav::NavMeshSettings& navMeshSettings,
                                  bool includeStaticObjects) {
@@ -897,10 +953,14 @@ bool Simulator::recomputeNavMesh(nav::PathFinder& pathfinder,
                  "loaded without renderer initialization.",
                  false);
 
-  assets::MeshData::uptr joinedMesh = assets::MeshData::create_unique();
+  auto input = std::make_unique<NavMeshInput>();
+  input->pathfinder = &pathfinder;
+  input->settings = navMeshSettings;
+  input->includeStaticObjects = includeStaticObjects;
+  input->stageMesh = assets::MeshData::create_unique();
   auto stageInitAttrs = physicsManager_->getStageInitAttributes();
   if (stageInitAttrs != nullptr) {
-    joinedMesh = resourceManager_->createJoinedCollisionMesh(
+    input->stageMesh = resourceManager_->createJoinedCollisionMesh(
         stageInitAttrs->getRenderAssetHandle());
   }
 
@@ -909,41 +969,18 @@ bool Simulator::recomputeNavMesh(nav::PathFinder& pathfinder,
     for (auto objectID : physicsManager_->getExistingObjectIDs()) {
       if (physicsManager_->getObjectMotionType(objectID) ==
           physics::MotionType::STATIC) {
-        auto objectTransform = Magnum::EigenIntegration::cast<
-            Eigen::Transform<float, 3, Eigen::Affine> >(
-            physicsManager_->getObjectVisualSceneNode(objectID)
-                .absoluteTransformationMatrix());
-        const metadata::attributes::ObjectAttributes::cptr
-            initializationTemplate =
-                physicsManager_->getObjectInitAttributes(objectID);
-        objectTransform.scale(Magnum::EigenIntegration::cast<vec3f>(
-            initializationTemplate->getScale()));
-        std::string meshHandle =
-            initializationTemplate->getCollisionAssetHandle();
-        if (meshHandle.empty()) {
-          meshHandle = initializationTemplate->getRenderAssetHandle();
-        }
-        assets::MeshData::uptr joinedObjectMesh =
-            resourceManager_->createJoinedCollisionMesh(meshHandle);
-        int prevNumIndices = joinedMesh->ibo.size();
-        int prevNumVerts = joinedMesh->vbo.size();
-        joinedMesh->ibo.resize(prevNumIndices + joinedObjectMesh->ibo.size());
-        for (size_t ix = 0; ix < joinedObjectMesh->ibo.size(); ++ix) {
-          joinedMesh->ibo[ix + prevNumIndices] =
-              joinedObjectMesh->ibo[ix] + prevNumVerts;
-        }
-        joinedMesh->vbo.reserve(joinedObjectMesh->vbo.size() + prevNumVerts);
-        for (auto& vert : joinedObjectMesh->vbo) {
-          joinedMesh->vbo.push_back(objectTransform * vert);
-        }
+        input->objects.emplace(objectID, createNavMeshObjectInput(objectID));
       }
     }
   }
 
+  assets::MeshData::uptr joinedMesh = joinNavMeshInput(*input);
   if (!pathfinder.build(navMeshSettings, *joinedMesh)) {
     LOG(ERROR) << "Failed to build navmesh";
+    navMeshInput_ = nullptr;
     return false;
   }
+  navMeshInput_ = std::move(input);
 
   if (&pathfinder == pathfinder_.get()) {
     if (isNavMeshVisualizationActive()) {
@@ -957,6 +994,88 @@ bool Simulator::recomputeNavMesh(nav::PathFinder& pathfinder,
   return true;
 }
 
+bool Simulator::updateNavMesh(nav::PathFinder& pathfinder) {
+  if (navMeshInput_ == nullptr) {
+    LOG(ERROR) << "Simulator::updateNavMesh : no navmesh was computed yet, "
+                  "call recomputeNavMesh first";
+    return false;
+  }
+  if (navMeshInput_->pathfinder != &pathfinder ||
+      !navMeshInput_->includeStaticObjects ||
+      navMeshInput_->settings.tileSize <= 0) {
+    // copy, as recomputeNavMesh replaces navMeshInput_
+    const nav::NavMeshSettings settings = navMeshInput_->settings;
+    return recomputeNavMesh(pathfinder, settings,
+                            navMeshInput_->includeStaticObjects);
+  }
+
+  // Reuse the input of all objects which are still there and didn't move,
+  // collect the bounds of everything else
+  std::vector<std::pair<vec3f, vec3f>> changedRegions;
+  std::map<int, NavMeshObjectInput> objects;
+  std::map<int, NavMeshObjectInput>& prevObjects = navMeshInput_->objects;
+  for (auto objectID : physicsManager_->getExistingObjectIDs()) {
+    if (physicsManager_->getObjectMotionType(objectID) !=
+        physics::MotionType::STATIC) {
+      continue;
+    }
+
+    auto prev = prevObjects.find(objectID);
+    if (prev != prevObjects.end()) {
+      const metadata::attributes::ObjectAttributes::cptr
+          initializationTemplate =
+              physicsManager_->getObjectInitAttributes(objectID);
+      std::string meshHandle =
+          initializationTemplate->getCollisionAssetHandle();
+      if (meshHandle.empty()) {
+        meshHandle = initializationTemplate->getRenderAssetHandle();
+      }
+      if (prev->second.meshHandle == meshHandle &&
+          prev->second.transformation ==
+              physicsManager_->getObjectVisualSceneNode(objectID)
+                  .absoluteTransformationMatrix()) {
+        objects.emplace(objectID, std::move(prev->second));
+        prevObjects.erase(prev);
+        continue;
+      }
+      changedRegions.push_back(prev->second.aabb);
+      prevObjects.erase(prev);
+    }
+
+    NavMeshObjectInput objectInput = createNavMeshObjectInput(objectID);
+    changedRegions.push_back(objectInput.aabb);
+    objects.emplace(objectID, std::move(objectInput));
+  }
+  // Whatever is left was removed or isn't STATIC anymore
+  for (const auto& entry : prevObjects) {
+    changedRegions.push_back(entry.second.aabb);
+  }
+  navMeshInput_->objects = std::move(objects);
+
+  if (changedRegions.empty()) {
+    return true;
+  }
+
+  assets::MeshData::uptr joinedMesh = joinNavMeshInput(*navMeshInput_);
+  if (!pathfinder.rebuildTiles(*joinedMesh, changedRegions)) {
+    LOG(ERROR) << "Failed to update navmesh";
+    navMeshInput_ = nullptr;
+    return false;
+  }
+
+  if (&pathfinder == pathfinder_.get()) {
+    if (isNavMeshVisualizationActive()) {
+      // if updating pathfinder_ instance, refresh the visualization.
+      setNavMeshVisualization(false);  // first clear the old instance
+      setNavMeshVisualization(true);
+    }
+  }
+
+  LOG(INFO) << "Simulator::updateNavMesh : rebuilt navmesh around "
+            << changedRegions.size() << " changed objects";
+  return true;
+}
+
 bool Simulator::setNavMeshVisualization(bool visualize) {
   // clean-up the NavMesh visualization if necessary
   if (!visualize && navMeshVisNode_ != nullptr) {
@@ -1253,9 +1372,32 @@ int Simulator::getAgentObservations(
   observations.clear();
   agent::Agent::ptr ag = getAgent(agentId);
   if (ag != nullptr) {
+    // draw the visual sensors together, so that co-located ones share a pass
+    std::vector<std::reference_wrapper<sensor::VisualSensor>> visualSensors;
+    if (renderer_) {
+      for (auto& s : ag->getSubtreeSensors()) {
+        if (s.second.get().isVisualSensor()) {
+          auto& visualSensor =
+              static_cast<sensor::VisualSensor&>(s.second.get());
+          if (visualSensor.hasRenderTarget()) {
+            visualSensors.emplace_back(visualSensor);
+          }
+        }
+      }
+      renderer_->draw(visualSensors, *this);
+    }
+
     for (auto& s : ag->getSubtreeSensors()) {
       sensor::Observation obs;
-      if (s.second.get().getObservation(*this, obs)) {
+      auto isDrawn = [&](const sensor::VisualSensor& visualSensor) {
+        return &visualSensor == &s.second.get();
+      };
+      auto drawnSensor =
+          std::find_if(visualSensors.begin(), visualSensors.end(), isDrawn);
+      if (drawnSensor != visualSensors.end()) {
+        drawnSensor->get().retrieveObservation(*this, obs);
+        observations[s.first] = obs;
+      } else if (s.second.get().getObservation(*this, obs)) {
         observations[s.first] = obs;
       }
     }
@@ -1263,6 +1405,75 @@ int Simulator::getAgentObservations(
   return observations.size();
 }
 
+int Simulator::getSensorObservations(scene::SceneNode& node,
+                                     sensor::ObservationArena& arena,
+                                     const std::size_t batchIndex) {
+  ESP_CHECK(batchIndex < arena.batchSize(),
+            "Simulator::getSensorObservations(): batch index"
+                << batchIndex << "out of range for an arena of batch size"
+                << arena.batchSize());
+  drawArenaSensors(node, arena);
+  return readArenaSensors(arena, batchIndex);
+}
+
+int Simulator::getAgentObservations(const int agentId,
+                                    sensor::ObservationArena& arena,
+                                    const std::size_t batchIndex) {
+  return getSensorObservations(getAgent(agentId)->node(), arena, batchIndex);
+}
+
+int Simulator::getBatchedSensorObservations(
+    const std::vector<std::reference_wrapper<Simulator>>& simulators,
+    const std::vector<std::reference_wrapper<scene::SceneNode>>& nodes,
+    sensor::ObservationArena& arena) {
+  ESP_CHECK(simulators.size() == nodes.size() &&
+                simulators.size() <= arena.batchSize(),
+            "Simulator::getBatchedSensorObservations(): expected as many"
+                << "nodes as simulators and at most" << arena.batchSize()
+                << "of each but got" << simulators.size() << "and"
+                << nodes.size());
+  for (std::size_t i = 0; i < simulators.size(); ++i) {
+    simulators[i].get().drawArenaSensors(nodes[i], arena);
+  }
+  int numObservations = 0;
+  for (std::size_t i = 0; i < simulators.size(); ++i) {
+    numObservations += simulators[i].get().readArenaSensors(arena, i);
+  }
+  return numObservations;
+}
+
+void Simulator::drawArenaSensors(scene::SceneNode& node,
+                                 const sensor::ObservationArena& arena) {
+  arenaSensors_.clear();
+  const auto& sensors = node.getSubtreeSensors();
+  for (const sensor::ObservationArena::Slot& slot : arena.slots()) {
+    auto found = sensors.find(slot.uuid);
+    ESP_CHECK(found != sensors.end() && found->second.get().isVisualSensor(),
+              "Simulator::drawArenaSensors(): the node has no visual sensor"
+                  << slot.uuid);
+    auto& visualSensor =
+        static_cast<sensor::VisualSensor&>(found->second.get());
+    ESP_CHECK(visualSensor.hasRenderTarget(),
+              "Simulator::drawArenaSensors(): sensor"
+                  << slot.uuid << "has no render target");
+    ESP_CHECK(visualSensor.observationPixelFormat() == slot.format &&
+                  visualSensor.framebufferSize() == slot.size,
+              "Simulator::drawArenaSensors(): the slot of sensor"
+                  << slot.uuid << "doesn't match its observations");
+    arenaSensors_.emplace_back(visualSensor);
+  }
+  renderer_->draw(arenaSensors_, *this);
+}
+
+int Simulator::readArenaSensors(sensor::ObservationArena& arena,
+                                const std::size_t batchIndex) {
+  for (std::size_t i = 0; i < arenaSensors_.size(); ++i) {
+    arenaSensors_[i].get().retrieveObservation(
+        *this, arena.getObservationView(i, batchIndex));
+  }
+  return arenaSensors_.size();
+}
+
 bool Simulator::getAgentObservationSpace(const int agentId,
                                          const std::string& sensorId,
                                          sensor::ObservationSpace& space) {
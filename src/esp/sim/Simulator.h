@@ -7,7 +7,9 @@
 
 #include <Corrade/Utility/Assert.h>
 
+#include <functional>
 #include <utility>
+#include <vector>
 #include "esp/agent/Agent.h"
 #include "esp/assets/ResourceManager.h"
 #include "esp/core/esp.h"
@@ -34,6 +36,10 @@ class ActionSpacePathFinder;
 namespace scene {
 class SemanticScene;
 }  // namespace scene
+namespace sensor {
+class ObservationArena;
+class VisualSensor;
+}  // namespace sensor
 namespace gfx {
 class Renderer;
 namespace replay {
@@ -718,6 +724,21 @@ class Simulator {
                         const nav::NavMeshSettings& navMeshSettings,
                         bool includeStaticObjects = false);
 
+  /**
+   * @brief Update the navmesh last computed by @ref recomputeNavMesh after
+   * STATIC objects were added, removed or moved.
+   *
+   * Only the navmesh tiles overlapping the old and new bounds of the changed
+   * objects are rebuilt, the input geometry of all other objects is reused
+   * from the last computation. Falls back to a full @ref recomputeNavMesh with
+   * the last settings if those were for another pathfinder, didn't include
+   * static objects or didn't use tiles (see @ref
+   * nav::NavMeshSettings::tileSize).
+   * @param pathfinder The pathfinder object whose navmesh is updated.
+   * @return Whether or not the navmesh update succeeded.
+   */
+  bool updateNavMesh(nav::PathFinder& pathfinder);
+
   /**
    * @brief Set visualization of the current NavMesh @ref pathfinder_ on or off.
    *
@@ -908,6 +929,42 @@ class Simulator {
       int agentId,
       std::map<std::string, sensor::Observation>& observations);
 
+  /**
+   * @brief Draw the visual sensors in the subtree of a node, e.g. of an
+   * agent, and read their observations into an arena, without allocating
+   * @param node       The node
+   * @param arena      Arena laid out for the sensors of @p node, see @ref
+   *                   sensor::ObservationArena
+   * @param batchIndex Observation of each slot of @p arena to read into
+   * @return The number of observations read
+   */
+  int getSensorObservations(scene::SceneNode& node,
+                            sensor::ObservationArena& arena,
+                            std::size_t batchIndex = 0);
+
+  /**
+   * @brief Like @ref getSensorObservations(), for the sensors of an agent
+   */
+  int getAgentObservations(int agentId,
+                           sensor::ObservationArena& arena,
+                           std::size_t batchIndex = 0);
+
+  /**
+   * @brief Draw the visual sensors in the subtree of a node in each of
+   * @p simulators and read their observations into an arena
+   *
+   * Observation i of each slot of @p arena comes from node i of simulator i,
+   * so the batch size of @p arena must be at least the number of simulators;
+   * observations past the last simulator are left as they are. All
+   * simulators are drawn before the first observation is read, so the GPU
+   * renders without waiting for the reads in between.
+   * @return The number of observations read
+   */
+  static int getBatchedSensorObservations(
+      const std::vector<std::reference_wrapper<Simulator>>& simulators,
+      const std::vector<std::reference_wrapper<scene::SceneNode>>& nodes,
+      sensor::ObservationArena& arena);
+
   bool getAgentObservationSpace(int agentId,
                                 const std::string& sensorId,
                                 sensor::ObservationSpace& space);
@@ -930,6 +987,23 @@ class Simulator {
    */
   bool isFrustumCullingEnabled() const { return frustumCulling_; }
 
+  /**
+   * @brief Enable or disable pipelined observations (disabled by default).
+   * See @ref SimulatorConfiguration::pipelinedObservations.
+   * @param val true = enable, false = disable
+   */
+  void setPipelinedObservationsEnabled(bool val) {
+    pipelinedObservations_ = val;
+  }
+
+  /**
+   * @brief Get status, whether pipelined observations are enabled or not
+   * @return true if enabled, otherwise false
+   */
+  bool isPipelinedObservationsEnabled() const {
+    return pipelinedObservations_;
+  }
+
   /**
    * @brief Get a copy of an existing @ref gfx::LightSetup by its key.
    *
@@ -1034,6 +1108,19 @@ class Simulator {
    */
   bool createSceneInstance(const std::string& activeSceneName);
 
+  /**
+   * @brief Draw the sensors in the subtree of @p node that have a slot in
+   * @p arena
+   */
+  void drawArenaSensors(scene::SceneNode& node,
+                        const sensor::ObservationArena& arena);
+
+  /**
+   * @brief Read the observations drawn by @ref drawArenaSensors() into
+   * observation @p batchIndex of each slot of @p arena
+   */
+  int readArenaSensors(sensor::ObservationArena& arena, std::size_t batchIndex);
+
   /**
    * @brief Builds a scene instance based on @ref
    * esp::metadata::attributes::SceneAttributes referenced by @p activeSceneName
@@ -1078,6 +1165,37 @@ class Simulator {
 
   void reconfigureReplayManager(bool enableGfxReplaySave);
 
+  //! Input geometry of a STATIC object as used for the navmesh
+  struct NavMeshObjectInput {
+    Magnum::Matrix4 transformation;
+    std::string meshHandle;
+    //! Collision mesh transformed to world space
+    assets::MeshData::uptr mesh;
+    std::pair<vec3f, vec3f> aabb;
+  };
+
+  //! Everything the last @ref recomputeNavMesh was computed from, so that
+  //! @ref updateNavMesh can find what changed
+  struct NavMeshInput {
+    //! Only compared against, never dereferenced
+    const nav::PathFinder* pathfinder = nullptr;
+    nav::NavMeshSettings settings;
+    bool includeStaticObjects = false;
+    assets::MeshData::uptr stageMesh;
+    std::map<int, NavMeshObjectInput> objects;
+  };
+
+  /**
+   * @brief Gather the world space collision geometry of a STATIC object for
+   * navmesh computation.
+   */
+  NavMeshObjectInput createNavMeshObjectInput(int objectID);
+
+  /**
+   * @brief Join the stage and all object meshes of the navmesh input.
+   */
+  assets::MeshData::uptr joinNavMeshInput(const NavMeshInput& input) const;
+
   gfx::WindowlessContext::uptr context_ = nullptr;
   std::shared_ptr<gfx::Renderer> renderer_ = nullptr;
   // CANNOT make the specification of resourceManager_ above the context_!
@@ -1121,6 +1239,17 @@ class Simulator {
   // rquires it when drawing the observation
   bool frustumCulling_ = true;
 
+  // state indicating visual sensor observations are read back asynchronously,
+  // one frame late
+  bool pipelinedObservations_ = false;
+
+  // sensors of the slots of the last arena drawn, kept to avoid allocating on
+  // every draw
+  std::vector<std::reference_wrapper<sensor::VisualSensor>> arenaSensors_;
+
+  //! Input of the last navmesh computation, see @ref updateNavMesh
+  std::unique_ptr<NavMeshInput> navMeshInput_ = nullptr;
+
   //! NavMesh visualization variables
   int navMeshVisPrimID_ = esp::ID_UNDEFINED;
   esp::scene::SceneNode* navMeshVisNode_ = nullptr;
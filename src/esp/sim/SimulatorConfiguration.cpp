@@ -16,6 +16,7 @@ bool operator==(const SimulatorConfiguration& a,
          a.createRenderer == b.createRenderer &&
          a.allowSliding == b.allowSliding &&
          a.frustumCulling == b.frustumCulling &&
+         a.pipelinedObservations == b.pipelinedObservations &&
          a.enablePhysics == b.enablePhysics &&
          a.enableGfxReplaySave == b.enableGfxReplaySave &&
          a.loadSemanticMesh == b.loadSemanticMesh &&
@@ -28,6 +28,14 @@ struct SimulatorConfiguration {
   bool allowSliding = true;
   // enable or disable the frustum culling
   bool frustumCulling = true;
+  /**
+   * @brief Whether visual sensor observations are pipelined. If set, an
+   * observation is read back asynchronously and returned by the next request
+   * for the same sensor, so each observation lags one frame behind (the
+   * "previous frame" contract). Only the very first observation of a sensor is
+   * read synchronously. See @ref sensor::VisualSensor::getObservation().
+   */
+  bool pipelinedObservations = false;
   /**
    * @brief This flags specifies whether or not dynamics is supported by the
    * simulation, if a suitable library (i.e. Bullet) has been installed.
@@ -7,14 +7,18 @@
 #include <Corrade/TestSuite/Tester.h>
 #include <Corrade/Utility/Directory.h>
 #include <Magnum/EigenIntegration/Integration.h>
+#include <Magnum/GL/Mesh.h>
 #include <Magnum/GL/SampleQuery.h>
 #include <Magnum/Math/Frustum.h>
 #include <Magnum/Math/Intersection.h>
 #include <Magnum/Math/Range.h>
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <string>
 
 #include "esp/assets/ResourceManager.h"
+#include "esp/gfx/Drawable.h"
+#include "esp/gfx/DrawableGroup.h"
 #include "esp/gfx/RenderCamera.h"
 #include "esp/gfx/RenderTarget.h"
 #include "esp/gfx/WindowlessContext.h"
@@ -34,26 +38,56 @@ namespace Test {
 // on GCC and Clang, the following namespace causes useful warnings to be
 // printed when you have accidentally unused variables or functions in the test
 namespace {
+
+// A drawable that is never drawn, so culling can be tested without a GL
+// context
+class CullingTestDrawable : public esp::gfx::Drawable {
+ public:
+  CullingTestDrawable(esp::scene::SceneNode& node,
+                      Mn::GL::Mesh& mesh,
+                      esp::gfx::DrawableGroup& group)
+      : esp::gfx::Drawable{node, mesh, &group} {}
+
+ protected:
+  void draw(const Mn::Matrix4&, Mn::SceneGraph::Camera3D&) override {}
+};
+
 struct CullingTest : Cr::TestSuite::Tester {
   explicit CullingTest();
 
   // init, returns ref to scene graph
   int setupTests();
 
+  // init a large scene of static and dynamic boxes without a GL context,
+  // returns the scene graph id
+  int setupLargeScene(std::vector<esp::scene::SceneNode*>& dynamicNodes);
+
   // tests
   void computeAbsoluteAABB();
   void frustumCulling();
+  void bvhCulling();
+
+  // benchmarks
+  void cullLinear();
+  void cullBVH();
 
  protected:
+  // drawn by no drawable
+  Mn::GL::Mesh mesh_{Mn::NoCreate};
   esp::gfx::WindowlessContext::uptr context_ = nullptr;
   std::unique_ptr<ResourceManager> resourceManager_ = nullptr;
   SceneManager::uptr sceneManager_ = nullptr;
+  // the batch size when running benchmarks
+  const unsigned int iterations_ = 10;
 };
 
 CullingTest::CullingTest() {
   // clang-format off
   addTests({&CullingTest::computeAbsoluteAABB,
-            &CullingTest::frustumCulling});
+            &CullingTest::frustumCulling,
+            &CullingTest::bvhCulling});
+  addBenchmarks({&CullingTest::cullLinear,
+                 &CullingTest::cullBVH}, 10);
   // clang-format on
 }
 
@@ -85,6 +119,43 @@ int CullingTest::setupTests() {
   return sceneID;
 }
 
+int CullingTest::setupLargeScene(
+    std::vector<esp::scene::SceneNode*>& dynamicNodes) {
+  if (!sceneManager_) {
+    sceneManager_ = SceneManager::create_unique();
+  }
+  int sceneID = sceneManager_->initSceneGraph();
+  auto& sceneGraph = sceneManager_->getSceneGraph(sceneID);
+  auto& rootNode = sceneGraph.getRootNode();
+  auto& drawables = sceneGraph.getDrawables();
+
+  // a 128 x 128 grid of unit boxes with static AABBs, like the sub-meshes of
+  // a large stage
+  const Mn::Range3D box{Mn::Vector3{-0.5f}, Mn::Vector3{0.5f}};
+  for (int i = 0; i < 128; ++i) {
+    for (int j = 0; j < 128; ++j) {
+      auto& node = rootNode.createChild();
+      const Mn::Vector3 translation{2.0f * i, 0.0f, 2.0f * j};
+      node.setTranslation(translation);
+      node.setAbsoluteAABB(
+          {box.min() + translation, box.max() + translation});
+      new CullingTestDrawable{node, mesh_, drawables};
+    }
+  }
+
+  // dynamic boxes, whose AABBs follow their nodes
+  dynamicNodes.clear();
+  for (int i = 0; i < 64; ++i) {
+    auto& node = rootNode.createChild();
+    node.setMeshBB(box);
+    node.computeCumulativeBB();
+    node.setTranslation({4.0f * i, 2.0f, 128.0f});
+    new CullingTestDrawable{node, mesh_, drawables};
+    dynamicNodes.push_back(&node);
+  }
+  return sceneID;
+}
+
 void CullingTest::computeAbsoluteAABB() {
   int sceneID = setupTests();
   auto& sceneGraph = sceneManager_->getSceneGraph(sceneID);
@@ -271,6 +342,104 @@ void CullingTest::frustumCulling() {
   target->renderExit();
   CORRADE_COMPARE(numVisibleObjects, numVisibleObjectsGroundTruth);
 }
+void CullingTest::bvhCulling() {
+  std::vector<esp::scene::SceneNode*> dynamicNodes;
+  int sceneID = setupLargeScene(dynamicNodes);
+  auto& sceneGraph = sceneManager_->getSceneGraph(sceneID);
+  auto& drawables = sceneGraph.getDrawables();
+
+  auto& cameraNode = sceneGraph.getRootNode().createChild();
+  esp::gfx::RenderCamera& renderCamera =
+      *(new esp::gfx::RenderCamera(cameraNode));
+  renderCamera.setProjectionMatrix(640, 480, 0.01f, 100.0f, 90.0_degf);
+  cameraNode.setTranslation({128.0f, 1.0f, 128.0f});
+
+  std::vector<std::reference_wrapper<Mn::SceneGraph::Drawable3D>>
+      visibleDrawables;
+  // compare the BVH against culling every drawable, while the camera turns
+  // and dynamic boxes move or get deleted
+  for (int iStep = 0; iStep < 8; ++iStep) {
+    CORRADE_ITERATION(iStep);
+    cameraNode.rotateY(45.0_degf);
+    for (size_t i = iStep % 2; i < dynamicNodes.size(); i += 2) {
+      dynamicNodes[i]->translate({0.0f, 0.0f, -16.0f});
+    }
+    if (iStep == 4) {
+      delete dynamicNodes.back();
+      dynamicNodes.pop_back();
+    }
+
+    auto drawableTransforms = renderCamera.drawableTransformations(drawables);
+    const size_t numVisibles = renderCamera.cull(drawableTransforms);
+    std::vector<const Mn::SceneGraph::Drawable3D*> expected;
+    for (size_t i = 0; i < numVisibles; ++i) {
+      expected.push_back(&drawableTransforms[i].first.get());
+    }
+
+    drawables.cull(Mn::Frustum::fromMatrix(renderCamera.projectionMatrix() *
+                                           renderCamera.cameraMatrix()),
+                   visibleDrawables);
+    std::vector<const Mn::SceneGraph::Drawable3D*> actual;
+    for (const auto& drawable : visibleDrawables) {
+      actual.push_back(&drawable.get());
+    }
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    CORRADE_VERIFY(numVisibles > 0);
+    CORRADE_VERIFY(numVisibles < drawables.size());
+    CORRADE_COMPARE(actual.size(), expected.size());
+    CORRADE_VERIFY(actual == expected);
+  }
+}
+
+void CullingTest::cullLinear() {
+  std::vector<esp::scene::SceneNode*> dynamicNodes;
+  int sceneID = setupLargeScene(dynamicNodes);
+  auto& sceneGraph = sceneManager_->getSceneGraph(sceneID);
+  auto& drawables = sceneGraph.getDrawables();
+
+  auto& cameraNode = sceneGraph.getRootNode().createChild();
+  esp::gfx::RenderCamera& renderCamera =
+      *(new esp::gfx::RenderCamera(cameraNode));
+  renderCamera.setProjectionMatrix(640, 480, 0.01f, 100.0f, 90.0_degf);
+  cameraNode.setTranslation({128.0f, 1.0f, 128.0f});
+
+  size_t numVisibles = 0;
+  CORRADE_BENCHMARK(iterations_) {
+    auto drawableTransforms = renderCamera.drawableTransformations(drawables);
+    numVisibles += renderCamera.cull(drawableTransforms);
+  }
+  CORRADE_VERIFY(numVisibles > 0);
+}
+
+void CullingTest::cullBVH() {
+  std::vector<esp::scene::SceneNode*> dynamicNodes;
+  int sceneID = setupLargeScene(dynamicNodes);
+  auto& sceneGraph = sceneManager_->getSceneGraph(sceneID);
+  auto& drawables = sceneGraph.getDrawables();
+
+  auto& cameraNode = sceneGraph.getRootNode().createChild();
+  esp::gfx::RenderCamera& renderCamera =
+      *(new esp::gfx::RenderCamera(cameraNode));
+  renderCamera.setProjectionMatrix(640, 480, 0.01f, 100.0f, 90.0_degf);
+  cameraNode.setTranslation({128.0f, 1.0f, 128.0f});
+  const Mn::Frustum frustum = Mn::Frustum::fromMatrix(
+      renderCamera.projectionMatrix() * renderCamera.cameraMatrix());
+
+  std::vector<std::reference_wrapper<Mn::SceneGraph::Drawable3D>>
+      visibleDrawables;
+  // build the BVH outside of the benchmark
+  drawables.cull(frustum, visibleDrawables);
+
+  size_t numVisibles = 0;
+  CORRADE_BENCHMARK(iterations_) {
+    drawables.cull(frustum, visibleDrawables);
+    numVisibles +=
+        renderCamera.drawableTransformations(visibleDrawables).size();
+  }
+  CORRADE_VERIFY(numVisibles > 0);
+}
 }  // namespace
 }  // namespace Test
 
@@ -2,15 +2,23 @@
 // This source code is licensed under the MIT license found in the
 // LICENSE file in the root directory of this source tree.
 
+#include <Corrade/Containers/StridedArrayView.h>
+#include <Corrade/TestSuite/Compare/Container.h>
 #include <Corrade/TestSuite/Tester.h>
 #include <Corrade/Utility/Directory.h>
+#include <Magnum/GL/Framebuffer.h>
 #include <Magnum/GL/Mesh.h>
+#include <Magnum/GL/Renderbuffer.h>
+#include <Magnum/GL/RenderbufferFormat.h>
+#include <Magnum/Image.h>
+#include <Magnum/PixelFormat.h>
 #include <Magnum/MeshTools/Compile.h>
 #include <Magnum/Primitives/Cube.h>
 #include <Magnum/Shaders/FlatGL.h>
 #include <Magnum/Trade/MeshData.h>
 #include "esp/assets/ResourceManager.h"
 #include "esp/gfx/GenericDrawable.h"
+#include "esp/gfx/RenderCamera.h"
 #include "esp/gfx/RenderTarget.h"
 #include "esp/gfx/WindowlessContext.h"
 #include "esp/scene/SceneManager.h"
@@ -23,6 +31,7 @@ namespace Mn = Magnum;
 using esp::assets::ResourceManager;
 using esp::metadata::MetadataMediator;
 using esp::scene::SceneManager;
+using Magnum::Math::Literals::operator""_degf;
 
 namespace Test {
 // on GCC and Clang, the following namespace causes useful warnings to be
@@ -41,6 +50,8 @@ struct DrawableTest : Cr::TestSuite::Tester {
   explicit DrawableTest();
   // tests
   void addRemoveDrawables();
+  void sortedDraw();
+  void instancedDraw();
 
  protected:
   esp::gfx::WindowlessContext::uptr context_ =
@@ -58,7 +69,8 @@ DrawableTest::DrawableTest() {
   auto MM = MetadataMediator::create(cfg);
   resourceManager_ = std::make_unique<ResourceManagerExtended>(MM);
   //clang-format off
-  addTests({&DrawableTest::addRemoveDrawables});
+  addTests({&DrawableTest::addRemoveDrawables,
+            &DrawableTest::sortedDraw, &DrawableTest::instancedDraw});
   // flang-format on
   auto stageAttributesMgr = MM->getStageAttributesManager();
   std::string stageFile =
@@ -150,6 +162,125 @@ void DrawableTest::addRemoveDrawables() {
   CORRADE_VERIFY(!drawableGroup_->hasDrawable(dr->getDrawableId()));
 }
 
+void DrawableTest::sortedDraw() {
+  Mn::GL::Mesh box = Mn::MeshTools::compile(Mn::Primitives::cubeSolid());
+  const int sceneID = sceneManager_.initSceneGraph();
+  auto& sceneGraph = sceneManager_.getSceneGraph(sceneID);
+  esp::gfx::DrawableGroup& group = sceneGraph.getDrawables();
+  esp::scene::SceneNode& rootNode = sceneGraph.getRootNode();
+  esp::gfx::Drawable::Flags meshAttributeFlags{};
+
+  // the default and white materials share a shader, the per-vertex object id
+  // material needs another one
+  const char* materials[]{esp::DEFAULT_MATERIAL_KEY, esp::WHITE_MATERIAL_KEY,
+                          esp::PER_VERTEX_OBJECT_ID_MATERIAL_KEY};
+  for (int i = 0; i < 12; ++i) {
+    esp::scene::SceneNode& node = rootNode.createChild();
+    node.translate({0.0f, 0.0f, -2.0f * i - 5.0f});
+    node.addFeature<esp::gfx::GenericDrawable>(
+        box, meshAttributeFlags, resourceManager_->getShaderManager(),
+        esp::NO_LIGHT_KEY, materials[i % 3], &group);
+  }
+
+  Mn::GL::Renderbuffer color;
+  color.setStorage(Mn::GL::RenderbufferFormat::RGBA8, {32, 32});
+  Mn::GL::Framebuffer framebuffer{{{}, {32, 32}}};
+  framebuffer.attachRenderbuffer(Mn::GL::Framebuffer::ColorAttachment{0},
+                                 color);
+  framebuffer.bind();
+
+  esp::gfx::RenderCamera& camera =
+      *(new esp::gfx::RenderCamera(rootNode.createChild()));
+  camera.setProjectionMatrix(32, 32, 0.01f, 100.0f, 90.0_degf);
+
+  // drawables sharing their state would be drawn as one
+  group.setInstancingEnabled(false);
+
+  // drawn in scene graph order, every drawable would change the material
+  for (int draw = 0; draw < 2; ++draw) {
+    CORRADE_ITERATION(draw);
+    group.resetDrawStatistics();
+    CORRADE_VERIFY(group.prepareForDraw(camera));
+    CORRADE_COMPARE(camera.draw(group, {}), 12);
+    CORRADE_COMPARE(group.drawStatistics().drawCalls, 12);
+    CORRADE_COMPARE(group.drawStatistics().shaderChanges, 2);
+    CORRADE_COMPARE(group.drawStatistics().materialChanges, 3);
+  }
+}
+
+void DrawableTest::instancedDraw() {
+  Mn::GL::Mesh box = Mn::MeshTools::compile(Mn::Primitives::cubeSolid());
+  // instancing attaches the object ids of the instances to the mesh, which
+  // the per-vertex object id material would read
+  Mn::GL::Mesh semanticBox =
+      Mn::MeshTools::compile(Mn::Primitives::cubeSolid());
+  const int sceneID = sceneManager_.initSceneGraph();
+  auto& sceneGraph = sceneManager_.getSceneGraph(sceneID);
+  esp::gfx::DrawableGroup& group = sceneGraph.getDrawables();
+  esp::scene::SceneNode& rootNode = sceneGraph.getRootNode();
+  esp::gfx::Drawable::Flags meshAttributeFlags{};
+
+  // the per-vertex object id material can't be drawn instanced
+  const char* materials[]{esp::DEFAULT_MATERIAL_KEY, esp::WHITE_MATERIAL_KEY,
+                          esp::PER_VERTEX_OBJECT_ID_MATERIAL_KEY};
+  for (int i = 0; i < 12; ++i) {
+    esp::scene::SceneNode& node = rootNode.createChild();
+    node.translate({0.5f * (i % 4) - 0.75f, 0.0f, -2.0f * i - 5.0f});
+    node.setSemanticId(i + 1);
+    node.addFeature<esp::gfx::GenericDrawable>(
+        i % 3 == 2 ? semanticBox : box, meshAttributeFlags,
+        resourceManager_->getShaderManager(), esp::NO_LIGHT_KEY,
+        materials[i % 3], &group);
+  }
+  // behind the camera, so it is culled from the instances of the default
+  // material
+  esp::scene::SceneNode& culledNode = rootNode.createChild();
+  culledNode.translate({0.0f, 0.0f, 10.0f});
+  culledNode.addFeature<esp::gfx::GenericDrawable>(
+      box, meshAttributeFlags, resourceManager_->getShaderManager(),
+      esp::NO_LIGHT_KEY, esp::DEFAULT_MATERIAL_KEY, &group);
+
+  esp::gfx::RenderCamera& camera =
+      *(new esp::gfx::RenderCamera(rootNode.createChild()));
+  camera.setProjectionMatrix(32, 32, 0.01f, 100.0f, 90.0_degf);
+  esp::gfx::RenderTarget target{
+      {32, 32},
+      esp::gfx::calculateDepthUnprojection(camera.projectionMatrix()),
+      nullptr};
+
+  std::vector<Mn::Image2D> rgba;
+  std::vector<Mn::Image2D> objectIds;
+  for (int instanced = 0; instanced < 2; ++instanced) {
+    CORRADE_ITERATION(instanced);
+    rgba.emplace_back(Mn::PixelFormat::RGBA8Unorm, Mn::Vector2i{32, 32},
+                      Cr::Containers::Array<char>{32 * 32 * 4});
+    objectIds.emplace_back(Mn::PixelFormat::R32UI, Mn::Vector2i{32, 32},
+                           Cr::Containers::Array<char>{32 * 32 * 4});
+    group.setInstancingEnabled(instanced);
+    group.resetDrawStatistics();
+    target.renderEnter();
+    CORRADE_VERIFY(group.prepareForDraw(camera));
+    CORRADE_COMPARE(
+        camera.draw(group, esp::gfx::RenderCamera::Flag::FrustumCulling), 12);
+    target.renderExit();
+    target.readFrameRgba(rgba[instanced]);
+    target.readFrameObjectId(objectIds[instanced]);
+  }
+
+  // four drawables of each of the default and white materials are drawn at
+  // once, the per-vertex object id ones one by one
+  CORRADE_COMPARE(group.drawStatistics().drawCalls, 6);
+  CORRADE_COMPARE(group.drawStatistics().instancedDrawCalls, 2);
+  CORRADE_COMPARE(group.drawStatistics().instances, 8);
+
+  // the closest box has the default material, and with it its semantic id
+  CORRADE_COMPARE(objectIds[1].pixels<Mn::UnsignedInt>()[16][16], 1);
+  CORRADE_COMPARE_AS(rgba[1].data(), rgba[0].data(),
+                     Cr::TestSuite::Compare::Container);
+  CORRADE_COMPARE_AS(objectIds[1].data(), objectIds[0].data(),
+                     Cr::TestSuite::Compare::Container);
+}
+
 }  // namespace
 }  // namespace Test
 
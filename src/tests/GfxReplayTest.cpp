@@ -8,8 +8,10 @@
 #include "esp/assets/ResourceManager.h"
 #include "esp/gfx/Renderer.h"
 #include "esp/gfx/WindowlessContext.h"
+#include "esp/gfx/replay/KeyframeFile.h"
 #include "esp/gfx/replay/Player.h"
 #include "esp/gfx/replay/Recorder.h"
+#include "esp/gfx/replay/ReplayRenderer.h"
 #include "esp/gfx/replay/ReplayManager.h"
 #include "esp/scene/SceneManager.h"
 #include "esp/sim/Simulator.h"
@@ -20,6 +22,7 @@
 #include <Magnum/Math/Range.h>
 
 #include <gtest/gtest.h>
+#include <chrono>
 #include <fstream>
 #include <string>
 
@@ -122,6 +125,206 @@ TEST(GfxReplayTest, recorder) {
          Mn::Vector3(4.f, 5.f, 6.f));
 }
 
+// record a scene where few of many instances move, and time the Recorder
+TEST(GfxReplayTest, recorderBenchmark) {
+  constexpr int numInstances = 5000;
+  constexpr int numMovingInstances = 50;
+  constexpr int numKeyframes = 200;
+
+  SceneManager sceneManager_;
+  int sceneID = sceneManager_.initSceneGraph();
+  auto& rootNode = sceneManager_.getSceneGraph(sceneID).getRootNode();
+
+  esp::assets::RenderAssetInstanceCreationInfo creation(
+      "box.glb", Corrade::Containers::NullOpt, {}, "");
+  esp::gfx::replay::Recorder recorder;
+  std::vector<esp::scene::SceneNode*> nodes;
+  for (int i = 0; i < numInstances; ++i) {
+    auto& node = rootNode.createChild();
+    node.setTranslation(Mn::Vector3(float(i), 0.f, 0.f));
+    nodes.push_back(&node);
+    recorder.onCreateRenderAssetInstance(&node, creation);
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  recorder.saveKeyframe();
+  for (int k = 1; k < numKeyframes; ++k) {
+    for (int i = 0; i < numMovingInstances; ++i) {
+      auto* node = nodes[(k + i * 97) % numInstances];
+      node->translate(Mn::Vector3(0.f, 0.1f, 0.f));
+    }
+    recorder.saveKeyframe();
+  }
+  const auto saved = std::chrono::steady_clock::now();
+  // delete every other instance
+  for (int i = 0; i < numInstances; i += 2) {
+    delete nodes[i];
+  }
+  recorder.saveKeyframe();
+  const auto end = std::chrono::steady_clock::now();
+
+  const auto& keyframes = recorder.debugGetSavedKeyframes();
+  ASSERT_EQ(keyframes.size(), numKeyframes + 1);
+  EXPECT_EQ(keyframes[0].stateUpdates.size(), numInstances);
+  for (int k = 1; k < numKeyframes; ++k) {
+    EXPECT_EQ(keyframes[k].stateUpdates.size(), numMovingInstances);
+  }
+  EXPECT_EQ(keyframes.back().deletions.size(), numInstances / 2);
+
+  LOG(INFO) << "GfxReplayTest::recorderBenchmark: " << numKeyframes
+            << " keyframes of " << numInstances << " instances in "
+            << std::chrono::duration<double, std::milli>(saved - start).count()
+            << " ms, " << numInstances / 2 << " deletions in "
+            << std::chrono::duration<double, std::milli>(end - saved).count()
+            << " ms";
+}
+
+// stream keyframes to disk on a background thread with a small queue
+TEST(GfxReplayTest, recorderAsyncStreaming) {
+  constexpr int numKeyframes = 100;
+  auto testFilepath =
+      Corrade::Utility::Directory::join(DATA_DIR, "./gfx_replay_test.bin");
+
+  SceneManager sceneManager_;
+  int sceneID = sceneManager_.initSceneGraph();
+  auto& rootNode = sceneManager_.getSceneGraph(sceneID).getRootNode();
+
+  esp::assets::RenderAssetInstanceCreationInfo creation(
+      "box.glb", Corrade::Containers::NullOpt, {}, "");
+  esp::gfx::replay::Recorder recorder;
+  auto& node = rootNode.createChild();
+  recorder.onCreateRenderAssetInstance(&node, creation);
+  // this keyframe is already saved and should be written first
+  recorder.saveKeyframe();
+
+  ASSERT_TRUE(recorder.startStreamingKeyframesToFile(testFilepath, 4));
+  EXPECT_TRUE(recorder.isStreamingKeyframes());
+  for (int i = 1; i < numKeyframes; ++i) {
+    node.setTranslation(Mn::Vector3(float(i), 0.f, 0.f));
+    recorder.saveKeyframe();
+  }
+  EXPECT_TRUE(recorder.debugGetSavedKeyframes().empty());
+  EXPECT_TRUE(recorder.stopStreamingKeyframes());
+  EXPECT_FALSE(recorder.isStreamingKeyframes());
+
+  std::vector<esp::gfx::replay::Keyframe> keyframes;
+  ASSERT_TRUE(
+      esp::gfx::replay::readKeyframesFromFile(testFilepath, keyframes));
+  ASSERT_EQ(keyframes.size(), numKeyframes);
+  EXPECT_EQ(keyframes[0].creations.size(), 1);
+  for (int i = 1; i < numKeyframes; ++i) {
+    ASSERT_EQ(keyframes[i].stateUpdates.size(), 1);
+    const auto& state = keyframes[i].stateUpdates[0].second;
+    EXPECT_NEAR(state.absTransform.translation.x(), float(i), 1e-4f);
+  }
+
+  // keyframes saved after streaming stops start with the streamed creations
+  recorder.saveKeyframe();
+  ASSERT_EQ(recorder.debugGetSavedKeyframes().size(), 1);
+  EXPECT_EQ(recorder.debugGetSavedKeyframes()[0].creations.size(), 1);
+
+  if (!Corrade::Utility::Directory::rm(testFilepath)) {
+    LOG(WARNING) << "GfxReplayTest::recorderAsyncStreaming : unable to remove "
+                    "temporary test file "
+                 << testFilepath;
+  }
+}
+
+// jitter below the change thresholds and unchanged user transforms are left
+// out of keyframes, and still play back
+TEST(GfxReplayTest, recorderChangeThresholds) {
+  auto testFilepath =
+      Corrade::Utility::Directory::join(DATA_DIR, "./gfx_replay_test.bin");
+
+  SceneManager sceneManager_;
+  int sceneID = sceneManager_.initSceneGraph();
+  auto& rootNode = sceneManager_.getSceneGraph(sceneID).getRootNode();
+
+  esp::assets::RenderAssetInstanceCreationInfo creation(
+      "box.glb", Corrade::Containers::NullOpt, {}, "");
+  esp::gfx::replay::Recorder recorder;
+  recorder.setChangeThresholds(1e-3f, Mn::Rad(Mn::Deg(0.5f)));
+  auto& node = rootNode.createChild();
+  node.setSemanticId(4);
+  recorder.onCreateRenderAssetInstance(&node, creation);
+  const Mn::Quaternion cameraRotation =
+      Mn::Quaternion::rotation(Mn::Deg(30.f), Mn::Vector3::yAxis());
+  recorder.addUserTransformToKeyframe("camera", Mn::Vector3(1.f, 2.f, 3.f),
+                                      cameraRotation);
+  recorder.saveKeyframe();
+
+  // jitter: each step is below the threshold, but they add up to a change in
+  // the last keyframe
+  for (int i = 1; i <= 4; ++i) {
+    node.setTranslation(Mn::Vector3(0.f, 0.0003f * i, 0.f));
+    node.setRotation(
+        Mn::Quaternion::rotation(Mn::Deg(0.1f * i), Mn::Vector3::xAxis()));
+    recorder.addUserTransformToKeyframe("camera", Mn::Vector3(1.f, 2.f, 3.f),
+                                        cameraRotation);
+    recorder.saveKeyframe();
+  }
+  // a new name is always recorded
+  recorder.addUserTransformToKeyframe("agent", Mn::Vector3(5.f, 0.f, 0.f),
+                                      Mn::Quaternion(Mn::Math::IdentityInit));
+  recorder.saveKeyframe();
+
+  const auto& keyframes = recorder.debugGetSavedKeyframes();
+  ASSERT_EQ(keyframes.size(), 6);
+  EXPECT_EQ(keyframes[0].stateUpdates.size(), 1);
+  EXPECT_EQ(keyframes[0].userTransforms.size(), 1);
+  for (int i = 1; i <= 3; ++i) {
+    EXPECT_TRUE(keyframes[i].stateUpdates.empty());
+    EXPECT_TRUE(keyframes[i].userTransforms.empty());
+  }
+  ASSERT_EQ(keyframes[4].stateUpdates.size(), 1);
+  EXPECT_EQ(keyframes[4].stateUpdates[0].second.semanticId, 4);
+  EXPECT_EQ(keyframes[5].userTransforms.size(), 1);
+  EXPECT_EQ(keyframes[5].userTransforms.count("agent"), 1);
+
+  // the semantic id doesn't change, so the binary file leaves it out after the
+  // first keyframe, and it must still read back
+  ASSERT_TRUE(recorder.writeSavedKeyframesToFile(testFilepath));
+  std::vector<esp::gfx::replay::Keyframe> readKeyframes;
+  ASSERT_TRUE(
+      esp::gfx::replay::readKeyframesFromFile(testFilepath, readKeyframes));
+  ASSERT_EQ(readKeyframes.size(), keyframes.size());
+  ASSERT_EQ(readKeyframes[4].stateUpdates.size(), 1);
+  const auto& state = readKeyframes[4].stateUpdates[0].second;
+  EXPECT_NEAR(state.absTransform.translation.y(), 0.0012f, 1e-4f);
+  EXPECT_EQ(state.semanticId, 4);
+  EXPECT_EQ(readKeyframes[5].userTransforms, keyframes[5].userTransforms);
+
+  // the Player keeps the last recorded user transforms
+  auto dummyCallback =
+      [&](const esp::assets::AssetInfo& assetInfo,
+          const esp::assets::RenderAssetInstanceCreationInfo& creation) {
+        return nullptr;
+      };
+  esp::gfx::replay::Player player(dummyCallback, 2);
+  player.readKeyframesFromFile(testFilepath);
+  for (const int keyframeIndex : {3, 5, 1, 4}) {
+    player.setKeyframeIndex(keyframeIndex);
+    Mn::Vector3 translation;
+    Mn::Quaternion rotation;
+    ASSERT_TRUE(player.getUserTransform("camera", &translation, &rotation));
+    EXPECT_TRUE(translation == Mn::Vector3(1.f, 2.f, 3.f));
+    EXPECT_EQ(player.getUserTransform("agent", &translation, &rotation),
+              keyframeIndex == 5);
+  }
+  player.close();
+
+  // the next recording starts with the last user transforms
+  recorder.saveKeyframe();
+  ASSERT_EQ(recorder.debugGetSavedKeyframes().size(), 1);
+  EXPECT_EQ(recorder.debugGetSavedKeyframes()[0].userTransforms.size(), 2);
+
+  if (!Corrade::Utility::Directory::rm(testFilepath)) {
+    LOG(WARNING) << "GfxReplayTest::recorderChangeThresholds : unable to "
+                    "remove temporary test file "
+                 << testFilepath;
+  }
+}
+
 // construct some render keyframes and play them using replay::Player
 TEST(GfxReplayTest, player) {
   esp::gfx::WindowlessContext::uptr context_ =
@@ -276,6 +479,89 @@ TEST(GfxReplayTest, player) {
   }
 }
 
+// seek with snapshots, which should reuse existing instances
+TEST(GfxReplayTest, playerSnapshots) {
+  esp::gfx::WindowlessContext::uptr context_ =
+      esp::gfx::WindowlessContext::create_unique(0);
+
+  std::shared_ptr<esp::gfx::Renderer> renderer_ = esp::gfx::Renderer::create();
+
+  auto cfg = esp::sim::SimulatorConfiguration{};
+  auto MM = MetadataMediator::create(cfg);
+  // must declare these in this order due to avoid deallocation errors
+  ResourceManager resourceManager(MM);
+  SceneManager sceneManager_;
+  std::string boxFile =
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/transform_box.glb");
+
+  int sceneID = sceneManager_.initSceneGraph();
+  auto& rootNode = sceneManager_.getSceneGraph(sceneID).getRootNode();
+  int numberOfChildren = getNumberOfChildrenOfRoot(rootNode);
+
+  int numCreatedInstances = 0;
+  esp::scene::SceneNode* lastCreatedNode = nullptr;
+  auto callback =
+      [&](const esp::assets::AssetInfo& assetInfo,
+          const esp::assets::RenderAssetInstanceCreationInfo& creation) {
+        std::vector<int> tempIDs{sceneID, esp::ID_UNDEFINED};
+        ++numCreatedInstances;
+        lastCreatedNode = resourceManager.loadAndCreateRenderAssetInstance(
+            assetInfo, creation, &sceneManager_, tempIDs);
+        return lastCreatedNode;
+      };
+  // snapshots after keyframes 2, 5, and 8
+  esp::gfx::replay::Player player(callback, 3);
+
+  esp::gfx::replay::RenderAssetInstanceKey instanceKey = 2;
+  esp::assets::RenderAssetInstanceCreationInfo creation(
+      boxFile, Corrade::Containers::NullOpt, {}, "");
+
+  // keyframe #0: load and create; #1-#7: move the instance; #8: delete it
+  std::vector<esp::gfx::replay::Keyframe> keyframes;
+  keyframes.emplace_back(esp::gfx::replay::Keyframe{
+      {esp::assets::AssetInfo::fromPath(boxFile)},
+      {{instanceKey, creation}},
+      {},
+      {},
+      {}});
+  for (int i = 1; i < 8; ++i) {
+    esp::gfx::replay::RenderAssetInstanceState state{
+        {Mn::Vector3(float(i), 0.f, 0.f),
+         Mn::Quaternion(Mn::Math::IdentityInit)},
+        i};
+    keyframes.emplace_back(
+        esp::gfx::replay::Keyframe{{}, {}, {}, {{instanceKey, state}}, {}});
+  }
+  keyframes.emplace_back(
+      esp::gfx::replay::Keyframe{{}, {}, {instanceKey}, {}, {}});
+  player.debugSetKeyframes(std::move(keyframes));
+
+  player.setKeyframeIndex(7);
+  ASSERT_EQ(numCreatedInstances, 1);
+  esp::scene::SceneNode* instanceNode = lastCreatedNode;
+  EXPECT_EQ(instanceNode->translation(), Mn::Vector3(7.f, 0.f, 0.f));
+
+  // seeking backward and forward past the first snapshot moves the existing
+  // instance
+  for (const int keyframeIndex : {3, 6, 2, 7, 5}) {
+    player.setKeyframeIndex(keyframeIndex);
+    EXPECT_EQ(numCreatedInstances, 1);
+    EXPECT_EQ(instanceNode->translation(),
+              Mn::Vector3(float(keyframeIndex), 0.f, 0.f));
+    EXPECT_EQ(instanceNode->getSemanticId(), keyframeIndex);
+  }
+
+  // the instance is deleted and recreated
+  player.setKeyframeIndex(8);
+  EXPECT_EQ(getNumberOfChildrenOfRoot(rootNode), numberOfChildren);
+  player.setKeyframeIndex(4);
+  EXPECT_EQ(numCreatedInstances, 2);
+  EXPECT_EQ(lastCreatedNode->translation(), Mn::Vector3(4.f, 0.f, 0.f));
+
+  player.setKeyframeIndex(-1);
+  EXPECT_EQ(getNumberOfChildrenOfRoot(rootNode), numberOfChildren);
+}
+
 TEST(GfxReplayTest, playerReadMissingFile) {
   auto dummyCallback =
       [&](const esp::assets::AssetInfo& assetInfo,
@@ -315,6 +601,205 @@ TEST(GfxReplayTest, playerReadInvalidFile) {
   }
 }
 
+// write keyframes to the binary format and read them back, also through JSON
+TEST(GfxReplayTest, binaryKeyframeFile) {
+  auto binaryFilepath =
+      Corrade::Utility::Directory::join(DATA_DIR, "./gfx_replay_test.bin");
+  auto jsonFilepath =
+      Corrade::Utility::Directory::join(DATA_DIR, "./gfx_replay_test.json");
+
+  esp::assets::AssetInfo info = esp::assets::AssetInfo::fromPath(
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/transform_box.glb"));
+  esp::assets::RenderAssetInstanceCreationInfo::Flags flags;
+  flags |= esp::assets::RenderAssetInstanceCreationInfo::Flag::IsSemantic;
+  esp::assets::RenderAssetInstanceCreationInfo creation(
+      info.filepath, Mn::Vector3(2.f, 2.f, 2.f), flags, "lights");
+
+  std::vector<esp::gfx::replay::Keyframe> keyframes;
+  keyframes.emplace_back(esp::gfx::replay::Keyframe{
+      {info}, {{3, creation}, {-5, creation}}, {}, {}, {}});
+  for (int i = 0; i < 9; ++i) {
+    esp::gfx::replay::RenderAssetInstanceState state{
+        {Mn::Vector3(0.1f * i, -2.f, 30.f + i),
+         Mn::Quaternion::rotation(Mn::Deg(35.f * i),
+                                  Mn::Vector3(1.f, 2.f, -3.f).normalized())},
+        i};
+    keyframes.emplace_back(esp::gfx::replay::Keyframe{
+        {}, {}, {}, {{3, state}}, {{"camera", state.absTransform}}});
+  }
+  keyframes.emplace_back(esp::gfx::replay::Keyframe{{}, {}, {3, -5}, {}, {}});
+
+  // small chunks, so keyframes span several of them
+  esp::gfx::replay::KeyframeWriter writer(4);
+  ASSERT_TRUE(writer.open(binaryFilepath));
+  for (const auto& keyframe : keyframes) {
+    writer.writeKeyframe(keyframe);
+  }
+  EXPECT_TRUE(writer.close());
+
+  auto checkKeyframes =
+      [&](const std::vector<esp::gfx::replay::Keyframe>& readKeyframes) {
+        ASSERT_EQ(readKeyframes.size(), keyframes.size());
+        for (size_t i = 0; i < keyframes.size(); ++i) {
+          const auto& expected = keyframes[i];
+          const auto& actual = readKeyframes[i];
+          ASSERT_EQ(actual.loads.size(), expected.loads.size());
+          for (size_t j = 0; j < expected.loads.size(); ++j) {
+            EXPECT_EQ(actual.loads[j], expected.loads[j]);
+          }
+          ASSERT_EQ(actual.creations.size(), expected.creations.size());
+          for (size_t j = 0; j < expected.creations.size(); ++j) {
+            const auto& a = actual.creations[j];
+            const auto& e = expected.creations[j];
+            EXPECT_EQ(a.first, e.first);
+            EXPECT_EQ(a.second.filepath, e.second.filepath);
+            EXPECT_TRUE(a.second.scale && *a.second.scale == *e.second.scale);
+            EXPECT_TRUE(a.second.flags == e.second.flags);
+            EXPECT_EQ(a.second.lightSetupKey, e.second.lightSetupKey);
+          }
+          EXPECT_EQ(actual.deletions, expected.deletions);
+          ASSERT_EQ(actual.stateUpdates.size(), expected.stateUpdates.size());
+          for (size_t j = 0; j < expected.stateUpdates.size(); ++j) {
+            const auto& a = actual.stateUpdates[j];
+            const auto& e = expected.stateUpdates[j];
+            EXPECT_EQ(a.first, e.first);
+            // translations and rotations are quantized
+            EXPECT_LT(Mn::Math::abs(a.second.absTransform.translation -
+                                    e.second.absTransform.translation)
+                          .max(),
+                      1e-4f);
+            EXPECT_GT(std::abs(Mn::Math::dot(a.second.absTransform.rotation,
+                                             e.second.absTransform.rotation)),
+                      0.9999f);
+            EXPECT_EQ(a.second.semanticId, e.second.semanticId);
+          }
+          EXPECT_EQ(actual.userTransforms, expected.userTransforms);
+        }
+      };
+
+  esp::gfx::replay::KeyframeReader reader;
+  ASSERT_TRUE(reader.open(binaryFilepath));
+  EXPECT_EQ(reader.getNumKeyframes(), keyframes.size());
+  EXPECT_EQ(reader.getNumChunks(), 3);
+  EXPECT_EQ(reader.findChunk(9), 2);
+  EXPECT_EQ(reader.getChunkFirstKeyframe(2), 8);
+
+  std::vector<esp::gfx::replay::Keyframe> readKeyframes;
+  ASSERT_TRUE(
+      esp::gfx::replay::readKeyframesFromFile(binaryFilepath, readKeyframes));
+  checkKeyframes(readKeyframes);
+
+  // binary -> JSON -> binary
+  ASSERT_TRUE(
+      esp::gfx::replay::convertKeyframeFile(binaryFilepath, jsonFilepath));
+  EXPECT_FALSE(esp::gfx::replay::KeyframeReader::isBinaryFile(jsonFilepath));
+  ASSERT_TRUE(
+      esp::gfx::replay::convertKeyframeFile(jsonFilepath, binaryFilepath));
+  ASSERT_TRUE(
+      esp::gfx::replay::readKeyframesFromFile(binaryFilepath, readKeyframes));
+  checkKeyframes(readKeyframes);
+
+  // seek through the file with a Player
+  auto dummyCallback =
+      [&](const esp::assets::AssetInfo& assetInfo,
+          const esp::assets::RenderAssetInstanceCreationInfo& creation) {
+        return nullptr;
+      };
+  esp::gfx::replay::Player player(dummyCallback);
+  player.readKeyframesFromFile(binaryFilepath);
+  EXPECT_EQ(player.getNumKeyframes(), keyframes.size());
+  for (const int keyframeIndex : {7, 2, 9, 4, 1}) {
+    player.setKeyframeIndex(keyframeIndex);
+    Mn::Vector3 translation;
+    Mn::Quaternion rotation;
+    ASSERT_TRUE(player.getUserTransform("camera", &translation, &rotation));
+    const auto& expected = keyframes[keyframeIndex].userTransforms.at("camera");
+    EXPECT_TRUE(translation == expected.translation);
+  }
+  player.close();
+
+  for (const auto& filepath : {binaryFilepath, jsonFilepath}) {
+    if (!Corrade::Utility::Directory::rm(filepath)) {
+      LOG(WARNING) << "GfxReplayTest::binaryKeyframeFile : unable to remove "
+                      "temporary test file "
+                   << filepath;
+    }
+  }
+}
+
+// render a replay file from new cameras without a simulator
+TEST(GfxReplayTest, replayRenderer) {
+  std::string boxFile =
+      Cr::Utility::Directory::join(TEST_ASSETS, "objects/transform_box.glb");
+  auto testFilepath =
+      Corrade::Utility::Directory::join(DATA_DIR, "./gfx_replay_test.json");
+
+  // a box in front of a recorded "agent" that moves back between keyframes
+  constexpr int semanticId = 5;
+  esp::assets::RenderAssetInstanceCreationInfo::Flags flags;
+  flags |= esp::assets::RenderAssetInstanceCreationInfo::Flag::IsSemantic;
+  esp::assets::RenderAssetInstanceCreationInfo creation(
+      boxFile, Corrade::Containers::NullOpt, flags, esp::NO_LIGHT_KEY);
+  esp::gfx::replay::RenderAssetInstanceState boxState{
+      {Mn::Vector3(0.f, 0.f, -3.f), Mn::Quaternion(Mn::Math::IdentityInit)},
+      semanticId};
+  std::vector<esp::gfx::replay::Keyframe> keyframes;
+  for (int i = 0; i < 3; ++i) {
+    esp::gfx::replay::Keyframe keyframe;
+    if (i == 0) {
+      keyframe.loads.push_back(esp::assets::AssetInfo::fromPath(boxFile));
+      keyframe.creations.emplace_back(0, creation);
+      keyframe.stateUpdates.emplace_back(0, boxState);
+    }
+    keyframe.userTransforms["agent"] = {
+        Mn::Vector3(0.f, 0.f, float(i)),
+        Mn::Quaternion(Mn::Math::IdentityInit)};
+    keyframes.push_back(keyframe);
+  }
+  ASSERT_TRUE(esp::gfx::replay::writeKeyframesToFile(testFilepath, keyframes));
+
+  std::vector<esp::gfx::replay::ReplayRenderer::CameraSpec> cameras(3);
+  cameras[0].sensorType = esp::sensor::SensorType::Color;
+  cameras[1].sensorType = esp::sensor::SensorType::Depth;
+  cameras[2].sensorType = esp::sensor::SensorType::Semantic;
+  for (auto& camera : cameras) {
+    camera.resolution = {32, 48};
+    camera.userTransformName = "agent";
+  }
+  esp::gfx::replay::ReplayRenderer renderer(cameras);
+  renderer.readKeyframesFromFile(testFilepath);
+  ASSERT_EQ(renderer.getNumKeyframes(), 3);
+
+  const auto buffers = renderer.renderKeyframes({0, 2, 1});
+  ASSERT_EQ(buffers.size(), 3);
+  EXPECT_EQ(buffers[0]->shape, (std::vector<size_t>{3, 32, 48, 4}));
+  EXPECT_EQ(buffers[1]->shape, (std::vector<size_t>{3, 32, 48, 1}));
+  EXPECT_EQ(buffers[2]->shape, (std::vector<size_t>{3, 32, 48, 1}));
+
+  // the center pixel of each frame sees the front face of the 2x2x2 box, at a
+  // distance that grows as the agent moves back
+  const size_t centerPixel = 16 * 48 + 24;
+  const auto* depth = reinterpret_cast<const float*>(buffers[1]->data.data());
+  const auto* semantic =
+      reinterpret_cast<const uint32_t*>(buffers[2]->data.data());
+  const int renderedKeyframes[] = {0, 2, 1};
+  for (int i = 0; i < 3; ++i) {
+    const float expectedDepth = 2.f + renderedKeyframes[i];
+    EXPECT_NEAR(depth[i * 32 * 48 + centerPixel], expectedDepth, 0.05f);
+    EXPECT_EQ(semantic[i * 32 * 48 + centerPixel], semanticId);
+  }
+  const auto* color = buffers[0]->data.data();
+  EXPECT_GT(color[centerPixel * 4] + color[centerPixel * 4 + 1] +
+                color[centerPixel * 4 + 2],
+            0);
+
+  if (!Corrade::Utility::Directory::rm(testFilepath)) {
+    LOG(WARNING) << "GfxReplayTest::replayRenderer : unable to remove "
+                    "temporary test file "
+                 << testFilepath;
+  }
+}
+
 // test recording and playback through the simulator interface
 TEST(GfxReplayTest, simulatorIntegration) {
   std::string boxFile =
@@ -334,7 +819,7 @@ TEST(GfxReplayTest, simulatorIntegration) {
   const auto recorder = sim->getGfxReplayManager()->getRecorder();
   EXPECT_TRUE(recorder);
   recorder->saveKeyframe();
-  recorder->writeSavedKeyframesToFile(testFilepath);
+  ASSERT_TRUE(recorder->writeSavedKeyframesToFile(testFilepath));
 
   auto player = sim->getGfxReplayManager()->readKeyframesFromFile(testFilepath);
   EXPECT_TRUE(player);
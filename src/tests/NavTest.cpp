@@ -4,6 +4,8 @@
 
 #include <Corrade/Utility/Directory.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
 
 #include "esp/assets/MeshData.h"
 #include "esp/core/esp.h"
@@ -167,3 +169,54 @@ TEST(NavTest, PathFinderTestMeshData) {
   ASSERT_EQ(meshData->vbo.size(), 63);
   ASSERT_EQ(meshData->ibo.size(), 63);
 }
+
+TEST(NavTest, PathFinderMultiGoalVsPerGoal) {
+  PathFinder pf;
+  pf.loadNavMesh(Cr::Utility::Directory::join(
+      SCENE_DATASETS, "habitat-test-scenes/skokloster-castle.navmesh"));
+  pf.seed(0);
+
+  vec3f start;
+  do {
+    start = pf.getRandomNavigablePoint();
+  } while (pf.islandRadius(start) < 10.0);
+
+  std::vector<vec3f> ends;
+  for (int i = 0; i < 1000; i++) {
+    ends.emplace_back(pf.getRandomNavigablePoint());
+  }
+
+  MultiGoalShortestPath multiGoalPath;
+  multiGoalPath.requestedStart = start;
+  multiGoalPath.setRequestedEnds(ends);
+  auto t0 = std::chrono::steady_clock::now();
+  pf.findPath(multiGoalPath);
+  auto t1 = std::chrono::steady_clock::now();
+
+  // A query per end in order of their straight-line distance, stopping once
+  // no closer end can beat the shortest path found so far
+  float perGoalDistance = std::numeric_limits<float>::infinity();
+  auto t2 = std::chrono::steady_clock::now();
+  std::sort(ends.begin(), ends.end(), [&](const vec3f& a, const vec3f& b) {
+    return (a - start).norm() < (b - start).norm();
+  });
+  ShortestPath path;
+  path.requestedStart = start;
+  for (const vec3f& end : ends) {
+    if ((end - start).norm() >= perGoalDistance)
+      break;
+    path.requestedEnd = end;
+    if (pf.findPath(path))
+      perGoalDistance = std::min(perGoalDistance, path.geodesicDistance);
+  }
+  auto t3 = std::chrono::steady_clock::now();
+
+  LOG(INFO) << "closest of " << ends.size() << " goals: multi-goal "
+            << std::chrono::duration<double, std::milli>(t1 - t0).count()
+            << "ms, per-goal "
+            << std::chrono::duration<double, std::milli>(t3 - t2).count()
+            << "ms";
+
+  ASSERT_TRUE(std::isfinite(perGoalDistance));
+  EXPECT_NEAR(multiGoalPath.geodesicDistance, perGoalDistance, 1e-3);
+}
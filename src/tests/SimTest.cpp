@@ -10,11 +10,17 @@
 #include <Magnum/ImageView.h>
 #include <Magnum/Magnum.h>
 #include <Magnum/PixelFormat.h>
+#include <algorithm>
+#include <cstdint>
+#include <map>
 #include <string>
+#include <vector>
 
 #include "esp/assets/ResourceManager.h"
+#include "esp/gfx/RenderTarget.h"
 #include "esp/physics/RigidObject.h"
 #include "esp/sensor/CameraSensor.h"
+#include "esp/sensor/ObservationArena.h"
 #include "esp/sim/Simulator.h"
 
 #include "configure.h"
@@ -36,6 +42,7 @@ using esp::nav::PathFinder;
 using esp::sensor::CameraSensor;
 using esp::sensor::CameraSensorSpec;
 using esp::sensor::Observation;
+using esp::sensor::ObservationArena;
 using esp::sensor::ObservationSpace;
 using esp::sensor::ObservationSpaceType;
 using esp::sensor::SensorType;
@@ -123,10 +130,14 @@ struct SimTest : Cr::TestSuite::Tester {
   void updateObjectLightSetupRGBAObservation();
   void multipleLightingSetupsRGBAObservation();
   void recomputeNavmeshWithStaticObjects();
+  void updateNavmeshWithStaticObjects();
   void loadingObjectTemplates();
   void buildingPrimAssetObjectTemplates();
   void addObjectByHandle();
   void addSensorToObject();
+  void pipelinedObservations();
+  void colocatedSensorObservations();
+  void arenaObservations();
 
   // TODO: remove outlier pixels from image and lower maxThreshold
   const Magnum::Float maxThreshold = 255.f;
@@ -152,7 +163,10 @@ SimTest::SimTest() {
   // clang-format off
   addTests({&SimTest::basic,
             &SimTest::reconfigure,
-            &SimTest::reset});
+            &SimTest::reset,
+            &SimTest::pipelinedObservations,
+            &SimTest::colocatedSensorObservations,
+            &SimTest::arenaObservations});
             //test instances test both mechanisms for constructing simulator
   addInstancedTests({
             &SimTest::getSceneRGBAObservation,
@@ -163,6 +177,7 @@ SimTest::SimTest() {
             &SimTest::updateObjectLightSetupRGBAObservation,
             &SimTest::multipleLightingSetupsRGBAObservation,
             &SimTest::recomputeNavmeshWithStaticObjects,
+            &SimTest::updateNavmeshWithStaticObjects,
             &SimTest::loadingObjectTemplates,
             &SimTest::buildingPrimAssetObjectTemplates,
             &SimTest::addObjectByHandle,
@@ -513,6 +528,71 @@ void SimTest::recomputeNavmeshWithStaticObjects() {
       simulator->getPathFinder()->isNavigable(randomNavPoint + offset, 0.2));
 }
 
+void SimTest::updateNavmeshWithStaticObjects() {
+  Corrade::Utility::Debug()
+      << "Starting Test : updateNavmeshWithStaticObjects ";
+  auto&& data = SimulatorBuilder[testCaseInstanceId()];
+  setTestCaseDescription(data.name);
+  auto simulator = data.creator(*this, skokloster, esp::NO_LIGHT_KEY);
+  auto objectAttribsMgr = simulator->getObjectAttributesManager();
+  PathFinder& pathfinder = *simulator->getPathFinder();
+
+  // compute the initial tiled navmesh
+  esp::nav::NavMeshSettings navMeshSettings;
+  navMeshSettings.setDefaults();
+  navMeshSettings.tileSize = 64;
+  CORRADE_VERIFY(
+      simulator->recomputeNavMesh(pathfinder, navMeshSettings, true));
+
+  esp::vec3f randomNavPoint = pathfinder.getRandomNavigablePoint();
+  while (pathfinder.distanceToClosestObstacle(randomNavPoint) < 1.0 ||
+         randomNavPoint[1] > 1.0) {
+    randomNavPoint = pathfinder.getRandomNavigablePoint();
+  }
+  const float navigableArea = pathfinder.getNavigableArea();
+
+  // nothing changed, nothing to update
+  CORRADE_VERIFY(simulator->updateNavMesh(pathfinder));
+  CORRADE_COMPARE(pathfinder.getNavigableArea(), navigableArea);
+
+  // add a static object at a known navigable point
+  auto objs = objectAttribsMgr->getObjectHandlesBySubstring("nested_box");
+  int objectID = simulator->addObjectByHandle(objs[0]);
+  simulator->setTranslation(Magnum::Vector3{randomNavPoint}, objectID);
+  simulator->setObjectMotionType(esp::physics::MotionType::STATIC, objectID);
+  CORRADE_VERIFY(simulator->updateNavMesh(pathfinder));
+  CORRADE_VERIFY(!pathfinder.isNavigable(randomNavPoint, 0.1));
+
+  // the incremental update matches a full recompute
+  const float updatedArea = pathfinder.getNavigableArea();
+  PathFinder fullPathfinder;
+  CORRADE_VERIFY(
+      simulator->recomputeNavMesh(fullPathfinder, navMeshSettings, true));
+  CORRADE_VERIFY(std::abs(fullPathfinder.getNavigableArea() - updatedArea) <
+                 1e-3f * updatedArea);
+
+  // the last computation was for another pathfinder, so this falls back to a
+  // full recompute
+  CORRADE_VERIFY(simulator->updateNavMesh(pathfinder));
+  CORRADE_VERIFY(!pathfinder.isNavigable(randomNavPoint, 0.1));
+
+  // moving the object away frees the point again
+  simulator->setTranslation(
+      Magnum::Vector3{randomNavPoint} + Magnum::Vector3{0, 10.0, 0}, objectID);
+  CORRADE_VERIFY(simulator->updateNavMesh(pathfinder));
+  CORRADE_VERIFY(pathfinder.isNavigable(randomNavPoint, 0.1));
+
+  // as does removing it
+  simulator->setTranslation(Magnum::Vector3{randomNavPoint}, objectID);
+  CORRADE_VERIFY(simulator->updateNavMesh(pathfinder));
+  CORRADE_VERIFY(!pathfinder.isNavigable(randomNavPoint, 0.1));
+  simulator->removeObject(objectID);
+  CORRADE_VERIFY(simulator->updateNavMesh(pathfinder));
+  CORRADE_VERIFY(pathfinder.isNavigable(randomNavPoint, 0.1));
+  CORRADE_VERIFY(std::abs(pathfinder.getNavigableArea() - navigableArea) <
+                 1e-3f * navigableArea);
+}
+
 void SimTest::loadingObjectTemplates() {
   Corrade::Utility::Debug() << "Starting Test : loadingObjectTemplates ";
   auto&& data = SimulatorBuilder[testCaseInstanceId()];
@@ -797,6 +877,197 @@ void SimTest::addSensorToObject() {
       Cr::Utility::Directory::join(screenshotDir, "SimTestExpectedScene.png"),
       (Mn::DebugTools::CompareImageToFile{maxThreshold, 0.75f}));
 }
+
+void SimTest::pipelinedObservations() {
+  auto simulator = getSimulator(*this, vangogh);
+
+  auto colorSpec = CameraSensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->sensorSubType = esp::sensor::SensorSubType::Pinhole;
+  colorSpec->sensorType = SensorType::Color;
+  colorSpec->position = {0.0f, 1.5f, 0.0f};
+  colorSpec->resolution = {64, 64};
+  auto depthSpec = CameraSensorSpec::create();
+  depthSpec->uuid = "depth";
+  depthSpec->sensorSubType = esp::sensor::SensorSubType::Pinhole;
+  depthSpec->sensorType = SensorType::Depth;
+  depthSpec->position = {0.0f, 1.5f, 0.0f};
+  depthSpec->resolution = {64, 64};
+  depthSpec->channels = 1;
+
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec, depthSpec};
+  Agent::ptr agent = simulator->addAgent(agentConfig);
+
+  AgentState stateA;
+  stateA.position = {1.0f, 0.0f, 1.0f};
+  AgentState stateB;
+  stateB.position = {-1.0f, 0.0f, 0.5f};
+
+  // copies of the color and depth observations, concatenated
+  const auto observe = [&](const AgentState& state) {
+    agent->setState(state);
+    std::vector<uint8_t> data;
+    for (const char* uuid : {"color", "depth"}) {
+      Observation observation;
+      CORRADE_INTERNAL_ASSERT_OUTPUT(
+          simulator->getAgentObservation(0, uuid, observation));
+      data.insert(data.end(), observation.buffer->data.begin(),
+                  observation.buffer->data.end());
+    }
+    return data;
+  };
+
+  const std::vector<uint8_t> observationA = observe(stateA);
+  const std::vector<uint8_t> observationB = observe(stateB);
+  CORRADE_VERIFY(observationA != observationB);
+
+  simulator->setPipelinedObservationsEnabled(true);
+  CORRADE_VERIFY(simulator->isPipelinedObservationsEnabled());
+  // the first observation can't lag behind
+  CORRADE_VERIFY(observe(stateA) == observationA);
+  // afterwards, each observation is the one drawn by the previous call
+  CORRADE_VERIFY(observe(stateB) == observationA);
+  CORRADE_VERIFY(observe(stateB) == observationB);
+  CORRADE_VERIFY(observe(stateA) == observationB);
+
+  // the pending read is dropped when pipelining gets disabled
+  simulator->setPipelinedObservationsEnabled(false);
+  CORRADE_VERIFY(observe(stateB) == observationB);
+  simulator->setPipelinedObservationsEnabled(true);
+  CORRADE_VERIFY(observe(stateA) == observationA);
+}
+
+void SimTest::colocatedSensorObservations() {
+  auto simulator = getSimulator(*this, vangogh);
+
+  auto colorSpec = CameraSensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->sensorSubType = esp::sensor::SensorSubType::Pinhole;
+  colorSpec->sensorType = SensorType::Color;
+  colorSpec->position = {0.0f, 1.5f, 0.0f};
+  colorSpec->resolution = {64, 64};
+  auto depthSpec = CameraSensorSpec::create();
+  *depthSpec = *colorSpec;
+  depthSpec->uuid = "depth";
+  depthSpec->sensorType = SensorType::Depth;
+  depthSpec->channels = 1;
+  // not co-located, so drawn on its own
+  auto otherDepthSpec = CameraSensorSpec::create();
+  *otherDepthSpec = *depthSpec;
+  otherDepthSpec->uuid = "otherDepth";
+  otherDepthSpec->position = {0.0f, 1.0f, 0.0f};
+
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec, depthSpec, otherDepthSpec};
+  Agent::ptr agent = simulator->addAgent(agentConfig);
+  AgentState state;
+  state.position = {1.0f, 0.0f, 1.0f};
+  agent->setState(state);
+
+  // the depth sensor shares the render pass of the color sensor
+  std::map<std::string, Observation> observations;
+  CORRADE_COMPARE(simulator->getAgentObservations(0, observations), 3);
+  // observations share the memory of their sensor, so copy them before the
+  // sensors are drawn again
+  std::map<std::string, std::vector<uint8_t>> sharedData;
+  for (const auto& observation : observations) {
+    sharedData[observation.first].assign(
+        observation.second.buffer->data.begin(),
+        observation.second.buffer->data.end());
+  }
+  auto& colorSensor = static_cast<esp::sensor::VisualSensor&>(
+      agent->getSubtreeSensorSuite().get("color"));
+  CORRADE_VERIFY(colorSensor.renderTarget().flags() &
+                 esp::gfx::RenderTarget::Flag::DepthTextureAttachment);
+  auto& otherDepthSensor = static_cast<esp::sensor::VisualSensor&>(
+      agent->getSubtreeSensorSuite().get("otherDepth"));
+  CORRADE_VERIFY(!(otherDepthSensor.renderTarget().flags() &
+                   esp::gfx::RenderTarget::Flag::RgbaAttachment));
+
+  // same as drawing every sensor on its own
+  for (const char* uuid : {"color", "depth", "otherDepth"}) {
+    CORRADE_ITERATION(uuid);
+    Observation observation;
+    CORRADE_VERIFY(simulator->getAgentObservation(0, uuid, observation));
+    const Observation& sharedObservation = observations.at(uuid);
+    CORRADE_COMPARE(sharedObservation.buffer->shape,
+                    observation.buffer->shape);
+    CORRADE_VERIFY(std::equal(observation.buffer->data.begin(),
+                              observation.buffer->data.end(),
+                              sharedData.at(uuid).begin()));
+  }
+}
+
+void SimTest::arenaObservations() {
+  auto colorSpec = CameraSensorSpec::create();
+  colorSpec->uuid = "color";
+  colorSpec->sensorSubType = esp::sensor::SensorSubType::Pinhole;
+  colorSpec->sensorType = SensorType::Color;
+  colorSpec->position = {0.0f, 1.5f, 0.0f};
+  colorSpec->resolution = {48, 64};
+  auto depthSpec = CameraSensorSpec::create();
+  *depthSpec = *colorSpec;
+  depthSpec->uuid = "depth";
+  depthSpec->sensorType = SensorType::Depth;
+  depthSpec->channels = 1;
+  AgentConfiguration agentConfig{};
+  agentConfig.sensorSpecifications = {colorSpec, depthSpec};
+
+  auto simulatorA = getSimulator(*this, vangogh);
+  auto simulatorB = getSimulator(*this, vangogh);
+  Agent::ptr agentA = simulatorA->addAgent(agentConfig);
+  Agent::ptr agentB = simulatorB->addAgent(agentConfig);
+  AgentState stateA;
+  stateA.position = {1.0f, 0.0f, 1.0f};
+  agentA->setState(stateA);
+  AgentState stateB;
+  stateB.position = {-1.0f, 0.0f, 0.5f};
+  agentB->setState(stateB);
+
+  ObservationArena arena{agentA->getSubtreeSensors(), 2};
+  CORRADE_COMPARE(arena.batchSize(), 2);
+  CORRADE_COMPARE(arena.slots().size(), 2);
+  CORRADE_COMPARE(arena.getSlotIndex("color"), 0);
+  CORRADE_COMPARE(arena.getSlotIndex("depth"), 1);
+  CORRADE_COMPARE(arena.getSlotIndex("semantic"), esp::ID_UNDEFINED);
+  CORRADE_COMPARE(arena.slots()[1].frameSize, 48 * 64 * sizeof(float));
+  CORRADE_COMPARE(
+      reinterpret_cast<std::uintptr_t>(arena.data().data()) %
+          ObservationArena::Alignment,
+      0);
+  CORRADE_COMPARE(arena.slots()[1].offset % ObservationArena::Alignment, 0);
+
+  // same as the observations read into the memory of the sensors
+  const auto compare = [&](Simulator& simulator, std::size_t batchIndex) {
+    CORRADE_ITERATION(batchIndex);
+    for (int slotIndex : {0, 1}) {
+      const ObservationArena::Slot& slot = arena.slots()[slotIndex];
+      CORRADE_ITERATION(slot.uuid);
+      Observation observation;
+      CORRADE_VERIFY(simulator.getAgentObservation(0, slot.uuid, observation));
+      Mn::MutableImageView2D view =
+          arena.getObservationView(slotIndex, batchIndex);
+      CORRADE_COMPARE(view.data().size(), observation.buffer->data.size());
+      CORRADE_VERIFY(std::equal(observation.buffer->data.begin(),
+                                observation.buffer->data.end(),
+                                view.data().begin()));
+    }
+  };
+
+  CORRADE_COMPARE(simulatorA->getAgentObservations(0, arena, 1), 2);
+  compare(*simulatorA, 1);
+
+  CORRADE_COMPARE(Simulator::getBatchedSensorObservations(
+                      {*simulatorA, *simulatorB},
+                      {agentA->node(), agentB->node()}, arena),
+                  4);
+  compare(*simulatorA, 0);
+  compare(*simulatorB, 1);
+  CORRADE_VERIFY(!std::equal(arena.getObservationView(0, 0).data().begin(),
+                             arena.getObservationView(0, 0).data().end(),
+                             arena.getObservationView(0, 1).data().begin()));
+}
 }  // namespace
 
 CORRADE_TEST_MAIN(SimTest)
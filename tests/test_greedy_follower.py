@@ -184,3 +184,33 @@ def test_greedy_follower(test_navmesh, move_filter_fn, action_noise, pbar):
 
     if not test_all:
         assert test_spl / NUM_TESTS >= ACCEPTABLE_SPLS[(move_filter_fn, action_noise)]
+
+    # Planning revisits positions, e.g. when turning in place, so the
+    # geodesic distances must be cached
+    assert follower.impl.cache_stats.geo_dist_hits > 0
+
+    # Planning the same path again simulates the same steps. Without noise they
+    # must come from the cache; with noise the cache is off and every step is
+    # simulated
+    for _ in range(2):
+        agent.state = state
+        follower.impl.reset_cache_stats()
+        try:
+            follower.find_path(goal_pos)
+        except habitat_sim.errors.GreedyFollowerError:
+            pass
+    if action_noise:
+        assert not follower.impl.try_step_cache_enabled
+        assert follower.impl.cache_stats.try_step_hits == 0
+    else:
+        assert follower.impl.cache_stats.try_step_hits > 0
+
+        # As done for noisy actuations, the steps can be simulated every time
+        follower.impl.try_step_cache_enabled = False
+        agent.state = state
+        follower.impl.reset_cache_stats()
+        try:
+            follower.find_path(goal_pos)
+        except habitat_sim.errors.GreedyFollowerError:
+            pass
+        assert follower.impl.cache_stats.try_step_hits == 0
@@ -231,6 +231,96 @@ def test_reconfigure_render(
         ) < 9.0e-2 * np.linalg.norm(gt.astype(float)), f"Incorrect {sensor_type} output"
 
 
+@pytest.mark.gfxtest
+@pytest.mark.parametrize("scene", _test_scenes)
+def test_pipelined_observations(scene, make_cfg_settings):
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    make_cfg_settings["scene"] = scene
+    make_cfg_settings["color_sensor"] = True
+    make_cfg_settings["depth_sensor"] = True
+    make_cfg_settings["semantic_sensor"] = False
+
+    with habitat_sim.Simulator(make_cfg(make_cfg_settings)) as sim:
+        agent = sim.get_agent(0)
+        state_a = agent.get_state()
+        state_b = agent.get_state()
+        state_b.position = state_b.position + np.array([0.5, 0.0, 0.5])
+
+        def observe(state):
+            agent.set_state(state)
+            return {k: v.copy() for k, v in sim.get_sensor_observations().items()}
+
+        def assert_equal(obs, expected):
+            for k in expected:
+                assert np.array_equal(obs[k], expected[k]), f"Incorrect {k}"
+
+        obs_a = observe(state_a)
+        obs_b = observe(state_b)
+
+        sim.pipelined_observations = True
+        # The first observation is read synchronously, the next ones are the
+        # observations of the previous call
+        assert_equal(observe(state_a), obs_a)
+        assert_equal(observe(state_b), obs_a)
+        assert_equal(observe(state_b), obs_b)
+
+        sim.pipelined_observations = False
+        assert_equal(observe(state_a), obs_a)
+
+
+@pytest.mark.gfxtest
+@pytest.mark.parametrize("scene", _test_scenes)
+def test_arena_observations(scene, make_cfg_settings):
+    if not osp.exists(scene):
+        pytest.skip("Skipping {}".format(scene))
+
+    make_cfg_settings["scene"] = scene
+    make_cfg_settings["color_sensor"] = True
+    make_cfg_settings["depth_sensor"] = True
+    make_cfg_settings["semantic_sensor"] = False
+
+    cfg = make_cfg(make_cfg_settings)
+    with habitat_sim.Simulator(cfg) as sim_a, habitat_sim.Simulator(cfg) as sim_b:
+        agent_a = sim_a.get_agent(0)
+        agent_b = sim_b.get_agent(0)
+        state = agent_b.get_state()
+        state.position = state.position + np.array([0.5, 0.0, 0.5])
+        agent_b.set_state(state)
+
+        arena = habitat_sim.sensor.ObservationArena(agent_a.scene_node, 2)
+        assert arena.batch_size == 2
+        assert sorted(arena.uuids) == ["color_sensor", "depth_sensor"]
+        views = {uuid: arena[uuid] for uuid in arena.uuids}
+
+        def assert_equal(obs, batch_index):
+            for uuid, view in views.items():
+                assert view.shape[1:] == obs[uuid].shape
+                assert view.dtype == obs[uuid].dtype
+                assert np.array_equal(view[batch_index], obs[uuid])
+
+        sim_a.fill_sensor_observations(agent_a.scene_node, arena, 1)
+        assert_equal(sim_a.get_sensor_observations(), 1)
+
+        habitat_sim.Simulator.fill_batched_sensor_observations(
+            [sim_a, sim_b], [agent_a.scene_node, agent_b.scene_node], arena
+        )
+        # the views are filled in place
+        assert_equal(sim_a.get_sensor_observations(), 0)
+        assert_equal(sim_b.get_sensor_observations(), 1)
+
+        # bad inputs raise instead of crashing
+        with pytest.raises(AssertionError):
+            habitat_sim.Simulator.fill_batched_sensor_observations(
+                [sim_a, None], [agent_a.scene_node, agent_b.scene_node], arena
+            )
+        with pytest.raises(AssertionError):
+            habitat_sim.Simulator.fill_batched_sensor_observations(
+                [sim_a, sim_b], [agent_a.scene_node], arena
+            )
+
+
 # Tests to make sure that no sensors is supported and doesn't crash
 # Also tests to make sure we can have multiple instances
 # of the simulator with no sensors